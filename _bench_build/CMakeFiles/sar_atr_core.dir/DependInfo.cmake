@@ -0,0 +1,46 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/amq_client.cpp" "CMakeFiles/sar_atr_core.dir/src/amq_client.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/amq_client.cpp.o.d"
+  "/root/repo/src/amq_connection_pool.cpp" "CMakeFiles/sar_atr_core.dir/src/amq_connection_pool.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/amq_connection_pool.cpp.o.d"
+  "/root/repo/src/async_file_io.cpp" "CMakeFiles/sar_atr_core.dir/src/async_file_io.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/async_file_io.cpp.o.d"
+  "/root/repo/src/buffer_pool.cpp" "CMakeFiles/sar_atr_core.dir/src/buffer_pool.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/buffer_pool.cpp.o.d"
+  "/root/repo/src/chip_extractor.cpp" "CMakeFiles/sar_atr_core.dir/src/chip_extractor.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/chip_extractor.cpp.o.d"
+  "/root/repo/src/class_registry.cpp" "CMakeFiles/sar_atr_core.dir/src/class_registry.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/class_registry.cpp.o.d"
+  "/root/repo/src/config_manager.cpp" "CMakeFiles/sar_atr_core.dir/src/config_manager.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/config_manager.cpp.o.d"
+  "/root/repo/src/detection_batch.cpp" "CMakeFiles/sar_atr_core.dir/src/detection_batch.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/detection_batch.cpp.o.d"
+  "/root/repo/src/engine_registry.cpp" "CMakeFiles/sar_atr_core.dir/src/engine_registry.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/engine_registry.cpp.o.d"
+  "/root/repo/src/event_loop.cpp" "CMakeFiles/sar_atr_core.dir/src/event_loop.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/event_loop.cpp.o.d"
+  "/root/repo/src/image_arena.cpp" "CMakeFiles/sar_atr_core.dir/src/image_arena.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/image_arena.cpp.o.d"
+  "/root/repo/src/image_geometry.cpp" "CMakeFiles/sar_atr_core.dir/src/image_geometry.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/image_geometry.cpp.o.d"
+  "/root/repo/src/logger.cpp" "CMakeFiles/sar_atr_core.dir/src/logger.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/logger.cpp.o.d"
+  "/root/repo/src/mapped_file.cpp" "CMakeFiles/sar_atr_core.dir/src/mapped_file.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/mapped_file.cpp.o.d"
+  "/root/repo/src/metrics.cpp" "CMakeFiles/sar_atr_core.dir/src/metrics.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/metrics.cpp.o.d"
+  "/root/repo/src/metrics_server.cpp" "CMakeFiles/sar_atr_core.dir/src/metrics_server.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/metrics_server.cpp.o.d"
+  "/root/repo/src/mock_inference_engine.cpp" "CMakeFiles/sar_atr_core.dir/src/mock_inference_engine.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/mock_inference_engine.cpp.o.d"
+  "/root/repo/src/nitf_reader.cpp" "CMakeFiles/sar_atr_core.dir/src/nitf_reader.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/nitf_reader.cpp.o.d"
+  "/root/repo/src/non_max_suppression.cpp" "CMakeFiles/sar_atr_core.dir/src/non_max_suppression.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/non_max_suppression.cpp.o.d"
+  "/root/repo/src/prefetcher.cpp" "CMakeFiles/sar_atr_core.dir/src/prefetcher.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/prefetcher.cpp.o.d"
+  "/root/repo/src/result_cache.cpp" "CMakeFiles/sar_atr_core.dir/src/result_cache.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/result_cache.cpp.o.d"
+  "/root/repo/src/sar_atr_service.cpp" "CMakeFiles/sar_atr_core.dir/src/sar_atr_service.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/sar_atr_service.cpp.o.d"
+  "/root/repo/src/stomp_frame.cpp" "CMakeFiles/sar_atr_core.dir/src/stomp_frame.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/stomp_frame.cpp.o.d"
+  "/root/repo/src/thread_pool.cpp" "CMakeFiles/sar_atr_core.dir/src/thread_pool.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/thread_pool.cpp.o.d"
+  "/root/repo/src/tiled_inference.cpp" "CMakeFiles/sar_atr_core.dir/src/tiled_inference.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/tiled_inference.cpp.o.d"
+  "/root/repo/src/uci_messages.cpp" "CMakeFiles/sar_atr_core.dir/src/uci_messages.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/uci_messages.cpp.o.d"
+  "/root/repo/src/uci_serializer.cpp" "CMakeFiles/sar_atr_core.dir/src/uci_serializer.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/uci_serializer.cpp.o.d"
+  "/root/repo/src/websocket_frame.cpp" "CMakeFiles/sar_atr_core.dir/src/websocket_frame.cpp.o" "gcc" "CMakeFiles/sar_atr_core.dir/src/websocket_frame.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
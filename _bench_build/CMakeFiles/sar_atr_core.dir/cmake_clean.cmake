@@ -0,0 +1,65 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/sar_atr_core.dir/src/amq_client.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/amq_client.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/amq_connection_pool.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/amq_connection_pool.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/async_file_io.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/async_file_io.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/buffer_pool.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/buffer_pool.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/chip_extractor.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/chip_extractor.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/class_registry.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/class_registry.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/config_manager.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/config_manager.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/detection_batch.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/detection_batch.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/engine_registry.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/engine_registry.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/event_loop.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/event_loop.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/image_arena.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/image_arena.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/image_geometry.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/image_geometry.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/logger.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/logger.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/mapped_file.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/mapped_file.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/metrics.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/metrics.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/metrics_server.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/metrics_server.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/mock_inference_engine.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/mock_inference_engine.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/nitf_reader.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/nitf_reader.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/non_max_suppression.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/non_max_suppression.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/prefetcher.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/prefetcher.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/result_cache.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/result_cache.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/sar_atr_service.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/sar_atr_service.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/stomp_frame.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/stomp_frame.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/thread_pool.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/thread_pool.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/tiled_inference.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/tiled_inference.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/uci_messages.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/uci_messages.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/uci_serializer.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/uci_serializer.cpp.o.d"
+  "CMakeFiles/sar_atr_core.dir/src/websocket_frame.cpp.o"
+  "CMakeFiles/sar_atr_core.dir/src/websocket_frame.cpp.o.d"
+  "libsar_atr_core.a"
+  "libsar_atr_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/sar_atr_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
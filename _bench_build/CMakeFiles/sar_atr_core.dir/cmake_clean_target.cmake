@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libsar_atr_core.a"
+)
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/sar_atr_service.dir/src/main.cpp.o"
+  "CMakeFiles/sar_atr_service.dir/src/main.cpp.o.d"
+  "sar_atr_service"
+  "sar_atr_service.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/sar_atr_service.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
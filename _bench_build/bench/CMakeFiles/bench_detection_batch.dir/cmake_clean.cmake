@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_detection_batch.dir/bench_detection_batch.cpp.o"
+  "CMakeFiles/bench_detection_batch.dir/bench_detection_batch.cpp.o.d"
+  "bench_detection_batch"
+  "bench_detection_batch.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_detection_batch.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
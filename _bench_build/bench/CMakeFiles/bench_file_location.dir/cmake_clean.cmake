@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_file_location.dir/bench_file_location.cpp.o"
+  "CMakeFiles/bench_file_location.dir/bench_file_location.cpp.o.d"
+  "bench_file_location"
+  "bench_file_location.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_file_location.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_ids.dir/bench_ids.cpp.o"
+  "CMakeFiles/bench_ids.dir/bench_ids.cpp.o.d"
+  "bench_ids"
+  "bench_ids.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_ids.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_message_path.dir/bench_message_path.cpp.o"
+  "CMakeFiles/bench_message_path.dir/bench_message_path.cpp.o.d"
+  "bench_message_path"
+  "bench_message_path.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_message_path.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
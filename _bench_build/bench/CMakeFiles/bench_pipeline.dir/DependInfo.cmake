@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/bench/bench_pipeline.cpp" "bench/CMakeFiles/bench_pipeline.dir/bench_pipeline.cpp.o" "gcc" "bench/CMakeFiles/bench_pipeline.dir/bench_pipeline.cpp.o.d"
+  "/root/repo/bench/loopback_broker.cpp" "bench/CMakeFiles/bench_pipeline.dir/loopback_broker.cpp.o" "gcc" "bench/CMakeFiles/bench_pipeline.dir/loopback_broker.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_bench_build/CMakeFiles/sar_atr_core.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_uci_serializer.dir/bench_uci_serializer.cpp.o"
+  "CMakeFiles/bench_uci_serializer.dir/bench_uci_serializer.cpp.o.d"
+  "bench_uci_serializer"
+  "bench_uci_serializer.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_uci_serializer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
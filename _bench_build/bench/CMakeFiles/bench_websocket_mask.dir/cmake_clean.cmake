@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_websocket_mask.dir/bench_websocket_mask.cpp.o"
+  "CMakeFiles/bench_websocket_mask.dir/bench_websocket_mask.cpp.o.d"
+  "bench_websocket_mask"
+  "bench_websocket_mask.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_websocket_mask.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
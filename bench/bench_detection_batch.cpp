@@ -0,0 +1,330 @@
+/**
+ * @file bench_detection_batch.cpp
+ * @brief Compares per-DetectionResult loops with the DetectionBatch column kernels
+ *
+ * Candidate counts span a sparse scene up to the thousands of raw boxes a
+ * dense model emits per tile before thresholding. The NMS cases run on
+ * detections that already passed, clustered a few per target.
+ *
+ * Run: ./bench/bench_detection_batch [--benchmark_format=json]
+ */
+
+#include "chip_extractor.h"
+#include "detection_batch.h"
+#include "non_max_suppression.h"
+#include "tiled_inference.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using sar_atr::DetectionBatch;
+using sar_atr::DetectionList;
+using sar_atr::DetectionResult;
+
+constexpr float kThreshold = 0.5f;
+
+/// Raw-model-like candidates: mostly near-zero scores (about 8% reach the threshold), small boxes anywhere
+DetectionList makeCandidates(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> coord(0.0f, 0.95f);
+    std::uniform_real_distribution<float> extent(0.002f, 0.05f);
+    const sar_atr::ClassId classes[3] = {sar_atr::internClass("T-72"), sar_atr::internClass("BMP-2"),
+                                         sar_atr::internClass("ZSU-23-4")};
+
+    DetectionList candidates;
+    candidates.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        DetectionResult& detection = candidates.emplace_back();
+        detection.class_id = classes[i % 3];
+        detection.confidence = std::pow(unit(rng), 8.0f);
+        float x = coord(rng);
+        float y = coord(rng);
+        detection.bounding_box = {x, y, x + extent(rng), y + extent(rng)};
+    }
+    return candidates;
+}
+
+// Selection alone: which candidates pass, without building any DetectionResult
+void BM_SelectListScalar(benchmark::State& state) {
+    DetectionList candidates = makeCandidates(static_cast<size_t>(state.range(0)));
+    std::vector<uint32_t> selected(candidates.size());
+    for (auto _ : state) {
+        size_t count = 0;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (candidates[i].confidence >= kThreshold) {
+                selected[count++] = static_cast<uint32_t>(i);
+            }
+        }
+        benchmark::DoNotOptimize(count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_SelectBatch(benchmark::State& state) {
+    DetectionBatch candidates;
+    candidates.append(makeCandidates(static_cast<size_t>(state.range(0))));
+    std::vector<uint32_t> selected(candidates.size());
+    for (auto _ : state) {
+        size_t count = candidates.selectAbove(kThreshold, selected.data());
+        benchmark::DoNotOptimize(count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+/// A model's raw output tensors, one array per field
+struct CandidateTensors {
+    std::vector<float> confidence, x1, y1, x2, y2;
+    std::vector<sar_atr::ClassId> class_ids;
+
+    explicit CandidateTensors(const DetectionList& candidates) {
+        for (const auto& detection : candidates) {
+            confidence.push_back(detection.confidence);
+            x1.push_back(detection.bounding_box.x1);
+            y1.push_back(detection.bounding_box.y1);
+            x2.push_back(detection.bounding_box.x2);
+            y2.push_back(detection.bounding_box.y2);
+            class_ids.push_back(detection.class_id);
+        }
+    }
+};
+
+// Engine output to thresholded DetectionResults. The list path builds a
+// DetectionResult for every candidate and then filters; the batch path
+// copies the tensors into columns and only builds the survivors.
+void BM_EmitFilterList(benchmark::State& state) {
+    const CandidateTensors tensors(makeCandidates(static_cast<size_t>(state.range(0))));
+    const size_t count = tensors.confidence.size();
+    DetectionList candidates;
+    DetectionList kept;
+    for (auto _ : state) {
+        candidates.clear();
+        kept.clear();
+        for (size_t i = 0; i < count; ++i) {
+            DetectionResult& detection = candidates.emplace_back();
+            detection.class_id = tensors.class_ids[i];
+            detection.confidence = tensors.confidence[i];
+            detection.bounding_box = {tensors.x1[i], tensors.y1[i], tensors.x2[i], tensors.y2[i]};
+        }
+        for (const auto& detection : candidates) {
+            if (detection.confidence >= kThreshold) {
+                kept.push_back(detection);
+            }
+        }
+        benchmark::DoNotOptimize(kept.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_EmitFilterBatch(benchmark::State& state) {
+    const CandidateTensors tensors(makeCandidates(static_cast<size_t>(state.range(0))));
+    const size_t count = tensors.confidence.size();
+    DetectionBatch candidates;
+    std::vector<uint32_t> selected(count);
+    DetectionList kept;
+    for (auto _ : state) {
+        kept.clear();
+        candidates.resize(count);
+        std::copy(tensors.confidence.begin(), tensors.confidence.end(), candidates.confidence());
+        std::copy(tensors.x1.begin(), tensors.x1.end(), candidates.x1());
+        std::copy(tensors.y1.begin(), tensors.y1.end(), candidates.y1());
+        std::copy(tensors.x2.begin(), tensors.x2.end(), candidates.x2());
+        std::copy(tensors.y2.begin(), tensors.y2.end(), candidates.y2());
+        std::copy(tensors.class_ids.begin(), tensors.class_ids.end(), candidates.classIds());
+        size_t passed = candidates.selectAbove(kThreshold, selected.data());
+        candidates.appendTo(selected.data(), passed, kept);
+        benchmark::DoNotOptimize(kept.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_ChipPixelsScalar(benchmark::State& state) {
+    DetectionList candidates = makeCandidates(static_cast<size_t>(state.range(0)));
+    sar_atr::ChipOptions options;
+    for (auto _ : state) {
+        long long total = 0;
+        for (const auto& detection : candidates) {
+            if (detection.confidence >= kThreshold) {
+                sar_atr::ChipRegion chip = sar_atr::computeChipRegion(detection.bounding_box, 16384, 16384, options);
+                total += static_cast<long long>(chip.cols) * chip.rows;
+            }
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_ChipPixelsBatch(benchmark::State& state) {
+    DetectionBatch candidates;
+    candidates.append(makeCandidates(static_cast<size_t>(state.range(0))));
+    sar_atr::ChipOptions options;
+    for (auto _ : state) {
+        long long total = sar_atr::totalChipPixels(candidates, kThreshold, 16384, 16384, options);
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Tile mapping is applied in place, so both variants restore their input
+// outside the timed region each iteration
+void BM_MapTileList(benchmark::State& state) {
+    const DetectionList original = makeCandidates(static_cast<size_t>(state.range(0)));
+    const sar_atr::ImageTile tile{6144, 2048, 2048, 2048, 16384, 16384, 7};
+    DetectionList candidates;
+    for (auto _ : state) {
+        state.PauseTiming();
+        candidates = original;
+        state.ResumeTiming();
+        sar_atr::mapTileDetections(tile, candidates);
+        benchmark::DoNotOptimize(candidates.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_MapTileBatch(benchmark::State& state) {
+    const DetectionList original = makeCandidates(static_cast<size_t>(state.range(0)));
+    const sar_atr::ImageTile tile{6144, 2048, 2048, 2048, 16384, 16384, 7};
+    DetectionBatch candidates;
+    for (auto _ : state) {
+        state.PauseTiming();
+        candidates.clear();
+        candidates.append(original);
+        state.ResumeTiming();
+        candidates.mapBoxes(static_cast<float>(tile.cols) / tile.image_cols,
+                            static_cast<float>(tile.col_offset) / tile.image_cols,
+                            static_cast<float>(tile.rows) / tile.image_rows,
+                            static_cast<float>(tile.row_offset) / tile.image_rows);
+        benchmark::DoNotOptimize(candidates.x1());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+/// Passing detections as a model emits them: a few boxes per target, jittered around each other
+DetectionList makeClusteredDetections(size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> coord(0.0f, 0.95f);
+    std::uniform_real_distribution<float> jitter(-0.004f, 0.004f);
+    const sar_atr::ClassId classes[3] = {sar_atr::internClass("T-72"), sar_atr::internClass("BMP-2"),
+                                         sar_atr::internClass("ZSU-23-4")};
+
+    DetectionList detections;
+    detections.reserve(count);
+    constexpr size_t kPerTarget = 6;
+    for (size_t target = 0; detections.size() < count; ++target) {
+        float x = coord(rng);
+        float y = coord(rng);
+        for (size_t k = 0; k < kPerTarget && detections.size() < count; ++k) {
+            DetectionResult& detection = detections.emplace_back();
+            detection.class_id = classes[target % 3];
+            detection.confidence = kThreshold + (1.0f - kThreshold) * unit(rng);
+            float x1 = x + jitter(rng);
+            float y1 = y + jitter(rng);
+            detection.bounding_box = {x1, y1, x1 + 0.02f + jitter(rng), y1 + 0.02f + jitter(rng)};
+        }
+    }
+    return detections;
+}
+
+float iouOf(const sar_atr::BoundingBox& a, const sar_atr::BoundingBox& b) {
+    float w = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    float h = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = w * h;
+    return inter / ((a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter);
+}
+
+// Textbook greedy NMS over the list: sort by score, then test every kept box against every later one
+void BM_NmsListScalar(benchmark::State& state) {
+    const DetectionList detections = makeClusteredDetections(static_cast<size_t>(state.range(0)));
+    std::vector<uint32_t> order(detections.size());
+    std::vector<char> removed(detections.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return detections[a].confidence > detections[b].confidence;
+        });
+        std::fill(removed.begin(), removed.end(), 0);
+        size_t kept = 0;
+        for (size_t a = 0; a < order.size(); ++a) {
+            if (removed[a]) {
+                continue;
+            }
+            kept++;
+            const DetectionResult& best = detections[order[a]];
+            for (size_t b = a + 1; b < order.size(); ++b) {
+                const DetectionResult& other = detections[order[b]];
+                if (!removed[b] && other.class_id == best.class_id &&
+                    iouOf(best.bounding_box, other.bounding_box) > 0.5f) {
+                    removed[b] = 1;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(kept);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void runNms(benchmark::State& state, sar_atr::NmsOptions::Method method) {
+    const DetectionList detections = makeClusteredDetections(static_cast<size_t>(state.range(0)));
+    sar_atr::NmsOptions options;
+    options.method = method;
+    DetectionBatch candidates;
+    std::vector<uint32_t> selected(detections.size());
+    for (auto _ : state) {
+        // Soft methods rewrite confidences, so every pass starts from the engine output
+        state.PauseTiming();
+        candidates.clear();
+        candidates.append(detections);
+        state.ResumeTiming();
+        size_t passed = candidates.selectAbove(kThreshold, selected.data());
+        size_t kept = sar_atr::suppressNonMaxima(candidates, selected.data(), passed, options, kThreshold);
+        benchmark::DoNotOptimize(kept);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_NmsGreedy(benchmark::State& state) {
+    runNms(state, sar_atr::NmsOptions::Method::GREEDY);
+}
+
+void BM_NmsSoftLinear(benchmark::State& state) {
+    runNms(state, sar_atr::NmsOptions::Method::SOFT_LINEAR);
+}
+
+void BM_NmsSoftGaussian(benchmark::State& state) {
+    runNms(state, sar_atr::NmsOptions::Method::SOFT_GAUSSIAN);
+}
+
+#define CANDIDATE_COUNTS ->Arg(16)->Arg(256)->Arg(4096)->Arg(32768)
+
+BENCHMARK(BM_SelectListScalar) CANDIDATE_COUNTS;
+BENCHMARK(BM_SelectBatch) CANDIDATE_COUNTS;
+BENCHMARK(BM_EmitFilterList) CANDIDATE_COUNTS;
+BENCHMARK(BM_EmitFilterBatch) CANDIDATE_COUNTS;
+BENCHMARK(BM_ChipPixelsScalar) CANDIDATE_COUNTS;
+BENCHMARK(BM_ChipPixelsBatch) CANDIDATE_COUNTS;
+BENCHMARK(BM_MapTileList) CANDIDATE_COUNTS;
+BENCHMARK(BM_MapTileBatch) CANDIDATE_COUNTS;
+
+#define NMS_COUNTS ->Arg(256)->Arg(1024)->Arg(4096)->Arg(8192)->Unit(benchmark::kMicrosecond)
+
+BENCHMARK(BM_NmsListScalar) NMS_COUNTS;
+BENCHMARK(BM_NmsGreedy) NMS_COUNTS;
+BENCHMARK(BM_NmsSoftLinear) NMS_COUNTS;
+BENCHMARK(BM_NmsSoftGaussian) NMS_COUNTS;
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+/**
+ * @file bench_file_location.cpp
+ * @brief Compares the FileLocation fast-path scanner against the original DOM parse
+ *
+ * Run: ./bench/bench_file_location [--benchmark_format=json]
+ */
+
+#include "uci_messages.h"
+#include <benchmark/benchmark.h>
+#include <json/json.h>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Original parseFileLocationMessage: stream copy plus full DOM
+std::string legacyParseFileLocationMessage(const std::string& json_message) {
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errs;
+    std::istringstream iss(json_message);
+
+    if (!Json::parseFromStream(builder, iss, &root, &errs)) {
+        throw std::runtime_error("Failed to parse FileLocation message: " + errs);
+    }
+    return root["FileLocation"]["MessageData"]["LocationAndStatus"]["Location"]["Network"]["Address"].asString();
+}
+
+// Minimal message, as published by the upstream file watcher
+const std::string kMinimalMessage =
+    R"({"FileLocation":{"MessageData":{"LocationAndStatus":{"Location":{"Network":)"
+    R"({"Address":"/mock/data/test_image_0_2048x2048.nitf"}}}}}})";
+
+// Full message: header, security and sibling fields ahead of the address
+const std::string kFullMessage = R"({
+  "FileLocation": {
+    "SecurityInformation": {"Classification": "UNCLASSIFIED", "OwnerProducer": ["USA"]},
+    "MessageHeader": {
+      "SystemID": {"UUID": "4b0e3c9a-9d2f-4f7e-8c31-2a6f1e0d7b55", "DescriptiveLabel": "Collection Manager"},
+      "Timestamp": "2026-10-14T12:00:00.000Z",
+      "SchemaVersion": "2.5",
+      "Mode": "LIVE",
+      "ServiceID": {"UUID": "c9a1f4e2-5b3d-4a8c-9e7f-1d2b3c4d5e6f", "DescriptiveLabel": "Ingest"}
+    },
+    "MessageData": {
+      "FileLocationID": {"UUID": "0f1e2d3c-4b5a-4968-8776-655443322110"},
+      "FileType": "NITF",
+      "Size": 8389451,
+      "Checksums": [{"Algorithm": "SHA256", "Value": "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08"}],
+      "LocationAndStatus": {
+        "Status": "AVAILABLE",
+        "Location": {
+          "Network": {
+            "Protocol": "FILE",
+            "Address": "/data/collects/2026/10/14/pass_0412/SAR_0412_0007_16384x16384.nitf"
+          }
+        }
+      }
+    }
+  }
+})";
+
+void BM_FileLocationLegacyDom(benchmark::State& state, const std::string& message) {
+    for (auto _ : state) {
+        std::string path = legacyParseFileLocationMessage(message);
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * message.size());
+}
+
+void BM_FileLocationParse(benchmark::State& state, const std::string& message) {
+    for (auto _ : state) {
+        std::string path = sar_atr::parseFileLocationMessage(message);
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * message.size());
+}
+
+void BM_FileLocationScanView(benchmark::State& state, const std::string& message) {
+    for (auto _ : state) {
+        std::string_view address;
+        bool found = sar_atr::findFileLocationAddress(message, address);
+        benchmark::DoNotOptimize(found);
+        benchmark::DoNotOptimize(address.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * message.size());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_FileLocationLegacyDom, minimal, kMinimalMessage);
+BENCHMARK_CAPTURE(BM_FileLocationParse, minimal, kMinimalMessage);
+BENCHMARK_CAPTURE(BM_FileLocationScanView, minimal, kMinimalMessage);
+BENCHMARK_CAPTURE(BM_FileLocationLegacyDom, full, kFullMessage);
+BENCHMARK_CAPTURE(BM_FileLocationParse, full, kFullMessage);
+BENCHMARK_CAPTURE(BM_FileLocationScanView, full, kFullMessage);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+/**
+ * @file bench_ids.cpp
+ * @brief Per-call cost of UUID and timestamp generation, before and after
+ *
+ * Run: ./bench/bench_ids [--benchmark_format=json]
+ */
+
+#include "uci_messages.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Original generateUUID: 32 distribution draws through a stringstream
+std::string legacyGenerateUUID() {
+    thread_local std::mt19937 gen(std::random_device{}());
+    thread_local std::uniform_int_distribution<> dis(0, 15);
+    thread_local std::uniform_int_distribution<> dis2(8, 11);
+
+    std::stringstream ss;
+    int i;
+    ss << std::hex;
+    for (i = 0; i < 8; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    for (i = 0; i < 4; i++) {
+        ss << dis(gen);
+    }
+    ss << "-4";
+    for (i = 0; i < 3; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    ss << dis2(gen);
+    for (i = 0; i < 3; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    for (i = 0; i < 12; i++) {
+        ss << dis(gen);
+    }
+    return ss.str();
+}
+
+// Original getCurrentTimestamp: put_time plus a stringstream per call
+std::string legacyGetCurrentTimestamp() {
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+
+    std::tm utc_tm;
+    gmtime_r(&time, &utc_tm);
+
+    std::stringstream ss;
+    ss << std::put_time(&utc_tm, "%Y-%m-%dT%H:%M:%S");
+    ss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
+    return ss.str();
+}
+
+void BM_UuidLegacy(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string uuid = legacyGenerateUUID();
+        benchmark::DoNotOptimize(uuid.data());
+    }
+}
+
+void BM_UuidString(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string uuid = sar_atr::generateUUID();
+        benchmark::DoNotOptimize(uuid.data());
+    }
+}
+
+void BM_UuidBuffer(benchmark::State& state) {
+    char uuid[sar_atr::kUuidLength];
+    for (auto _ : state) {
+        sar_atr::generateUUID(uuid);
+        benchmark::DoNotOptimize(uuid);
+    }
+}
+
+void BM_TimestampLegacy(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string timestamp = legacyGetCurrentTimestamp();
+        benchmark::DoNotOptimize(timestamp.data());
+    }
+}
+
+void BM_TimestampString(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string timestamp = sar_atr::getCurrentTimestamp();
+        benchmark::DoNotOptimize(timestamp.data());
+    }
+}
+
+void BM_TimestampBuffer(benchmark::State& state) {
+    char timestamp[sar_atr::kTimestampLength];
+    for (auto _ : state) {
+        sar_atr::formatTimestamp(timestamp, std::chrono::system_clock::now());
+        benchmark::DoNotOptimize(timestamp);
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_UuidLegacy);
+BENCHMARK(BM_UuidString);
+BENCHMARK(BM_UuidBuffer);
+BENCHMARK(BM_UuidBuffer)->Threads(4);
+BENCHMARK(BM_TimestampLegacy);
+BENCHMARK(BM_TimestampString);
+BENCHMARK(BM_TimestampBuffer);
+BENCHMARK(BM_TimestampBuffer)->Threads(4);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,223 @@
+/**
+ * @file bench_message_path.cpp
+ * @brief Microbenchmarks for each primitive on the FileLocation -> UCI publish path
+ *
+ * Every primitive is measured on its own through its public entry point,
+ * across message sizes and detection counts seen in practice. Unlike the
+ * before/after comparisons in the other bench files, this suite is meant to
+ * be tracked from commit to commit:
+ *
+ * Run: ./bench/bench_message_path --benchmark_out=message_path.json --benchmark_out_format=json
+ *      (or build the run_benchmarks target, which writes every suite's JSON to bench_results/)
+ */
+
+#include "amq_client.h"
+#include "image_arena.h"
+#include "inference_engine.h"
+#include "stomp_frame.h"
+#include "uci_messages.h"
+#include "uci_serializer.h"
+#include "websocket_frame.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+using sar_atr::DetectionResult;
+using sar_atr::SystemInfo;
+
+const SystemInfo kSystemInfo{"7f3c2a10-8d4e-4b6f-9a21-3c5d7e9f1b2a", "SAR ATR Service", "1.0.0"};
+const std::string kUuid = "0d642701-f06f-4364-951c-31c4412dbb6c";
+
+/// NITF path of roughly the requested length, shaped like the collection system's
+std::string makePath(size_t length) {
+    std::string path = "/data/collections/2026/10/14/sensor_a/";
+    while (path.size() + 24 < length) {
+        path += "pass_0042/";
+    }
+    return path + "SAR_0412_16384x16384.ntf";
+}
+
+/// FileLocation as published upstream: header, security block and then the address
+std::string makeFileLocation(size_t path_length) {
+    return R"({"FileLocation":{"@xmlns":"namespace","SecurityInformation":{"Classification":"UNCLASSIFIED",)"
+           R"("OwnerProducer":["USA"]},"MessageHeader":{"Mode":"SIMULATION","SchemaVersion":"002.3","SystemID":)"
+           R"({"DescriptiveLabel":"Collection Manager","UUID":"4b0e3c9a-9d2f-4f7e-8c31-2a6f1e0d7b55"},)"
+           R"("Timestamp":"2026-10-14T12:00:00.000Z"},"MessageData":{"ProductDescription":{"ProcessingType":)"
+           R"("NONE"},"LocationAndStatus":{"Location":{"Network":{"Address":")" +
+           makePath(path_length) + R"("}}}}}})";
+}
+
+DetectionResult makeDetection(size_t index) {
+    DetectionResult detection;
+    detection.setClassification(index % 3 == 0 ? "T-72" : (index % 3 == 1 ? "BMP-2" : "ZSU-23-4"));
+    detection.confidence = 0.5f + 0.004f * static_cast<float>(index % 100);
+    float x = 0.05f + 0.0009f * static_cast<float>(index % 1000);
+    detection.bounding_box = {x, 0.2345f, x + 0.0312f, 0.2711f};
+    detection.output_file_path.assign("/data/sar_atr/chips/SAR_0412_16384x16384_" + std::to_string(index) + ".ntf");
+    return detection;
+}
+
+std::string makePayload(size_t size) {
+    std::string payload(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = static_cast<char>('a' + (i % 26));
+    }
+    return payload;
+}
+
+// --- Inbound -----------------------------------------------------------------
+
+void BM_ParseFileLocationMessage(benchmark::State& state) {
+    const std::string message = makeFileLocation(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string path = sar_atr::parseFileLocationMessage(message);
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * message.size()));
+}
+
+void BM_ParseWebSocketFrame(benchmark::State& state) {
+    std::string frame;
+    sar_atr::appendWebSocketFrame(makePayload(static_cast<size_t>(state.range(0))), sar_atr::WebSocketOpcode::TEXT,
+                                  frame);
+    for (auto _ : state) {
+        // Unmasking is in place, so the payload flips between masked and clear; the cost is the same
+        sar_atr::WebSocketFrame parsed;
+        size_t consumed = sar_atr::parseWebSocketFrame(&frame[0], frame.size(), parsed);
+        benchmark::DoNotOptimize(consumed);
+        benchmark::DoNotOptimize(parsed.payload.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame.size()));
+}
+
+// --- IDs ---------------------------------------------------------------------
+
+void BM_GenerateUUID(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string uuid = sar_atr::generateUUID();
+        benchmark::DoNotOptimize(uuid.data());
+    }
+}
+
+void BM_GetCurrentTimestamp(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string timestamp = sar_atr::getCurrentTimestamp();
+        benchmark::DoNotOptimize(timestamp.data());
+    }
+}
+
+// --- Outbound messages -------------------------------------------------------
+
+void BM_CreateEntityMessage(benchmark::State& state) {
+    const DetectionResult detection = makeDetection(7);
+    for (auto _ : state) {
+        std::string message = sar_atr::createEntityMessage(detection, kSystemInfo);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_CreateProductMetadataMessage(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string message = sar_atr::createProductMetadataMessage(kUuid, kUuid, kSystemInfo);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_CreateProductLocationMessage(benchmark::State& state) {
+    const std::string path = makePath(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string message = sar_atr::createProductLocationMessage(kUuid, path, kSystemInfo);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_CreateAtrProcessingResultMessage(benchmark::State& state) {
+    const std::vector<std::string> entity_uuids(static_cast<size_t>(state.range(0)), kUuid);
+    for (auto _ : state) {
+        std::string message = sar_atr::createAtrProcessingResultMessage(entity_uuids);
+        benchmark::DoNotOptimize(message.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entity_uuids.size()));
+}
+
+/// Everything published for one image with N detections, as the service builds it (in a reused arena)
+void BM_SerializeImageResults(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    sar_atr::DetectionList detections;
+    for (size_t i = 0; i < count; ++i) {
+        detections.push_back(makeDetection(i));
+    }
+    const sar_atr::UciSerializer serializer(kSystemInfo);
+    sar_atr::ImageArena arena;
+
+    for (auto _ : state) {
+        {
+            sar_atr::ImageMessageContext context(count * 2, &arena);
+            std::pmr::vector<std::string_view> entity_uuids(&arena);
+            sar_atr::OutboundBatch batch(&arena);
+            entity_uuids.reserve(count);
+            batch.reserve(count * 3 + 1);
+            for (const auto& detection : detections) {
+                sar_atr::UciMessage entity = serializer.entity(detection, context);
+                sar_atr::UciMessage metadata = serializer.productMetadata(entity.uuid, context);
+                batch.emplace_back("Entity_uci", std::move(entity.body));
+                batch.emplace_back("ProductMetadata_uci", std::move(metadata.body));
+                batch.emplace_back("ProductLocation_uci",
+                                   serializer.productLocation(metadata.uuid, detection.output_file_path, context));
+                entity_uuids.push_back(entity.uuid);
+            }
+            batch.emplace_back("AtrProcessingResult_uci", sar_atr::UciSerializer::atrProcessingResult(entity_uuids));
+            benchmark::DoNotOptimize(batch.data());
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+
+// --- Framing -----------------------------------------------------------------
+
+/// STOMP SEND frame as built by AMQClient::publish/publishBatch
+void BM_StompSendFrame(benchmark::State& state) {
+    const std::string body = makePayload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string frame;
+        sar_atr::appendStompSendFrame("Entity_uci", body, frame);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+}
+
+/// Masked client frame as built by AMQClient::createWebSocketFrame
+void BM_CreateWebSocketFrame(benchmark::State& state) {
+    const std::string payload = makePayload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string frame;
+        frame.reserve(sar_atr::webSocketHeaderSize(payload.size()) + payload.size());
+        sar_atr::appendWebSocketFrame(payload, sar_atr::WebSocketOpcode::TEXT, frame);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+}
+
+// Path lengths: short test paths up to deep archive layouts
+BENCHMARK(BM_ParseFileLocationMessage)->Arg(48)->Arg(128)->Arg(512);
+BENCHMARK(BM_ParseWebSocketFrame)->Arg(64)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+
+BENCHMARK(BM_GenerateUUID);
+BENCHMARK(BM_GetCurrentTimestamp);
+
+BENCHMARK(BM_CreateEntityMessage);
+BENCHMARK(BM_CreateProductMetadataMessage);
+BENCHMARK(BM_CreateProductLocationMessage)->Arg(48)->Arg(128)->Arg(512);
+BENCHMARK(BM_CreateAtrProcessingResultMessage)->Arg(1)->Arg(8)->Arg(64)->Arg(512);
+BENCHMARK(BM_SerializeImageResults)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// Body sizes: ProductMetadata (~500 B), Entity (~800 B), AtrProcessingResult with many entities
+BENCHMARK(BM_StompSendFrame)->Arg(512)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+BENCHMARK(BM_CreateWebSocketFrame)->Arg(512)->Arg(1024)->Arg(16 * 1024)->Arg(256 * 1024);
+
+} // namespace
+
+BENCHMARK_MAIN();
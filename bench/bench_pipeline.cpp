@@ -0,0 +1,587 @@
+/**
+ * @file bench_pipeline.cpp
+ * @brief End-to-end load generator: FileLocation in, UCI results out, through the real service
+ *
+ * Starts an in-process LoopbackBroker and a SarAtrService backed by
+ * MockInferenceEngine, then publishes FileLocation messages at a fixed rate.
+ * The messages are either synthetic or replayed from a file holding one
+ * FileLocation JSON per line. An image counts as done when its
+ * AtrProcessingResult reaches the broker. Latency is measured from the
+ * scheduled send time, so a stalled pipeline is not hidden by a stalled
+ * generator.
+ *
+ * Run: ./bench/bench_pipeline [--messages=2000] [--rate=200] [--workers=4]
+ *          [--latency=uniform|normal|exponential] [--min-latency-ms=2] [--max-latency-ms=10]
+ *          [--replay=FILE] [--format=json] ...   (--help lists every option)
+ */
+
+#include "config_manager.h"
+#include "logger.h"
+#include "loopback_broker.h"
+#include "metrics.h"
+#include "mock_inference_engine.h"
+#include "sar_atr_service.h"
+#include "uci_messages.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Allocation counting: every operator new outside the harness's own threads
+
+namespace {
+
+std::atomic<unsigned long long> g_allocations{0};
+std::atomic<unsigned long long> g_allocated_bytes{0};
+thread_local bool t_harness_thread = false;
+
+void* countedAlloc(std::size_t size) {
+    if (!t_harness_thread) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using sar_atr::MockInferenceEngine;
+using Clock = std::chrono::steady_clock;
+
+// ---------------------------------------------------------------------------
+// Options
+
+struct Options {
+    int messages = 2000;
+    int warmup = 100;
+    double rate = 200;                  // FileLocation messages per second (0 = as fast as possible)
+    int timeout_s = 30;                 // How long to wait for stragglers after the last send
+    std::string replay_path;
+    std::string format = "text";
+
+    int workers = 4;
+    int queue_capacity = 256;
+    int queue_slo_ms = 0;
+    int batch_size = 1;
+    int batch_wait_ms = 0;
+    int connections = 1;
+    int parse_threads = 0;
+    int serialize_threads = 1;
+    int publish_threads = 1;
+    bool ordered = false;
+    double confidence_threshold = 0.5;
+    std::string log_level = "warning";
+
+    std::string latency = "uniform";
+    double min_latency_ms = 2;
+    double max_latency_ms = 10;
+    double per_image_ms = 0.5;
+    int min_detections = 1;
+    int max_detections = 5;
+};
+
+void printUsage() {
+    std::cout <<
+        "Usage: bench_pipeline [options]\n"
+        "  --messages=N          measured FileLocation messages (2000)\n"
+        "  --warmup=N            unmeasured messages sent first (100)\n"
+        "  --rate=R              messages per second, 0 = unthrottled (200)\n"
+        "  --timeout-s=S         wait for outstanding results after the last send (30)\n"
+        "  --replay=FILE         replay FileLocation JSON, one message per line\n"
+        "  --format=text|json    report format (text)\n"
+        "  --workers=N           inference workers (4)\n"
+        "  --queue-capacity=N    job queue capacity (256)\n"
+        "  --queue-slo-ms=N      shed jobs queued longer than this, 0 = never (0)\n"
+        "  --batch-size=N        inference batch size (1)\n"
+        "  --batch-wait-ms=N     batch fill wait (0)\n"
+        "  --connections=N       broker connections publishes are sharded over (1)\n"
+        "  --parse-threads=N     parse stage threads, 0 = on the receive thread (0)\n"
+        "  --serialize-threads=N serialize stage threads, 0 = on the inference worker (1)\n"
+        "  --publish-threads=N   publish stage threads, 0 = on the serializing thread (1)\n"
+        "  --ordered=0|1         publish images in arrival order (0)\n"
+        "  --threshold=F         confidence threshold (0.5)\n"
+        "  --log-level=LEVEL     service log level (warning)\n"
+        "  --latency=DIST        engine overhead: uniform, normal or exponential (uniform)\n"
+        "  --min-latency-ms=F    minimum engine overhead per call (2)\n"
+        "  --max-latency-ms=F    maximum engine overhead per call (10)\n"
+        "  --per-image-ms=F      engine cost per image in a call (0.5)\n"
+        "  --min-detections=N    detections per image, lower bound (1)\n"
+        "  --max-detections=N    detections per image, upper bound (5)\n";
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        }
+        size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+            throw std::runtime_error("Unrecognised argument: " + arg);
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+
+        if (key == "messages") options.messages = std::stoi(value);
+        else if (key == "warmup") options.warmup = std::stoi(value);
+        else if (key == "rate") options.rate = std::stod(value);
+        else if (key == "timeout-s") options.timeout_s = std::stoi(value);
+        else if (key == "replay") options.replay_path = value;
+        else if (key == "format") options.format = value;
+        else if (key == "workers") options.workers = std::stoi(value);
+        else if (key == "queue-capacity") options.queue_capacity = std::stoi(value);
+        else if (key == "queue-slo-ms") options.queue_slo_ms = std::stoi(value);
+        else if (key == "batch-size") options.batch_size = std::stoi(value);
+        else if (key == "batch-wait-ms") options.batch_wait_ms = std::stoi(value);
+        else if (key == "connections") options.connections = std::stoi(value);
+        else if (key == "parse-threads") options.parse_threads = std::stoi(value);
+        else if (key == "serialize-threads") options.serialize_threads = std::stoi(value);
+        else if (key == "publish-threads") options.publish_threads = std::stoi(value);
+        else if (key == "ordered") options.ordered = std::stoi(value) != 0;
+        else if (key == "threshold") options.confidence_threshold = std::stod(value);
+        else if (key == "log-level") options.log_level = value;
+        else if (key == "latency") options.latency = value;
+        else if (key == "min-latency-ms") options.min_latency_ms = std::stod(value);
+        else if (key == "max-latency-ms") options.max_latency_ms = std::stod(value);
+        else if (key == "per-image-ms") options.per_image_ms = std::stod(value);
+        else if (key == "min-detections") options.min_detections = std::stoi(value);
+        else if (key == "max-detections") options.max_detections = std::stoi(value);
+        else throw std::runtime_error("Unknown option --" + key);
+    }
+    if (options.messages <= 0 || options.warmup < 0 || options.rate < 0) {
+        throw std::runtime_error("--messages must be positive; --warmup and --rate must not be negative");
+    }
+    if (options.format != "text" && options.format != "json") {
+        throw std::runtime_error("--format must be text or json");
+    }
+    return options;
+}
+
+MockInferenceEngine::LatencyModel::Distribution parseDistribution(const std::string& name) {
+    using Distribution = MockInferenceEngine::LatencyModel::Distribution;
+    if (name == "uniform") {
+        return Distribution::UNIFORM;
+    }
+    if (name == "normal") {
+        return Distribution::NORMAL;
+    }
+    if (name == "exponential") {
+        return Distribution::EXPONENTIAL;
+    }
+    throw std::runtime_error("Unknown latency distribution: " + name);
+}
+
+// ---------------------------------------------------------------------------
+// Workload
+
+std::string syntheticFileLocation(size_t index) {
+    return R"({"FileLocation":{"@xmlns":"namespace","MessageData":{"LocationAndStatus":{"Location":)"
+           R"({"Network":{"Address":"/bench/replay/scene_)" + std::to_string(index) +
+           R"(_4096x4096.nitf"}}}},"MessageHeader":{"Mode":"SIMULATION","SchemaVersion":"002.3",)"
+           R"("SystemID":{"DescriptiveLabel":"Collection Manager","UUID":"4b0e3c9a-9d2f-4f7e-8c31-2a6f1e0d7b55"},)"
+           R"("Timestamp":"2026-10-14T12:00:00.000Z"},"SecurityInformation":null}})";
+}
+
+struct Workload {
+    std::vector<std::string> bodies;
+    std::vector<std::string> paths;     // Address of each body, for correlating results
+};
+
+Workload loadWorkload(const Options& options) {
+    Workload workload;
+    size_t total = static_cast<size_t>(options.warmup + options.messages);
+
+    if (options.replay_path.empty()) {
+        for (size_t i = 0; i < total; ++i) {
+            workload.bodies.push_back(syntheticFileLocation(i));
+        }
+    } else {
+        std::ifstream in(options.replay_path);
+        if (!in) {
+            throw std::runtime_error("Cannot open replay file: " + options.replay_path);
+        }
+        std::vector<std::string> recorded;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) {
+                recorded.push_back(line);
+            }
+        }
+        if (recorded.empty()) {
+            throw std::runtime_error("Replay file has no messages: " + options.replay_path);
+        }
+        // Cycle through the recording until the requested count is reached
+        for (size_t i = 0; i < total; ++i) {
+            workload.bodies.push_back(recorded[i % recorded.size()]);
+        }
+    }
+
+    for (const auto& body : workload.bodies) {
+        workload.paths.push_back(sar_atr::parseFileLocationMessage(body));
+    }
+    return workload;
+}
+
+/**
+ * Engine decorator: the first detection of every image points at the source
+ * path, so its ProductLocation message identifies which request the
+ * following AtrProcessingResult completes.
+ */
+class TaggingEngine : public sar_atr::InferenceEngine {
+public:
+    explicit TaggingEngine(std::shared_ptr<MockInferenceEngine> engine)
+        : engine_(std::move(engine)), tag_class_(sar_atr::internClass("class1")) {}
+
+    void process(const std::string& nitf_file_path, sar_atr::DetectionList& detections) override {
+        engine_->process(nitf_file_path, detections);
+        tag(detections, nitf_file_path);
+    }
+
+    void processBatch(const std::vector<sar_atr::BatchItem>& items) override {
+        engine_->processBatch(items);
+        for (const auto& item : items) {
+            tag(*item.detections, *item.nitf_file_path);
+        }
+    }
+
+private:
+    std::shared_ptr<MockInferenceEngine> engine_;
+    sar_atr::ClassId tag_class_;
+
+    void tag(sar_atr::DetectionList& detections, const std::string& path) const {
+        if (detections.empty()) {
+            sar_atr::DetectionResult& detection = detections.emplace_back();
+            detection.class_id = tag_class_;
+            detection.bounding_box = {0.4f, 0.4f, 0.6f, 0.6f};
+        }
+        // Top score: neither the confidence threshold nor NMS may drop the tag
+        detections.front().confidence = 1.0f;
+        detections.front().output_file_path.assign(path);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Result tracking (runs on the broker's connection threads)
+
+class ResultTracker {
+public:
+    void expect(const std::string& path, Clock::time_point scheduled) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outstanding_[path].push_back(scheduled);
+        ++pending_;
+    }
+
+    void onSend(size_t connection, std::string_view destination, std::string_view body) {
+        // All messages of one image arrive as one contiguous batch on one
+        // connection: the tagged ProductLocation first, the AtrProcessingResult last
+        if (destination == "/topic/ProductLocation_uci") {
+            std::string_view address;
+            if (sar_atr::findFileLocationAddress(body, address)) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::string& current = current_[connection];
+                if (current.empty() && outstanding_.count(std::string(address)) > 0) {
+                    current = std::string(address);
+                }
+            }
+        } else if (destination == "/topic/AtrProcessingResult_uci") {
+            Clock::time_point now = Clock::now();
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::string& current = current_[connection];
+            auto it = outstanding_.find(current);
+            current.clear();
+            if (it == outstanding_.end() || it->second.empty()) {
+                ++unmatched_;
+                return;
+            }
+            if (recording_) {
+                latencies_.record(now - it->second.front());
+            }
+            // Sends are scheduled in arrival order, so an earlier schedule finishing later is a reorder
+            if (it->second.front() < last_completed_) {
+                ++reordered_;
+            } else {
+                last_completed_ = it->second.front();
+            }
+            it->second.pop_front();
+            if (it->second.empty()) {
+                outstanding_.erase(it);
+            }
+            --pending_;
+            ++completed_;
+            done_cv_.notify_all();
+        }
+    }
+
+    bool waitForAll(std::chrono::seconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return done_cv_.wait_for(lock, timeout, [this]() { return pending_ == 0; });
+    }
+
+    void startRecording() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        recording_ = true;
+        completed_ = 0;
+        reordered_ = 0;
+    }
+
+    size_t completed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return completed_;
+    }
+
+    size_t pending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_;
+    }
+
+    size_t unmatched() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return unmatched_;
+    }
+
+    size_t reordered() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reordered_;
+    }
+
+    sar_atr::LatencyHistogram::Snapshot latencies() const { return latencies_.snapshot(); }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable done_cv_;
+    std::unordered_map<std::string, std::deque<Clock::time_point>> outstanding_;
+    std::unordered_map<size_t, std::string> current_;  ///< Image whose batch is in progress, per connection
+    size_t pending_ = 0;
+    size_t completed_ = 0;
+    size_t unmatched_ = 0;
+    size_t reordered_ = 0;
+    Clock::time_point last_completed_;
+    bool recording_ = false;
+    sar_atr::LatencyHistogram latencies_;
+};
+
+// ---------------------------------------------------------------------------
+// Service setup
+
+std::string writeConfig(const Options& options, const std::string& broker_address) {
+    char path[] = "/tmp/bench_pipeline_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create temporary config file");
+    }
+    close(fd);
+
+    std::ofstream out(path);
+    out << "broker_address: \"" << broker_address << "\"\n"
+        << "confidence_threshold: " << options.confidence_threshold << "\n"
+        << "log_level: \"" << options.log_level << "\"\n"
+        << "worker_threads: " << options.workers << "\n"
+        << "job_queue_capacity: " << options.queue_capacity << "\n"
+        << "enqueue_timeout_ms: 5000\n"
+        << "queue_slo_ms: " << options.queue_slo_ms << "\n"
+        << "overload_action: \"shed\"\n"
+        << "inference_batch_size: " << options.batch_size << "\n"
+        << "inference_batch_wait_ms: " << options.batch_wait_ms << "\n"
+        << "publish_connections: " << options.connections << "\n"
+        << "publish_shard_by: \"image\"\n"
+        << "parse_threads: " << options.parse_threads << "\n"
+        << "serialize_threads: " << options.serialize_threads << "\n"
+        << "publish_threads: " << options.publish_threads << "\n"
+        << "ordered_output: " << (options.ordered ? "true" : "false") << "\n"
+        << "result_cache_enabled: false\n"
+        << "tiling_enabled: false\n"
+        << "chip_extraction_enabled: false\n"
+        << "metrics_enabled: false\n";
+    return path;
+}
+
+struct Report {
+    double seconds = 0;
+    size_t sent = 0;
+    size_t completed = 0;
+    size_t lost = 0;
+    size_t unmatched = 0;
+    size_t reordered = 0;
+    unsigned long long allocations = 0;
+    unsigned long long allocated_bytes = 0;
+    sar_atr::LatencyHistogram::Snapshot latency;
+};
+
+void printReport(const Options& options, const Report& report) {
+    auto ms = [&](double quantile) {
+        return static_cast<double>(report.latency.valueAtQuantile(quantile)) / 1e6;
+    };
+    double mean_ms = report.latency.count > 0
+        ? static_cast<double>(report.latency.sum_nanos) / 1e6 / static_cast<double>(report.latency.count)
+        : 0.0;
+    double throughput = report.seconds > 0 ? static_cast<double>(report.completed) / report.seconds : 0.0;
+    double per_message = report.completed > 0 ? static_cast<double>(report.completed) : 1.0;
+
+    char buffer[2048];
+    if (options.format == "json") {
+        std::snprintf(buffer, sizeof(buffer),
+                      "{\"benchmark\":\"pipeline\",\"rate\":%.1f,\"workers\":%d,\"batch_size\":%d,\"connections\":%d,"
+                      "\"ordered\":%s,"
+                      "\"latency_model\":\"%s\",\"min_latency_ms\":%.3f,\"max_latency_ms\":%.3f,"
+                      "\"sent\":%zu,\"completed\":%zu,\"lost\":%zu,\"unmatched\":%zu,\"reordered\":%zu,\"seconds\":%.3f,"
+                      "\"throughput_per_s\":%.2f,\"latency_ms\":{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,"
+                      "\"p99\":%.3f,\"p999\":%.3f,\"max\":%.3f},"
+                      "\"allocations_per_message\":%.1f,\"allocated_bytes_per_message\":%.0f}\n",
+                      options.rate, options.workers, options.batch_size, options.connections,
+                      options.ordered ? "true" : "false",
+                      options.latency.c_str(), options.min_latency_ms, options.max_latency_ms, report.sent,
+                      report.completed, report.lost, report.unmatched, report.reordered, report.seconds, throughput, mean_ms, ms(0.5), ms(0.9),
+                      ms(0.99), ms(0.999), ms(1.0), static_cast<double>(report.allocations) / per_message,
+                      static_cast<double>(report.allocated_bytes) / per_message);
+    } else {
+        std::snprintf(buffer, sizeof(buffer),
+                      "Pipeline benchmark: %zu messages at %.0f/s, %d worker(s), batch %d, %d connection(s), "
+                      "%s output, %s engine %.1f-%.1f ms\n"
+                      "  completed     %zu (lost %zu, unmatched %zu, reordered %zu) in %.2f s\n"
+                      "  throughput    %.1f images/s\n"
+                      "  latency ms    mean %.2f  p50 %.2f  p90 %.2f  p99 %.2f  p999 %.2f  max %.2f\n"
+                      "  allocations   %.1f per message (%.0f bytes)\n",
+                      report.sent, options.rate, options.workers, options.batch_size, options.connections,
+                      options.ordered ? "ordered" : "unordered", options.latency.c_str(),
+                      options.min_latency_ms, options.max_latency_ms, report.completed, report.lost,
+                      report.unmatched, report.reordered, report.seconds, throughput, mean_ms, ms(0.5), ms(0.9), ms(0.99),
+                      ms(0.999), ms(1.0), static_cast<double>(report.allocations) / per_message,
+                      static_cast<double>(report.allocated_bytes) / per_message);
+    }
+    std::fputs(buffer, stdout);
+}
+
+/// Send bodies [begin, end) on a fixed schedule starting now
+void sendPaced(sar_atr::bench::LoopbackBroker& broker, ResultTracker& tracker, const Workload& workload,
+               size_t begin, size_t end, double rate) {
+    Clock::time_point start = Clock::now();
+    for (size_t i = begin; i < end; ++i) {
+        Clock::time_point scheduled = start;
+        if (rate > 0) {
+            scheduled += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(i - begin) / rate));
+            std::this_thread::sleep_until(scheduled);
+        } else {
+            scheduled = Clock::now();
+        }
+        tracker.expect(workload.paths[i], scheduled);
+        if (!broker.deliver("FileLocation_uci", workload.bodies[i])) {
+            throw std::runtime_error("Broker lost the service connection");
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    t_harness_thread = true;
+
+    try {
+        Options options = parseOptions(argc, argv);
+        Workload workload = loadWorkload(options);
+
+        ResultTracker tracker;
+        sar_atr::bench::LoopbackBroker broker(
+            [&tracker](size_t connection, std::string_view destination, std::string_view body) {
+                t_harness_thread = true;
+                tracker.onSend(connection, destination, body);
+            });
+        broker.start();
+
+        // Keep stdout clean for the report (the config summary logs at INFO)
+        sar_atr::Logger::setLevel(sar_atr::parseLogLevel(options.log_level));
+        std::string config_path = writeConfig(options, broker.address());
+        sar_atr::ServiceConfig config = sar_atr::ConfigManager::loadConfig(config_path);
+        std::remove(config_path.c_str());
+        sar_atr::Logger::start();
+
+        MockInferenceEngine::LatencyModel latency;
+        latency.min_overhead_ms = options.min_latency_ms;
+        latency.max_overhead_ms = options.max_latency_ms;
+        latency.per_image_ms = options.per_image_ms;
+        latency.distribution = parseDistribution(options.latency);
+        MockInferenceEngine::DetectionModel detection_model;
+        detection_model.min_detections = options.min_detections;
+        detection_model.max_detections = options.max_detections;
+
+        auto engine = std::make_shared<TaggingEngine>(
+            std::make_shared<MockInferenceEngine>(latency, detection_model));
+
+        sar_atr::SarAtrService service(config, engine);
+        std::thread service_thread([&service]() {
+            service.start();
+        });
+
+        if (!broker.waitForSubscription("FileLocation_uci", std::chrono::seconds(10))) {
+            service.stop();
+            service_thread.join();
+            throw std::runtime_error("Service did not subscribe to FileLocation_uci");
+        }
+
+        size_t warmup = static_cast<size_t>(options.warmup);
+        sendPaced(broker, tracker, workload, 0, warmup, options.rate);
+        tracker.waitForAll(std::chrono::seconds(options.timeout_s));
+
+        tracker.startRecording();
+        g_allocations = 0;
+        g_allocated_bytes = 0;
+        Clock::time_point start = Clock::now();
+
+        sendPaced(broker, tracker, workload, warmup, workload.bodies.size(), options.rate);
+        tracker.waitForAll(std::chrono::seconds(options.timeout_s));
+
+        Report report;
+        report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        report.allocations = g_allocations.load();
+        report.allocated_bytes = g_allocated_bytes.load();
+        report.sent = static_cast<size_t>(options.messages);
+        report.completed = tracker.completed();
+        report.lost = tracker.pending();
+        report.unmatched = tracker.unmatched();
+        report.reordered = tracker.reordered();
+        report.latency = tracker.latencies();
+
+        service.stop();
+        service_thread.join();
+        broker.stop();
+        sar_atr::Logger::shutdown();
+
+        printReport(options, report);
+        return report.lost == 0 ? 0 : 2;
+
+    } catch (const std::exception& e) {
+        sar_atr::Logger::shutdown();
+        std::cerr << "bench_pipeline: " << e.what() << std::endl;
+        return 1;
+    }
+}
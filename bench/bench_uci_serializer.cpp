@@ -0,0 +1,154 @@
+/**
+ * @file bench_uci_serializer.cpp
+ * @brief Compares template-based UCI serialization against per-message Json::Value trees
+ *
+ * Run: ./bench/bench_uci_serializer [--benchmark_format=json]
+ */
+
+#include "image_arena.h"
+#include "uci_serializer.h"
+#include <benchmark/benchmark.h>
+#include <json/json.h>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace {
+
+using sar_atr::DetectionResult;
+using sar_atr::SystemInfo;
+
+const SystemInfo kSystemInfo{"7f3c2a10-8d4e-4b6f-9a21-3c5d7e9f1b2a", "SAR ATR Service", "1.0.0"};
+const std::string kUuid = "0d642701-f06f-4364-951c-31c4412dbb6c";
+const std::string kTimestamp = "2026-10-14T14:49:34.631Z";
+
+DetectionResult makeDetection() {
+    DetectionResult detection;
+    detection.setClassification("T-72");
+    detection.confidence = 0.87f;
+    detection.bounding_box = {0.1234f, 0.2345f, 0.3456f, 0.4567f};
+    detection.output_file_path = "/data/sar_atr/chips/SAR_0412_0007_16384x16384_42.ntf";
+    return detection;
+}
+
+void appendLegacyHeader(Json::Value& header) {
+    header["SystemID"]["UUID"] = kSystemInfo.system_uuid;
+    header["SystemID"]["DescriptiveLabel"] = kSystemInfo.system_description;
+    header["Timestamp"] = kTimestamp;
+    header["SchemaVersion"] = "002.3";
+    header["Mode"] = "SIMULATION";
+    header["ServiceID"]["UUID"] = kSystemInfo.system_uuid;
+    header["ServiceID"]["DescriptiveLabel"] = kSystemInfo.system_description;
+    header["ServiceID"]["ServiceVersion"] = kSystemInfo.service_version;
+}
+
+// Original createEntityMessage with the UUID/timestamp fixed, so only JSON building is measured
+std::string legacyEntityMessage(const DetectionResult& detection) {
+    Json::Value root;
+    Json::Value& entity = root["Entity"];
+    entity["@xmlns"] = "namespace";
+    entity["SecurityInformation"];
+    appendLegacyHeader(entity["MessageHeader"]);
+
+    Json::Value& data = entity["MessageData"];
+    data["EntityID"]["UUID"] = kUuid;
+    data["CreationTimestamp"] = kTimestamp;
+    data["Identity"]["Platform"]["ThreatType"] = std::string(detection.classification());
+
+    Json::Value& rectangle = data["Kinematics"]["Position"]["Zone"]["Shape"]["Rectangle"];
+    rectangle["Width"] = detection.bounding_box.width();
+    rectangle["Height"] = detection.bounding_box.height();
+    Json::Value& relative_offset = rectangle["CenterPositionChoice"]["RelativePoint"]["RelativeOffset"];
+    relative_offset["X"] = detection.bounding_box.centerX();
+    relative_offset["Y"] = detection.bounding_box.centerY();
+
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    return Json::writeString(writer, root);
+}
+
+std::string legacyProductLocationMessage(std::string_view path) {
+    Json::Value root;
+    Json::Value& file_location = root["FileLocation"];
+    file_location["@xmlns"] = "namespace";
+    file_location["SecurityInformation"];
+    appendLegacyHeader(file_location["MessageHeader"]);
+
+    Json::Value& data = file_location["MessageData"];
+    data["ProductMetadataID"]["UUID"] = kUuid;
+    data["LocationAndStatus"]["Location"]["Network"]["Address"] = Json::Value(path.data(), path.data() + path.size());
+
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    return Json::writeString(writer, root);
+}
+
+void BM_EntityLegacyDom(benchmark::State& state) {
+    DetectionResult detection = makeDetection();
+    for (auto _ : state) {
+        std::string message = legacyEntityMessage(detection);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_EntityTemplate(benchmark::State& state) {
+    sar_atr::UciSerializer serializer(kSystemInfo);
+    DetectionResult detection = makeDetection();
+    for (auto _ : state) {
+        std::string message;
+        serializer.appendEntity(message, detection, kUuid, kTimestamp);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_EntityTemplateReusedBuffer(benchmark::State& state) {
+    sar_atr::UciSerializer serializer(kSystemInfo);
+    DetectionResult detection = makeDetection();
+    std::string message;
+    for (auto _ : state) {
+        message.clear();
+        serializer.appendEntity(message, detection, kUuid, kTimestamp);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_EntityTemplateArena(benchmark::State& state) {
+    sar_atr::UciSerializer serializer(kSystemInfo);
+    DetectionResult detection = makeDetection();
+    sar_atr::ImageArena arena;
+    for (auto _ : state) {
+        std::pmr::string message(&arena);
+        serializer.appendEntity(message, detection, kUuid, kTimestamp);
+        benchmark::DoNotOptimize(message.data());
+        arena.reset();
+    }
+}
+
+void BM_ProductLocationLegacyDom(benchmark::State& state) {
+    DetectionResult detection = makeDetection();
+    for (auto _ : state) {
+        std::string message = legacyProductLocationMessage(detection.output_file_path);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+void BM_ProductLocationTemplate(benchmark::State& state) {
+    sar_atr::UciSerializer serializer(kSystemInfo);
+    DetectionResult detection = makeDetection();
+    for (auto _ : state) {
+        std::string message;
+        serializer.appendProductLocation(message, kUuid, detection.output_file_path, kTimestamp);
+        benchmark::DoNotOptimize(message.data());
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_EntityLegacyDom);
+BENCHMARK(BM_EntityTemplate);
+BENCHMARK(BM_EntityTemplateReusedBuffer);
+BENCHMARK(BM_EntityTemplateArena);
+BENCHMARK(BM_ProductLocationLegacyDom);
+BENCHMARK(BM_ProductLocationTemplate);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+/**
+ * @file bench_websocket_mask.cpp
+ * @brief Compares WebSocket frame masking against the original byte loop
+ *
+ * Run: ./bench/bench_websocket_mask [--benchmark_format=json]
+ */
+
+#include "websocket_frame.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace {
+
+// Original AMQClient::createWebSocketFrame: byte-at-a-time masking with a
+// static key, appending to a growing string
+std::string legacyCreateWebSocketFrame(const std::string& data) {
+    std::string frame;
+    frame += static_cast<char>(0x81);
+
+    size_t len = data.length();
+    if (len <= 125) {
+        frame += static_cast<char>(0x80 | len);
+    } else if (len <= 65535) {
+        frame += static_cast<char>(0x80 | 126);
+        frame += static_cast<char>((len >> 8) & 0xFF);
+        frame += static_cast<char>(len & 0xFF);
+    } else {
+        frame += static_cast<char>(0x80 | 127);
+        for (int i = 7; i >= 0; i--) {
+            frame += static_cast<char>((len >> (i * 8)) & 0xFF);
+        }
+    }
+
+    unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    frame.append(reinterpret_cast<char*>(mask), 4);
+
+    for (size_t i = 0; i < len; i++) {
+        frame += static_cast<char>(data[i] ^ mask[i % 4]);
+    }
+
+    return frame;
+}
+
+std::string makePayload(size_t size) {
+    std::string payload(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = static_cast<char>('a' + (i % 26));
+    }
+    return payload;
+}
+
+void BM_MaskLegacyLoop(benchmark::State& state) {
+    std::string payload = makePayload(static_cast<size_t>(state.range(0)));
+    std::string out(payload.size(), '\0');
+    const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    for (auto _ : state) {
+        for (size_t i = 0; i < payload.size(); i++) {
+            out[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_MaskVectorized(benchmark::State& state) {
+    std::string payload = makePayload(static_cast<size_t>(state.range(0)));
+    std::string out(payload.size(), '\0');
+    const unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    for (auto _ : state) {
+        sar_atr::maskWebSocketPayload(payload.data(), &out[0], payload.size(), mask);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_FrameLegacy(benchmark::State& state) {
+    std::string payload = makePayload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string frame = legacyCreateWebSocketFrame(payload);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_FramePresized(benchmark::State& state) {
+    std::string payload = makePayload(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string frame;
+        frame.reserve(sar_atr::webSocketHeaderSize(payload.size()) + payload.size());
+        sar_atr::appendWebSocketFrame(payload, sar_atr::WebSocketOpcode::TEXT, frame);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Typical STOMP control frames up to chip-carrying ProductLocation payloads
+#define PAYLOAD_SIZES ->RangeMultiplier(4)->Range(16, 1 << 20)
+
+BENCHMARK(BM_MaskLegacyLoop) PAYLOAD_SIZES;
+BENCHMARK(BM_MaskVectorized) PAYLOAD_SIZES;
+BENCHMARK(BM_FrameLegacy) PAYLOAD_SIZES;
+BENCHMARK(BM_FramePresized) PAYLOAD_SIZES;
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,365 @@
+#include "loopback_broker.h"
+#include "stomp_frame.h"
+#include "websocket_frame.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace sar_atr {
+namespace bench {
+
+namespace {
+
+bool sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+LoopbackBroker::LoopbackBroker(SendHandler on_send)
+    : on_send_(std::move(on_send)), listen_fd_(-1), port_(0), running_(false), message_id_(0) {
+}
+
+LoopbackBroker::~LoopbackBroker() {
+    stop();
+}
+
+void LoopbackBroker::start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error("Failed to create broker socket");
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listen_fd_, 16) < 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        throw std::runtime_error("Failed to listen for broker connections: " + std::string(std::strerror(errno)));
+    }
+
+    socklen_t length = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &length);
+    port_ = ntohs(addr.sin_port);
+
+    running_ = true;
+    thread_ = std::thread([this]() {
+        serveLoop();
+    });
+}
+
+void LoopbackBroker::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    dropConnection();
+
+    std::vector<std::shared_ptr<Client>> clients;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients.swap(clients_);
+    }
+    for (auto& client : clients) {
+        if (client->thread.joinable()) {
+            client->thread.join();
+        }
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+std::string LoopbackBroker::address() const {
+    return "ws://127.0.0.1:" + std::to_string(port_) + "/";
+}
+
+bool LoopbackBroker::waitForSubscription(const std::string& topic, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return subscribed_cv_.wait_for(lock, timeout, [this, &topic]() {
+        return subscribers_.count(topic) > 0;
+    });
+}
+
+bool LoopbackBroker::deliver(const std::string& topic, std::string_view body) {
+    std::shared_ptr<Client> client;
+    std::string frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscribers_.find(topic);
+        if (it == subscribers_.end()) {
+            return false;
+        }
+        client = it->second.client;
+        frame.reserve(body.size() + 160);
+        frame += "MESSAGE\ndestination:/topic/";
+        frame += topic;
+        frame += "\nsubscription:";
+        frame += it->second.id;
+        frame += "\nmessage-id:";
+        frame += std::to_string(++message_id_);
+        frame += "\ncontent-type:application/json\ncontent-length:";
+        frame += std::to_string(body.size());
+        frame += "\n\n";
+        frame.append(body.data(), body.size());
+        frame += '\0';
+    }
+    return writeFrame(*client, frame);
+}
+
+void LoopbackBroker::dropConnection() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& client : clients_) {
+        std::lock_guard<std::mutex> write_lock(client->write_mutex);
+        if (client->fd >= 0) {
+            shutdown(client->fd, SHUT_RDWR);
+        }
+    }
+}
+
+size_t LoopbackBroker::connectionCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (auto& client : clients_) {
+        std::lock_guard<std::mutex> write_lock(client->write_mutex);
+        count += client->fd >= 0 ? 1 : 0;
+    }
+    return count;
+}
+
+void LoopbackBroker::serveLoop() {
+    size_t next_index = 0;
+    while (running_) {
+        struct pollfd pfd;
+        pfd.fd = listen_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        auto client = std::make_shared<Client>();
+        client->index = next_index++;
+        client->fd = fd;
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.push_back(client);
+        client->thread = std::thread([this, client]() {
+            serveClient(client);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+                    it = it->second.client == client ? subscribers_.erase(it) : std::next(it);
+                }
+            }
+            // Writers in deliver() may still hold the descriptor
+            std::lock_guard<std::mutex> write_lock(client->write_mutex);
+            close(client->fd);
+            client->fd = -1;
+        });
+    }
+}
+
+void LoopbackBroker::serveClient(const std::shared_ptr<Client>& client) {
+    // The descriptor only changes when this thread closes it
+    const int fd = client->fd;
+
+    // HTTP upgrade: accept whatever the client asks for
+    std::string request;
+    char chunk[4096];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return;
+        }
+        request.append(chunk, static_cast<size_t>(received));
+    }
+    static const char kUpgrade[] =
+        "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Protocol: stomp\r\n\r\n";
+    if (!sendAll(fd, kUpgrade, sizeof(kUpgrade) - 1)) {
+        return;
+    }
+
+    ReceiveBuffer buffer;
+    size_t leftover = request.size() - (request.find("\r\n\r\n") + 4);
+    if (leftover > 0) {
+        std::memcpy(buffer.prepareWrite(leftover), request.data() + request.size() - leftover, leftover);
+        buffer.commitWrite(leftover);
+    }
+
+    std::string fragments;
+    while (running_) {
+        try {
+            while (buffer.readableSize() > 0) {
+                WebSocketFrame frame;
+                size_t consumed = parseWebSocketFrame(buffer.readableData(), buffer.readableSize(), frame);
+                if (consumed == 0) {
+                    break;
+                }
+
+                bool keep_going = true;
+                switch (frame.opcode) {
+                    case WebSocketOpcode::PING: {
+                        std::string pong;
+                        pong += static_cast<char>(0x80 | static_cast<uint8_t>(WebSocketOpcode::PONG));
+                        pong += static_cast<char>(frame.payload.size());
+                        pong.append(frame.payload.data(), frame.payload.size());
+                        std::lock_guard<std::mutex> lock(client->write_mutex);
+                        sendAll(fd, pong.data(), pong.size());
+                        break;
+                    }
+                    case WebSocketOpcode::CLOSE:
+                        keep_going = false;
+                        break;
+                    case WebSocketOpcode::TEXT:
+                    case WebSocketOpcode::BINARY:
+                    case WebSocketOpcode::CONTINUATION:
+                        fragments.append(frame.payload.data(), frame.payload.size());
+                        if (frame.fin) {
+                            keep_going = handleStompFrame(client, fragments);
+                            fragments.clear();
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                buffer.consume(consumed);
+                if (!keep_going) {
+                    return;
+                }
+            }
+        } catch (const std::exception&) {
+            return;
+        }
+
+        char* write_ptr = buffer.prepareWrite(64 * 1024);
+        ssize_t received = recv(fd, write_ptr, buffer.writableSize(), 0);
+        if (received <= 0) {
+            return;
+        }
+        buffer.commitWrite(static_cast<size_t>(received));
+    }
+}
+
+bool LoopbackBroker::handleStompFrame(const std::shared_ptr<Client>& client, std::string_view data) {
+    StompFrame frame;
+    try {
+        if (!parseStompFrame(data, frame)) {
+            return true;    // heart-beat
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    std::string_view receipt = frame.header("receipt");
+
+    if (frame.command == "CONNECT" || frame.command == "STOMP") {
+        static const std::string kConnected = std::string("CONNECTED\nversion:1.2\nheart-beat:0,0\n\n") + '\0';
+        writeFrame(*client, kConnected);
+    } else if (frame.command == "SUBSCRIBE") {
+        std::string_view destination = frame.header("destination");
+        const std::string_view prefix = "/topic/";
+        if (destination.compare(0, prefix.size(), prefix) == 0) {
+            destination.remove_prefix(prefix.size());
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            subscribers_[std::string(destination)] = Subscriber{client, std::string(frame.header("id"))};
+        }
+        subscribed_cv_.notify_all();
+    } else if (frame.command == "UNSUBSCRIBE") {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it) {
+            if (it->second.client == client && it->second.id == frame.header("id")) {
+                subscribers_.erase(it);
+                break;
+            }
+        }
+    } else if (frame.command == "SEND") {
+        if (on_send_) {
+            on_send_(client->index, frame.header("destination"), frame.body);
+        }
+    } else if (frame.command == "DISCONNECT") {
+        writeReceipt(*client, receipt);
+        return false;
+    }
+
+    writeReceipt(*client, receipt);
+    return true;
+}
+
+void LoopbackBroker::writeReceipt(Client& client, std::string_view receipt) {
+    if (receipt.empty()) {
+        return;
+    }
+    // The client asks for one per publish batch; keep the frame off the heap
+    thread_local std::string frame;
+    frame.assign("RECEIPT\nreceipt-id:");
+    frame.append(receipt.data(), receipt.size());
+    frame.append("\n\n");
+    frame.push_back('\0');
+    writeFrame(client, frame);
+}
+
+bool LoopbackBroker::writeFrame(Client& client, std::string_view payload) {
+    std::lock_guard<std::mutex> lock(client.write_mutex);
+    return client.fd >= 0 && writeFrameLocked(client.fd, payload);
+}
+bool LoopbackBroker::writeFrameLocked(int fd, std::string_view payload) {
+    // Server frames are never masked
+    char header[10];
+    size_t header_length;
+    header[0] = static_cast<char>(0x80 | static_cast<uint8_t>(WebSocketOpcode::TEXT));
+    if (payload.size() <= 125) {
+        header[1] = static_cast<char>(payload.size());
+        header_length = 2;
+    } else if (payload.size() <= 0xFFFF) {
+        header[1] = 126;
+        header[2] = static_cast<char>((payload.size() >> 8) & 0xFF);
+        header[3] = static_cast<char>(payload.size() & 0xFF);
+        header_length = 4;
+    } else {
+        header[1] = 127;
+        for (int i = 0; i < 8; ++i) {
+            header[2 + i] = static_cast<char>((static_cast<uint64_t>(payload.size()) >> (56 - 8 * i)) & 0xFF);
+        }
+        header_length = 10;
+    }
+
+    return sendAll(fd, header, header_length) && sendAll(fd, payload.data(), payload.size());
+}
+
+} // namespace bench
+} // namespace sar_atr
@@ -0,0 +1,108 @@
+#ifndef LOOPBACK_BROKER_H
+#define LOOPBACK_BROKER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace sar_atr {
+namespace bench {
+
+/**
+ * @class LoopbackBroker
+ * @brief In-process STOMP-over-WebSocket broker for driving AMQClient on 127.0.0.1
+ *
+ * Speaks just enough of the protocol for the service: the HTTP upgrade,
+ * CONNECT/CONNECTED, SUBSCRIBE, SEND (handed to a callback), RECEIPT and DISCONNECT.
+ * Every connection gets its own thread, so a pool of client connections
+ * can be served at once; dropped clients may reconnect.
+ */
+class LoopbackBroker {
+public:
+    /// Called on the connection's thread for every SEND frame; connections are numbered in accept order
+    typedef std::function<void(size_t connection, std::string_view destination, std::string_view body)>
+        SendHandler;
+
+    explicit LoopbackBroker(SendHandler on_send);
+    ~LoopbackBroker();
+
+    LoopbackBroker(const LoopbackBroker&) = delete;
+    LoopbackBroker& operator=(const LoopbackBroker&) = delete;
+
+    /**
+     * @brief Listen on an ephemeral loopback port and start the broker thread
+     * @throws std::runtime_error if the socket cannot be set up
+     */
+    void start();
+
+    void stop();
+
+    /// ws:// address to hand to AMQClient::connect()
+    std::string address() const;
+
+    /**
+     * @brief Wait until some client has subscribed to a topic
+     */
+    bool waitForSubscription(const std::string& topic, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Send a MESSAGE frame to the subscriber of a topic (thread-safe)
+     * @return false if there is no subscriber or the write failed
+     */
+    bool deliver(const std::string& topic, std::string_view body);
+
+    /**
+     * @brief Drop every client connection (the broker keeps listening)
+     */
+    void dropConnection();
+
+    /**
+     * @brief Number of clients currently connected
+     */
+    size_t connectionCount();
+
+private:
+    struct Client {
+        size_t index;
+        int fd;                     ///< -1 once closed; guarded by write_mutex
+        std::mutex write_mutex;     ///< Serializes writes; never held while taking the broker mutex
+        std::thread thread;
+    };
+
+    struct Subscriber {
+        std::shared_ptr<Client> client;
+        std::string id;
+    };
+
+    SendHandler on_send_;
+    int listen_fd_;
+    int port_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable subscribed_cv_;
+    std::vector<std::shared_ptr<Client>> clients_;
+    std::map<std::string, Subscriber> subscribers_;     ///< By topic; the latest SUBSCRIBE wins
+    unsigned long long message_id_;
+
+    void serveLoop();
+    void serveClient(const std::shared_ptr<Client>& client);
+    bool handleStompFrame(const std::shared_ptr<Client>& client, std::string_view frame);
+    static void writeReceipt(Client& client, std::string_view receipt);
+    static bool writeFrame(Client& client, std::string_view payload);
+    static bool writeFrameLocked(int fd, std::string_view payload);
+};
+
+} // namespace bench
+} // namespace sar_atr
+
+#endif // LOOPBACK_BROKER_H
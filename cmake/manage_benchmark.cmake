@@ -0,0 +1,36 @@
+set(BENCHMARK_VERSION 1.7.1)
+message(STATUS "MANAGING DEPENDENCY: Google Benchmark (Version ${BENCHMARK_VERSION})\n")
+
+# Try the system/installed package first
+find_package(benchmark QUIET)
+
+if(NOT benchmark_FOUND)
+    message(STATUS "--> Unable to Find Google Benchmark - Building from Source\n")
+
+    include(FetchContent)
+
+    # Configure benchmark build options BEFORE declaring
+    set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "Build benchmark tests" FORCE)
+    set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "Build benchmark gtest tests" FORCE)
+    set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "Install benchmark" FORCE)
+
+    FetchContent_Declare(
+        benchmark
+        GIT_REPOSITORY https://github.com/google/benchmark.git
+        GIT_TAG v${BENCHMARK_VERSION}
+        GIT_SHALLOW TRUE
+    )
+
+    FetchContent_MakeAvailable(benchmark)
+else()
+    message(STATUS "--> Found Google Benchmark\n")
+endif()
+
+# benchmark creates benchmark::benchmark either way; make sure the alias exists
+if(NOT TARGET benchmark::benchmark)
+    if(TARGET benchmark)
+        add_library(benchmark::benchmark ALIAS benchmark)
+    else()
+        message(FATAL_ERROR "Could not find a Google Benchmark target")
+    endif()
+endif()
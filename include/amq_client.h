@@ -1,50 +1,237 @@
 #ifndef AMQ_CLIENT_H
 #define AMQ_CLIENT_H
 
+#include "event_loop.h"
+#include "metrics.h"
+#include "stomp_frame.h"
+#include "websocket_frame.h"
+#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
-#include <queue>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/uio.h>
 
 namespace sar_atr {
 
-typedef std::function<void(const std::string&)> MessageCallback;
+/**
+ * @brief Callback for STOMP MESSAGE bodies
+ *
+ * The body is a view into the client's receive buffer and is only valid for
+ * the duration of the call; copy it if it must outlive the callback.
+ */
+typedef std::function<void(std::string_view)> MessageCallback;
+
+/**
+ * @brief Runs a task on another thread, e.g. by submitting it to a ThreadPool
+ *
+ * Subscriptions with an executor get their own copy of each body, so the
+ * callback may take as long as it likes without holding up the connection.
+ */
+typedef std::function<void(std::function<void()>)> MessageExecutor;
+
+/**
+ * @struct OutboundMessage
+ * @brief One message of a publish batch
+ *
+ * Allocator-aware so a batch built in an image arena keeps its bodies there.
+ * The topic is only a view: it must stay valid until publishBatch() returns
+ * (topics are normally string literals).
+ */
+struct OutboundMessage {
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    std::string_view topic;   ///< Topic name to publish to
+    std::pmr::string body;    ///< Message content
+
+    OutboundMessage() = default;
+    explicit OutboundMessage(const allocator_type& alloc) : body(alloc) {}
+    OutboundMessage(std::string_view topic_name, std::string_view content,
+                    const allocator_type& alloc = allocator_type())
+        : topic(topic_name), body(content, alloc) {}
+    OutboundMessage(std::string_view topic_name, std::pmr::string&& content,
+                    const allocator_type& alloc = allocator_type())
+        : topic(topic_name), body(std::move(content), alloc) {}
+    OutboundMessage(const OutboundMessage& other, const allocator_type& alloc)
+        : topic(other.topic), body(other.body, alloc) {}
+    OutboundMessage(OutboundMessage&& other, const allocator_type& alloc)
+        : topic(other.topic), body(std::move(other.body), alloc) {}
+    OutboundMessage(const OutboundMessage&) = default;
+    OutboundMessage(OutboundMessage&&) = default;
+    OutboundMessage& operator=(const OutboundMessage&) = default;
+    OutboundMessage& operator=(OutboundMessage&&) = default;
+};
+
+/**
+ * @brief Messages published together, in order
+ */
+using OutboundBatch = std::pmr::vector<OutboundMessage>;
+
+/**
+ * @struct SendOptions
+ * @brief Tuning for the asynchronous send queue
+ */
+struct SendOptions {
+    size_t high_water_bytes = 8 * 1024 * 1024;                  ///< Publishers block above this many queued bytes
+    std::chrono::milliseconds block_timeout{5000};              ///< Longest a publisher waits for queue space
+    std::chrono::milliseconds flush_timeout{5000};              ///< Longest disconnect() waits for the queue to drain
+    std::chrono::microseconds linger{0};                        ///< Writer waits this long to coalesce more frames
+    bool receipts = true;                                       ///< Track publishes until the broker's RECEIPT
+};
+
+/**
+ * @struct ConnectionOptions
+ * @brief Connection establishment and STOMP heart-beating
+ */
+struct ConnectionOptions {
+    std::chrono::milliseconds connect_timeout{10000};           ///< Longest connect() waits for CONNECTED
+    std::chrono::milliseconds heartbeat_interval{10000};        ///< Heart-beat offered both ways (0 = none)
+    bool reconnect = true;                                      ///< Re-establish a lost connection in the background
+    std::chrono::milliseconds reconnect_initial_delay{250};     ///< Backoff before the first reconnect attempt
+    std::chrono::milliseconds reconnect_max_delay{30000};       ///< Backoff cap
+};
+
+/**
+ * @brief Jittered exponential backoff before connection attempt number attempt (0-based)
+ *
+ * The delay doubles from reconnect_initial_delay up to reconnect_max_delay,
+ * and is then drawn uniformly from its upper half so that clients that lost
+ * the same broker do not all come back at the same moment.
+ */
+std::chrono::milliseconds reconnectDelay(const ConnectionOptions& options, unsigned attempt);
 
 /**
  * @class AMQClient
  * @brief WebSocket client for ActiveMQ message broker communication
  * 
- * Handles connection, subscription, and publishing to AMQ topics over WebSocket
+ * Handles connection, subscription, and publishing to AMQ topics over WebSocket.
+ * The socket is non-blocking and driven by an EventLoop: reads, queued
+ * writes, heart-beats and the connection handshake all run on the loop
+ * thread, which may be shared by several clients. Publishing is
+ * asynchronous: frames are queued and written by the loop, so callers never
+ * block on the socket unless the queue is above its high-water mark.
+ * Message callbacks run on the loop thread.
+ *
+ * Once connect() has succeeded, a lost connection (broker restart or
+ * failover, socket error, heart-beat timeout) is re-established by a
+ * background thread with jittered exponential backoff until disconnect().
+ * Subscriptions are renewed under their original ids. With
+ * SendOptions::receipts, the last frame of every publish batch asks for a
+ * RECEIPT; batches are kept until the broker acknowledges them and are
+ * written again after a reconnect, in their original order, ahead of
+ * anything published since (delivery is at least once: a batch whose
+ * receipt was lost with the connection is sent twice). Publishes made while
+ * the connection is down are queued for the new one, within the same
+ * high-water mark.
  */
 class AMQClient {
 public:
+    /// Client with its own event loop thread
     AMQClient();
+    
+    /// Client driven by a shared event loop (started on connect if needed)
+    explicit AMQClient(std::shared_ptr<EventLoop> loop);
+    
     ~AMQClient();
     
+    AMQClient(const AMQClient&) = delete;
+    AMQClient& operator=(const AMQClient&) = delete;
+    
     /**
      * @brief Connect to the AMQ broker
+     * 
+     * Returns as soon as the broker's CONNECTED frame arrives.
+     * 
      * @param broker_address WebSocket address (e.g., ws://localhost:9000)
+     * @throws std::runtime_error if the connection fails or times out
      */
     void connect(const std::string& broker_address);
     
     /**
-     * @brief Subscribe to a topic and set message callback
+     * @brief Subscribe to a topic with its own message handler
+     * 
+     * Any number of topics can share the connection; MESSAGE frames are
+     * dispatched by their subscription header.
+     * 
      * @param topic Topic name to subscribe to
      * @param callback Function to call when messages arrive
+     * @param executor Where to run the callback; empty = inline on the loop thread
+     * @return Subscription id, for unsubscribe()
+     * @throws std::runtime_error if not connected
+     */
+    std::string subscribe(const std::string& topic, MessageCallback callback,
+                          MessageExecutor executor = MessageExecutor());
+    
+    /**
+     * @brief Cancel a subscription; messages already in flight for it are dropped
+     */
+    void unsubscribe(const std::string& subscription_id);
+    
+    /**
+     * @brief Stop reading from the broker, or start again
+     * 
+     * While paused, the socket is not read once connected and no MESSAGE is
+     * dispatched (frames already buffered wait), so a slow consumer backs
+     * the broker up through TCP instead of dropping what it was sent.
+     * Receipts and heart-beats wait as well; the heart-beat timeout is
+     * suspended meanwhile. Survives reconnects. Thread-safe.
      */
-    void subscribe(const std::string& topic, MessageCallback callback);
+    void pauseReading(bool paused);
     
     /**
-     * @brief Publish a message to a topic
+     * @brief Queue a message for publishing to a topic
      * @param topic Topic name to publish to
      * @param message Message content
+     * @throws std::runtime_error if not connected or the send queue stays full
      */
     void publish(const std::string& topic, const std::string& message);
     
+    /**
+     * @brief Queue several messages to go out in one scatter-gather write
+     * 
+     * Frames are written in order and are never interleaved with frames from
+     * other publishers. Returns as soon as the batch is queued.
+     * 
+     * @param messages Messages to publish, in order
+     * @throws std::runtime_error if not connected or the send queue stays full
+     */
+    void publishBatch(const OutboundBatch& messages);
+    
+    /**
+     * @brief Configure send queue limits and coalescing (call before connect)
+     */
+    void setSendOptions(const SendOptions& options);
+    
+    /**
+     * @brief Configure connect timeout and heart-beats (call before connect)
+     */
+    void setConnectionOptions(const ConnectionOptions& options);
+    
+    /**
+     * @brief Record receive/socket-write latency and send failures here (call before connect)
+     *
+     * The metrics object must outlive the client; nullptr disables recording.
+     */
+    void setMetrics(ServiceMetrics* metrics);
+    
+    /**
+     * @brief Bytes queued, being written, or waiting for the broker's receipt
+     */
+    size_t queuedBytes() const;
+    
     /**
      * @brief Disconnect from the broker
+     * 
+     * Frames already queued are flushed (bounded by SendOptions::flush_timeout)
+     * before the socket is closed.
      */
     void disconnect();
     
@@ -54,35 +241,147 @@ public:
     bool isConnected() const;
     
     /**
-     * @brief Run the client event loop (blocking)
+     * @brief Connected, or reconnecting and queueing publishes for the new connection
+     */
+    bool acceptsPublishes() const;
+    
+    /**
+     * @brief Block until the connection is closed for good (disconnect(), or a loss without reconnect)
      */
     void run();
     
 private:
-    int socket_fd_;
+    /// Connection state machine, advanced by the loop thread
+    enum class State {
+        DISCONNECTED,
+        TCP_CONNECTING,         ///< Non-blocking connect() in progress
+        WEBSOCKET_HANDSHAKE,    ///< HTTP upgrade sent, waiting for 101
+        STOMP_CONNECTING,       ///< CONNECT sent, waiting for CONNECTED
+        CONNECTED
+    };
+    
+    std::shared_ptr<EventLoop> loop_;
+    bool owns_loop_;
+    
+    // state_ is written on the loop thread under state_mutex_; connect() and
+    // run() wait on state_cv_
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
+    State state_;
+    std::string failure_reason_;
     std::atomic<bool> connected_;
-    std::atomic<bool> running_;
-    std::thread run_thread_;
-    std::thread receive_thread_;
+    std::atomic<bool> disconnecting_;   ///< DISCONNECT sent: the broker closing the socket is expected
+    bool session_;                      ///< connect() succeeded and disconnect() has not been called
+    std::thread reconnect_thread_;      ///< Started with the session, re-establishes lost connections
     
     std::string host_;
     int port_;
     std::string path_;
+    ConnectionOptions connection_options_;
+    
+    /// Bookkeeping for one send queue entry
+    struct EntryInfo {
+        size_t frames = 1;              ///< WebSocket frames in the entry
+        bool publish = false;           ///< SEND frames, kept across a reconnect (the rest is connection-bound)
+        uint64_t receipt = 0;           ///< Receipt requested by its last frame, 0 = none
+    };
+    
+    struct Subscription {
+        std::string topic;
+        MessageCallback callback;
+        MessageExecutor executor;
+    };
+    
+    // Loop-thread state
+    int socket_fd_;
+    bool want_write_;                   ///< EPOLLOUT is part of the epoll interest
+    bool read_paused_;                  ///< pauseReading(): EPOLLIN is left out once connected
+    std::map<std::string, Subscription, std::less<>> subscriptions_;   ///< By subscription id
+    uint64_t next_subscription_;
+    ServiceMetrics* metrics_;
+    std::chrono::steady_clock::time_point last_read_at_;   ///< When the bytes being parsed arrived
+    std::chrono::steady_clock::time_point last_write_at_;
+    std::chrono::milliseconds heartbeat_send_;              ///< Negotiated; 0 = none
+    std::chrono::milliseconds heartbeat_receive_;
+    EventLoop::TimerId heartbeat_timer_;
+    EventLoop::TimerId linger_timer_;
+    
+    // Send queue: publishers append under send_mutex_, the loop swaps the
+    // whole vector out so each lock hold is short. An entry may hold several
+    // WebSocket frames (a whole publish batch); written entries go back to
+    // spare_buffers_ so their capacity is reused by the next batch.
+    SendOptions send_options_;
+    mutable std::mutex send_mutex_;
+    std::condition_variable space_cv_;          ///< Wakes publishers blocked on the high-water mark
+    std::vector<std::string> send_queue_;
+    std::vector<EntryInfo> send_queue_info_;
+    std::vector<std::string> spare_buffers_;
+    size_t queued_bytes_;
+    bool flush_posted_;                 ///< A flush task is queued on the loop
+    bool detached_;                     ///< Client is being destroyed; post nothing more
+    bool resuming_;                     ///< Connection lost with the session intact; publishes go to held_
+    std::vector<std::string> held_;     ///< Publishes waiting for the next connection, in order
+    std::vector<EntryInfo> held_info_;
+    std::atomic<uint64_t> next_receipt_;
+    
+    // Batch being written by the loop, resumed after partial writes
+    std::vector<std::string> writing_;
+    std::vector<EntryInfo> writing_info_;
+    size_t write_index_;
+    size_t write_offset_;
+    size_t writing_bytes_;
+    std::vector<struct iovec> iov_;
+    
+    // Publishes written and waiting for their RECEIPT, in write order (loop thread)
+    std::vector<std::string> unacked_;
+    std::vector<EntryInfo> unacked_info_;
+    
+    ReceiveBuffer receive_buffer_;
+    std::string fragment_buffer_;       ///< Reassembly buffer for fragmented messages
+    bool in_fragmented_message_;
+    
+    // Loop thread: connection state machine
+    void beginConnect(const struct sockaddr_in& address);
+    void onSocketEvent(uint32_t events);
+    void onTcpConnected();
+    bool processHandshakeResponse();
+    void onStompConnected(const StompFrame& frame);
+    void dispatchMessage(const StompFrame& frame);
+    void setState(State state);
+    void failConnection(const std::string& reason);
+    void closeConnection(const std::string& reason);
+    void holdForReconnectLocked();
+    void onReceipt(std::string_view receipt_id);
     
-    MessageCallback message_callback_;
+    // Connection attempts (caller's thread or the reconnect thread)
+    void openConnection(bool reconnecting);
+    void reconnectLoop();
     
-    std::mutex send_mutex_;
-    std::queue<std::string> send_queue_;
+    // Loop thread: I/O
+    void readAvailable();
+    void processFrames();
+    void flushOutput();
+    bool writeSome();
+    void setWriteInterest(bool enabled);
+    void updateInterest();
+    bool readingPaused() const { return read_paused_ && state_ == State::CONNECTED; }
+    void onFlushRequested();
+    void scheduleHeartbeat();
+    void onHeartbeatTimer();
     
-    // WebSocket functions
-    bool connectSocket(const std::string& broker_address);
-    bool performWebSocketHandshake();
-    void receiveLoop();
-    void sendFrame(const std::string& data);
-    std::string receiveFrame();
-    void parseStompMessage(const std::string& message);
-    std::string createWebSocketFrame(const std::string& data);
-    bool parseWebSocketFrame(const std::string& data, std::string& payload);
+    // Any thread
+    void queueFrame(std::string_view data, WebSocketOpcode opcode);
+    void queueRaw(std::string bytes);
+    static std::string subscribeFrame(const std::string& id, const std::string& topic);
+    void scheduleFlushLocked();
+    void sendFrame(const std::string& data, WebSocketOpcode opcode = WebSocketOpcode::TEXT);
+    void enqueueFrames(std::string& frames, const EntryInfo& info);
+    std::string takeSpareBuffer();
+    void recycleWrittenLocked();
+    void recycleBufferLocked(std::string& buffer);
+    bool handleWebSocketFrame(const WebSocketFrame& frame);
+    void parseStompMessage(std::string_view message);
+    std::string createWebSocketFrame(std::string_view data, WebSocketOpcode opcode);
 };
 
 } // namespace sar_atr
@@ -0,0 +1,117 @@
+#ifndef AMQ_CONNECTION_POOL_H
+#define AMQ_CONNECTION_POOL_H
+
+#include "amq_client.h"
+#include "event_loop.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @brief How publish traffic is spread over the pool's connections
+ */
+enum class ShardPolicy {
+    IMAGE,      ///< A whole batch (one image) goes out on one connection, in one write
+    TOPIC       ///< Each topic sticks to one connection; a batch is split by topic
+};
+
+/**
+ * @brief Parse "image" or "topic"
+ * @throws std::runtime_error for anything else
+ */
+ShardPolicy parseShardPolicy(const std::string& name);
+
+/**
+ * @class AMQConnectionPool
+ * @brief Several AMQClient connections on one event loop, with sharded publishing
+ *
+ * Connection i goes to broker address i modulo the number of addresses, so
+ * the pool can span several brokers. Subscriptions live on the first
+ * connection. Publishes pick a connection by hashing a shard key (the image
+ * for ShardPolicy::IMAGE, the topic for ShardPolicy::TOPIC), so everything
+ * sharing a key stays in order on one TCP stream while unrelated traffic
+ * runs on the others. If the chosen connection is down, the next connected
+ * one takes over; while none is up, batches queue on the chosen one until
+ * it reconnects (see AMQClient).
+ */
+class AMQConnectionPool {
+public:
+    /**
+     * @param connections Number of broker connections (at least 1)
+     * @param policy How publishes are sharded
+     */
+    AMQConnectionPool(size_t connections, ShardPolicy policy);
+    ~AMQConnectionPool();
+
+    AMQConnectionPool(const AMQConnectionPool&) = delete;
+    AMQConnectionPool& operator=(const AMQConnectionPool&) = delete;
+
+    /// Applied to every connection (call before connect)
+    void setSendOptions(const SendOptions& options);
+    void setConnectionOptions(const ConnectionOptions& options);
+    void setMetrics(ServiceMetrics* metrics);
+
+    /**
+     * @brief Open every connection
+     *
+     * All-or-nothing: if one connection fails, the ones already open are
+     * closed again and the error is rethrown.
+     *
+     * @param broker_addresses WebSocket addresses, used round-robin
+     * @throws std::runtime_error if any connection fails
+     */
+    void connect(const std::vector<std::string>& broker_addresses);
+
+    /**
+     * @brief Subscribe on the first connection (see AMQClient::subscribe)
+     *
+     * The subscription is renewed whenever that connection is re-established.
+     */
+    std::string subscribe(const std::string& topic, MessageCallback callback,
+                          MessageExecutor executor = MessageExecutor());
+
+    /**
+     * @brief Pause or resume deliveries on the subscribing connection (see AMQClient::pauseReading)
+     */
+    void pauseReading(bool paused);
+
+    /**
+     * @brief Queue a batch on the connection its shard key maps to
+     *
+     * @param shard_key Identifies the image the batch belongs to (ignored for ShardPolicy::TOPIC)
+     * @param messages Messages to publish, in order
+     * @throws std::runtime_error if no connection is up or the send queue stays full
+     */
+    void publishBatch(std::string_view shard_key, const OutboundBatch& messages);
+
+    /**
+     * @brief Bytes queued across all connections
+     */
+    size_t queuedBytes() const;
+
+    /**
+     * @brief True while the subscribing connection is up
+     */
+    bool isConnected() const;
+
+    /**
+     * @brief Flush and close every connection
+     */
+    void disconnect();
+
+    size_t size() const { return clients_.size(); }
+
+private:
+    ShardPolicy policy_;
+    std::shared_ptr<EventLoop> loop_;
+    std::vector<std::unique_ptr<AMQClient>> clients_;
+
+    void publishOn(size_t shard, const OutboundBatch& messages);
+};
+
+} // namespace sar_atr
+
+#endif // AMQ_CONNECTION_POOL_H
@@ -0,0 +1,156 @@
+#ifndef ASYNC_FILE_IO_H
+#define ASYNC_FILE_IO_H
+
+#include "buffer_pool.h"
+#include "metrics.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @struct AsyncIoOptions
+ * @brief Sizing of the asynchronous file I/O layer
+ */
+struct AsyncIoOptions {
+    bool use_io_uring = true;       ///< Fall back to threads when false or when the kernel refuses io_uring
+    unsigned queue_depth = 64;      ///< Most requests in flight (io_uring ring entries)
+    size_t buffer_count = 16;       ///< Pooled buffers (registered with the ring when it allows)
+    size_t buffer_size = 1 << 20;   ///< Bytes per pooled buffer (rounded up to 4 KiB)
+    int fallback_threads = 2;       ///< Threads running blocking pread/pwrite for the thread backend
+};
+
+/**
+ * @class AsyncFileIO
+ * @brief Positional file reads and writes that complete through callbacks
+ *
+ * read() and write() only queue a request; submit() hands everything queued
+ * so far to the backend in one call, so a caller issuing many requests pays
+ * for one system call. The completion runs with the number of bytes
+ * transferred (possibly short) or -errno, on the backend's completion thread;
+ * it must be quick and must not issue requests of its own.
+ *
+ * Two backends: io_uring, set up with raw system calls (no liburing), which
+ * keeps up to queue_depth requests in flight from a single completion thread;
+ * and a small thread pool running pread()/pwrite(), used when io_uring is
+ * disabled or unavailable. With either, a request queued while queue_depth
+ * are already in flight waits for one to complete.
+ *
+ * acquireBuffer() lends one of a fixed set of 4 KiB-aligned buffers (usable
+ * with O_DIRECT). The io_uring backend registers them with the kernel, so
+ * requests on them skip the per-request page pinning.
+ *
+ * Thread-safe.
+ */
+class AsyncFileIO {
+public:
+    /// Bytes transferred, or -errno
+    using Completion = std::function<void(ssize_t result)>;
+
+    /**
+     * @class Buffer
+     * @brief One of the pooled buffers, returned on destruction (move-only)
+     */
+    class Buffer {
+    public:
+        Buffer() = default;
+        ~Buffer();
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        explicit operator bool() const { return data_ != nullptr; }
+        uint8_t* data() const { return data_; }
+        size_t capacity() const { return capacity_; }
+
+    private:
+        friend class AsyncFileIO;
+
+        AsyncFileIO* owner_ = nullptr;
+        uint8_t* data_ = nullptr;
+        size_t capacity_ = 0;
+        int index_ = -1;
+    };
+
+    /**
+     * @brief The io_uring backend if requested and available, the thread backend otherwise
+     * @param metrics Receives request counts and the in-flight gauge (may be null)
+     */
+    static std::unique_ptr<AsyncFileIO> create(const AsyncIoOptions& options, ServiceMetrics* metrics = nullptr);
+
+    virtual ~AsyncFileIO() = default;
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    /// "io_uring" or "threads"
+    virtual const char* backend() const = 0;
+
+    /**
+     * @brief Borrow a pooled buffer (never blocks)
+     * @return Empty buffer if all are in use
+     */
+    Buffer acquireBuffer();
+
+    /// @name Requests
+    /// The memory must stay valid, and the descriptor open, until the completion runs.
+    /// After shutdown() the completion runs at once with -ECANCELED.
+    /// @{
+    void read(int fd, void* data, size_t length, uint64_t offset, Completion done) {
+        queue(false, fd, data, length, offset, -1, std::move(done));
+    }
+    void read(int fd, const Buffer& buffer, size_t length, uint64_t offset, Completion done) {
+        queue(false, fd, buffer.data(), length, offset, buffer.index_, std::move(done));
+    }
+    void write(int fd, const void* data, size_t length, uint64_t offset, Completion done) {
+        queue(true, fd, const_cast<void*>(data), length, offset, -1, std::move(done));
+    }
+    void write(int fd, const Buffer& buffer, size_t length, uint64_t offset, Completion done) {
+        queue(true, fd, buffer.data(), length, offset, buffer.index_, std::move(done));
+    }
+    /// @}
+
+    /**
+     * @brief Start every request queued since the last submit()
+     */
+    virtual void submit() = 0;
+
+    /**
+     * @brief Wait for requests in flight, then stop the backend
+     */
+    virtual void shutdown() = 0;
+
+protected:
+    AsyncFileIO(const AsyncIoOptions& options, ServiceMetrics* metrics);
+
+    /**
+     * @param buffer_index Pooled buffer holding data, or -1
+     */
+    virtual void queue(bool write, int fd, void* data, size_t length, uint64_t offset, int buffer_index,
+                       Completion done) = 0;
+
+    /// Pooled buffers, in index order
+    const std::vector<BufferPool::Storage>& buffers() const { return buffers_; }
+    size_t bufferSize() const { return buffer_size_; }
+
+    ServiceMetrics* metrics_;
+
+private:
+    void releaseBuffer(int index);
+
+    const size_t buffer_size_;
+    std::vector<BufferPool::Storage> buffers_;
+    std::mutex buffer_mutex_;
+    std::vector<int> free_buffers_;
+};
+
+} // namespace sar_atr
+
+#endif // ASYNC_FILE_IO_H
@@ -0,0 +1,233 @@
+#ifndef BOUNDED_PRIORITY_QUEUE_H
+#define BOUNDED_PRIORITY_QUEUE_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class BoundedPriorityQueue
+ * @brief Fixed-capacity blocking queue that hands out the most urgent item first
+ *
+ * Same interface and close() semantics as BoundedQueue, but pop() and
+ * popBatch() take items in the order given by Before (Before(a, b) is true
+ * when a should run before b) instead of arrival order. When the queue is
+ * full, tryPushDisplacing() lets an item take the place of the one that
+ * would run last, provided the new item would run before it.
+ *
+ * Items live in a binary heap whose storage is reserved once up front, so
+ * pushing and popping never touch the allocator.
+ */
+template <typename T, typename Before>
+class BoundedPriorityQueue {
+public:
+    explicit BoundedPriorityQueue(size_t capacity, Before before = Before())
+        : capacity_(capacity == 0 ? 1 : capacity), closed_(false), later_{before} {
+        heap_.reserve(capacity_);
+    }
+
+    BoundedPriorityQueue(const BoundedPriorityQueue&) = delete;
+    BoundedPriorityQueue& operator=(const BoundedPriorityQueue&) = delete;
+
+    /**
+     * @brief Push an item, blocking while the queue is full
+     *
+     * Like the other push variants, the item is only moved from on success.
+     *
+     * @return false if the queue was closed
+     */
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return closed_ || heap_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        pushLocked(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Push an item, waiting at most timeout for space
+     * @return false if the queue stayed full or was closed
+     */
+    template <typename Rep, typename Period>
+    bool pushFor(T&& item, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!not_full_.wait_for(lock, timeout, [this]() { return closed_ || heap_.size() < capacity_; })) {
+            return false;
+        }
+        if (closed_) {
+            return false;
+        }
+        pushLocked(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Push an item only if there is space right now
+     * @return false if the queue is full or closed
+     */
+    bool tryPush(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_ || heap_.size() >= capacity_) {
+            return false;
+        }
+        pushLocked(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Push an item, making room by taking out the item that would run last
+     *
+     * Only displaces an item the new one would run before; with space left
+     * this is tryPush().
+     *
+     * @param displaced Receives the item taken out, if any
+     * @return false if the queue is closed, or full of items that run before this one
+     */
+    bool tryPushDisplacing(T&& item, T& displaced, bool& did_displace) {
+        did_displace = false;
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        if (heap_.size() < capacity_) {
+            pushLocked(std::move(item));
+        } else {
+            // The item that runs last is one of the leaves
+            size_t last = heap_.size() / 2;
+            for (size_t i = last + 1; i < heap_.size(); ++i) {
+                if (later_(heap_[i], heap_[last])) {
+                    last = i;
+                }
+            }
+            if (!later_(heap_[last], item)) {
+                return false;
+            }
+            // A leaf replaced by something more urgent only needs to move up
+            displaced = std::move(heap_[last]);
+            heap_[last] = std::move(item);
+            std::push_heap(heap_.begin(), heap_.begin() + static_cast<std::ptrdiff_t>(last) + 1, later_);
+            did_displace = true;
+        }
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Pop the most urgent item, blocking until one is available
+     * @return false once the queue is closed and fully drained
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !heap_.empty(); });
+        if (heap_.empty()) {
+            return false;
+        }
+        item = popLocked();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Pop up to max_items, most urgent first, waiting at most max_wait for a batch to fill
+     *
+     * Blocks until at least one item is available, then keeps collecting until
+     * max_items are taken or max_wait has passed since the first one.
+     *
+     * @param items Receives the popped items (cleared first)
+     * @return false once the queue is closed and fully drained
+     */
+    template <typename Rep, typename Period>
+    bool popBatch(std::vector<T>& items, size_t max_items,
+                  const std::chrono::duration<Rep, Period>& max_wait) {
+        items.clear();
+        if (max_items == 0) {
+            max_items = 1;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !heap_.empty(); });
+        if (heap_.empty()) {
+            return false;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + max_wait;
+        while (items.size() < max_items) {
+            while (!heap_.empty() && items.size() < max_items) {
+                items.push_back(popLocked());
+            }
+            not_full_.notify_all();
+            if (items.size() >= max_items || closed_) {
+                break;
+            }
+            if (!not_empty_.wait_until(lock, deadline, [this]() { return closed_ || !heap_.empty(); })) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stop accepting new items and wake all waiting threads
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    /// Heap order: the front is the item no other runs before
+    struct Later {
+        Before before;
+        bool operator()(const T& a, const T& b) const { return before(b, a); }
+    };
+
+    const size_t capacity_;
+    bool closed_;
+    Later later_;
+    std::vector<T> heap_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+
+    void pushLocked(T&& item) {
+        heap_.push_back(std::move(item));
+        std::push_heap(heap_.begin(), heap_.end(), later_);
+    }
+
+    T popLocked() {
+        std::pop_heap(heap_.begin(), heap_.end(), later_);
+        T item = std::move(heap_.back());
+        heap_.pop_back();
+        return item;
+    }
+};
+
+} // namespace sar_atr
+
+#endif // BOUNDED_PRIORITY_QUEUE_H
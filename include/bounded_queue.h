@@ -0,0 +1,186 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class BoundedQueue
+ * @brief Fixed-capacity multi-producer/multi-consumer blocking queue
+ *
+ * Producers block (or time out) while the queue is full, which gives the
+ * receive path natural backpressure. Once close() is called, producers are
+ * rejected and consumers drain the remaining items before pop() returns false.
+ *
+ * Items live in a ring of capacity slots allocated once up front, so pushing
+ * and popping never touch the allocator (T must be default-constructible).
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity), closed_(false), slots_(capacity_), head_(0), count_(0) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Push an item, blocking while the queue is full
+     *
+     * Like the other push variants, the item is only moved from on success;
+     * a rejected item is left with the caller.
+     *
+     * @return false if the queue was closed
+     */
+    bool push(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return closed_ || count_ < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        pushLocked(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Push an item, waiting at most timeout for space
+     * @return false if the queue stayed full or was closed
+     */
+    template <typename Rep, typename Period>
+    bool pushFor(T&& item, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!not_full_.wait_for(lock, timeout, [this]() { return closed_ || count_ < capacity_; })) {
+            return false;
+        }
+        if (closed_) {
+            return false;
+        }
+        pushLocked(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Push an item only if there is space right now
+     * @return false if the queue is full or closed
+     */
+    bool tryPush(T&& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_ || count_ >= capacity_) {
+            return false;
+        }
+        pushLocked(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Pop an item, blocking until one is available
+     * @return false once the queue is closed and fully drained
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || count_ > 0; });
+        if (count_ == 0) {
+            return false;
+        }
+        item = popLocked();
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Pop up to max_items, waiting at most max_wait for a batch to fill
+     *
+     * Blocks until at least one item is available, then keeps collecting until
+     * max_items are taken or max_wait has passed since the first one.
+     *
+     * @param items Receives the popped items (cleared first)
+     * @return false once the queue is closed and fully drained
+     */
+    template <typename Rep, typename Period>
+    bool popBatch(std::vector<T>& items, size_t max_items,
+                  const std::chrono::duration<Rep, Period>& max_wait) {
+        items.clear();
+        if (max_items == 0) {
+            max_items = 1;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || count_ > 0; });
+        if (count_ == 0) {
+            return false;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + max_wait;
+        while (items.size() < max_items) {
+            while (count_ > 0 && items.size() < max_items) {
+                items.push_back(popLocked());
+            }
+            not_full_.notify_all();
+            if (items.size() >= max_items || closed_) {
+                break;
+            }
+            if (!not_empty_.wait_until(lock, deadline, [this]() { return closed_ || count_ > 0; })) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Stop accepting new items and wake all waiting threads
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    bool closed_;
+    std::vector<T> slots_;
+    size_t head_;       ///< Slot of the oldest item
+    size_t count_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+
+    void pushLocked(T&& item) {
+        size_t tail = head_ + count_;
+        slots_[tail >= capacity_ ? tail - capacity_ : tail] = std::move(item);
+        ++count_;
+    }
+
+    T popLocked() {
+        T item = std::move(slots_[head_]);
+        head_ = head_ + 1 == capacity_ ? 0 : head_ + 1;
+        --count_;
+        return item;
+    }
+};
+
+} // namespace sar_atr
+
+#endif // BOUNDED_QUEUE_H
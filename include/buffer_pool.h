@@ -0,0 +1,90 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class BufferPool
+ * @brief Recycles aligned I/O buffers so the hot path does not hit the allocator
+ *
+ * acquire() never blocks: when the pool is empty a new buffer is allocated,
+ * and on release at most max_cached buffers are kept for reuse. Buffers are
+ * aligned (and sized in multiples of the alignment) for O_DIRECT writes.
+ */
+class BufferPool {
+public:
+    struct AlignedFree {
+        void operator()(uint8_t* p) const;
+    };
+    using Storage = std::unique_ptr<uint8_t[], AlignedFree>;
+
+    /**
+     * @class Lease
+     * @brief A buffer borrowed from the pool, returned on destruction
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(BufferPool* pool, Storage storage, size_t capacity)
+            : pool_(pool), storage_(std::move(storage)), capacity_(capacity) {}
+        ~Lease();
+
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        uint8_t* data() const { return storage_.get(); }
+        size_t capacity() const { return capacity_; }
+
+    private:
+        BufferPool* pool_ = nullptr;
+        Storage storage_;
+        size_t capacity_ = 0;
+    };
+
+    /**
+     * @param alignment Buffer address and size alignment (power of two)
+     * @param max_cached Buffers kept for reuse once returned
+     */
+    explicit BufferPool(size_t alignment = 4096, size_t max_cached = 16);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Borrow a buffer of at least min_bytes
+     * @throws std::bad_alloc if a new buffer cannot be allocated
+     */
+    Lease acquire(size_t min_bytes);
+
+    size_t alignment() const { return alignment_; }
+
+    /**
+     * @brief Round a size up to the buffer alignment
+     */
+    size_t alignUp(size_t bytes) const { return (bytes + alignment_ - 1) & ~(alignment_ - 1); }
+
+private:
+    struct Cached {
+        Storage storage;
+        size_t capacity;
+    };
+
+    const size_t alignment_;
+    const size_t max_cached_;
+    std::mutex mutex_;
+    std::vector<Cached> free_;
+
+    void release(Storage storage, size_t capacity);
+};
+
+} // namespace sar_atr
+
+#endif // BUFFER_POOL_H
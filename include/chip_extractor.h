@@ -0,0 +1,127 @@
+#ifndef CHIP_EXTRACTOR_H
+#define CHIP_EXTRACTOR_H
+
+#include "async_file_io.h"
+#include "buffer_pool.h"
+#include "detection_batch.h"
+#include "inference_engine.h"
+#include "nitf_reader.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @struct ChipOptions
+ * @brief Geometry and output settings for detection chips
+ */
+struct ChipOptions {
+    std::string output_dir = "/tmp/sar_atr_chips"; ///< Directory chips are written to
+    bool write_nitf = true;     ///< NITF 2.1 chips; raw band-sequential pixels otherwise
+    double padding = 0.4;       ///< Fraction of the box size added around it (split over both sides)
+    int min_size = 64;          ///< Smallest chip edge in pixels
+    int max_size = 512;         ///< Largest chip edge in pixels
+    int threads = 0;            ///< Chip writer threads (0 = one per core)
+    bool direct_io = true;      ///< Write with O_DIRECT where the filesystem allows it
+};
+
+/**
+ * @struct ChipRegion
+ * @brief Pixel rectangle of a chip inside its source image
+ */
+struct ChipRegion {
+    int col = 0;
+    int row = 0;
+    int cols = 0;
+    int rows = 0;
+};
+
+/**
+ * @brief Pixel region for a detection: padded box, clamped in size, kept inside the image
+ */
+ChipRegion computeChipRegion(const BoundingBox& box, int image_cols, int image_rows, const ChipOptions& options);
+
+/**
+ * @brief Total pixels of the chips computeChipRegion() gives candidates at or above min_confidence
+ *
+ * Sizes a SIMD register of candidates at a time, rounding and clamping
+ * exactly as computeChipRegion() does, and never builds a DetectionResult.
+ */
+long long totalChipPixels(const DetectionBatch& candidates, float min_confidence, int image_cols, int image_rows,
+                          const ChipOptions& options);
+
+/**
+ * @class ChipExtractor
+ * @brief Cuts detection chips out of mapped NITF imagery and writes them in parallel
+ *
+ * Pixels are copied straight from NitfReader block views into pooled aligned
+ * buffers, so the only copy is the one into the output file's page. Each
+ * chip is one write of one buffer.
+ *
+ * Given an AsyncFileIO, the writer threads only cut chips: every chip of an
+ * image is written through one submission, so no writer thread blocks on
+ * storage. The I/O layer only reports each result; the extract() caller
+ * finishes a short write, truncates and closes, so nothing blocks the I/O
+ * layer's completion thread either.
+ */
+class ChipExtractor {
+public:
+    /**
+     * @param io Writes chips asynchronously when given (not owned; must outlive the extractor)
+     * @throws std::runtime_error if the output directory cannot be created
+     */
+    explicit ChipExtractor(const ChipOptions& options, AsyncFileIO* io = nullptr);
+
+    /**
+     * @brief Write chips for detections at or above min_confidence
+     *
+     * Sets output_file_path of every detection whose chip was written; others
+     * keep whatever path the engine supplied. Blocks until all chips are on disk.
+     *
+     * @return Number of chips written
+     */
+    int extract(const std::string& nitf_path, DetectionList& detections, float min_confidence);
+
+    /**
+     * @brief Stop the writer pool (waits for chips in flight)
+     */
+    void shutdown();
+
+    const ChipOptions& options() const { return options_; }
+
+private:
+    ChipOptions options_;
+    BufferPool buffers_;
+    AsyncFileIO* io_;
+    std::unique_ptr<ThreadPool> pool_;
+    std::atomic<unsigned long long> sequence_;
+
+    struct PendingChip;
+
+    /**
+     * @brief Cut one chip and write it, or queue its write when there is an AsyncFileIO
+     *
+     * A queued write is handed back through pending for finishChip(); otherwise
+     * the chip is on disk on return. An exception thrown from here means the
+     * write never started.
+     */
+    void writeChip(const NitfReader& reader, const DetectionResult& detection, const std::string& chip_path,
+                   std::shared_ptr<PendingChip>& pending);
+
+    /**
+     * @brief Wait for a queued write, write any short tail, truncate and close
+     * @throws std::runtime_error if the chip did not make it to disk (the descriptor is closed either way)
+     */
+    static void finishChip(PendingChip& chip);
+
+    /// Create the chip file, with O_DIRECT when configured and allowed
+    int openChip(const std::string& path, bool& direct);
+};
+
+} // namespace sar_atr
+
+#endif // CHIP_EXTRACTOR_H
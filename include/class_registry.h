@@ -0,0 +1,49 @@
+#ifndef CLASS_REGISTRY_H
+#define CLASS_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace sar_atr {
+
+/**
+ * @brief Small integer standing for a target classification ("T-72", "BMP-2", ...)
+ *
+ * Detections carry the ID instead of a string; className() turns it back
+ * into the name when a message is serialized or a chip header written.
+ */
+typedef uint16_t ClassId;
+
+/// ID of the empty classification, which every detection starts with
+constexpr ClassId kUnclassified = 0;
+
+/// Most distinct classifications a process can intern
+constexpr size_t kMaxClasses = 4096;
+
+/**
+ * @brief Get the ID for a classification name, registering it on first use
+ *
+ * Thread-safe. IDs are dense, start at 1 and stay valid for the life of the
+ * process. Takes a lock, so engines should intern their label set once up
+ * front rather than per detection.
+ *
+ * @throws std::runtime_error once kMaxClasses names are registered
+ */
+ClassId internClass(std::string_view name);
+
+/**
+ * @brief Name of an interned classification
+ *
+ * Lock-free. Unknown IDs map to the empty string.
+ */
+std::string_view className(ClassId id);
+
+/**
+ * @brief Number of IDs handed out so far, including kUnclassified
+ */
+size_t classCount();
+
+} // namespace sar_atr
+
+#endif // CLASS_REGISTRY_H
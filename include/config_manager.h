@@ -1,21 +1,126 @@
 #ifndef CONFIG_MANAGER_H
 #define CONFIG_MANAGER_H
 
+#include <map>
 #include <string>
+#include <vector>
 #include <yaml-cpp/yaml.h>
 
 namespace sar_atr {
 
+/**
+ * @struct EngineConfig
+ * @brief One inference engine the registry loads (see engine_registry.h)
+ */
+struct EngineConfig {
+    std::string name;                           ///< Referenced by routes and default_engine
+    std::string type;                           ///< Factory that builds it ("mock" is built in)
+    std::string model_path;                     ///< Model file, for engines that load one
+    std::map<std::string, std::string> options; ///< Engine-specific settings, passed through as text
+
+    bool operator==(const EngineConfig& other) const {
+        return name == other.name && type == other.type && model_path == other.model_path &&
+               options == other.options;
+    }
+    bool operator!=(const EngineConfig& other) const { return !(*this == other); }
+};
+
+/**
+ * @struct EngineRoute
+ * @brief Sends images matching every given condition to one engine
+ */
+struct EngineRoute {
+    std::string engine;         ///< Engine name
+    std::string path_prefix;    ///< NITF path starts with this (empty = any)
+    std::string category;       ///< First image segment's ICAT, e.g. SAR, VIS, IR (empty = any)
+    long long min_pixels = 0;   ///< First image segment has at least this many pixels (0 = any)
+};
+
+/**
+ * @struct RequestTopic
+ * @brief A topic FileLocation requests arrive on, and how urgent its requests are
+ */
+struct RequestTopic {
+    std::string topic;          ///< Topic subscribed to
+    int priority = 0;           ///< Requests with a higher priority are run first
+    int deadline_ms = 0;        ///< Shed a request not started this long after its MessageHeader.Timestamp (0 = none)
+};
+
 /**
  * @struct ServiceConfig
  * @brief Configuration parameters for the SAR ATR service
  */
 struct ServiceConfig {
-    std::string broker_address;        ///< AMQ broker WebSocket address
+    std::string broker_address;        ///< AMQ broker WebSocket address (the first of broker_addresses)
+    std::vector<std::string> broker_addresses;  ///< Brokers the publish connections are spread over
     float confidence_threshold;        ///< Minimum confidence to publish results
+    std::string nms_method;            ///< Duplicate suppression: none, greedy, soft_linear or soft_gaussian
+    float nms_iou_threshold;           ///< IoU above which same-class detections are duplicates
+    float nms_sigma;                   ///< Score decay width for soft_gaussian
+    std::vector<EngineConfig> engines; ///< Inference engines to load (one mock engine if not configured)
+    std::vector<EngineRoute> engine_routes; ///< First matching route picks an image's engine
+    std::string default_engine;        ///< Engine for images no route matches (the first engine if empty)
+    bool engine_warmup;                ///< Run each engine once before it takes traffic
     std::string system_uuid;           ///< System UUID for UCI messages
     std::string system_description;    ///< System description for UCI messages
     std::string service_version;       ///< Service version string
+    std::string log_level;             ///< Lowest level written: debug, info, warning or error
+    int worker_threads;                ///< Inference worker threads (0 = one per core)
+    int job_queue_capacity;            ///< Maximum FileLocation jobs waiting for a worker
+    int enqueue_timeout_ms;            ///< How long a parse thread waits for job queue space before dropping
+    std::vector<RequestTopic> request_topics; ///< Topics FileLocation requests are taken from
+    int queue_slo_ms;                  ///< Queue wait above which overload_action applies (0 = off)
+    std::string overload_action;       ///< What happens to a request over the SLO: "shed" or "degrade"
+    std::string degraded_engine;       ///< Engine degraded requests run on (empty = their routed engine)
+    int degraded_tile_overlap;         ///< Tile overlap for degraded requests (below tile_overlap = coarser stride)
+    int parse_threads;                 ///< FileLocation parse threads (0 = parse on the receive thread)
+    int serialize_threads;             ///< UCI serialize threads (0 = on the inference worker)
+    int publish_threads;               ///< Publish threads (0 = on the serializing thread)
+    int stage_queue_capacity;          ///< Capacity of the queues in front of the parse, serialize and publish stages
+    bool ordered_output;               ///< Publish images strictly in arrival order (no request priorities or deadlines)
+    int inference_batch_size;          ///< Maximum images per InferenceEngine::processBatch call
+    int inference_batch_wait_ms;       ///< Longest a worker waits for a batch to fill
+    bool result_cache_enabled;         ///< Reuse engine output when an unchanged image is requested again
+    int result_cache_entries;          ///< Most images kept in the result cache
+    int result_cache_ttl_s;            ///< Longest a cached result is served, in seconds (0 = until evicted)
+    bool prefetch_enabled;             ///< Start reading queued images before a worker reaches them
+    int prefetch_image_mb;             ///< Most MiB read ahead per queued image
+    int prefetch_budget_mb;            ///< Most MiB read ahead for all queued images together
+    int prefetch_threads;              ///< Threads issuing read-ahead
+    bool tiling_enabled;               ///< Stream large images through the engine tile by tile
+    int tile_size;                     ///< Tile edge length in pixels
+    int tile_overlap;                  ///< Pixels shared by neighbouring tiles
+    int tile_threads;                  ///< Threads running tiles in parallel (0 = one per core)
+    float tile_merge_threshold;        ///< Min overlap of the smaller box to merge seam duplicates
+    bool chip_extraction_enabled;      ///< Cut detection chips out of the source image
+    std::string chip_output_dir;       ///< Directory chips are written to
+    std::string chip_format;           ///< "nitf" or "raw"
+    double chip_padding;               ///< Fraction of the box size added around a detection
+    int chip_min_size;                 ///< Smallest chip edge in pixels
+    int chip_max_size;                 ///< Largest chip edge in pixels
+    int chip_threads;                  ///< Chip writer threads (0 = one per core)
+    bool chip_direct_io;               ///< Write chips with O_DIRECT where supported
+    bool io_uring_enabled;             ///< Use io_uring for chip writes and prefetch reads (threads otherwise)
+    int io_queue_depth;                ///< Most file I/O requests in flight
+    int io_buffer_count;               ///< Pooled (io_uring-registered) I/O buffers
+    int io_buffer_kb;                  ///< Size of each pooled I/O buffer in KiB
+    int io_threads;                    ///< Threads running file I/O when io_uring is unavailable
+    int connect_timeout_ms;            ///< Longest a connection attempt waits for the broker's CONNECTED
+    int heartbeat_interval_ms;         ///< STOMP heart-beat offered in both directions (0 = off)
+    bool reconnect_enabled;            ///< Re-establish lost broker connections and resume the session
+    int reconnect_initial_ms;          ///< Backoff before the first connection retry
+    int reconnect_max_ms;              ///< Cap of the exponential connection retry backoff
+    int publish_connections;           ///< Broker connections publishes are sharded across (1 with ordered_output)
+    std::string publish_shard_by;      ///< "image" (one connection per image) or "topic"
+    int publish_linger_us;             ///< Window for coalescing concurrent publish batches (0 = off)
+    int send_high_water_bytes;         ///< Queued outbound bytes above which publishers block
+    int send_block_timeout_ms;         ///< Longest a publisher blocks on a full send queue
+    int send_flush_timeout_ms;         ///< Longest disconnect waits to flush the send queue
+    bool publish_receipts;             ///< Keep publishes until the broker's RECEIPT, resend them after a reconnect
+    bool metrics_enabled;              ///< Serve Prometheus metrics over HTTP
+    std::string metrics_bind_address;  ///< IPv4 address the metrics endpoint listens on
+    int metrics_port;                  ///< TCP port of the metrics endpoint
+    std::string config_path;           ///< File this configuration was loaded from (re-read on engine reload)
 };
 
 /**
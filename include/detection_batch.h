@@ -0,0 +1,145 @@
+#ifndef DETECTION_BATCH_H
+#define DETECTION_BATCH_H
+
+#include "class_registry.h"
+#include "inference_engine.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class DetectionBatch
+ * @brief Raw detection candidates stored as a structure of arrays
+ *
+ * Each field is its own contiguous column (confidence, x1, y1, x2, y2,
+ * class ID), so filtering and box arithmetic run over thousands of
+ * candidates several lanes at a time instead of one DetectionResult at a
+ * time. Engines whose models emit dense candidate tensors fill a batch
+ * directly (InferenceEngine::processCandidates()); the service thresholds
+ * and deduplicates it (non_max_suppression.h) and only the survivors
+ * become DetectionResults.
+ *
+ * Candidates carry no output path: chips are cut later, for survivors only.
+ * The columns allocate from the memory resource given at construction
+ * (normally the image's arena).
+ */
+class DetectionBatch {
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<float>;
+
+    explicit DetectionBatch(const allocator_type& alloc = {})
+        : confidence_(alloc), x1_(alloc), y1_(alloc), x2_(alloc), y2_(alloc), class_ids_(alloc) {}
+
+    DetectionBatch(DetectionBatch&&) = default;
+    DetectionBatch& operator=(DetectionBatch&&) = default;
+    DetectionBatch(const DetectionBatch&) = delete;
+    DetectionBatch& operator=(const DetectionBatch&) = delete;
+
+    /**
+     * @brief Exchange contents (both batches must use the same memory resource)
+     */
+    void swap(DetectionBatch& other);
+
+    size_t size() const { return confidence_.size(); }
+    bool empty() const { return confidence_.empty(); }
+
+    void reserve(size_t count);
+    void clear();
+
+    /**
+     * @brief Replace the contents with a copy of another batch's (this batch keeps its memory resource)
+     */
+    void assign(const DetectionBatch& other);
+
+    /**
+     * @brief Append one candidate
+     */
+    void push_back(ClassId class_id, float confidence, const BoundingBox& box) {
+        confidence_.push_back(confidence);
+        x1_.push_back(box.x1);
+        y1_.push_back(box.y1);
+        x2_.push_back(box.x2);
+        y2_.push_back(box.y2);
+        class_ids_.push_back(class_id);
+    }
+
+    /**
+     * @brief Append the class, confidence and box of every detection in a list
+     */
+    void append(const DetectionList& detections);
+
+    /**
+     * @brief Resize every column (new candidates are zeroed), e.g. before an engine copies tensors in
+     */
+    void resize(size_t count);
+
+    /**
+     * @brief Copy selected candidates to the end of a DetectionList
+     * @param selected Candidate indices, e.g. from selectAbove()
+     */
+    void appendTo(const uint32_t* selected, size_t count, DetectionList& out) const;
+
+    BoundingBox box(size_t i) const { return BoundingBox{x1_[i], y1_[i], x2_[i], y2_[i]}; }
+
+    /// @name Columns
+    /// @{
+    float* confidence() { return confidence_.data(); }
+    float* x1() { return x1_.data(); }
+    float* y1() { return y1_.data(); }
+    float* x2() { return x2_.data(); }
+    float* y2() { return y2_.data(); }
+    ClassId* classIds() { return class_ids_.data(); }
+    const float* confidence() const { return confidence_.data(); }
+    const float* x1() const { return x1_.data(); }
+    const float* y1() const { return y1_.data(); }
+    const float* x2() const { return x2_.data(); }
+    const float* y2() const { return y2_.data(); }
+    const ClassId* classIds() const { return class_ids_.data(); }
+    /// @}
+
+    /**
+     * @brief Indices of candidates with confidence >= threshold, in order
+     *
+     * Compares a SIMD register of confidences at a time. NaN confidences are
+     * never selected.
+     *
+     * @param selected Receives the indices; must have room for size() entries
+     * @return Number of indices written
+     */
+    size_t selectAbove(float threshold, uint32_t* selected) const;
+
+    /**
+     * @brief Box areas (width * height) of every candidate
+     * @param areas Receives size() values
+     */
+    void boxAreas(float* areas) const;
+
+    /**
+     * @brief Apply x' = min(1, x * scale_x + offset_x) (and likewise for y) to every box
+     *
+     * Maps tile-normalized boxes into full-image coordinates the way
+     * mapTileDetections() does.
+     */
+    void mapBoxes(float scale_x, float offset_x, float scale_y, float offset_y);
+
+private:
+    std::pmr::vector<float> confidence_;
+    std::pmr::vector<float> x1_;
+    std::pmr::vector<float> y1_;
+    std::pmr::vector<float> x2_;
+    std::pmr::vector<float> y2_;
+    std::pmr::vector<ClassId> class_ids_;
+};
+
+/**
+ * @brief areas[i] = (x2[i] - x1[i]) * (y2[i] - y1[i]) over plain columns (what DetectionBatch::boxAreas() runs)
+ */
+void computeBoxAreas(const float* x1, const float* y1, const float* x2, const float* y2, size_t count,
+                     float* areas);
+
+} // namespace sar_atr
+
+#endif // DETECTION_BATCH_H
@@ -0,0 +1,122 @@
+#ifndef ENGINE_REGISTRY_H
+#define ENGINE_REGISTRY_H
+
+#include "config_manager.h"
+#include "image_geometry.h"
+#include "inference_engine.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class EngineRegistry
+ * @brief The service's inference engines, how images are routed to them, and atomic swaps
+ *
+ * Engines are built by named factories from EngineConfig entries ("mock" is
+ * built in; integrations add theirs with registerFactory()). route() picks
+ * an image's engine: the first EngineRoute whose conditions all hold, else
+ * the default engine. Routes on header fields read the NITF headers only,
+ * into the image's ImageDescription, so later stages do not read them again.
+ *
+ * The engines and routes form an immutable snapshot behind an atomically
+ * swapped shared_ptr, RCU style: route() takes no lock, and every job holds
+ * a reference to its engine, so after load() publishes a new snapshot the
+ * jobs already running finish on the old engines, which are destroyed when
+ * the last of those jobs lets go. load() builds and warms every new or
+ * changed engine before publishing anything, so a reload that fails leaves
+ * the old snapshot serving, and traffic never reaches a cold engine.
+ *
+ * Thread-safe; load() calls are serialized.
+ */
+class EngineRegistry {
+public:
+    /**
+     * @struct Engine
+     * @brief A loaded engine and the configuration it was built from
+     */
+    struct Engine {
+        EngineConfig config;
+        std::shared_ptr<InferenceEngine> engine;
+    };
+
+    using Factory = std::function<std::shared_ptr<InferenceEngine>(const EngineConfig& config)>;
+
+    /**
+     * @brief Make a type available to EngineConfig::type (replaces a factory of the same name)
+     */
+    static void registerFactory(const std::string& type, Factory factory);
+
+    EngineRegistry() = default;
+    EngineRegistry(const EngineRegistry&) = delete;
+    EngineRegistry& operator=(const EngineRegistry&) = delete;
+
+    /**
+     * @brief Publish exactly one engine, already built and warm, that every image goes to
+     */
+    void adopt(const std::string& name, std::shared_ptr<InferenceEngine> engine);
+
+    /**
+     * @brief Build, warm and publish engines and routes from the configuration
+     *
+     * Engines whose name and configuration are unchanged are kept as they
+     * are (not rebuilt or warmed again); the others are built from their
+     * factory and, with config.engine_warmup, run once through
+     * InferenceEngine::warmUp().
+     *
+     * @return Number of engines built
+     * @throws std::runtime_error if a factory is unknown, a route, the
+     *         default or the degraded engine names a missing engine, or
+     *         building or warming fails; the published snapshot is then
+     *         unchanged
+     */
+    size_t load(const ServiceConfig& config);
+
+    /**
+     * @brief The engine for an image
+     * @param geometry The image's geometry, described only if some route looks at headers
+     * @throws std::runtime_error if nothing has been published yet
+     */
+    std::shared_ptr<const Engine> route(const std::string& nitf_path, ImageDescription& geometry) const;
+
+    /**
+     * @brief The engine images go to when no route matches
+     */
+    std::shared_ptr<const Engine> defaultEngine() const;
+
+    /**
+     * @brief The published engine of this name; null if there is none
+     */
+    std::shared_ptr<const Engine> find(const std::string& name) const;
+
+    /**
+     * @brief Names of the published engines, in configuration order
+     */
+    std::vector<std::string> names() const;
+
+private:
+    struct Snapshot {
+        std::vector<std::shared_ptr<const Engine>> engines;
+        struct Route {
+            EngineRoute match;
+            std::shared_ptr<const Engine> engine;
+        };
+        std::vector<Route> routes;
+        std::shared_ptr<const Engine> fallback;
+        bool reads_headers = false;     ///< Some route needs the NITF headers
+    };
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+    void publish(std::shared_ptr<const Snapshot> next);
+
+    std::shared_ptr<const Snapshot> snapshot_;   ///< Only accessed through std::atomic_load/atomic_store
+    std::mutex load_mutex_;                      ///< Serializes load() and adopt()
+};
+
+} // namespace sar_atr
+
+#endif // ENGINE_REGISTRY_H
@@ -0,0 +1,131 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class EventLoop
+ * @brief One epoll thread driving non-blocking sockets, timers and posted tasks
+ *
+ * Descriptors, handlers and timers belong to the loop thread: add(), modify(),
+ * remove(), runAfter() and cancel() must be called from it (from a handler,
+ * a timer or a posted task). Other threads hand work over with post() or
+ * runSync(), which wake the loop through an eventfd. Several connections can
+ * share one loop; handlers must not block.
+ */
+class EventLoop {
+public:
+    /// Called with the ready epoll events (EPOLLIN, EPOLLOUT, EPOLLERR, ...)
+    typedef std::function<void(uint32_t events)> IoHandler;
+    typedef std::function<void()> Task;
+    typedef uint64_t TimerId;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * @brief Start the loop thread (no-op if already running)
+     * @throws std::runtime_error if epoll or the wakeup eventfd cannot be created
+     */
+    void start();
+
+    /**
+     * @brief Run the tasks already posted, then stop and join the loop thread
+     */
+    void stop();
+
+    bool inLoopThread() const;
+
+    /**
+     * @brief Watch a descriptor (level-triggered)
+     * @throws std::runtime_error if epoll refuses the descriptor
+     */
+    void add(int fd, uint32_t events, IoHandler handler);
+
+    /**
+     * @brief Change the events a watched descriptor is interested in
+     */
+    void modify(int fd, uint32_t events);
+
+    /**
+     * @brief Stop watching a descriptor; events already returned for it are discarded
+     */
+    void remove(int fd);
+
+    /**
+     * @brief Run a task on the loop thread (thread-safe, FIFO)
+     */
+    void post(Task task);
+
+    /**
+     * @brief Run a task on the loop thread and wait for it to finish
+     *
+     * Runs inline when called from the loop thread or when the loop is not running.
+     */
+    void runSync(const Task& task);
+
+    /**
+     * @brief Run a task once on the loop thread after a delay
+     * @return Handle for cancel()
+     */
+    TimerId runAfter(std::chrono::steady_clock::duration delay, Task task);
+
+    /**
+     * @brief Cancel a timer that has not fired yet (unknown ids are ignored)
+     */
+    void cancel(TimerId id);
+
+private:
+    // Each add() gets a fresh token, stored in epoll_event.data, so events
+    // still queued for a removed (and possibly reused) descriptor are dropped
+    struct Watch {
+        int fd;
+        IoHandler handler;
+    };
+
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        TimerId id;
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    int epoll_fd_;
+    int wake_fd_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    std::mutex task_mutex_;
+    std::vector<Task> tasks_;
+    bool wake_pending_;             ///< An eventfd write is outstanding; later posts need not write
+
+    // Loop-thread state
+    std::vector<Task> running_tasks_;               ///< Batch taken from tasks_ by runTasks()
+    std::unordered_map<uint64_t, Watch> watches_;   ///< By token
+    std::unordered_map<int, uint64_t> fd_tokens_;
+    uint64_t next_token_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timer_heap_;
+    std::unordered_map<TimerId, Task> timers_;      ///< Pending timers; cancelled ones are erased here only
+    TimerId next_timer_id_;
+
+    void loop();
+    void runTasks();
+    void runTimers();
+    int nextTimeoutMs();
+};
+
+} // namespace sar_atr
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,77 @@
+#ifndef IMAGE_ARENA_H
+#define IMAGE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class ImageArena
+ * @brief Monotonic memory for everything one image allocates, reused image after image
+ *
+ * Allocation bumps a pointer and deallocation is a no-op; reset() rewinds
+ * the arena once the image is done. Unlike std::pmr::monotonic_buffer_resource
+ * the memory survives reset(): if an image needed more than one block, the
+ * blocks are replaced by a single block big enough for all of it, so from
+ * then on an image of that size allocates nothing from the heap at all.
+ * Arenas that grew past retain_limit shrink back on reset so one huge scene
+ * does not pin its memory forever.
+ *
+ * Not thread-safe: an arena belongs to one image, and an image is worked on
+ * by one thread at a time.
+ */
+class ImageArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kDefaultInitialBytes = 64 * 1024;
+    static constexpr size_t kDefaultRetainLimit = 4 * 1024 * 1024;
+
+    /**
+     * @param initial_bytes Size of the first block
+     * @param retain_limit Largest block size kept across reset()
+     */
+    explicit ImageArena(size_t initial_bytes = kDefaultInitialBytes, size_t retain_limit = kDefaultRetainLimit);
+
+    ImageArena(const ImageArena&) = delete;
+    ImageArena& operator=(const ImageArena&) = delete;
+
+    /**
+     * @brief Forget every allocation; nothing allocated before may be used afterwards
+     */
+    void reset();
+
+    /**
+     * @brief Bytes handed out since the last reset (including alignment padding)
+     */
+    size_t used() const { return used_; }
+
+    /**
+     * @brief Bytes of block memory currently held
+     */
+    size_t capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    const size_t initial_bytes_;
+    const size_t retain_limit_;
+    std::vector<Block> blocks_;
+    size_t current_;        ///< Block being carved
+    size_t offset_;         ///< Next free byte in the current block
+    size_t used_;
+
+    void addBlock(size_t min_bytes);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+} // namespace sar_atr
+
+#endif // IMAGE_ARENA_H
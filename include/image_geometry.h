@@ -0,0 +1,63 @@
+#ifndef IMAGE_GEOMETRY_H
+#define IMAGE_GEOMETRY_H
+
+#include <string>
+
+namespace sar_atr {
+
+/**
+ * @struct ImageGeometry
+ * @brief Size of an image and where that information came from
+ */
+struct ImageGeometry {
+    enum class Source { NITF_HEADER, FILENAME, ESTIMATED };
+
+    int cols = 4096;                ///< Width in pixels
+    int rows = 4096;                ///< Height in pixels
+    int bytes_per_pixel = 2;        ///< Bytes per pixel across all bands
+    long long file_bytes = 0;       ///< Size on disk (0 if the file was not read)
+    std::string category;           ///< First image segment's ICAT (empty unless from the header)
+    Source source = Source::ESTIMATED;
+
+    bool known() const { return source != Source::ESTIMATED; }
+    bool fromHeader() const { return source == Source::NITF_HEADER; }
+};
+
+/**
+ * @brief Determine image size from the NITF header, falling back to the filename
+ *
+ * Opens the file and parses its headers; ImageDescription keeps the result
+ * so this runs once per image.
+ */
+ImageGeometry describeImage(const std::string& nitf_path);
+
+/**
+ * @class ImageDescription
+ * @brief An image's geometry, described on first use and kept for the rest of the pipeline
+ *
+ * Tiling, routing and reporting all ask for the geometry; only the first
+ * ask reads the file. Not thread-safe: it travels with the image's job.
+ */
+class ImageDescription {
+public:
+    const ImageGeometry& get(const std::string& nitf_path) {
+        if (!described_) {
+            geometry_ = describeImage(nitf_path);
+            described_ = true;
+        }
+        return geometry_;
+    }
+
+    /**
+     * @brief Forget the geometry (the image is reused for another file)
+     */
+    void reset() { described_ = false; }
+
+private:
+    ImageGeometry geometry_;
+    bool described_ = false;
+};
+
+} // namespace sar_atr
+
+#endif // IMAGE_GEOMETRY_H
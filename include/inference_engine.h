@@ -11,8 +11,26 @@
  * To integrate your inference engine implementation:
  * 1. Include this header file in your implementation
  * 2. Implement a class that provides the process() method with this signature
- * 3. The service will call process() with the NITF file path
- * 4. Return a vector of DetectionResult structures
+ * 3. The service will call process() with the NITF file path and an empty
+ *    DetectionList backed by the image's arena
+ * 4. Append one DetectionResult per target with detections.emplace_back() so
+ *    the result (and its output path) is allocated from that arena; intern
+ *    classification names once with internClass() and store the ID
+ * 5. Optionally override processBatch() to run several images per model
+ *    invocation (the default implementation calls process() for each image)
+ * 6. Optionally override supportsTiling()/processTile() so the service can
+ *    stream large images through the engine one overlapping tile at a time
+ * 7. Read pixels through NitfReader (nitf_reader.h): it memory-maps the file
+ *    and hands out zero-copy block views instead of loading the whole image
+ * 8. Models that emit dense candidate tensors should override
+ *    emitsCandidates()/processCandidates() and write straight into a
+ *    structure-of-arrays DetectionBatch (detection_batch.h); the service
+ *    thresholds and deduplicates the columns with SIMD and only builds
+ *    DetectionResults for the survivors
+ * 9. Override warmUp() to load the model and push a synthetic input
+ *    through it, and register a factory with EngineRegistry
+ *    (engine_registry.h) so service_config.yaml can name, route to and
+ *    hot-swap the engine
  * 
  * THREAD SAFETY:
  * --------------
@@ -23,11 +41,17 @@
 #ifndef INFERENCE_ENGINE_H
 #define INFERENCE_ENGINE_H
 
+#include "class_registry.h"
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace sar_atr {
 
+class DetectionBatch;
+
 /**
  * @struct BoundingBox
  * @brief Represents a bounding box in normalized pixel coordinates (XYXY format)
@@ -77,12 +101,77 @@ struct BoundingBox {
  * 
  * Represents one detected/classified target in the imagery with its
  * classification, confidence score, location, and optional output file path.
+ * 
+ * The classification is an interned ClassId rather than a string, and the
+ * type is allocator-aware: inside a DetectionList the output path is
+ * allocated from the same memory resource as the list itself.
  */
 struct DetectionResult {
-    std::string classification;  ///< Target classification/type (e.g., "T-72", "BMP-2")
-    float confidence;            ///< Confidence score [0.0, 1.0] where 1.0 is highest confidence
-    BoundingBox bounding_box;    ///< Location of detection in normalized XYXY coordinates
-    std::string output_file_path; ///< Optional: Path to chip/product file for this detection (empty if not generated)
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    ClassId class_id = kUnclassified;  ///< Interned target classification/type (see classification())
+    float confidence = 0.0f;           ///< Confidence score [0.0, 1.0] where 1.0 is highest confidence
+    BoundingBox bounding_box{};        ///< Location of detection in normalized XYXY coordinates
+    std::pmr::string output_file_path; ///< Optional: Path to chip/product file for this detection (empty if not generated)
+
+    DetectionResult() = default;
+    explicit DetectionResult(const allocator_type& alloc) : output_file_path(alloc) {}
+    DetectionResult(const DetectionResult& other, const allocator_type& alloc)
+        : class_id(other.class_id), confidence(other.confidence), bounding_box(other.bounding_box),
+          output_file_path(other.output_file_path, alloc) {}
+    DetectionResult(DetectionResult&& other, const allocator_type& alloc)
+        : class_id(other.class_id), confidence(other.confidence), bounding_box(other.bounding_box),
+          output_file_path(std::move(other.output_file_path), alloc) {}
+    DetectionResult(const DetectionResult&) = default;
+    DetectionResult(DetectionResult&&) = default;
+    DetectionResult& operator=(const DetectionResult&) = default;
+    DetectionResult& operator=(DetectionResult&&) = default;
+
+    /**
+     * @brief Target classification/type (e.g., "T-72", "BMP-2")
+     */
+    std::string_view classification() const { return className(class_id); }
+
+    /**
+     * @brief Set the classification by name (takes the registry lock; prefer caching IDs)
+     */
+    void setClassification(std::string_view name) { class_id = internClass(name); }
+};
+
+/**
+ * @brief Detections for one image, allocated from that image's arena
+ */
+using DetectionList = std::pmr::vector<DetectionResult>;
+
+/**
+ * @struct BatchItem
+ * @brief One image of a processBatch() call and where its detections go
+ *
+ * Engines that emit candidates fill candidates; all others fill detections.
+ */
+struct BatchItem {
+    const std::string* nitf_file_path;  ///< Absolute path to the NITF file
+    DetectionList* detections;          ///< Empty on entry; receives the image's detections
+    DetectionBatch* candidates;         ///< Empty on entry; receives the image's raw candidates
+};
+
+/**
+ * @struct ImageTile
+ * @brief A rectangular window of a larger image, in pixel coordinates
+ * 
+ * Tiles are produced by the service when tiled processing is enabled. The
+ * engine reads only this window of the NITF file and reports detections
+ * normalized to the tile (0.0-1.0 across the tile, not the full image);
+ * the service maps them back into full-image coordinates.
+ */
+struct ImageTile {
+    int col_offset;    ///< First column of the tile in the full image
+    int row_offset;    ///< First row of the tile in the full image
+    int cols;          ///< Tile width in pixels
+    int rows;          ///< Tile height in pixels
+    int image_cols;    ///< Full image width in pixels
+    int image_rows;    ///< Full image height in pixels
+    int index;         ///< Position of the tile in the service's tiling plan
 };
 
 /**
@@ -103,17 +192,102 @@ public:
      * This is the main entry point for inference. The implementation should:
      * 1. Load and parse the NITF file at the given path
      * 2. Run the SAR ATR algorithm on the imagery
-     * 3. Return all detections that meet internal quality thresholds
+     * 3. Append all detections that meet internal quality thresholds
      * 
-     * NOTE: The service applies its own confidence threshold filtering
-     * after this method returns, so implementations should return all
-     * reasonable detections and not apply aggressive filtering.
+     * NOTE: The service applies its own confidence threshold filtering and
+     * per-class non-maximum suppression after this method returns, so
+     * implementations should return all reasonable detections and not
+     * apply aggressive filtering.
      * 
      * @param nitf_file_path Absolute path to the NITF file to process
-     * @return Vector of detection results (may be empty if no targets found)
+     * @param detections Receives the detection results (left empty if no targets found)
      * @throws std::runtime_error if file cannot be read or processing fails
      */
-    virtual std::vector<DetectionResult> process(const std::string& nitf_file_path) = 0;
+    virtual void process(const std::string& nitf_file_path, DetectionList& detections) = 0;
+    
+    /**
+     * @brief Process several NITF files in one call
+     * 
+     * The service's dynamic batcher groups queued requests and calls this
+     * method when inference_batch_size is greater than 1. Engines backed by
+     * an accelerator should override it to run the images as one batch.
+     * If it throws, the service clears every list and retries each image
+     * individually with process().
+     * 
+     * @param items Images to process, each with the list that receives its detections
+     * @throws std::runtime_error if any file cannot be read or processing fails
+     */
+    virtual void processBatch(const std::vector<BatchItem>& items) {
+        for (const auto& item : items) {
+            if (emitsCandidates()) {
+                processCandidates(*item.nitf_file_path, *item.candidates);
+            } else {
+                process(*item.nitf_file_path, *item.detections);
+            }
+        }
+    }
+    
+    /**
+     * @brief Whether whole images go through processCandidates() instead of process()
+     * 
+     * Tiles still go through processTile().
+     */
+    virtual bool emitsCandidates() const { return false; }
+    
+    /**
+     * @brief Process a NITF file into raw candidates, one column per field
+     * 
+     * For models whose output is thousands of scored boxes: copy the output
+     * tensors into the batch's columns (resize() then confidence(), x1(), ...)
+     * without any filtering. The service drops candidates below its
+     * confidence threshold, and duplicates by NMS, before anything else
+     * looks at them.
+     * 
+     * @param nitf_file_path Absolute path to the NITF file to process
+     * @param candidates Receives the candidates (boxes normalized to the image)
+     * @throws std::runtime_error if candidates are unsupported or processing fails
+     */
+    virtual void processCandidates(const std::string& nitf_file_path, DetectionBatch& candidates) {
+        (void)candidates;
+        throw std::runtime_error("Candidate batches not supported for " + nitf_file_path);
+    }
+    
+    /**
+     * @brief Whether processTile() is implemented
+     * 
+     * Engines that return false are always given whole images.
+     */
+    virtual bool supportsTiling() const { return false; }
+    
+    /**
+     * @brief Process one tile of a NITF file
+     * 
+     * Called concurrently for different tiles of the same image when tiled
+     * processing is enabled. Implementations should read only the tile's
+     * window so memory use stays bounded regardless of image size.
+     * 
+     * @param nitf_file_path Absolute path to the NITF file
+     * @param tile Window of the image to process
+     * @param detections Receives detections with bounding boxes normalized to the tile
+     * @throws std::runtime_error if tiling is unsupported or processing fails
+     */
+    virtual void processTile(const std::string& nitf_file_path, const ImageTile& tile,
+                             DetectionList& detections) {
+        (void)tile;
+        (void)detections;
+        throw std::runtime_error("Tiled processing not supported for " + nitf_file_path);
+    }
+    
+    /**
+     * @brief Get ready for traffic: load weights, allocate accelerator memory, run a synthetic input
+     * 
+     * Called once before the engine takes its first image, at startup and
+     * when a reload swaps it in, so no request pays for lazy initialization.
+     * The default does nothing.
+     * 
+     * @throws std::runtime_error if the engine cannot get ready; it is then not used
+     */
+    virtual void warmUp() {}
 };
 
 } // namespace sar_atr
@@ -1,73 +1,97 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
 #include <string>
-#include <iostream>
-#include <sstream>
-#include <chrono>
-#include <iomanip>
 
 namespace sar_atr {
 
+/// Severity, lowest first; messages below the configured level are skipped
 enum class LogLevel {
+    DEBUG,
     INFO,
     WARNING,
-    ERROR,
-    DEBUG
+    ERROR
 };
 
+/**
+ * @brief Parse a level name ("debug", "info", "warning", "error"; case-insensitive)
+ * @throws std::runtime_error for unknown names
+ */
+LogLevel parseLogLevel(const std::string& name);
+
 /**
  * @class Logger
- * @brief Simple logger for service output
+ * @brief Service logger with an asynchronous backend
+ *
+ * Until start() is called, lines are written synchronously. After start(),
+ * each calling thread appends to its own lock-free ring buffer and a
+ * background thread timestamps, formats and writes the lines in batches, so
+ * the hot path never formats dates or flushes stdout. ERROR lines that find
+ * their ring full are written synchronously instead of being dropped; other
+ * levels are counted and reported as dropped.
+ *
+ * Use the SAR_LOG_* macros where building the message is not free: they
+ * check the level before evaluating their argument.
  */
 class Logger {
 public:
-    static void log(LogLevel level, const std::string& message) {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-        
-        std::stringstream ss;
-        ss << "[" << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
-        ss << "." << std::setfill('0') << std::setw(3) << ms.count() << "] ";
-        
-        switch(level) {
-            case LogLevel::INFO:
-                ss << "[INFO]    ";
-                break;
-            case LogLevel::WARNING:
-                ss << "[WARNING] ";
-                break;
-            case LogLevel::ERROR:
-                ss << "[ERROR]   ";
-                break;
-            case LogLevel::DEBUG:
-                ss << "[DEBUG]   ";
-                break;
-        }
-        
-        ss << message;
-        std::cout << ss.str() << std::endl;
+    static void log(LogLevel level, std::string message);
+
+    static void info(std::string message) {
+        log(LogLevel::INFO, std::move(message));
     }
-    
-    static void info(const std::string& message) {
-        log(LogLevel::INFO, message);
+
+    static void warning(std::string message) {
+        log(LogLevel::WARNING, std::move(message));
     }
-    
-    static void warning(const std::string& message) {
-        log(LogLevel::WARNING, message);
+
+    static void error(std::string message) {
+        log(LogLevel::ERROR, std::move(message));
     }
-    
-    static void error(const std::string& message) {
-        log(LogLevel::ERROR, message);
+
+    static void debug(std::string message) {
+        log(LogLevel::DEBUG, std::move(message));
     }
-    
-    static void debug(const std::string& message) {
-        log(LogLevel::DEBUG, message);
+
+    /**
+     * @brief Whether messages of this level are currently written
+     */
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= min_level_.load(std::memory_order_relaxed);
     }
+
+    static void setLevel(LogLevel level) {
+        min_level_.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Start the background writer thread (idempotent)
+     */
+    static void start();
+
+    /**
+     * @brief Write everything still buffered and stop the writer thread
+     */
+    static void shutdown();
+
+private:
+    static std::atomic<int> min_level_;
 };
 
 } // namespace sar_atr
 
+/// Level-checked logging: the message expression is only evaluated when enabled
+#define SAR_LOG_AT(level, ...)                                        \
+    do {                                                              \
+        if (::sar_atr::Logger::enabled(level)) {                      \
+            ::sar_atr::Logger::log(level, __VA_ARGS__);               \
+        }                                                             \
+    } while (0)
+
+#define SAR_LOG_DEBUG(...) SAR_LOG_AT(::sar_atr::LogLevel::DEBUG, __VA_ARGS__)
+#define SAR_LOG_INFO(...) SAR_LOG_AT(::sar_atr::LogLevel::INFO, __VA_ARGS__)
+#define SAR_LOG_WARNING(...) SAR_LOG_AT(::sar_atr::LogLevel::WARNING, __VA_ARGS__)
+#define SAR_LOG_ERROR(...) SAR_LOG_AT(::sar_atr::LogLevel::ERROR, __VA_ARGS__)
+
 #endif // LOGGER_H
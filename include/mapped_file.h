@@ -0,0 +1,46 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sar_atr {
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Pages are faulted in by the kernel on first access and shared with the page
+ * cache, so mapping a multi-GB collect costs no heap memory and no read()
+ * copies. The mapping stays valid for the lifetime of the object.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map a file read-only
+     * @throws std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    const uint8_t* data_;
+    size_t size_;
+
+    void unmap();
+};
+
+} // namespace sar_atr
+
+#endif // MAPPED_FILE_H
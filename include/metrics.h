@@ -0,0 +1,206 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class Counter
+ * @brief Monotonic event counter, safe to bump from any thread
+ */
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @class Gauge
+ * @brief Point-in-time value that can go up and down
+ */
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief HDR-style latency histogram with bounded relative error
+ *
+ * Durations are recorded in nanoseconds into log-linear buckets: each power
+ * of two is split into kSubBuckets linear steps, so any recorded value is
+ * reported within about 3% across the whole range (1 ns to ~73 minutes;
+ * longer values land in the last bucket). Recording is two relaxed atomic
+ * adds (bucket and sum), with no locks.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxValueBits = 42;
+    static constexpr size_t kBucketCount =
+        2 * kSubBuckets + static_cast<size_t>(kMaxValueBits - kSubBucketBits - 1) * kSubBuckets;
+
+    /**
+     * @struct Snapshot
+     * @brief Copy of the counts taken at one point in time
+     */
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sum_nanos = 0;
+
+        /**
+         * @brief Value (ns) at or below which the given fraction of samples fall
+         * @param quantile Fraction in [0, 1]
+         */
+        uint64_t valueAtQuantile(double quantile) const;
+
+        /**
+         * @brief Number of samples no larger than limit_nanos
+         */
+        uint64_t countAtOrBelow(uint64_t limit_nanos) const;
+    };
+
+    void record(uint64_t nanos);
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(nanos > 0 ? static_cast<uint64_t>(nanos) : 0);
+    }
+
+    void recordSince(std::chrono::steady_clock::time_point start) {
+        record(std::chrono::steady_clock::now() - start);
+    }
+
+    Snapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t nanos);
+
+    /// Largest value that maps to a bucket
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    alignas(64) std::atomic<uint64_t> sum_nanos_{0};
+};
+
+/**
+ * @brief Pipeline stages timed per message
+ */
+enum class PipelineStage {
+    RECEIVE,        ///< Socket read to STOMP MESSAGE dispatch
+    PARSE_WAIT,     ///< Time a message waits for a parse thread (parse_threads > 0)
+    PARSE,          ///< FileLocation JSON to NITF path
+    QUEUE_WAIT,     ///< Time a job waits for an inference worker
+    INFERENCE,      ///< Engine call (whole image, batch or tiles)
+    SERIALIZE,      ///< Building every UCI message for an image
+    PUBLISH,        ///< Handing the batch to the send queue, including backpressure
+    SOCKET_WRITE,   ///< Sender thread writing one batch of frames to the socket
+    COUNT
+};
+
+const char* pipelineStageName(PipelineStage stage);
+
+/**
+ * @struct ServiceMetrics
+ * @brief Every metric the service exports
+ *
+ * Members are updated in place by the components that own the events. The
+ * sampled gauges (queue depths) are set by whoever renders the snapshot.
+ */
+struct ServiceMetrics {
+    std::array<LatencyHistogram, static_cast<size_t>(PipelineStage::COUNT)> stages;
+
+    Counter messages_received;       ///< STOMP MESSAGE frames delivered to the service
+    Counter parse_failures;          ///< FileLocation messages without a usable path
+    Counter jobs_dropped;            ///< Jobs rejected because the job queue stayed full
+    Counter receive_pauses;          ///< Times reading from the broker stopped until a full queue drained
+    Counter jobs_shed;               ///< Jobs given up as stale (over the SLO or deadline) or displaced by more urgent ones
+    Counter jobs_degraded;           ///< Jobs run on the degraded engine or tile stride because they queued past the SLO
+    Counter jobs_processed;          ///< Images that reached the publish step
+    Counter jobs_failed;             ///< Images whose inference or publishing threw
+    Counter detections_total;        ///< Detections returned by the engine
+    Counter detections_filtered;     ///< Detections below confidence_threshold
+    Counter detections_suppressed;   ///< Detections removed as duplicates by NMS
+    Counter detections_published;    ///< Detections published as Entity messages
+    Counter messages_published;      ///< UCI messages accepted by the send queue
+    Counter publish_failures;        ///< UCI messages the send queue rejected
+    Counter frames_dropped;          ///< Queued frames discarded when the connection failed
+    Counter frames_replayed;         ///< Publish frames resent on a new connection after one was lost
+    Counter broker_reconnects;       ///< Lost broker connections re-established in the background
+    Counter bytes_written;           ///< Bytes written to the broker socket
+    Counter result_cache_hits;       ///< Images answered from the result cache
+    Counter result_cache_misses;     ///< Images the result cache sent to the engine
+    Counter result_cache_coalesced;  ///< Images that waited for another request's inference
+    Counter result_cache_evictions;  ///< Cached results dropped to stay within capacity
+    Counter prefetch_images;         ///< Queued images whose read-ahead was issued
+    Counter prefetch_bytes;          ///< Bytes read ahead for queued images
+    Counter prefetch_skipped;        ///< Images queued without read-ahead (budget or slots used up)
+    Counter prefetch_late;           ///< Images a worker reached before their read-ahead started
+    Counter io_requests;             ///< Reads and writes queued on the async file I/O layer
+    Counter io_errors;               ///< Async file I/O requests that completed with an error
+    Counter engine_reloads;          ///< Engine reloads that swapped in the new configuration
+    Counter engine_reload_failures;  ///< Engine reloads that failed and kept the running engines
+
+    Gauge send_queue_bytes;          ///< Outbound bytes queued for the broker socket
+    Gauge parse_queue_depth;         ///< FileLocation messages waiting for a parse thread
+    Gauge job_queue_depth;           ///< Jobs waiting for an inference worker
+    Gauge serialize_queue_depth;     ///< Images waiting for a serialize thread
+    Gauge publish_queue_depth;       ///< Message batches waiting for a publish thread
+    Gauge reorder_held;              ///< Finished images held back for ordered output
+    Gauge result_cache_entries;      ///< Images in the result cache, including ones in flight
+    Gauge prefetch_outstanding_bytes; ///< Read-ahead bytes held for images no worker has reached
+    Gauge io_in_flight;              ///< Async file I/O requests queued or in flight
+
+    LatencyHistogram& stage(PipelineStage which) { return stages[static_cast<size_t>(which)]; }
+
+    /**
+     * @brief Render in the Prometheus text exposition format (version 0.0.4)
+     */
+    std::string renderPrometheus() const;
+};
+
+/**
+ * @class StageTimer
+ * @brief Records the time between construction and destruction into a stage histogram
+ *
+ * A null metrics pointer makes the timer a no-op.
+ */
+class StageTimer {
+public:
+    StageTimer(ServiceMetrics* metrics, PipelineStage stage)
+        : histogram_(metrics ? &metrics->stage(stage) : nullptr),
+          start_(histogram_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+
+    ~StageTimer() {
+        if (histogram_) {
+            histogram_->recordSince(start_);
+        }
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    LatencyHistogram* histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace sar_atr
+
+#endif // METRICS_H
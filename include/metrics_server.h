@@ -0,0 +1,59 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace sar_atr {
+
+/**
+ * @class MetricsServer
+ * @brief Minimal HTTP/1.1 server answering GET /metrics for Prometheus scrapes
+ *
+ * One background thread accepts and serves connections one at a time with
+ * Connection: close. Scrapes are rare and small, so there is no keep-alive,
+ * chunking or request body handling; anything other than GET /metrics gets
+ * a 404.
+ */
+class MetricsServer {
+public:
+    /// Produces the response body on each scrape (called on the server thread)
+    typedef std::function<std::string()> RenderFunction;
+
+    MetricsServer(const std::string& bind_address, int port, RenderFunction render);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @brief Bind the listening socket and start serving
+     * @throws std::runtime_error if the address cannot be bound
+     */
+    void start();
+
+    /**
+     * @brief Stop serving and join the server thread (idempotent)
+     */
+    void stop();
+
+    /// Port actually bound (useful when constructed with port 0)
+    int port() const { return port_; }
+
+private:
+    std::string bind_address_;
+    int port_;
+    RenderFunction render_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    void serveLoop();
+    void serveConnection(int client_fd);
+};
+
+} // namespace sar_atr
+
+#endif // METRICS_SERVER_H
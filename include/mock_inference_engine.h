@@ -2,6 +2,8 @@
 #define MOCK_INFERENCE_ENGINE_H
 
 #include "inference_engine.h"
+#include <array>
+#include <mutex>
 #include <random>
 
 namespace sar_atr {
@@ -11,26 +13,85 @@ namespace sar_atr {
  * @brief Mock implementation of the SAR ATR inference engine for testing
  * 
  * This mock generates random detection results without actually processing
- * the NITF file. Used for testing the service architecture.
+ * the NITF file. Used for testing the service architecture. Safe to call
+ * from several worker threads at once.
  */
 class MockInferenceEngine : public InferenceEngine {
 public:
+    /**
+     * @struct LatencyModel
+     * @brief Simulated accelerator timing
+     * 
+     * A call costs a random fixed overhead (model launch, transfers) plus a
+     * per-image cost, so batching N images amortizes the overhead the way a
+     * GPU-backed engine would. The defaults reproduce the original
+     * 100-500 ms per single image.
+     */
+    struct LatencyModel {
+        /// How the fixed cost is drawn; always clamped to [min_overhead_ms, max_overhead_ms]
+        enum class Distribution {
+            UNIFORM,        ///< Evenly between min and max
+            NORMAL,         ///< Centred between min and max, sigma = range / 6
+            EXPONENTIAL     ///< min plus an exponential tail with mean range / 4 (rare slow calls)
+        };
+        
+        double min_overhead_ms = 80;    ///< Minimum fixed cost per call
+        double max_overhead_ms = 480;   ///< Maximum fixed cost per call
+        double per_image_ms = 20;       ///< Additional cost for every image in the call
+        Distribution distribution = Distribution::UNIFORM;
+    };
+    
+    /**
+     * @struct DetectionModel
+     * @brief How many detections each image yields
+     */
+    struct DetectionModel {
+        int min_detections = 0;
+        int max_detections = 5;
+    };
+    
     MockInferenceEngine();
+    explicit MockInferenceEngine(const LatencyModel& latency);
+    MockInferenceEngine(const LatencyModel& latency, const DetectionModel& detections);
     
     /**
      * @brief Generate mock detection results
      * @param nitf_file_path Path to NITF file (not actually used in mock)
-     * @return Vector of randomly generated detection results
+     * @param detections Receives the randomly generated detection results
+     */
+    void process(const std::string& nitf_file_path, DetectionList& detections) override;
+    
+    /**
+     * @brief Generate mock results for a batch with batch-amortized latency
      */
-    std::vector<DetectionResult> process(const std::string& nitf_file_path) override;
+    void processBatch(const std::vector<BatchItem>& items) override;
+    
+    bool supportsTiling() const override { return true; }
+    
+    /**
+     * @brief Run one synthetic image through the simulated model
+     */
+    void warmUp() override;
+    
+    /**
+     * @brief Generate mock results for one tile, with latency scaled by tile area
+     */
+    void processTile(const std::string& nitf_file_path, const ImageTile& tile,
+                     DetectionList& detections) override;
     
 private:
+    LatencyModel latency_;
+    
+    void simulateLatency(size_t batch_size, double overhead_scale = 1.0);
+    void generateDetections(DetectionList& detections, int max_detections = -1);
+    
+    std::mutex rng_mutex_;
     std::mt19937 rng_;
     std::uniform_real_distribution<float> confidence_dist_;
     std::uniform_real_distribution<float> coord_dist_;
     std::uniform_int_distribution<int> count_dist_;
     
-    static const std::vector<std::string> classifications_;
+    std::array<ClassId, 3> class_ids_;  ///< Interned "class1".."class3"
 };
 
 } // namespace sar_atr
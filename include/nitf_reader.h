@@ -0,0 +1,130 @@
+#ifndef NITF_READER_H
+#define NITF_READER_H
+
+#include "mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @struct NitfImageInfo
+ * @brief Fields of one image subheader needed to locate its pixels
+ */
+struct NitfImageInfo {
+    std::string image_id;          ///< IID1
+    int rows = 0;                  ///< NROWS
+    int cols = 0;                  ///< NCOLS
+    int bands = 0;                 ///< NBANDS (or XBANDS)
+    int bits_per_pixel = 0;        ///< NBPP (storage bits per band sample)
+    int actual_bits_per_pixel = 0; ///< ABPP (significant bits)
+    std::string pixel_type;        ///< PVTYPE (INT, SI, R, C, B)
+    std::string representation;    ///< IREP (MONO, RGB, NODISPLY, ...)
+    std::string category;          ///< ICAT (SAR, VIS, ...)
+    std::string compression;       ///< IC (NC, NM, C3, ...)
+    char image_mode = 'B';         ///< IMODE (B, P, R or S)
+    int blocks_per_row = 0;        ///< NBPR
+    int blocks_per_column = 0;     ///< NBPC
+    int block_cols = 0;            ///< NPPBH (resolved when 0)
+    int block_rows = 0;            ///< NPPBV (resolved when 0)
+
+    size_t header_offset = 0;      ///< Subheader offset in the file
+    size_t header_length = 0;      ///< LISH
+    size_t data_offset = 0;        ///< Image data offset in the file
+    size_t data_length = 0;        ///< LI
+
+    bool isUncompressed() const { return compression == "NC" || compression == "NM"; }
+    bool hasMaskTable() const { return compression == "NM"; }
+    int bytesPerPixel() const { return (bits_per_pixel + 7) / 8; }
+    int blockCount() const { return blocks_per_row * blocks_per_column; }
+
+    /**
+     * @brief Bytes of one band of one block
+     */
+    size_t blockBytes() const {
+        return static_cast<size_t>(block_cols) * block_rows * bytesPerPixel();
+    }
+};
+
+/**
+ * @struct NitfBlockView
+ * @brief Zero-copy view of one band of one image block
+ *
+ * Points straight into the mapping. Pixels may be interleaved with other
+ * bands (IMODE P/R), so walk them with pixel_stride and row_stride. Blocks on
+ * the right and bottom edges keep their full size; pixels past NCOLS/NROWS
+ * are fill.
+ */
+struct NitfBlockView {
+    const uint8_t* data = nullptr; ///< First sample of this band in the block
+    int rows = 0;                  ///< Block height in pixels
+    int cols = 0;                  ///< Block width in pixels
+    int bytes_per_pixel = 0;
+    size_t pixel_stride = 0;       ///< Bytes between horizontally adjacent samples
+    size_t row_stride = 0;         ///< Bytes between vertically adjacent samples
+
+    bool empty() const { return data == nullptr; }
+    bool contiguous() const { return pixel_stride == static_cast<size_t>(bytes_per_pixel); }
+    const uint8_t* row(int r) const { return data + static_cast<size_t>(r) * row_stride; }
+    const uint8_t* pixel(int r, int c) const { return row(r) + static_cast<size_t>(c) * pixel_stride; }
+};
+
+/**
+ * @class NitfReader
+ * @brief Parses NITF 2.1 / NSIF 1.0 headers from a memory-mapped file
+ *
+ * Only the header bytes are touched while parsing; pixel data is paged in
+ * lazily when a block view is read, so opening a multi-GB collect is cheap
+ * and never duplicates the image in heap memory. Block views are valid while
+ * the reader is alive.
+ */
+class NitfReader {
+public:
+    /**
+     * @brief Map and parse a NITF file
+     * @throws std::runtime_error if the file is missing, truncated or not NITF 2.1
+     */
+    explicit NitfReader(const std::string& path);
+
+    const std::string& path() const { return file_.path(); }
+    std::string_view version() const { return version_; }
+    size_t fileSize() const { return file_.size(); }
+
+    size_t imageCount() const { return images_.size(); }
+
+    /**
+     * @throws std::out_of_range if index is past the last image segment
+     */
+    const NitfImageInfo& image(size_t index = 0) const;
+
+    /**
+     * @brief View one band of one block of an uncompressed image
+     * @return Empty view for blocks the mask table marks as not recorded
+     * @throws std::runtime_error for compressed or sub-byte pixel data
+     * @throws std::out_of_range if the block or band does not exist
+     */
+    NitfBlockView block(size_t image_index, int block_row, int block_col, int band = 0) const;
+
+    /**
+     * @brief Raw image data bytes of an image segment (still compressed if IC says so)
+     */
+    std::string_view imageData(size_t image_index = 0) const;
+
+private:
+    MappedFile file_;
+    std::string version_;
+    std::vector<NitfImageInfo> images_;
+    /// Per image: byte offset of each block record from data start (NM mask tables only)
+    std::vector<std::vector<uint32_t>> block_offsets_;
+
+    void parseFileHeader();
+    void parseImageSubheader(NitfImageInfo& info);
+    void parseMaskTable(size_t image_index);
+};
+
+} // namespace sar_atr
+
+#endif // NITF_READER_H
@@ -0,0 +1,63 @@
+#ifndef NON_MAX_SUPPRESSION_H
+#define NON_MAX_SUPPRESSION_H
+
+#include "detection_batch.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace sar_atr {
+
+/**
+ * @struct NmsOptions
+ * @brief How overlapping detections of the same class are deduplicated
+ */
+struct NmsOptions {
+    enum class Method {
+        NONE,           ///< Publish every detection above the confidence threshold
+        GREEDY,         ///< Drop every box whose IoU with a higher-scoring box exceeds iou_threshold
+        SOFT_LINEAR,    ///< Scale overlapping scores by (1 - IoU) above iou_threshold instead of dropping them
+        SOFT_GAUSSIAN   ///< Scale every overlapping score by exp(-IoU^2 / sigma)
+    };
+
+    Method method = Method::GREEDY;
+    float iou_threshold = 0.5f;     ///< IoU above which boxes are duplicates (greedy, soft_linear)
+    float sigma = 0.5f;             ///< Gaussian decay width (soft_gaussian)
+};
+
+/**
+ * @brief Parse "none", "greedy", "soft_linear" or "soft_gaussian"
+ * @throws std::runtime_error for any other name
+ */
+NmsOptions::Method parseNmsMethod(const std::string& name);
+
+/// Soft methods drop boxes whose decayed score falls below this, even with a zero confidence threshold
+constexpr float kSoftNmsScoreFloor = 0.001f;
+
+/**
+ * @brief Per-class non-maximum suppression over a subset of a batch
+ *
+ * Boxes are grouped by class and visited in descending confidence. Each
+ * class is laid out in x1 order, so a kept box is only compared against
+ * the run of boxes whose x range can reach it, and those IoUs are computed
+ * a SIMD register at a time (AVX2 or SSE2, scalar elsewhere). Soft methods
+ * pick the next box from a heap of lazily refreshed scores.
+ *
+ * Soft methods write the decayed confidence of every kept box back into
+ * the batch and drop boxes that decay below min_confidence.
+ *
+ * @param candidates Boxes to deduplicate
+ * @param selected In: indices into candidates to consider. Out: the kept indices, ascending
+ * @param count Number of entries in selected
+ * @param min_confidence Lowest score a soft-decayed box may keep (floored at kSoftNmsScoreFloor)
+ * @param scratch Memory for the working columns (e.g. the image's arena)
+ * @return Number of kept indices written to the front of selected
+ */
+size_t suppressNonMaxima(DetectionBatch& candidates, uint32_t* selected, size_t count, const NmsOptions& options,
+                         float min_confidence,
+                         std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+} // namespace sar_atr
+
+#endif // NON_MAX_SUPPRESSION_H
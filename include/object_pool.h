@@ -0,0 +1,111 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class ObjectPool
+ * @brief Recycles heavyweight objects (and the memory they hold) between uses
+ *
+ * acquire() never blocks: when the pool is empty a new T is constructed.
+ * When a lease is dropped the object's reset() is called and, if fewer than
+ * max_cached objects are idle, it goes back on the free list with whatever
+ * capacity it built up; otherwise it is destroyed. The pool must outlive
+ * every lease it hands out.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    /**
+     * @class Lease
+     * @brief An object borrowed from the pool, returned on destruction
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(ObjectPool* pool, std::unique_ptr<T> object) : pool_(pool), object_(std::move(object)) {}
+        ~Lease() { release(); }
+
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                pool_ = other.pool_;
+                object_ = std::move(other.object_);
+                other.pool_ = nullptr;
+            }
+            return *this;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        T* get() const { return object_.get(); }
+        T* operator->() const { return object_.get(); }
+        T& operator*() const { return *object_; }
+        explicit operator bool() const { return static_cast<bool>(object_); }
+
+    private:
+        ObjectPool* pool_ = nullptr;
+        std::unique_ptr<T> object_;
+
+        void release() {
+            if (pool_ && object_) {
+                pool_->giveBack(std::move(object_));
+            }
+        }
+    };
+
+    /**
+     * @param max_cached Idle objects kept for reuse
+     */
+    explicit ObjectPool(size_t max_cached = 64) : max_cached_(max_cached) {}
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /**
+     * @brief Borrow an object, reusing an idle one when available
+     */
+    Lease acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                std::unique_ptr<T> object = std::move(free_.back());
+                free_.pop_back();
+                return Lease(this, std::move(object));
+            }
+        }
+        return Lease(this, std::make_unique<T>());
+    }
+
+    /**
+     * @brief Objects waiting for reuse
+     */
+    size_t idle() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+
+private:
+    const size_t max_cached_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<T>> free_;
+
+    void giveBack(std::unique_ptr<T> object) {
+        object->reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < max_cached_) {
+            free_.push_back(std::move(object));
+        }
+        // Otherwise the object is destroyed when it goes out of scope here
+    }
+};
+
+} // namespace sar_atr
+
+#endif // OBJECT_POOL_H
@@ -0,0 +1,139 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include "async_file_io.h"
+#include "metrics.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class Prefetcher
+ * @brief Warms the page cache for images waiting in the job queue
+ *
+ * The parse stage hint()s each image as soon as it knows the path; a
+ * prefetch thread then reads the NITF headers and asks the kernel
+ * (posix_fadvise WILLNEED) to start reading the first blocks of image data,
+ * so storage latency overlaps with inference on the images ahead of it.
+ * Given an AsyncFileIO, as much of that as the I/O layer has free buffers
+ * for is read outright, all of an image's reads in one submission: network
+ * filesystems may treat the advice as optional, but not a read. When a
+ * worker reaches the image it release()s the hint.
+ *
+ * Read-ahead is bounded twice: at most bytes_per_image per image, and at most
+ * budget_bytes for all images hinted but not yet released, so a long queue
+ * cannot push the pages of the next image out of the cache. Hints that do not
+ * fit are skipped rather than waited for: hint() never blocks the caller.
+ *
+ * Each hint takes any free slot of a fixed set, and prefetch threads pick
+ * hints up oldest first. Workers may release() them in any order (the job
+ * queue is a priority queue), and a hint held by a job waiting behind
+ * more urgent ones only keeps its own slot. Slot path strings keep their
+ * capacity, so hinting does not allocate once the slots have warmed up.
+ * Thread-safe.
+ */
+class Prefetcher {
+public:
+    /**
+     * @param slots Most images hinted at once (normally the job queue capacity)
+     * @param bytes_per_image Most bytes read ahead for one image, headers included
+     * @param budget_bytes Most bytes read ahead for images no worker has reached yet
+     * @param threads Threads issuing the reads (at least 1)
+     * @param metrics Receives prefetch counts (may be null)
+     * @param io Reads ahead through this when given (not owned; must outlive the prefetcher)
+     */
+    Prefetcher(size_t slots, size_t bytes_per_image, size_t budget_bytes, int threads,
+               ServiceMetrics* metrics = nullptr, AsyncFileIO* io = nullptr);
+    ~Prefetcher();
+
+    Prefetcher(const Prefetcher&) = delete;
+    Prefetcher& operator=(const Prefetcher&) = delete;
+
+    /**
+     * @brief Queue an image for read-ahead (never blocks)
+     * @return Ticket to release() once a worker reaches the image; 0 if the hint was skipped
+     */
+    uint64_t hint(const std::string& nitf_path);
+
+    /**
+     * @brief A worker reached (or dropped) the image: return its bytes to the budget
+     *
+     * Cancels the hint if no prefetch thread has got to it yet. No-op for ticket 0.
+     */
+    void release(uint64_t ticket);
+
+    /**
+     * @brief Bytes read ahead (or reserved for queued hints) and not yet released
+     */
+    size_t outstandingBytes() const;
+
+    /**
+     * @brief Drop queued hints and join the threads
+     */
+    void shutdown();
+
+private:
+    enum class State {
+        FREE,       ///< Unused
+        QUEUED,     ///< Waiting for a prefetch thread
+        RUNNING,    ///< A prefetch thread is reading it
+        WARM        ///< Read-ahead issued, waiting for a worker
+    };
+
+    struct Slot {
+        uint64_t ticket = 0;
+        State state = State::FREE;
+        bool released = false;      ///< release() came while RUNNING
+        size_t bytes = 0;           ///< Budget held: reserved while queued, what was read ahead once WARM
+        std::string path;
+    };
+
+    /// Prefetch thread body
+    void run();
+
+    /**
+     * @brief Read the headers of a file and start read-ahead of its first blocks
+     * @return Bytes read or advised, at most limit
+     */
+    size_t warm(const std::string& path, size_t limit);
+
+    /// Closes the file once its last read completes
+    struct OpenFile {
+        explicit OpenFile(int descriptor) : fd(descriptor) {}
+        ~OpenFile();
+        OpenFile(const OpenFile&) = delete;
+        OpenFile& operator=(const OpenFile&) = delete;
+
+        const int fd;
+    };
+
+    /// Read (or advise) one byte range of a file
+    void readAhead(const std::shared_ptr<OpenFile>& file, size_t offset, size_t length);
+
+
+    const size_t bytes_per_image_;
+    const size_t budget_bytes_;
+    ServiceMetrics* metrics_;
+    AsyncFileIO* io_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<Slot> slots_;       ///< Indexed by the low 32 bits of a ticket; a serial fills the rest
+    std::vector<uint32_t> free_slots_;
+    std::vector<uint32_t> queued_;  ///< QUEUED slots, oldest hint first
+    uint64_t next_serial_ = 1;      ///< Serial of the next hint's ticket
+    size_t outstanding_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace sar_atr
+
+#endif // PREFETCHER_H
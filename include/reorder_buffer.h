@@ -0,0 +1,108 @@
+#ifndef REORDER_BUFFER_H
+#define REORDER_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+
+namespace sar_atr {
+
+/**
+ * @class ReorderBuffer
+ * @brief Releases items in sequence order after they finish out of order
+ *
+ * Every sequence number from the first one on is either put() (when its item
+ * is ready) or skip()ped (when it never will be, e.g. a failed image), from
+ * any thread. popReady() hands items back strictly in order, stepping over
+ * skipped numbers and stopping at the first gap. Items are moved in and
+ * out, never copied, and map nodes are recycled through a pool so a steady
+ * stream of sequences does not allocate.
+ */
+template <typename T>
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(uint64_t first_sequence = 1) : next_(first_sequence) {}
+
+    ReorderBuffer(const ReorderBuffer&) = delete;
+    ReorderBuffer& operator=(const ReorderBuffer&) = delete;
+
+    /**
+     * @brief Hold an item until every earlier sequence is released
+     */
+    void put(uint64_t sequence, T item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_.emplace(sequence, std::optional<T>(std::move(item)));
+    }
+
+    /**
+     * @brief Mark a sequence number that will never get an item
+     */
+    void skip(uint64_t sequence) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_.emplace(sequence, std::nullopt);
+    }
+
+    /**
+     * @brief Take the next item in order
+     * @return false if the next sequence has not arrived yet
+     */
+    bool popReady(T& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!held_.empty() && held_.begin()->first <= next_) {
+            auto it = held_.begin();
+            if (it->first == next_) {
+                ++next_;
+            }
+            std::optional<T> slot = std::move(it->second);
+            held_.erase(it);
+            if (slot) {
+                item = std::move(*slot);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Take the lowest held item even if earlier sequences are missing
+     *
+     * For shutdown: whatever is still held goes out in order, gaps and all.
+     *
+     * @return false if nothing is held
+     */
+    bool popAny(T& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!held_.empty()) {
+            auto it = held_.begin();
+            next_ = it->first + 1;
+            std::optional<T> slot = std::move(it->second);
+            held_.erase(it);
+            if (slot) {
+                item = std::move(*slot);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Sequence numbers held (items and skips) waiting on an earlier one
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return held_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    uint64_t next_;
+    std::pmr::unsynchronized_pool_resource nodes_;  ///< Guarded by mutex_ like the map itself
+    std::pmr::map<uint64_t, std::optional<T>> held_{&nodes_};
+};
+
+} // namespace sar_atr
+
+#endif // REORDER_BUFFER_H
@@ -0,0 +1,198 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "detection_batch.h"
+#include "inference_engine.h"
+#include "metrics.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sar_atr {
+
+/**
+ * @struct FileIdentity
+ * @brief What tells two versions of a file at one path apart: device, inode, size and mtime
+ */
+struct FileIdentity {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    int64_t size = 0;
+    int64_t mtime_ns = 0;
+
+    bool operator==(const FileIdentity& other) const {
+        return device == other.device && inode == other.inode && size == other.size && mtime_ns == other.mtime_ns;
+    }
+    bool operator!=(const FileIdentity& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief stat() a file
+ * @return false if it cannot be stat()ed
+ */
+bool readFileIdentity(const std::string& path, FileIdentity& identity);
+
+/**
+ * @class ResultCache
+ * @brief Bounded LRU cache of raw engine output, so a repeated FileLocation skips inference
+ *
+ * Entries are keyed by NITF path and remember the file's identity; a file
+ * that was replaced or touched since (different inode, size or mtime) is a
+ * miss, as is an entry older than the TTL. What is cached is exactly what
+ * the engine produced (candidates and/or detections, before thresholding
+ * and NMS), copied out of the image's arena, so a hit goes through the same
+ * serialize stage as a fresh result.
+ *
+ * Requests are coalesced: the first claim for an image leads and runs the
+ * engine, and claims that arrive while it runs follow and wait for its
+ * result instead of running their own. Lookups never block; only
+ * restore() on a following claim waits.
+ *
+ * Thread-safe.
+ */
+class ResultCache {
+    struct Result;
+    struct Flight;
+
+public:
+    /**
+     * @class Claim
+     * @brief One request's stake in a cache entry (move-only)
+     *
+     * A leading claim that is destroyed or cancel()ed before fill() or
+     * share() fails its followers with an error.
+     */
+    class Claim {
+    public:
+        enum class Kind {
+            BYPASS,     ///< No cache (disabled, or the file could not be stat()ed): run the engine
+            HIT,        ///< Cached result available: restore() it
+            LEAD,       ///< First request for this image: run the engine, then fill()
+            FOLLOW      ///< Another request is running the engine: restore() waits for it
+        };
+
+        Claim() = default;
+        Claim(Claim&& other) noexcept;
+        Claim& operator=(Claim&& other) noexcept;
+        Claim(const Claim&) = delete;
+        Claim& operator=(const Claim&) = delete;
+        ~Claim() { cancel(); }
+
+        Kind kind() const { return kind_; }
+        bool hit() const { return kind_ == Kind::HIT; }
+        bool leads() const { return kind_ == Kind::LEAD; }
+        bool follows() const { return kind_ == Kind::FOLLOW; }
+
+        /**
+         * @brief Give up a leading claim (the engine failed); no-op otherwise
+         */
+        void cancel();
+
+    private:
+        friend class ResultCache;
+
+        ResultCache* cache_ = nullptr;
+        Kind kind_ = Kind::BYPASS;
+        std::string path_;                      ///< Leading claims only: the entry to fill
+        std::shared_ptr<const Result> result_;  ///< HIT
+        std::shared_ptr<Flight> flight_;        ///< LEAD and FOLLOW
+    };
+
+    /**
+     * @param capacity Most images kept (at least 1)
+     * @param ttl Age after which an entry is no longer served (zero = no limit)
+     * @param metrics Receives hit/miss/coalesced/eviction counts (may be null)
+     */
+    ResultCache(size_t capacity, std::chrono::seconds ttl, ServiceMetrics* metrics = nullptr);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * @brief Look an image up, becoming its leader on a miss (never blocks)
+     */
+    Claim claim(const std::string& nitf_path);
+
+    /**
+     * @brief Replace detections and candidates with the cached engine output
+     *
+     * For HIT and FOLLOW claims. A following claim blocks until its leader
+     * fills the entry.
+     *
+     * @throws std::runtime_error if the leader gave up
+     */
+    void restore(Claim& claim, DetectionList& detections, DetectionBatch& candidates);
+
+    /**
+     * @brief Store a leading claim's engine output and wake its followers
+     */
+    void fill(Claim& claim, const DetectionList& detections, const DetectionBatch& candidates);
+
+    /**
+     * @brief Hand a leading claim's output to its followers without storing it
+     *
+     * For output later requests should not be served (e.g. from a degraded
+     * run): the entry is forgotten, so the next request leads again.
+     */
+    void share(Claim& claim, const DetectionList& detections, const DetectionBatch& candidates);
+
+    /**
+     * @brief Number of entries, including images still being inferred
+     */
+    size_t size() const;
+
+    /**
+     * @brief Forget every entry (e.g. once the engines that produced them are replaced)
+     *
+     * Inferences in flight still serve the requests following them, but no
+     * longer fill the cache.
+     */
+    void clear();
+
+private:
+    /// Engine output for one image, on the heap so it outlives the image's arena
+    struct Result {
+        DetectionList detections;
+        DetectionBatch candidates;
+    };
+
+    /// A leader's inference in progress, shared with its followers
+    struct Flight {
+        std::promise<std::shared_ptr<const Result>> promise;
+        std::shared_future<std::shared_ptr<const Result>> result = promise.get_future().share();
+    };
+
+    struct Entry {
+        FileIdentity identity;
+        std::chrono::steady_clock::time_point stored_at;
+        std::shared_ptr<const Result> result;   ///< Null while in flight
+        std::shared_ptr<Flight> flight;         ///< Set while in flight
+    };
+
+    using Node = std::pair<std::string, Entry>;
+
+    /// Drop the least recently used finished entries until within capacity
+    void evictLocked();
+
+    /// A leading claim gave up: forget its entry and fail its followers
+    void abandon(Claim& claim);
+
+    const size_t capacity_;
+    const std::chrono::steady_clock::duration ttl_;
+    ServiceMetrics* metrics_;
+
+    mutable std::mutex mutex_;
+    std::list<Node> lru_;                                                   ///< Most recently used first
+    std::unordered_map<std::string_view, std::list<Node>::iterator> index_; ///< Keys view the node's path
+};
+
+} // namespace sar_atr
+
+#endif // RESULT_CACHE_H
@@ -1,15 +1,176 @@
 #ifndef SAR_ATR_SERVICE_H
 #define SAR_ATR_SERVICE_H
 
-#include "amq_client.h"
+#include "amq_connection_pool.h"
+#include "async_file_io.h"
+#include "bounded_priority_queue.h"
+#include "bounded_queue.h"
+#include "chip_extractor.h"
 #include "config_manager.h"
+#include "detection_batch.h"
+#include "engine_registry.h"
+#include "image_arena.h"
+#include "image_geometry.h"
 #include "inference_engine.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#include "non_max_suppression.h"
+#include "object_pool.h"
+#include "prefetcher.h"
+#include "reorder_buffer.h"
+#include "result_cache.h"
+#include "tiled_inference.h"
 #include "uci_messages.h"
+#include "uci_serializer.h"
 #include <memory>
 #include <atomic>
+#include <string_view>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace sar_atr {
 
+/**
+ * @struct ImageWork
+ * @brief Everything one image allocates on its way through the pipeline
+ *
+ * Candidates, detections and the outgoing message bodies are allocated from
+ * the arena; the path and request strings keep their capacity. Instances are pooled, so
+ * once the pool and the arenas have warmed up an image costs no heap
+ * allocations between the received message and the send queue.
+ */
+struct ImageWork {
+    ImageArena arena;                       ///< Declared first: the containers below allocate from it
+    std::string nitf_path;                  ///< NITF file to process
+    std::string request;                    ///< FileLocation body, when a parse thread needs its own copy
+    ImageDescription geometry;              ///< Read from the file once, the first time a stage needs it
+    DetectionBatch candidates{&arena};      ///< Raw output of engines that emit candidates
+    DetectionList detections{&arena};       ///< Detections left after thresholding and NMS
+    size_t below_threshold = 0;             ///< Detections dropped below the confidence threshold
+    size_t suppressed = 0;                  ///< Detections dropped as duplicates by NMS
+    OutboundBatch messages{&arena};         ///< Entity/ProductMetadata/ProductLocation..., AtrProcessingResult last
+
+    /**
+     * @brief Forget the image, keeping the memory for the next one
+     */
+    void reset() {
+        // Drop the arena-backed containers before rewinding the memory under them
+        DetectionBatch(&arena).swap(candidates);
+        DetectionList(&arena).swap(detections);
+        OutboundBatch(&arena).swap(messages);
+        arena.reset();
+        nitf_path.clear();
+        request.clear();
+        geometry.reset();
+        below_threshold = 0;
+        suppressed = 0;
+    }
+};
+
+using ImageLease = ObjectPool<ImageWork>::Lease;
+
+/*
+ * Pipeline jobs. Each stage hands its job to the next by moving it through a
+ * BoundedQueue (the inference stage's queue runs the most urgent job first);
+ * the types are move-only and carry the image's pooled ImageWork, so
+ * detections and message buffers are never copied on the way. sequence is
+ * the receive order of the FileLocation message (from 1) and is what ordered
+ * output sorts by.
+ */
+
+/**
+ * @struct ReceivedMessage
+ * @brief A FileLocation body (copied into image->request) waiting for a parse thread
+ */
+struct ReceivedMessage {
+    uint64_t sequence = 0;
+    ImageLease image;
+    std::chrono::steady_clock::time_point received_at;   ///< Handed to the parse queue (its wait is PARSE_WAIT)
+    const RequestTopic* topic = nullptr;    ///< Topic it arrived on (an entry of ServiceConfig::request_topics)
+
+    ReceivedMessage() = default;
+    ReceivedMessage(ReceivedMessage&&) = default;
+    ReceivedMessage& operator=(ReceivedMessage&&) = default;
+    ReceivedMessage(const ReceivedMessage&) = delete;
+    ReceivedMessage& operator=(const ReceivedMessage&) = delete;
+};
+
+/**
+ * @struct InferenceJob
+ * @brief A parsed FileLocation request (image->nitf_path) waiting for an inference worker
+ */
+struct InferenceJob {
+    uint64_t sequence = 0;
+    ImageLease image;
+    std::chrono::steady_clock::time_point enqueued_at;    ///< When the job entered the queue
+    ResultCache::Claim cached;                            ///< The image's result cache entry, once looked up
+    uint64_t prefetch_ticket = 0;                         ///< Read-ahead to release when a worker takes the job
+    std::shared_ptr<const EngineRegistry::Engine> engine; ///< Routed engine, held until inference finishes
+    int priority = 0;                                     ///< From the request topic; higher runs first
+    std::chrono::steady_clock::time_point due;            ///< Deadline, or arrival if there is none: earlier runs first
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();     ///< Shed if not started by then
+    bool degraded = false;                                ///< Queued past the SLO: tile with the degraded stride
+
+    InferenceJob() = default;
+    InferenceJob(InferenceJob&&) = default;
+    InferenceJob& operator=(InferenceJob&&) = default;
+    InferenceJob(const InferenceJob&) = delete;
+    InferenceJob& operator=(const InferenceJob&) = delete;
+};
+
+/**
+ * @brief Job queue order: higher priority first, then earlier due, then receive order
+ */
+struct JobOrder {
+    bool operator()(const InferenceJob& a, const InferenceJob& b) const {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        if (a.due != b.due) {
+            return a.due < b.due;
+        }
+        return a.sequence < b.sequence;
+    }
+};
+
+/**
+ * @struct SerializeJob
+ * @brief One image's detections (image->detections) waiting to be turned into UCI messages
+ */
+struct SerializeJob {
+    uint64_t sequence = 0;
+    ImageLease image;
+    std::chrono::milliseconds inference_time{0};
+
+    SerializeJob() = default;
+    SerializeJob(SerializeJob&&) = default;
+    SerializeJob& operator=(SerializeJob&&) = default;
+    SerializeJob(const SerializeJob&) = delete;
+    SerializeJob& operator=(const SerializeJob&) = delete;
+};
+
+/**
+ * @struct PublishJob
+ * @brief One image's complete, ordered message batch (image->messages) waiting for the send queue
+ *
+ * The batch may be empty (nothing above the threshold); it still holds its
+ * place in ordered output.
+ */
+struct PublishJob {
+    uint64_t sequence = 0;
+    ImageLease image;
+
+    PublishJob() = default;
+    PublishJob(PublishJob&&) = default;
+    PublishJob& operator=(PublishJob&&) = default;
+    PublishJob(const PublishJob&) = delete;
+    PublishJob& operator=(const PublishJob&) = delete;
+};
+
 /**
  * @class SarAtrService
  * @brief Main service orchestrator for SAR ATR UCI processing
@@ -21,10 +182,12 @@ public:
     /**
      * @brief Constructor
      * @param config Service configuration
-     * @param inference_engine Pointer to inference engine implementation
+     * @param inference_engine Engine every image goes to; when null, the
+     *        engines in config.engines are built, warmed and routed to
+     * @throws std::runtime_error if an engine cannot be loaded
      */
-    SarAtrService(const ServiceConfig& config, 
-                  std::shared_ptr<InferenceEngine> inference_engine);
+    explicit SarAtrService(const ServiceConfig& config,
+                           std::shared_ptr<InferenceEngine> inference_engine = nullptr);
     
     /**
      * @brief Initialize and start the service
@@ -41,29 +204,262 @@ public:
      */
     bool isRunning() const;
     
+    /**
+     * @brief Ask the service to re-read its configuration file and swap in changed engines
+     *
+     * Only sets a flag (safe from a signal handler); the reload runs on the
+     * thread that called start(). Jobs already routed finish on the engines
+     * they were given.
+     */
+    void requestEngineReload();
+    
+    /**
+     * @brief Ask the service to stop, as stop() does from the thread that called start()
+     *
+     * Only sets a flag (safe from a signal handler): stop() drains and
+     * joins the pipeline threads, which a handler running on one of them
+     * could not do. start() returns once the service has stopped.
+     */
+    void requestStop();
+    
 private:
     ServiceConfig config_;
-    std::shared_ptr<InferenceEngine> inference_engine_;
-    std::unique_ptr<AMQClient> amq_client_;
+    EngineRegistry engines_;
+    ServiceMetrics metrics_;                          ///< Outlives the AMQ connections that record into it
+    std::unique_ptr<AMQConnectionPool> amq_pool_;
     std::atomic<bool> running_;
+    std::atomic<bool> reload_requested_;
+    std::atomic<bool> stop_requested_;
     SystemInfo system_info_;
+    UciSerializer uci_serializer_;
+    ObjectPool<ImageWork> image_pool_;                ///< Declared before every stage that holds leases
+    
+    // Stages: parse -> inference -> serialize -> publish. A stage with no
+    // threads runs inline on the thread of the stage before it.
+    std::atomic<uint64_t> next_sequence_;
+    BoundedQueue<ReceivedMessage> parse_queue_;
+    BoundedPriorityQueue<InferenceJob, JobOrder> job_queue_;
+    BoundedQueue<SerializeJob> serialize_queue_;
+    BoundedQueue<PublishJob> publish_queue_;
+    ReorderBuffer<PublishJob> reorder_;               ///< Finished images held back for ordered output
+    std::mutex release_mutex_;                        ///< Held by the one thread releasing ordered output
+    std::atomic<bool> release_requested_;             ///< Set when the releasing thread should look again
+    // The receive thread never waits for queue space: the one message that
+    // does not fit is held here and reading stops until a consumer makes room
+    std::mutex held_mutex_;
+    std::atomic<bool> receive_paused_;
+    InferenceJob held_job_;                           ///< parse_threads == 0: waiting for the job queue
+    ReceivedMessage held_message_;                    ///< Otherwise: waiting for the parse queue
+    std::vector<std::thread> parse_workers_;
+    std::vector<std::thread> workers_;
+    std::vector<std::thread> serialize_workers_;
+    std::vector<std::thread> publish_workers_;
+    std::unique_ptr<AsyncFileIO> file_io_;             ///< Declared before the chip extractor and prefetcher using it
+    std::unique_ptr<TiledInferenceRunner> tiler_;
+    std::unique_ptr<ResultCache> result_cache_;
+    std::unique_ptr<Prefetcher> prefetcher_;
+    ConnectionOptions connection_options_;
+    NmsOptions nms_options_;
+    ChipOptions chip_options_;
+    std::unique_ptr<ChipExtractor> chip_extractor_;
+    std::unique_ptr<MetricsServer> metrics_server_;   ///< Declared last: stops before what it renders
     
     /**
      * @brief Handle incoming FileLocation UCI messages
+     * 
+     * Runs on the AMQ event loop thread: numbers the message and parses it
+     * (or queues it for a parse thread) so the socket keeps being serviced
+     * during inference. Never blocks on a full queue, since the loop also
+     * flushes the publishers' sends: the message is held and deliveries
+     * pause until the queue drains (see holdReceived()).
+     */
+    void handleFileLocationMessage(std::string_view message, const RequestTopic& topic);
+    
+    /**
+     * @brief Parse stage: extract the NITF path into the image and queue it for inference
+     *
+     * The job takes its priority from the topic, and its deadline from the
+     * topic's deadline_ms counted from the message's timestamp. When the
+     * queue is full, a more urgent job displaces the one that would run last.
+     */
+    void parseMessage(uint64_t sequence, std::string_view message, ImageLease image, const RequestTopic& topic);
+    
+    /**
+     * @brief The receive thread's job or message did not fit its queue: hold it and stop reading
+     *
+     * The broker then backs up through TCP rather than losing deliveries
+     * (subscriptions acknowledge automatically).
+     */
+    void holdReceived(InferenceJob& job);
+    void holdReceived(ReceivedMessage& message);
+    
+    /**
+     * @brief Called by a consumer after taking from its queue: queue the held item and read again
+     */
+    void resumeReceive();
+    
+    /**
+     * @brief Parse stage body, for messages the receive thread queued
+     */
+    void parseLoop(int worker_id);
+    
+    /**
+     * @brief Worker thread body: pull batches of jobs off the queue until it is closed
+     */
+    void workerLoop(int worker_id);
+    
+    /**
+     * @brief Run inference for a batch of jobs and hand each image's results on
+     *
+     * Images the result cache already has (or another worker is inferring)
+     * skip the engine.
+     */
+    void processJobs(std::vector<InferenceJob>& jobs);
+    
+    /**
+     * @brief Load shedding for a job a worker just took off the queue
+     *
+     * Past its deadline, or (with queue_slo_ms) queued for longer than the
+     * SLO under overload_action shed, the job is shed and false returned.
+     * Over the SLO under degrade, it is marked degraded instead. Runs before
+     * the job claims its cache entry, so a shed job never leads others.
+     */
+    bool admit(InferenceJob& job, std::chrono::steady_clock::time_point now);
+    
+    /**
+     * @brief Move a degraded job to degraded_engine, or keep it undegraded if nothing is cheaper
+     */
+    void degrade(InferenceJob& job);
+    
+    /**
+     * @brief Give up a queued job to make way for fresher or more urgent ones
+     */
+    void shedJob(InferenceJob& job, const char* reason);
+    
+    /**
+     * @brief Run one engine on whole-image jobs, as one processBatch() call when there are several
+     */
+    void runBatch(InferenceJob* jobs, size_t count);
+    
+    /**
+     * @brief Hand on a job whose results come from the result cache (waits if another request is inferring it)
+     */
+    void finishCached(InferenceJob job);
+    
+    /**
+     * @brief Run inference for one job and hand its results on
+     */
+    void processJob(InferenceJob& job);
+    
+    /**
+     * @brief Serialize stage body, for jobs handed over by the inference stage
+     */
+    void serializeLoop(int worker_id);
+    
+    /**
+     * @brief Publish stage body, for batches handed over by the serialize stage
+     */
+    void publishLoop(int worker_id);
+    
+    /**
+     * @brief Pass an image's detections to the serialize stage
+     */
+    void handOffToSerialize(SerializeJob job);
+    
+    /**
+     * @brief Pass an image's message batch to the publish stage
+     */
+    void handOffToPublish(PublishJob job);
+    
+    /**
+     * @brief Give up an image's place in ordered output (dropped or failed)
+     */
+    void skipSequence(uint64_t sequence);
+    
+    /**
+     * @brief Publish a batch, or with ordered output, whatever it lets through
+     */
+    void publishInOrder(PublishJob job);
+    
+    /**
+     * @brief Publish every batch whose turn has come
+     *
+     * Never blocks: if another thread is already releasing, it is asked to
+     * look again once done, so a batch is never stranded and the event loop
+     * thread never waits behind a publisher.
+     */
+    void releaseInOrder();
+    
+    /**
+     * @brief Run the engine on one image, tiling it when configured and worthwhile
+     *
+     * Fills image.candidates for engines that emit candidates (untiled) and
+     * image.detections otherwise. Degraded images are tiled with
+     * degraded_tile_overlap.
+     */
+    void runInference(InferenceEngine& engine, ImageWork& image, bool degraded);
+    
+    /**
+     * @brief Whether runInference() would tile this image on this engine
+     */
+    bool wouldTile(const InferenceEngine& engine, ImageWork& image) const;
+    
+    /**
+     * @brief Re-read the configuration file and load its engines; keeps the running ones on failure
+     */
+    void reloadEngines();
+    
+    /**
+     * @brief Log inference summary for one image and hand its results to the serialize stage
+     */
+    void finishInference(InferenceJob job, std::chrono::milliseconds inference_time);
+    
+    /**
+     * @brief Serialize stage: write chips and build the image's message batch
+     */
+    void serializeResults(SerializeJob& job);
+    
+    /**
+     * @brief Threshold and deduplicate an image's detections
+     *
+     * Works on image.candidates, or on a columnar copy of image.detections
+     * for engines that fill the list themselves; either way image.detections
+     * ends up holding only the survivors, in engine order.
+     */
+    void filterDetections(ImageWork& image);
+    
+    /**
+     * @brief Start every stage's threads (no-op if already running)
+     */
+    void startWorkers();
+    
+    /**
+     * @brief Close the stage queues front to back, letting each stage drain, and join the threads
+     */
+    void stopWorkers();
+    
+    /**
+     * @brief Sample the queue depth gauges and render all metrics
+     */
+    std::string renderMetrics();
+    
+    /**
+     * @brief Build every UCI message for one image's detections into image.messages, in publish order
      */
-    void handleFileLocationMessage(const std::string& message);
+    void buildResultMessages(ImageWork& image);
     
     /**
-     * @brief Process detections and publish UCI messages
+     * @brief Hand one image's batch to the send queue
      */
-    void processAndPublishResults(const std::string& nitf_path,
-                                   const std::vector<DetectionResult>& detections);
+    void publishResults(const PublishJob& job);
     
     /**
      * @brief Calculate and log bandwidth savings from chip-based transmission
+     *
+     * @param boxes Detections of the image; only those at or above the threshold are counted
      */
-    void calculateBandwidthSavings(const std::string& nitf_path,
-                                    const std::vector<DetectionResult>& detections,
+    void calculateBandwidthSavings(const ImageGeometry& geometry,
+                                    const DetectionBatch& boxes,
                                     int published_count);
 };
 
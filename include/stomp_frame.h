@@ -0,0 +1,66 @@
+#ifndef STOMP_FRAME_H
+#define STOMP_FRAME_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace sar_atr {
+
+/**
+ * @brief Exact size of the STOMP SEND frame appendStompSendFrame() writes
+ */
+size_t stompSendFrameSize(std::string_view topic, std::string_view body, std::string_view receipt = {});
+
+/**
+ * @brief Append a STOMP 1.2 SEND frame for /topic/<topic> with a JSON body
+ *
+ * Writes the command, destination, receipt (if any), content-type and
+ * content-length headers, the body and the NUL terminator, reserving the
+ * full size once.
+ *
+ * @param topic Topic name (without the /topic/ prefix)
+ * @param body Message body
+ * @param out String the frame is appended to
+ * @param receipt Receipt id the broker should acknowledge the frame with; empty = none
+ */
+void appendStompSendFrame(std::string_view topic, std::string_view body, std::string& out,
+                          std::string_view receipt = {});
+
+/**
+ * @struct StompFrame
+ * @brief One received STOMP frame, as views into the bytes it was parsed from
+ *
+ * Nothing is copied: the views are only valid as long as the source buffer.
+ * Header values are returned as sent; STOMP 1.2 escape sequences are not
+ * decoded, which is fine for the ids and destinations this client looks at.
+ */
+struct StompFrame {
+    std::string_view command;
+    std::string_view headers;   ///< Raw header block, one name:value per line
+    std::string_view body;      ///< content-length bytes, or up to the NUL terminator
+
+    /**
+     * @brief Value of the first header with this name, or an empty view
+     */
+    std::string_view header(std::string_view name) const;
+
+    bool hasHeader(std::string_view name) const;
+};
+
+/**
+ * @brief Split a STOMP frame into command, header block and body
+ *
+ * Accepts LF and CRLF line endings and skips heart-beat EOLs in front of
+ * the command.
+ *
+ * @param data Frame bytes (one WebSocket message)
+ * @param frame Receives the views on success
+ * @return false if data holds only heart-beats
+ * @throws std::runtime_error if the frame is truncated or content-length is invalid
+ */
+bool parseStompFrame(std::string_view data, StompFrame& frame);
+
+} // namespace sar_atr
+
+#endif // STOMP_FRAME_H
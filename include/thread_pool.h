@@ -0,0 +1,67 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "bounded_queue.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of threads running tasks from a bounded queue
+ *
+ * submit() blocks while the queue is full, so a producer can never have more
+ * than queue_capacity tasks waiting. Tasks must not submit to the pool they
+ * run on and then wait for the result.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param name Label used in log messages
+     * @param thread_count Number of threads (0 = one per core)
+     * @param queue_capacity Maximum tasks waiting for a thread
+     */
+    ThreadPool(const std::string& name, int thread_count, size_t queue_capacity);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a callable and get a future for its result
+     * @throws std::runtime_error if the pool has been shut down
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<typename std::invoke_result<F>::type> {
+        using Result = typename std::invoke_result<F>::type;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    /**
+     * @brief Stop accepting tasks, finish the queued ones and join the threads
+     */
+    void shutdown();
+
+    size_t threadCount() const { return threads_.size(); }
+
+private:
+    std::string name_;
+    BoundedQueue<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+
+    void enqueue(std::function<void()> task);
+    void run();
+};
+
+} // namespace sar_atr
+
+#endif // THREAD_POOL_H
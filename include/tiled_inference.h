@@ -0,0 +1,99 @@
+#ifndef TILED_INFERENCE_H
+#define TILED_INFERENCE_H
+
+#include "inference_engine.h"
+#include "thread_pool.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @struct TilingOptions
+ * @brief How large images are split for tiled inference
+ */
+struct TilingOptions {
+    int tile_size = 1024;                ///< Tile edge length in pixels
+    int overlap = 128;                   ///< Pixels shared by neighbouring tiles
+    int threads = 0;                     ///< Tile worker threads (0 = one per core)
+    float merge_overlap_threshold = 0.5f; ///< Min intersection-over-smaller-box to merge seam duplicates
+};
+
+/**
+ * @brief Split an image into overlapping tiles covering every pixel
+ *
+ * Tiles step by tile_size - overlap; the last row/column of tiles is shifted
+ * back so it ends exactly at the image edge instead of running past it.
+ */
+std::vector<ImageTile> planTiles(int image_cols, int image_rows, int tile_size, int overlap);
+
+/**
+ * @brief Convert tile-normalized boxes into full-image normalized coordinates
+ */
+void mapTileDetections(const ImageTile& tile, DetectionList& detections);
+
+/**
+ * @brief Merge duplicate detections of the same target across tile seams
+ *
+ * Two detections of the same class from different tiles are duplicates when
+ * their intersection covers at least min_overlap of the smaller box (a
+ * target cut by a seam yields one truncated box). Duplicates collapse into
+ * the union of the boxes, keeping the highest confidence and its output path.
+ *
+ * @param detections Full-image detections
+ * @param tile_indices Tile each detection came from (same length as detections)
+ * @param min_overlap Intersection-over-smaller-box threshold
+ * @param merged Receives the merged detections (appended, in its own memory)
+ */
+void mergeTileDetections(const DetectionList& detections, const std::vector<int>& tile_indices,
+                         float min_overlap, DetectionList& merged);
+
+/**
+ * @class TiledInferenceRunner
+ * @brief Streams an image through an engine tile by tile on a shared pool
+ *
+ * Tiles are submitted to a bounded thread pool, so at most a pool's worth of
+ * tiles is in flight per image and tiles of one image run in parallel.
+ */
+class TiledInferenceRunner {
+public:
+    explicit TiledInferenceRunner(const TilingOptions& options);
+
+    /**
+     * @brief Whether an image of this size should be tiled at all
+     */
+    bool shouldTile(int image_cols, int image_rows) const;
+
+    /**
+     * @brief Run the engine over every tile and merge the results
+     *
+     * Tiles fill their own heap lists on the pool threads (an image arena
+     * is single-threaded); only the merged result is copied into detections.
+     *
+     * @param detections Receives detections in full-image normalized coordinates
+     * @throws std::runtime_error if any tile fails
+     */
+    void run(InferenceEngine& engine, const std::string& nitf_path, int image_cols, int image_rows,
+             DetectionList& detections);
+
+    /**
+     * @brief run() with a different overlap than configured, e.g. a smaller
+     *        one for a coarser stride and fewer tiles under load
+     */
+    void run(InferenceEngine& engine, const std::string& nitf_path, int image_cols, int image_rows, int overlap,
+             DetectionList& detections);
+
+    /**
+     * @brief Stop the tile pool (waits for running tiles)
+     */
+    void shutdown();
+
+private:
+    TilingOptions options_;
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+} // namespace sar_atr
+
+#endif // TILED_INFERENCE_H
@@ -1,18 +1,42 @@
 #ifndef UCI_MESSAGES_H
 #define UCI_MESSAGES_H
 
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <json/json.h>
 #include "inference_engine.h"
 
 namespace sar_atr {
 
+/// Characters in a formatted UUID (8-4-4-4-12 hex digits)
+constexpr size_t kUuidLength = 36;
+
+/// Characters in a timestamp such as 2026-01-31T23:59:59.123Z
+constexpr size_t kTimestampLength = 24;
+
+/**
+ * @brief Write a random UUID v4 into out (exactly kUuidLength chars, no terminator)
+ *
+ * Draws 128 bits at once from a per-thread xoshiro256** generator seeded from
+ * std::random_device. Thread-safe and allocation-free.
+ */
+void generateUUID(char* out);
+
 /**
  * @brief Generate a UUID v4 string
  */
 std::string generateUUID();
 
+/**
+ * @brief Write a UTC ISO 8601 timestamp with milliseconds (kTimestampLength chars, no terminator)
+ *
+ * The "YYYY-MM-DDTHH:MM:SS." prefix is cached per thread and only
+ * reformatted when the second changes. Thread-safe and allocation-free.
+ */
+void formatTimestamp(char* out, std::chrono::system_clock::time_point time);
+
 /**
  * @brief Get current timestamp in ISO 8601 format
  */
@@ -28,19 +52,64 @@ struct SystemInfo {
     std::string service_version;
 };
 
+/**
+ * @brief Find the file path in a FileLocation message without building a DOM
+ *
+ * Walks FileLocation.MessageData.LocationAndStatus.Location.Network.Address,
+ * skipping every other member unparsed, then checks that the document ends
+ * after closing those objects.
+ *
+ * @param json_message The JSON string of the FileLocation message
+ * @param address Receives a view into json_message (set only on success)
+ * @return false if the message is malformed or truncated, the path is
+ *         missing or empty, a key on the path appears twice, or the address
+ *         contains escapes that need decoding
+ */
+bool findFileLocationAddress(std::string_view json_message, std::string_view& address);
+
+/**
+ * @brief Find when a FileLocation message was issued, without building a DOM
+ *
+ * Reads FileLocation.MessageHeader.Timestamp as a UTC ISO 8601 time in the
+ * form formatTimestamp() writes ("YYYY-MM-DDTHH:MM:SS", optional fraction,
+ * trailing Z), to the millisecond.
+ *
+ * @param json_message The JSON string of the FileLocation message
+ * @param timestamp Receives the time (set only on success)
+ * @return false if the message is malformed or has no timestamp in that form
+ */
+bool findFileLocationTimestamp(std::string_view json_message, std::chrono::system_clock::time_point& timestamp);
+
 /**
  * @brief Parse FileLocation UCI message to extract NITF file path
+ *
+ * Uses findFileLocationAddress() and only falls back to a full JSON parse
+ * when the fast path cannot answer.
+ *
+ * @param json_message The JSON string of the FileLocation message
+ * @return The file path extracted from the message
+ * @throws std::runtime_error if parsing fails
+ */
+std::string parseFileLocationMessage(std::string_view json_message);
+
+/**
+ * @brief The full JSON parse behind parseFileLocationMessage()
+ *
+ * For callers that already tried findFileLocationAddress() on the message.
+ *
  * @param json_message The JSON string of the FileLocation message
  * @return The file path extracted from the message
  * @throws std::runtime_error if parsing fails
  */
-std::string parseFileLocationMessage(const std::string& json_message);
+std::string parseFileLocationJson(std::string_view json_message);
 
 /**
  * @brief Create Entity UCI message from detection result
  * @param detection The detection result from inference engine
  * @param system_info System identification information
  * @return JSON string of the Entity message
+ * @note The generated EntityID is not returned; UciSerializer::entity() returns
+ *       it alongside the message
  */
 std::string createEntityMessage(const DetectionResult& detection, const SystemInfo& system_info);
 
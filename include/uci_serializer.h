@@ -0,0 +1,141 @@
+#ifndef UCI_SERIALIZER_H
+#define UCI_SERIALIZER_H
+
+#include "inference_engine.h"
+#include "uci_messages.h"
+#include <array>
+#include <deque>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @struct UciMessage
+ * @brief A serialized message together with the ID generated for it
+ */
+struct UciMessage {
+    std::pmr::string body;  ///< JSON bytes, ready to publish (in the context's memory)
+    std::string_view uuid;  ///< UUID minted for this message (EntityID, ProductMetadataID, ...); owned by the context
+};
+
+/**
+ * @class ImageMessageContext
+ * @brief Timestamp, UUIDs and memory shared by every message published for one image
+ *
+ * The timestamp is taken once and the expected number of UUIDs is generated
+ * up front, so all of an image's messages carry the same time and the
+ * generator is not revisited per message. More UUIDs are minted on demand if
+ * the estimate was short. UUIDs live in the context's memory resource (the
+ * image arena on the service path) and the views handed out stay valid for
+ * the context's lifetime. Not thread-safe; use one context per image.
+ */
+class ImageMessageContext {
+public:
+    /**
+     * @param expected_uuids UUIDs to pre-generate (e.g. two per published detection)
+     * @param memory Where UUIDs and message bodies are allocated
+     */
+    explicit ImageMessageContext(size_t expected_uuids = 0,
+                                 std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    ImageMessageContext(const ImageMessageContext&) = delete;
+    ImageMessageContext& operator=(const ImageMessageContext&) = delete;
+
+    std::string_view timestamp() const { return std::string_view(timestamp_.data(), timestamp_.size()); }
+
+    /**
+     * @brief Hand out the next unused UUID
+     */
+    std::string_view nextUuid();
+
+    std::pmr::memory_resource* memory() const { return memory_; }
+
+private:
+    using Uuid = std::array<char, kUuidLength>;
+
+    std::pmr::memory_resource* memory_;
+    std::array<char, kTimestampLength> timestamp_;
+    std::pmr::deque<Uuid> uuids_;   ///< Deque so growing never moves handed-out UUIDs
+    size_t next_;
+};
+
+/**
+ * @class UciSerializer
+ * @brief Renders outgoing UCI messages from precompiled JSON templates
+ *
+ * Everything that does not change between messages, including the
+ * MessageHeader subtree derived from SystemInfo, is rendered once in the
+ * constructor. Each message is then the static segments copied in order with
+ * the dynamic fields (UUIDs, timestamps, box numbers, paths) written between
+ * them, into a buffer reserved to its final size up front.
+ *
+ * Output matches the jsoncpp writer used before (same key order, compact),
+ * except that floats use the shortest representation that round-trips.
+ * Instances are immutable after construction and safe to share across threads.
+ */
+class UciSerializer {
+public:
+    explicit UciSerializer(const SystemInfo& system_info);
+
+    /**
+     * @brief Entity message for a detection
+     * @return Message bytes and the new EntityID UUID
+     */
+    UciMessage entity(const DetectionResult& detection, ImageMessageContext& context) const;
+
+    /**
+     * @brief ProductMetadata message referencing an entity
+     * @return Message bytes and the new ProductMetadataID UUID
+     */
+    UciMessage productMetadata(std::string_view entity_uuid, ImageMessageContext& context) const;
+
+    /**
+     * @brief ProductLocation message pointing at a product file
+     */
+    std::pmr::string productLocation(std::string_view product_metadata_uuid, std::string_view output_file_path,
+                                     const ImageMessageContext& context) const;
+
+    static std::pmr::string atrProcessingResult(const std::pmr::vector<std::string_view>& entity_uuids);
+
+    /**
+     * @name Append variants
+     * Render into an existing buffer (e.g. one reused across messages).
+     * String is std::string or std::pmr::string.
+     */
+    ///@{
+    template <typename String>
+    void appendEntity(String& out, const DetectionResult& detection, std::string_view entity_uuid,
+                      std::string_view timestamp) const;
+    template <typename String>
+    void appendProductMetadata(String& out, std::string_view product_metadata_uuid,
+                               std::string_view entity_uuid, std::string_view timestamp) const;
+    template <typename String>
+    void appendProductLocation(String& out, std::string_view product_metadata_uuid,
+                               std::string_view output_file_path, std::string_view timestamp) const;
+    template <typename String>
+    static void appendAtrProcessingResult(String& out, const std::pmr::vector<std::string_view>& entity_uuids);
+    ///@}
+
+private:
+    /// "MessageHeader":{..."Timestamp":" - the timestamp value follows
+    std::string header_;
+};
+
+/**
+ * @brief Append a JSON string literal (quoted and escaped)
+ */
+template <typename String>
+void appendJsonString(String& out, std::string_view value);
+
+/**
+ * @brief Append the shortest decimal form of a float that parses back to the same value
+ */
+template <typename String>
+void appendJsonNumber(String& out, float value);
+
+} // namespace sar_atr
+
+#endif // UCI_SERIALIZER_H
@@ -0,0 +1,160 @@
+#ifndef WEBSOCKET_FRAME_H
+#define WEBSOCKET_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sar_atr {
+
+/**
+ * @brief WebSocket opcodes (RFC 6455 section 5.2)
+ */
+enum class WebSocketOpcode : uint8_t {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+};
+
+/**
+ * @struct WebSocketFrame
+ * @brief One decoded WebSocket frame
+ *
+ * The payload is a view into the buffer that was parsed and is only valid
+ * until that buffer is consumed or written to again.
+ */
+struct WebSocketFrame {
+    bool fin;                   ///< Final fragment of a message
+    WebSocketOpcode opcode;     ///< Frame opcode
+    std::string_view payload;   ///< Unmasked payload bytes (view into the source buffer)
+
+    bool isControl() const { return (static_cast<uint8_t>(opcode) & 0x8) != 0; }
+};
+
+/**
+ * @brief Largest frame payload accepted before the stream is treated as corrupt
+ */
+constexpr size_t kMaxWebSocketPayload = 64 * 1024 * 1024;
+
+/**
+ * @brief Parse one WebSocket frame from the front of a buffer
+ *
+ * Masked payloads are unmasked in place, which is why the buffer is mutable.
+ *
+ * @param data Start of the unparsed bytes
+ * @param length Number of unparsed bytes available
+ * @param frame Receives the decoded frame when a complete frame is present
+ * @return Number of bytes the frame occupies, or 0 if more data is needed
+ * @throws std::runtime_error if the frame header is invalid
+ */
+size_t parseWebSocketFrame(char* data, size_t length, WebSocketFrame& frame);
+
+/**
+ * @brief Number of header bytes a masked client frame needs for a payload
+ */
+size_t webSocketHeaderSize(size_t payload_length);
+
+/**
+ * @brief XOR a payload with a 4-byte WebSocket masking key
+ *
+ * Processes a SIMD register (AVX2/SSE2/NEON, whichever the build targets)
+ * or a machine word at a time; src and dst may be the same buffer.
+ *
+ * @param src Payload bytes
+ * @param dst Output, at least length bytes
+ * @param length Payload length
+ * @param mask Masking key in wire order
+ */
+void maskWebSocketPayload(const char* src, char* dst, size_t length, const unsigned char mask[4]);
+
+/**
+ * @brief Generate a masking key for one client frame
+ *
+ * Draws from a per-thread generator seeded from std::random_device, so a
+ * fresh key per frame costs a few nanoseconds and needs no locking.
+ */
+void generateWebSocketMask(unsigned char mask[4]);
+
+/**
+ * @brief Append the header of a masked client frame, masking key included
+ *
+ * For encoding in place: the caller appends the payload_length payload
+ * bytes right after the header and masks them with maskWebSocketPayload()
+ * using the same key.
+ *
+ * @param payload_length Length of the payload that will follow
+ * @param opcode Frame opcode (FIN is always set)
+ * @param out String the header is appended to
+ * @param mask Receives the freshly generated masking key
+ */
+void appendWebSocketHeader(size_t payload_length, WebSocketOpcode opcode, std::string& out, unsigned char mask[4]);
+
+/**
+ * @brief Append a complete masked client frame to out
+ *
+ * The output is sized once up front and header and masked payload are
+ * written straight into it.
+ *
+ * @param payload Frame payload
+ * @param opcode Frame opcode (FIN is always set)
+ * @param out String the frame is appended to
+ */
+void appendWebSocketFrame(std::string_view payload, WebSocketOpcode opcode, std::string& out);
+
+/**
+ * @class ReceiveBuffer
+ * @brief Linear socket receive buffer with consumed-byte tracking
+ *
+ * Bytes are appended at the write end by recv() and consumed from the read
+ * end by the frame parser. Unconsumed bytes are moved to the front only when
+ * more write space is needed, so a partial frame survives across reads and
+ * several frames in one read are all parsed.
+ */
+class ReceiveBuffer {
+public:
+    explicit ReceiveBuffer(size_t initial_capacity = 64 * 1024);
+
+    /**
+     * @brief Get space for at least min_space more bytes
+     *
+     * May move unconsumed data, which invalidates outstanding views.
+     */
+    char* prepareWrite(size_t min_space);
+
+    /**
+     * @brief Bytes available at the pointer returned by prepareWrite()
+     */
+    size_t writableSize() const { return buffer_.size() - write_pos_; }
+
+    /**
+     * @brief Mark n bytes written after prepareWrite()
+     */
+    void commitWrite(size_t n) { write_pos_ += n; }
+
+    char* readableData() { return buffer_.data() + read_pos_; }
+    size_t readableSize() const { return write_pos_ - read_pos_; }
+
+    /**
+     * @brief Drop n bytes from the read end
+     */
+    void consume(size_t n);
+
+    /**
+     * @brief Discard all buffered data
+     */
+    void clear() { read_pos_ = write_pos_ = 0; }
+
+private:
+    std::vector<char> buffer_;
+    size_t read_pos_;
+    size_t write_pos_;
+};
+
+} // namespace sar_atr
+
+#endif // WEBSOCKET_FRAME_H
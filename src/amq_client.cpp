@@ -2,6 +2,8 @@
 #include "logger.h"
 #include <stdexcept>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -11,29 +13,93 @@
 #include <iomanip>
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <random>
 
 namespace sar_atr {
 
-AMQClient::AMQClient() : socket_fd_(-1), connected_(false), running_(false), port_(0) {
+namespace {
+
+constexpr size_t kReadChunk = 8192;
+constexpr size_t kMaxHandshakeResponse = 16 * 1024;
+
+#ifdef IOV_MAX
+constexpr size_t kMaxIov = IOV_MAX;
+#else
+constexpr size_t kMaxIov = 1024;
+#endif
+
+// Written send buffers kept for reuse, and the largest one worth keeping
+constexpr size_t kMaxSpareBuffers = 64;
+constexpr size_t kMaxSpareBufferBytes = 256 * 1024;
+
+} // namespace
+
+std::chrono::milliseconds reconnectDelay(const ConnectionOptions& options, unsigned attempt) {
+    long long delay = std::max<long long>(options.reconnect_initial_delay.count(), 1);
+    const long long cap = std::max<long long>(delay, options.reconnect_max_delay.count());
+    for (unsigned i = 0; i < attempt && delay < cap; ++i) {
+        delay *= 2;
+    }
+    delay = std::min(delay, cap);
+    
+    thread_local std::mt19937_64 generator(std::random_device{}());
+    std::uniform_int_distribution<long long> jitter(delay / 2, delay);
+    return std::chrono::milliseconds(jitter(generator));
+}
+
+AMQClient::AMQClient() : AMQClient(std::make_shared<EventLoop>()) {
+    owns_loop_ = true;
+}
+
+AMQClient::AMQClient(std::shared_ptr<EventLoop> loop)
+    : loop_(std::move(loop)), owns_loop_(false), state_(State::DISCONNECTED), connected_(false),
+      disconnecting_(false), session_(false), port_(0),
+      socket_fd_(-1), want_write_(false), read_paused_(false), next_subscription_(0), metrics_(nullptr), heartbeat_send_(0), heartbeat_receive_(0),
+      heartbeat_timer_(0), linger_timer_(0), queued_bytes_(0), flush_posted_(false), detached_(false),
+      resuming_(false), next_receipt_(1),
+      write_index_(0), write_offset_(0), writing_bytes_(0), in_fragmented_message_(false) {
 }
 
 AMQClient::~AMQClient() {
     disconnect();
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        detached_ = true;
+    }
+    if (owns_loop_) {
+        loop_->stop();
+    } else {
+        // Let tasks that still reference this client finish before it goes away
+        loop_->runSync([]() {});
+    }
 }
 
-bool AMQClient::connectSocket(const std::string& broker_address) {
+void AMQClient::connect(const std::string& broker_address) {
+    Logger::info("Connecting to AMQ broker: " + broker_address);
+    
+    if (loop_->inLoopThread()) {
+        throw std::runtime_error("connect() must not be called from the event loop thread");
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (state_ != State::DISCONNECTED || session_) {
+            throw std::runtime_error("Already connected or connecting");
+        }
+    }
+    
     // Parse WebSocket URL (ws://host:port/path)
     size_t pos = broker_address.find("://");
     if (pos == std::string::npos) {
-        Logger::error("Invalid WebSocket URL format");
-        return false;
+        throw std::runtime_error("Invalid WebSocket URL format: " + broker_address);
     }
     
     std::string url = broker_address.substr(pos + 3);
     pos = url.find(':');
     if (pos == std::string::npos) {
-        Logger::error("Port not specified in URL");
-        return false;
+        throw std::runtime_error("Port not specified in URL: " + broker_address);
     }
     
     host_ = url.substr(0, pos);
@@ -49,43 +115,136 @@ bool AMQClient::connectSocket(const std::string& broker_address) {
     }
     
     Logger::info("Connecting to " + host_ + ":" + std::to_string(port_) + path_);
+    openConnection(false);
     
-    // Resolve hostname
-    struct hostent* server = gethostbyname(host_.c_str());
-    if (server == nullptr) {
-        Logger::error("Failed to resolve hostname: " + host_);
-        return false;
+    // From here a lost connection is re-established in the background
+    bool reconnect;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        session_ = true;
+        reconnect = connection_options_.reconnect;
+    }
+    if (reconnect && !reconnect_thread_.joinable()) {
+        reconnect_thread_ = std::thread(&AMQClient::reconnectLoop, this);
+    }
+}
+
+void AMQClient::openConnection(bool reconnecting) {
+    // Name resolution is the one blocking step, so it stays off the loop thread
+    // (and is repeated on reconnects, in case a failover moved the name)
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* resolved = nullptr;
+    if (getaddrinfo(host_.c_str(), nullptr, &hints, &resolved) != 0 || resolved == nullptr) {
+        throw std::runtime_error("Failed to resolve hostname: " + host_);
     }
+    struct sockaddr_in address;
+    memcpy(&address, resolved->ai_addr, sizeof(address));
+    address.sin_port = htons(static_cast<uint16_t>(port_));
+    freeaddrinfo(resolved);
     
-    // Create socket
-    socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    loop_->start();
+    
+    std::chrono::milliseconds timeout;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        state_ = State::TCP_CONNECTING;
+        failure_reason_.clear();
+        disconnecting_ = false;
+        timeout = connection_options_.connect_timeout;
+    }
+    loop_->post([this, address]() {
+        beginConnect(address);
+    });
+    
+    // Done as soon as CONNECTED arrives or the state machine gives up; a
+    // reconnect attempt also gives up when disconnect() ends the session
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    bool abandoned = false;
+    bool settled = state_cv_.wait_for(lock, timeout, [this, reconnecting, &abandoned]() {
+        abandoned = reconnecting && !session_;
+        return state_ == State::CONNECTED || state_ == State::DISCONNECTED || abandoned;
+    });
+    if (state_ == State::CONNECTED) {
+        return;
+    }
+    std::string reason = abandoned ? std::string("Disconnected while reconnecting")
+                       : settled ? failure_reason_
+                                 : "Timed out waiting for the broker to accept the connection";
+    settled = settled && !abandoned;
+    lock.unlock();
+    
+    if (!settled) {
+        loop_->runSync([this, &reason]() {
+            closeConnection(reason);
+        });
+    }
+    Logger::error("Connection failed: " + reason);
+    throw std::runtime_error(reason);
+}
+
+void AMQClient::beginConnect(const struct sockaddr_in& address) {
+    receive_buffer_.clear();
+    fragment_buffer_.clear();
+    in_fragmented_message_ = false;
+    writing_.clear();
+    writing_info_.clear();
+    write_index_ = write_offset_ = writing_bytes_ = 0;
+    last_read_at_ = last_write_at_ = std::chrono::steady_clock::now();
+    
+    socket_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (socket_fd_ < 0) {
-        Logger::error("Failed to create socket");
-        return false;
+        failConnection("Failed to create socket: " + std::string(strerror(errno)));
+        return;
     }
     
-    // Connect to server
-    struct sockaddr_in serv_addr;
-    memset(&serv_addr, 0, sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    memcpy(&serv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
-    serv_addr.sin_port = htons(port_);
+    if (::connect(socket_fd_, reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) < 0 &&
+        errno != EINPROGRESS) {
+        failConnection("Failed to connect to server: " + std::string(strerror(errno)));
+        return;
+    }
     
-    if (::connect(socket_fd_, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
-        Logger::error("Failed to connect to server");
-        close(socket_fd_);
-        socket_fd_ = -1;
-        return false;
+    // Writable means the TCP handshake finished, one way or the other
+    want_write_ = true;
+    try {
+        loop_->add(socket_fd_, EPOLLOUT, [this](uint32_t events) {
+            onSocketEvent(events);
+        });
+    } catch (const std::exception& e) {
+        failConnection(e.what());
+    }
+}
+
+void AMQClient::onSocketEvent(uint32_t events) {
+    if (state_ == State::TCP_CONNECTING) {
+        onTcpConnected();
+        return;
     }
     
-    return true;
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        readAvailable();
+    }
+    if (socket_fd_ >= 0 && (events & EPOLLOUT)) {
+        flushOutput();
+    }
 }
 
-bool AMQClient::performWebSocketHandshake() {
+void AMQClient::onTcpConnected() {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &length) < 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        failConnection("Failed to connect to server: " + std::string(strerror(error)));
+        return;
+    }
+    
     // Generate WebSocket key
     std::string key = "dGhlIHNhbXBsZSBub25jZQ=="; // Static for simplicity
     
-    // Send WebSocket handshake
     std::ostringstream handshake;
     handshake << "GET " << path_ << " HTTP/1.1\r\n";
     handshake << "Host: " << host_ << ":" << port_ << "\r\n";
@@ -96,26 +255,29 @@ bool AMQClient::performWebSocketHandshake() {
     handshake << "Sec-WebSocket-Protocol: stomp\r\n";
     handshake << "\r\n";
     
-    std::string handshake_str = handshake.str();
-    if (send(socket_fd_, handshake_str.c_str(), handshake_str.length(), 0) < 0) {
-        Logger::error("Failed to send WebSocket handshake");
-        return false;
-    }
-    
-    // Receive handshake response
-    char buffer[4096];
-    ssize_t received = recv(socket_fd_, buffer, sizeof(buffer) - 1, 0);
-    if (received <= 0) {
-        Logger::error("Failed to receive WebSocket handshake response");
+    setState(State::WEBSOCKET_HANDSHAKE);
+    loop_->modify(socket_fd_, EPOLLIN | EPOLLOUT);
+    queueRaw(handshake.str());
+    flushOutput();
+}
+
+bool AMQClient::processHandshakeResponse() {
+    std::string_view received(receive_buffer_.readableData(), receive_buffer_.readableSize());
+    size_t header_end = received.find("\r\n\r\n");
+    if (header_end == std::string_view::npos) {
+        if (received.size() > kMaxHandshakeResponse) {
+            failConnection("WebSocket handshake failed: response headers too large");
+        }
         return false;
     }
     
-    buffer[received] = '\0';
-    std::string response(buffer);
+    // Anything after the HTTP headers already belongs to the WebSocket stream
+    std::string response(received.substr(0, header_end + 4));
+    receive_buffer_.consume(header_end + 4);
     
     // Check for successful upgrade (HTTP 101 Switching Protocols)
     if (response.find("101") == std::string::npos) {
-        Logger::error("WebSocket handshake failed: " + response);
+        failConnection("WebSocket handshake failed: " + response);
         return false;
     }
     
@@ -124,277 +286,937 @@ bool AMQClient::performWebSocketHandshake() {
     std::transform(response_lower.begin(), response_lower.end(), response_lower.begin(), ::tolower);
     if (response_lower.find("upgrade:") == std::string::npos || 
         response_lower.find("websocket") == std::string::npos) {
-        Logger::error("WebSocket handshake failed: missing upgrade headers");
+        failConnection("WebSocket handshake failed: missing upgrade headers");
         return false;
     }
     
     Logger::info("WebSocket handshake successful");
+    
+    // Send STOMP CONNECT frame, offering the same heart-beat both ways
+    long long heartbeat_ms = connection_options_.heartbeat_interval.count();
+    std::string connect_frame = "CONNECT\n";
+    connect_frame += "accept-version:1.2\n";
+    connect_frame += "host:/\n";
+    connect_frame += "heart-beat:" + std::to_string(heartbeat_ms) + "," + std::to_string(heartbeat_ms) + "\n\n";
+    connect_frame += '\0';
+    
+    setState(State::STOMP_CONNECTING);
+    queueFrame(connect_frame, WebSocketOpcode::TEXT);
+    flushOutput();
+    Logger::info("STOMP handshake initiated");
     return true;
 }
 
-void AMQClient::connect(const std::string& broker_address) {
-    Logger::info("Connecting to AMQ broker: " + broker_address);
+void AMQClient::onStompConnected(const StompFrame& frame) {
+    // heart-beat:sx,sy - the broker can send every sx ms and wants ours every sy ms
+    long long offered = connection_options_.heartbeat_interval.count();
+    long long server_send = 0;
+    long long server_receive = 0;
+    std::string_view heartbeat = frame.header("heart-beat");
+    size_t comma = heartbeat.find(',');
+    if (comma != std::string_view::npos) {
+        std::from_chars(heartbeat.data(), heartbeat.data() + comma, server_send);
+        std::from_chars(heartbeat.data() + comma + 1, heartbeat.data() + heartbeat.size(), server_receive);
+    }
+    heartbeat_send_ = std::chrono::milliseconds(offered > 0 && server_receive > 0
+                                                    ? std::max(offered, server_receive) : 0);
+    heartbeat_receive_ = std::chrono::milliseconds(offered > 0 && server_send > 0
+                                                       ? std::max(offered, server_send) : 0);
     
-    try {
-        if (!connectSocket(broker_address)) {
-            throw std::runtime_error("Failed to connect socket");
-        }
-        
-        if (!performWebSocketHandshake()) {
-            close(socket_fd_);
-            socket_fd_ = -1;
-            throw std::runtime_error("Failed to perform WebSocket handshake");
+    Logger::info("STOMP connection confirmed (heart-beat send " + std::to_string(heartbeat_send_.count()) +
+                 " ms, receive " + std::to_string(heartbeat_receive_.count()) + " ms)");
+    
+    // On a reconnect: renew the subscriptions, then resend what the last
+    // connection left unacknowledged or unsent, ahead of any newer publish
+    for (const auto& entry : subscriptions_) {
+        queueFrame(subscribeFrame(entry.first, entry.second.topic), WebSocketOpcode::TEXT);
+    }
+    size_t replayed = 0;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (resuming_) {
+            for (size_t i = 0; i < held_.size(); ++i) {
+                replayed += held_info_[i].frames;
+                send_queue_.push_back(std::move(held_[i]));
+                send_queue_info_.push_back(held_info_[i]);
+            }
+            held_.clear();
+            held_info_.clear();
+            resuming_ = false;
+            scheduleFlushLocked();
         }
-        
         connected_ = true;
-        running_ = true;
-        
-        // Send STOMP CONNECT frame
-        std::string connect_frame = "CONNECT\n";
-        connect_frame += "accept-version:1.2\n";
-        connect_frame += "host:/\n\n";
-        connect_frame += '\0';
-        
-        sendFrame(connect_frame);
-        Logger::info("STOMP handshake initiated");
-        
-        // Start receive thread
-        receive_thread_ = std::thread([this]() {
-            receiveLoop();
+    }
+    if (!subscriptions_.empty() || replayed > 0) {
+        if (metrics_) {
+            metrics_->frames_replayed.inc(replayed);
+        }
+        Logger::info("Resumed session: renewed " + std::to_string(subscriptions_.size()) +
+                     " subscription(s), resending " + std::to_string(replayed) + " frame(s)");
+    }
+    
+    setState(State::CONNECTED);
+    if (read_paused_) {
+        updateInterest();
+    }
+    scheduleHeartbeat();
+}
+
+void AMQClient::setState(State state) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        state_ = state;
+    }
+    state_cv_.notify_all();
+}
+
+void AMQClient::failConnection(const std::string& reason) {
+    Logger::error(reason);
+    closeConnection(reason);
+}
+
+void AMQClient::closeConnection(const std::string& reason) {
+    if (socket_fd_ >= 0) {
+        loop_->remove(socket_fd_);
+        close(socket_fd_);
+        socket_fd_ = -1;
+    }
+    want_write_ = false;
+    if (heartbeat_timer_ != 0) {
+        loop_->cancel(heartbeat_timer_);
+        heartbeat_timer_ = 0;
+    }
+    if (linger_timer_ != 0) {
+        loop_->cancel(linger_timer_);
+        linger_timer_ = 0;
+    }
+    
+    // A session that is not over keeps its subscriptions and publishes for
+    // the next connection; otherwise the broker forgets the subscriptions
+    // with the connection and whatever was not written is lost
+    bool resume;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        resume = session_ && connection_options_.reconnect;
+        if (!resume) {
+            session_ = false;
+        }
+    }
+    if (!resume) {
+        subscriptions_.clear();
+    }
+    
+    size_t unsent = 0;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (resume) {
+            holdForReconnectLocked();
+        } else {
+            for (size_t i = write_index_; i < writing_info_.size(); ++i) {
+                unsent += writing_info_[i].frames;
+            }
+            for (const auto& info : send_queue_info_) {
+                unsent += info.frames;
+            }
+            for (const auto& info : held_info_) {
+                unsent += info.frames;
+            }
+            recycleWrittenLocked();
+            send_queue_.clear();
+            send_queue_info_.clear();
+            held_.clear();
+            held_info_.clear();
+            unacked_.clear();
+            unacked_info_.clear();
+            queued_bytes_ = 0;
+            resuming_ = false;
+        }
+        write_index_ = write_offset_ = writing_bytes_ = 0;
+        connected_ = false;
+    }
+    space_cv_.notify_all();
+    
+    if (unsent > 0) {
+        if (metrics_) {
+            metrics_->frames_dropped.inc(unsent);
+        }
+        Logger::warning("Discarding " + std::to_string(unsent) + " unsent frame(s)");
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (state_ != State::DISCONNECTED) {
+            failure_reason_ = reason;
+        }
+        state_ = State::DISCONNECTED;
+    }
+    state_cv_.notify_all();
+}
+
+void AMQClient::holdForReconnectLocked() {
+    // Caller holds send_mutex_. Publishes in send order: written but not
+    // acknowledged, the rest of the batch being written (a partly written
+    // entry goes again whole), the queue, then what an earlier failed attempt
+    // already held. Protocol frames belong to the dead connection.
+    std::vector<std::string> held;
+    std::vector<EntryInfo> held_info;
+    size_t held_bytes = 0;
+    auto keep = [&](std::string& bytes, const EntryInfo& info) {
+        if (info.publish) {
+            held_bytes += bytes.size();
+            held.push_back(std::move(bytes));
+            held_info.push_back(info);
+        }
+    };
+    for (size_t i = 0; i < unacked_.size(); ++i) {
+        keep(unacked_[i], unacked_info_[i]);
+    }
+    for (size_t i = write_index_; i < writing_.size(); ++i) {
+        keep(writing_[i], writing_info_[i]);
+    }
+    for (size_t i = 0; i < send_queue_.size(); ++i) {
+        keep(send_queue_[i], send_queue_info_[i]);
+    }
+    for (size_t i = 0; i < held_.size(); ++i) {
+        keep(held_[i], held_info_[i]);
+    }
+    
+    recycleWrittenLocked();
+    unacked_.clear();
+    unacked_info_.clear();
+    send_queue_.clear();
+    send_queue_info_.clear();
+    held_.swap(held);
+    held_info_.swap(held_info);
+    queued_bytes_ = held_bytes;
+    resuming_ = true;
+}
+
+void AMQClient::reconnectLoop() {
+    unsigned attempt = 0;
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    while (true) {
+        state_cv_.wait(lock, [this]() {
+            return !session_ || state_ == State::DISCONNECTED;
         });
+        if (!session_) {
+            return;
+        }
+        std::string reason = failure_reason_;
+        std::chrono::milliseconds delay = reconnectDelay(connection_options_, attempt);
+        lock.unlock();
         
-        // Wait a bit for STOMP connection to establish
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (attempt == 0) {
+            Logger::warning("Lost connection to " + host_ + ":" + std::to_string(port_) + " (" + reason +
+                            "), reconnecting in " + std::to_string(delay.count()) + " ms");
+        } else {
+            Logger::warning("Reconnect attempt " + std::to_string(attempt) + " failed, retrying in " +
+                            std::to_string(delay.count()) + " ms");
+        }
         
-    } catch (const std::exception& e) {
-        Logger::error("Connection failed: " + std::string(e.what()));
-        throw;
+        lock.lock();
+        if (state_cv_.wait_for(lock, delay, [this]() { return !session_; })) {
+            return;
+        }
+        lock.unlock();
+        try {
+            openConnection(true);
+            Logger::info("Reconnected to " + host_ + ":" + std::to_string(port_));
+            if (metrics_) {
+                metrics_->broker_reconnects.inc();
+            }
+            attempt = 0;
+        } catch (const std::exception&) {
+            // openConnection() logged why
+            attempt++;
+        }
+        lock.lock();
     }
 }
 
-std::string AMQClient::createWebSocketFrame(const std::string& data) {
-    std::string frame;
-    
-    // FIN=1, opcode=1 (text frame)
-    frame += static_cast<char>(0x81);
+void AMQClient::readAvailable() {
+    char* write_ptr = receive_buffer_.prepareWrite(kReadChunk);
+    ssize_t received = recv(socket_fd_, write_ptr, receive_buffer_.writableSize(), 0);
     
-    // Mask bit set, payload length
-    size_t len = data.length();
-    if (len <= 125) {
-        frame += static_cast<char>(0x80 | len);
-    } else if (len <= 65535) {
-        frame += static_cast<char>(0x80 | 126);
-        frame += static_cast<char>((len >> 8) & 0xFF);
-        frame += static_cast<char>(len & 0xFF);
-    } else {
-        frame += static_cast<char>(0x80 | 127);
-        for (int i = 7; i >= 0; i--) {
-            frame += static_cast<char>((len >> (i * 8)) & 0xFF);
+    if (received <= 0) {
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        if (received == 0 && disconnecting_) {
+            closeConnection("Disconnected");
+        } else {
+            failConnection(received == 0 ? std::string("Broker closed the connection")
+                                         : "Receive error: " + std::string(strerror(errno)));
         }
+        return;
     }
     
-    // Masking key (simple static key for simplicity)
-    unsigned char mask[4] = {0x12, 0x34, 0x56, 0x78};
-    frame.append(reinterpret_cast<char*>(mask), 4);
+    receive_buffer_.commitWrite(static_cast<size_t>(received));
+    last_read_at_ = std::chrono::steady_clock::now();
     
-    // Masked payload
-    for (size_t i = 0; i < len; i++) {
-        frame += static_cast<char>(data[i] ^ mask[i % 4]);
+    if (state_ == State::WEBSOCKET_HANDSHAKE && !processHandshakeResponse()) {
+        return;
     }
-    
+    processFrames();
+}
+
+void AMQClient::processFrames() {
+    // Parse every complete frame in the buffer; a trailing partial frame
+    // stays buffered until the next read completes it
+    try {
+        while (socket_fd_ >= 0 && !readingPaused() && receive_buffer_.readableSize() > 0) {
+            WebSocketFrame frame;
+            size_t consumed = parseWebSocketFrame(receive_buffer_.readableData(),
+                                                  receive_buffer_.readableSize(), frame);
+            if (consumed == 0) {
+                break;
+            }
+            
+            bool keep_going = handleWebSocketFrame(frame);
+            receive_buffer_.consume(consumed);
+            if (!keep_going) {
+                // Give the close reply a chance to go out with whatever is queued
+                flushOutput();
+                closeConnection("Broker closed the WebSocket connection");
+                return;
+            }
+        }
+    } catch (const std::exception& e) {
+        failConnection("WebSocket protocol error: " + std::string(e.what()));
+    }
+}
+
+std::string AMQClient::createWebSocketFrame(std::string_view data, WebSocketOpcode opcode) {
+    std::string frame = takeSpareBuffer();
+    frame.reserve(webSocketHeaderSize(data.size()) + data.size());
+    appendWebSocketFrame(data, opcode, frame);
     return frame;
 }
 
-bool AMQClient::parseWebSocketFrame(const std::string& data, std::string& payload) {
-    if (data.length() < 2) {
-        return false;
+void AMQClient::queueFrame(std::string_view data, WebSocketOpcode opcode) {
+    // Protocol frames (CONNECT, SUBSCRIBE, pong, close, heart-beats) bypass
+    // the high-water mark so the loop never waits behind bulk publishes
+    queueRaw(createWebSocketFrame(data, opcode));
+}
+
+void AMQClient::queueRaw(std::string bytes) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    queued_bytes_ += bytes.size();
+    send_queue_.push_back(std::move(bytes));
+    send_queue_info_.push_back(EntryInfo());
+    scheduleFlushLocked();
+}
+
+std::string AMQClient::takeSpareBuffer() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (spare_buffers_.empty()) {
+        return std::string();
+    }
+    std::string buffer = std::move(spare_buffers_.back());
+    spare_buffers_.pop_back();
+    return buffer;
+}
+
+void AMQClient::recycleWrittenLocked() {
+    // Caller holds send_mutex_; writing_ itself is only touched on the loop thread
+    for (auto& buffer : writing_) {
+        recycleBufferLocked(buffer);
+    }
+    writing_.clear();
+    writing_info_.clear();
+}
+
+void AMQClient::recycleBufferLocked(std::string& buffer) {
+    if (spare_buffers_.size() < kMaxSpareBuffers && buffer.capacity() <= kMaxSpareBufferBytes &&
+        buffer.capacity() > std::string().capacity()) {
+        buffer.clear();
+        spare_buffers_.push_back(std::move(buffer));
+    }
+}
+
+void AMQClient::scheduleFlushLocked() {
+    // One flush task covers everything queued until it runs
+    if (!flush_posted_ && !detached_) {
+        flush_posted_ = true;
+        loop_->post([this]() {
+            onFlushRequested();
+        });
+    }
+}
+
+void AMQClient::sendFrame(const std::string& data, WebSocketOpcode opcode) {
+    if (!connected_) {
+        throw std::runtime_error("Cannot send: not connected");
     }
+    queueFrame(data, opcode);
+}
+
+void AMQClient::enqueueFrames(std::string& frames, const EntryInfo& info) {
+    const size_t batch_bytes = frames.size();
     
-    size_t pos = 0;
+    std::unique_lock<std::mutex> lock(send_mutex_);
     
-    // Parse header
-    unsigned char byte1 = data[pos++];
-    unsigned char byte2 = data[pos++];
+    // Backpressure: wait for the loop to drain below the high-water mark.
+    // An empty queue always accepts, so one oversized batch cannot deadlock.
+    // The loop thread itself (a message callback) cannot wait for its own writes.
+    // While reconnecting the same limit bounds what is held for the new connection.
+    bool has_space = loop_->inLoopThread() ||
+        space_cv_.wait_for(lock, send_options_.block_timeout, [this, batch_bytes]() {
+            return !(connected_ || resuming_) || queued_bytes_ == 0 ||
+                   queued_bytes_ + batch_bytes <= send_options_.high_water_bytes;
+        });
     
-    bool fin = (byte1 & 0x80) != 0;
-    unsigned char opcode = byte1 & 0x0F;
-    bool masked = (byte2 & 0x80) != 0;
-    unsigned long long payload_len = byte2 & 0x7F;
+    if (!connected_ && !resuming_) {
+        throw std::runtime_error("Cannot publish: not connected");
+    }
+    if (!has_space) {
+        throw std::runtime_error(std::string(connected_ ? "Send queue" : "Reconnect queue") +
+                                 " above high-water mark (" + std::to_string(queued_bytes_) + " bytes queued)");
+    }
+    
+    queued_bytes_ += batch_bytes;
+    if (!connected_) {
+        held_.push_back(std::move(frames));
+        held_info_.push_back(info);
+        return;
+    }
+    send_queue_.push_back(std::move(frames));
+    send_queue_info_.push_back(info);
+    scheduleFlushLocked();
+}
+
+void AMQClient::onFlushRequested() {
+    bool linger;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        flush_posted_ = false;
+        linger = send_options_.linger.count() > 0 && queued_bytes_ < send_options_.high_water_bytes;
+    }
     
-    // Handle extended payload length
-    if (payload_len == 126) {
-        if (data.length() < pos + 2) return false;
-        payload_len = (static_cast<unsigned char>(data[pos]) << 8) | 
-                      static_cast<unsigned char>(data[pos + 1]);
-        pos += 2;
-    } else if (payload_len == 127) {
-        if (data.length() < pos + 8) return false;
-        payload_len = 0;
-        for (int i = 0; i < 8; i++) {
-            payload_len = (payload_len << 8) | static_cast<unsigned char>(data[pos++]);
+    // Optionally give other publishers a moment to add to this write
+    if (linger && state_ == State::CONNECTED) {
+        if (linger_timer_ == 0) {
+            linger_timer_ = loop_->runAfter(send_options_.linger, [this]() {
+                linger_timer_ = 0;
+                flushOutput();
+            });
         }
+        return;
+    }
+    if (linger_timer_ != 0) {
+        loop_->cancel(linger_timer_);
+        linger_timer_ = 0;
+    }
+    flushOutput();
+}
+
+void AMQClient::flushOutput() {
+    // Nothing can be written before the TCP connection is up
+    if (socket_fd_ < 0 || state_ == State::TCP_CONNECTING) {
+        return;
     }
     
-    // Skip mask if present (server shouldn't mask)
-    if (masked) {
-        pos += 4;
+    while (true) {
+        if (write_index_ >= writing_.size()) {
+            // Previous batch is out: release its bytes and take everything queued since
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            queued_bytes_ -= std::min(queued_bytes_, writing_bytes_);
+            if (writing_bytes_ > 0) {
+                space_cv_.notify_all();
+            }
+            recycleWrittenLocked();
+            writing_.swap(send_queue_);
+            writing_info_.swap(send_queue_info_);
+            write_index_ = write_offset_ = writing_bytes_ = 0;
+            for (const auto& frame : writing_) {
+                writing_bytes_ += frame.size();
+            }
+            if (writing_.empty()) {
+                break;
+            }
+        }
+        if (!writeSome()) {
+            return;
+        }
+    }
+    setWriteInterest(false);
+}
+
+bool AMQClient::writeSome() {
+    // As few sendmsg() calls as possible; a partial write resumes where it stopped
+    iov_.clear();
+    for (size_t i = write_index_; i < writing_.size() && iov_.size() < kMaxIov; ++i) {
+        size_t skip = i == write_index_ ? write_offset_ : 0;
+        struct iovec entry;
+        entry.iov_base = const_cast<char*>(writing_[i].data() + skip);
+        entry.iov_len = writing_[i].size() - skip;
+        iov_.push_back(entry);
     }
     
-    // Extract payload
-    if (data.length() < pos + payload_len) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov_.data();
+    msg.msg_iovlen = iov_.size();
+    
+    ssize_t sent;
+    {
+        StageTimer timer(metrics_, PipelineStage::SOCKET_WRITE);
+        sent = sendmsg(socket_fd_, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+    if (sent < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // Socket buffer full: resume when epoll reports it writable
+            setWriteInterest(true);
+            return false;
+        }
+        size_t unsent = 0;
+        for (size_t i = write_index_; i < writing_info_.size(); ++i) {
+            unsent += writing_info_[i].frames;
+        }
+        failConnection("Failed to send " + std::to_string(unsent) + " frame(s): " + std::string(strerror(errno)));
         return false;
     }
     
-    payload = data.substr(pos, payload_len);
+    last_write_at_ = std::chrono::steady_clock::now();
+    if (metrics_) {
+        metrics_->bytes_written.inc(static_cast<uint64_t>(sent));
+    }
+    
+    // Skip fully written entries and remember how far into a partial one we got.
+    // Entries waiting for a receipt move on to unacked_ and keep their bytes queued.
+    size_t remaining = static_cast<size_t>(sent);
+    while (write_index_ < writing_.size() && remaining >= writing_[write_index_].size() - write_offset_) {
+        remaining -= writing_[write_index_].size() - write_offset_;
+        if (writing_info_[write_index_].receipt != 0) {
+            writing_bytes_ -= writing_[write_index_].size();
+            unacked_.push_back(std::move(writing_[write_index_]));
+            unacked_info_.push_back(writing_info_[write_index_]);
+        }
+        write_index_++;
+        write_offset_ = 0;
+    }
+    write_offset_ += remaining;
     return true;
 }
 
-void AMQClient::sendFrame(const std::string& data) {
-    if (!connected_ || socket_fd_ < 0) {
-        throw std::runtime_error("Cannot send: not connected");
+void AMQClient::setWriteInterest(bool enabled) {
+    if (enabled != want_write_ && socket_fd_ >= 0) {
+        want_write_ = enabled;
+        updateInterest();
+    }
+}
+
+void AMQClient::updateInterest() {
+    if (socket_fd_ >= 0 && state_ != State::TCP_CONNECTING) {
+        loop_->modify(socket_fd_, (readingPaused() ? 0u : static_cast<uint32_t>(EPOLLIN)) |
+                                  (want_write_ ? static_cast<uint32_t>(EPOLLOUT) : 0u));
+    }
+}
+
+void AMQClient::pauseReading(bool paused) {
+    auto apply = [this, paused]() {
+        if (paused == read_paused_) {
+            return;
+        }
+        read_paused_ = paused;
+        if (!paused) {
+            // The broker was not silent, we were not listening
+            last_read_at_ = std::chrono::steady_clock::now();
+        }
+        updateInterest();
+        if (!paused && state_ == State::CONNECTED) {
+            processFrames(); // whatever was buffered when reading stopped
+        }
+    };
+    if (loop_->inLoopThread()) {
+        apply();
+        return;
     }
-    
     std::lock_guard<std::mutex> lock(send_mutex_);
-    
-    std::string frame = createWebSocketFrame(data);
-    ssize_t sent = send(socket_fd_, frame.c_str(), frame.length(), 0);
-    
-    if (sent < 0) {
-        Logger::error("Failed to send frame");
-        throw std::runtime_error("Failed to send frame");
+    if (!detached_) {
+        loop_->post(apply);
     }
 }
 
-void AMQClient::receiveLoop() {
-    char buffer[8192];
-    std::string accumulated;
+void AMQClient::scheduleHeartbeat() {
+    std::chrono::milliseconds tick(0);
+    for (auto interval : {heartbeat_send_, heartbeat_receive_}) {
+        if (interval.count() > 0 && (tick.count() == 0 || interval < tick)) {
+            tick = interval;
+        }
+    }
+    if (tick.count() == 0) {
+        return;
+    }
+    // Checking four times per interval keeps heart-beats inside the negotiated window
+    heartbeat_timer_ = loop_->runAfter(std::max(tick / 4, std::chrono::milliseconds(1)), [this]() {
+        heartbeat_timer_ = 0;
+        onHeartbeatTimer();
+    });
+}
+
+void AMQClient::onHeartbeatTimer() {
+    if (state_ != State::CONNECTED) {
+        return;
+    }
     
-    while (running_ && connected_) {
-        ssize_t received = recv(socket_fd_, buffer, sizeof(buffer), 0);
-        
-        if (received <= 0) {
-            if (received < 0) {
-                Logger::error("Receive error");
+    auto now = std::chrono::steady_clock::now();
+    // The broker allows some slack; treat it as gone after two silent intervals
+    if (heartbeat_receive_.count() > 0 && !read_paused_ && now - last_read_at_ > 2 * heartbeat_receive_) {
+        failConnection("No data from broker for " + std::to_string(2 * heartbeat_receive_.count()) +
+                       " ms, heart-beat timed out");
+        return;
+    }
+    // Top up idle periods with an end-of-line; any write counts as a heart-beat.
+    // Sending once three quarters of the interval has passed leaves a check to spare.
+    if (heartbeat_send_.count() > 0 && now - last_write_at_ >= heartbeat_send_ * 3 / 4) {
+        queueFrame("\n", WebSocketOpcode::TEXT);
+        flushOutput();
+    }
+    scheduleHeartbeat();
+}
+
+bool AMQClient::handleWebSocketFrame(const WebSocketFrame& frame) {
+    switch (frame.opcode) {
+        case WebSocketOpcode::PING:
+            queueFrame(frame.payload, WebSocketOpcode::PONG);
+            return true;
+            
+        case WebSocketOpcode::PONG:
+            return true;
+            
+        case WebSocketOpcode::CLOSE:
+            Logger::info("Broker closed the WebSocket connection");
+            queueFrame(frame.payload.substr(0, std::min<size_t>(2, frame.payload.size())), WebSocketOpcode::CLOSE);
+            return false;
+            
+        case WebSocketOpcode::TEXT:
+        case WebSocketOpcode::BINARY:
+            if (in_fragmented_message_) {
+                throw std::runtime_error("New data frame while a fragmented message is in progress");
             }
-            connected_ = false;
-            break;
-        }
-        
-        accumulated.append(buffer, received);
-        
-        // Try to parse WebSocket frames (there may be multiple)
-        while (true) {
-            std::string payload;
-            if (parseWebSocketFrame(accumulated, payload)) {
-                // Successfully parsed a frame, remove it from accumulated
-                // This is a simplified approach - in production you'd want to track bytes consumed
-                accumulated.clear();
-                parseStompMessage(payload);
+            if (frame.fin) {
+                // Common case: single-frame message, dispatched straight from the receive buffer
+                parseStompMessage(frame.payload);
             } else {
-                // Not enough data yet or incomplete frame
-                break;
+                fragment_buffer_.assign(frame.payload.data(), frame.payload.size());
+                in_fragmented_message_ = true;
+            }
+            return true;
+            
+        case WebSocketOpcode::CONTINUATION:
+            if (!in_fragmented_message_) {
+                throw std::runtime_error("Continuation frame without a fragmented message");
+            }
+            if (fragment_buffer_.size() + frame.payload.size() > kMaxWebSocketPayload) {
+                throw std::runtime_error("Fragmented WebSocket message too large");
+            }
+            fragment_buffer_.append(frame.payload.data(), frame.payload.size());
+            if (frame.fin) {
+                in_fragmented_message_ = false;
+                parseStompMessage(fragment_buffer_);
+                fragment_buffer_.clear();
             }
+            return true;
+            
+        default:
+            throw std::runtime_error("Unknown WebSocket opcode " +
+                                     std::to_string(static_cast<int>(frame.opcode)));
+    }
+}
+
+void AMQClient::parseStompMessage(std::string_view message) {
+    StompFrame frame;
+    try {
+        if (!parseStompFrame(message, frame)) {
+            return;     // heart-beat
         }
+    } catch (const std::exception& e) {
+        Logger::warning("Ignoring malformed STOMP frame: " + std::string(e.what()));
+        return;
+    }
+    
+    if (frame.command == "MESSAGE") {
+        dispatchMessage(frame);
+        return;
+    }
+    
+    if (frame.command == "RECEIPT") {
+        onReceipt(frame.header("receipt-id"));
+        return;
+    }
+    
+    if (frame.command == "CONNECTED") {
+        if (state_ == State::STOMP_CONNECTING) {
+            onStompConnected(frame);
+        }
+        return;
     }
     
-    Logger::info("Receive loop ended");
+    if (frame.command == "ERROR") {
+        // Brokers close the connection after an ERROR; during CONNECT it is the answer
+        std::string error = "STOMP error from broker: " + std::string(frame.header("message"));
+        if (!frame.body.empty()) {
+            error += " (" + std::string(frame.body) + ")";
+        }
+        if (state_ == State::STOMP_CONNECTING) {
+            failConnection(error);
+        } else {
+            Logger::error(error);
+        }
+        return;
+    }
 }
 
-void AMQClient::parseStompMessage(const std::string& message) {
-    if (message.find("CONNECTED") == 0) {
-        Logger::info("STOMP connection confirmed");
+void AMQClient::onReceipt(std::string_view receipt_id) {
+    uint64_t receipt = 0;
+    std::from_chars(receipt_id.data(), receipt_id.data() + receipt_id.size(), receipt);
+    
+    // The broker handles a connection's frames in order, so a receipt also
+    // covers every batch written before the one that asked for it
+    auto found = std::find_if(unacked_info_.begin(), unacked_info_.end(), [receipt](const EntryInfo& info) {
+        return info.receipt == receipt;
+    });
+    if (receipt == 0 || found == unacked_info_.end()) {
         return;
     }
+    size_t count = static_cast<size_t>(found - unacked_info_.begin()) + 1;
+    {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        size_t acknowledged = 0;
+        for (size_t i = 0; i < count; ++i) {
+            acknowledged += unacked_[i].size();
+            recycleBufferLocked(unacked_[i]);
+        }
+        queued_bytes_ -= std::min(queued_bytes_, acknowledged);
+    }
+    unacked_.erase(unacked_.begin(), unacked_.begin() + static_cast<std::ptrdiff_t>(count));
+    unacked_info_.erase(unacked_info_.begin(), unacked_info_.begin() + static_cast<std::ptrdiff_t>(count));
+    space_cv_.notify_all();
+}
+
+void AMQClient::dispatchMessage(const StompFrame& frame) {
+    if (metrics_) {
+        metrics_->stage(PipelineStage::RECEIVE).recordSince(last_read_at_);
+    }
     
-    if (message.find("MESSAGE") == 0) {
-        // Extract message body from STOMP frame
-        size_t body_start = message.find("\n\n");
-        if (body_start != std::string::npos) {
-            std::string body = message.substr(body_start + 2);
-            // Remove null terminator if present
-            if (!body.empty() && body.back() == '\0') {
-                body.pop_back();
-            }
-            
-            if (message_callback_) {
-                message_callback_(body);
-            }
+    auto it = subscriptions_.find(frame.header("subscription"));
+    if (it == subscriptions_.end()) {
+        // Unsubscribed, or a broker that leaves the header out: fall back to the destination
+        std::string_view destination = frame.header("destination");
+        const std::string_view prefix = "/topic/";
+        if (destination.compare(0, prefix.size(), prefix) == 0) {
+            destination.remove_prefix(prefix.size());
+        }
+        it = std::find_if(subscriptions_.begin(), subscriptions_.end(), [destination](const auto& entry) {
+            return entry.second.topic == destination;
+        });
+        if (it == subscriptions_.end()) {
+            SAR_LOG_DEBUG("Dropping MESSAGE for " + std::string(frame.header("destination")) +
+                          " with no matching subscription");
+            return;
         }
     }
+    
+    // Copies, because the callback may unsubscribe and so erase the entry
+    MessageCallback callback = it->second.callback;
+    if (!callback) {
+        return;
+    }
+    if (!it->second.executor) {
+        // Straight from the receive buffer
+        callback(frame.body);
+        return;
+    }
+    MessageExecutor executor = it->second.executor;
+    executor([callback = std::move(callback), body = std::string(frame.body)]() {
+        callback(body);
+    });
 }
 
 
-void AMQClient::subscribe(const std::string& topic, MessageCallback callback) {
+std::string AMQClient::subscribe(const std::string& topic, MessageCallback callback, MessageExecutor executor) {
     if (!connected_) {
         throw std::runtime_error("Cannot subscribe: not connected");
     }
     
     Logger::info("Subscribing to topic: " + topic);
-    message_callback_ = callback;
-    
-    // Send STOMP SUBSCRIBE frame
-    std::string subscribe_frame = "SUBSCRIBE\n";
-    subscribe_frame += "destination:/topic/" + topic + "\n";
-    subscribe_frame += "id:sub-0\n";
-    subscribe_frame += "ack:auto\n\n";
-    subscribe_frame += '\0';
     
     try {
-        sendFrame(subscribe_frame);
-        Logger::info("Successfully subscribed to: " + topic);
+        // The handler is installed on the loop thread before the frame can go out
+        std::string id;
+        loop_->runSync([&]() {
+            id = "sub-" + std::to_string(next_subscription_++);
+            sendFrame(subscribeFrame(id, topic));
+            subscriptions_[id] = Subscription{topic, std::move(callback), std::move(executor)};
+        });
+        Logger::info("Successfully subscribed to: " + topic + " (" + id + ")");
+        return id;
     } catch (const std::exception& e) {
         Logger::error("Failed to subscribe: " + std::string(e.what()));
         throw;
     }
 }
 
+std::string AMQClient::subscribeFrame(const std::string& id, const std::string& topic) {
+    std::string subscribe_frame = "SUBSCRIBE\n";
+    subscribe_frame += "destination:/topic/" + topic + "\n";
+    subscribe_frame += "id:" + id + "\n";
+    subscribe_frame += "ack:auto\n\n";
+    subscribe_frame += '\0';
+    return subscribe_frame;
+}
+
+void AMQClient::unsubscribe(const std::string& subscription_id) {
+    loop_->runSync([this, &subscription_id]() {
+        auto it = subscriptions_.find(subscription_id);
+        if (it == subscriptions_.end()) {
+            return;
+        }
+        Logger::info("Unsubscribing from topic: " + it->second.topic + " (" + subscription_id + ")");
+        subscriptions_.erase(it);
+        if (connected_) {
+            std::string unsubscribe_frame = "UNSUBSCRIBE\nid:" + subscription_id + "\n\n";
+            unsubscribe_frame += '\0';
+            queueFrame(unsubscribe_frame, WebSocketOpcode::TEXT);
+        }
+    });
+}
+
 void AMQClient::publish(const std::string& topic, const std::string& message) {
-    if (!connected_) {
+    // A batch of one, so it is tracked and resent like any other publish
+    OutboundBatch batch;
+    batch.emplace_back(topic, message);
+    publishBatch(batch);
+}
+
+void AMQClient::publishBatch(const OutboundBatch& messages) {
+    if (!connected_ && !acceptsPublishes()) {
         throw std::runtime_error("Cannot publish: not connected");
     }
+    if (messages.empty()) {
+        return;
+    }
+    
+    // Only the last frame asks for a receipt; it acknowledges the whole batch
+    EntryInfo info;
+    info.frames = messages.size();
+    info.publish = true;
+    info.receipt = send_options_.receipts ? next_receipt_.fetch_add(1, std::memory_order_relaxed) : 0;
+    char digits[24];
+    std::string_view receipt_id;
+    if (info.receipt != 0) {
+        auto result = std::to_chars(digits, digits + sizeof(digits), info.receipt);
+        receipt_id = std::string_view(digits, static_cast<size_t>(result.ptr - digits));
+    }
     
-    // Send STOMP SEND frame
-    std::string send_frame = "SEND\n";
-    send_frame += "destination:/topic/" + topic + "\n";
-    send_frame += "content-type:application/json\n";
-    send_frame += "content-length:" + std::to_string(message.length()) + "\n\n";
-    send_frame += message;
-    send_frame += '\0';
+    // Encode outside the lock so concurrent publishers only contend on the append.
+    // The whole batch goes into one recycled buffer: each STOMP frame is written
+    // straight after its WebSocket header and masked in place.
+    size_t total = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        std::string_view receipt = i + 1 == messages.size() ? receipt_id : std::string_view();
+        size_t stomp_size = stompSendFrameSize(messages[i].topic, messages[i].body, receipt);
+        total += webSocketHeaderSize(stomp_size) + stomp_size;
+    }
+    std::string frames = takeSpareBuffer();
+    frames.reserve(total);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const OutboundMessage& message = messages[i];
+        std::string_view receipt = i + 1 == messages.size() ? receipt_id : std::string_view();
+        unsigned char mask[4];
+        appendWebSocketHeader(stompSendFrameSize(message.topic, message.body, receipt), WebSocketOpcode::TEXT,
+                              frames, mask);
+        size_t payload = frames.size();
+        appendStompSendFrame(message.topic, message.body, frames, receipt);
+        maskWebSocketPayload(&frames[payload], &frames[payload], frames.size() - payload, mask);
+    }
     
     try {
-        sendFrame(send_frame);
+        enqueueFrames(frames, info);
     } catch (const std::exception& e) {
-        Logger::error("Failed to publish message: " + std::string(e.what()));
+        Logger::error("Failed to publish batch of " + std::to_string(messages.size()) +
+                      " messages: " + std::string(e.what()));
         throw;
     }
 }
 
+void AMQClient::setSendOptions(const SendOptions& options) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    send_options_ = options;
+}
+
+void AMQClient::setConnectionOptions(const ConnectionOptions& options) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    connection_options_ = options;
+}
+
+void AMQClient::setMetrics(ServiceMetrics* metrics) {
+    metrics_ = metrics;
+}
+
+size_t AMQClient::queuedBytes() const {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    return queued_bytes_;
+}
+
 void AMQClient::disconnect() {
-    if (connected_) {
-        Logger::info("Disconnecting from AMQ broker");
-        connected_ = false;
-        running_ = false;
+    // End the session first so nothing reconnects behind our back
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        session_ = false;
     }
-    
-    if (receive_thread_.joinable()) {
-        receive_thread_.join();
+    state_cv_.notify_all();
+    if (reconnect_thread_.joinable()) {
+        reconnect_thread_.join();
     }
     
-    if (socket_fd_ >= 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
+    if (connected_) {
+        Logger::info("Disconnecting from AMQ broker");
+        disconnecting_ = true;
+        
+        try {
+            std::string disconnect_frame = "DISCONNECT\n\n";
+            disconnect_frame += '\0';
+            sendFrame(disconnect_frame);
+        } catch (const std::exception&) {
+            // Connection dropped concurrently; nothing left to flush
+        }
+        
+        // Flush: let the loop drain what is already queued (it cannot wait on itself)
+        if (!loop_->inLoopThread()) {
+            std::unique_lock<std::mutex> lock(send_mutex_);
+            if (!space_cv_.wait_for(lock, send_options_.flush_timeout, [this]() {
+                    return queued_bytes_ == 0 || !connected_;
+                })) {
+                Logger::warning("Timed out flushing " + std::to_string(queued_bytes_) + " queued bytes");
+            }
+        }
     }
+    
+    loop_->runSync([this]() {
+        closeConnection("Disconnected");
+    });
 }
 
 bool AMQClient::isConnected() const {
     return connected_;
 }
 
+bool AMQClient::acceptsPublishes() const {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    return connected_ || resuming_;
+}
+
 void AMQClient::run() {
-    // Keep the main thread alive while connected
-    while (running_) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
+    // Keep the calling thread alive while the connection is up or being re-established
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    state_cv_.wait(lock, [this]() {
+        return state_ == State::DISCONNECTED && !session_;
+    });
 }
 
 } // namespace sar_atr
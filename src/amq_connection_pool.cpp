@@ -0,0 +1,155 @@
+#include "amq_connection_pool.h"
+#include "logger.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace sar_atr {
+
+ShardPolicy parseShardPolicy(const std::string& name) {
+    if (name == "image") {
+        return ShardPolicy::IMAGE;
+    }
+    if (name == "topic") {
+        return ShardPolicy::TOPIC;
+    }
+    throw std::runtime_error("Unknown shard policy '" + name + "' (expected image or topic)");
+}
+
+AMQConnectionPool::AMQConnectionPool(size_t connections, ShardPolicy policy)
+    : policy_(policy), loop_(std::make_shared<EventLoop>()) {
+    if (connections == 0) {
+        throw std::runtime_error("Connection pool needs at least one connection");
+    }
+    for (size_t i = 0; i < connections; ++i) {
+        clients_.push_back(std::make_unique<AMQClient>(loop_));
+    }
+}
+
+AMQConnectionPool::~AMQConnectionPool() {
+    disconnect();
+    clients_.clear();
+    loop_->stop();
+}
+
+void AMQConnectionPool::setSendOptions(const SendOptions& options) {
+    for (auto& client : clients_) {
+        client->setSendOptions(options);
+    }
+}
+
+void AMQConnectionPool::setConnectionOptions(const ConnectionOptions& options) {
+    for (auto& client : clients_) {
+        client->setConnectionOptions(options);
+    }
+}
+
+void AMQConnectionPool::setMetrics(ServiceMetrics* metrics) {
+    for (auto& client : clients_) {
+        client->setMetrics(metrics);
+    }
+}
+
+void AMQConnectionPool::connect(const std::vector<std::string>& broker_addresses) {
+    if (broker_addresses.empty()) {
+        throw std::runtime_error("No broker addresses to connect to");
+    }
+
+    try {
+        for (size_t i = 0; i < clients_.size(); ++i) {
+            clients_[i]->connect(broker_addresses[i % broker_addresses.size()]);
+        }
+    } catch (const std::exception&) {
+        disconnect();
+        throw;
+    }
+
+    if (clients_.size() > 1) {
+        Logger::info("Opened " + std::to_string(clients_.size()) + " broker connections across " +
+                     std::to_string(std::min(clients_.size(), broker_addresses.size())) + " broker(s)");
+    }
+}
+
+std::string AMQConnectionPool::subscribe(const std::string& topic, MessageCallback callback,
+                                         MessageExecutor executor) {
+    return clients_.front()->subscribe(topic, std::move(callback), std::move(executor));
+}
+
+void AMQConnectionPool::pauseReading(bool paused) {
+    clients_.front()->pauseReading(paused);
+}
+
+void AMQConnectionPool::publishBatch(std::string_view shard_key, const OutboundBatch& messages) {
+    if (messages.empty()) {
+        return;
+    }
+    const size_t count = clients_.size();
+    std::hash<std::string_view> hasher;
+
+    if (policy_ == ShardPolicy::IMAGE || count == 1) {
+        publishOn(hasher(shard_key) % count, messages);
+        return;
+    }
+
+    // Per topic: the common case of a batch that lands on one shard is passed through
+    size_t first = hasher(messages.front().topic) % count;
+    bool single_shard = true;
+    for (const auto& message : messages) {
+        if (hasher(message.topic) % count != first) {
+            single_shard = false;
+            break;
+        }
+    }
+    if (single_shard) {
+        publishOn(first, messages);
+        return;
+    }
+
+    std::vector<OutboundBatch> shards(count);
+    for (const auto& message : messages) {
+        shards[hasher(message.topic) % count].push_back(message);
+    }
+    for (size_t shard = 0; shard < count; ++shard) {
+        if (!shards[shard].empty()) {
+            publishOn(shard, shards[shard]);
+        }
+    }
+}
+
+void AMQConnectionPool::publishOn(size_t shard, const OutboundBatch& messages) {
+    // Keep the key's connection while it is up; otherwise the next live one
+    for (size_t attempt = 0; attempt < clients_.size(); ++attempt) {
+        AMQClient& client = *clients_[(shard + attempt) % clients_.size()];
+        if (client.isConnected()) {
+            client.publishBatch(messages);
+            return;
+        }
+    }
+    // None is up: the key's own connection holds the batch until it reconnects
+    AMQClient& home = *clients_[shard % clients_.size()];
+    if (home.acceptsPublishes()) {
+        home.publishBatch(messages);
+        return;
+    }
+    throw std::runtime_error("Cannot publish: no broker connection is up");
+}
+
+size_t AMQConnectionPool::queuedBytes() const {
+    size_t total = 0;
+    for (const auto& client : clients_) {
+        total += client->queuedBytes();
+    }
+    return total;
+}
+
+bool AMQConnectionPool::isConnected() const {
+    return clients_.front()->isConnected();
+}
+
+void AMQConnectionPool::disconnect() {
+    for (auto& client : clients_) {
+        client->disconnect();
+    }
+}
+
+} // namespace sar_atr
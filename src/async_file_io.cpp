@@ -0,0 +1,536 @@
+#include "async_file_io.h"
+#include "logger.h"
+#include "thread_pool.h"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+namespace sar_atr {
+
+namespace {
+
+constexpr size_t kBufferAlignment = 4096;
+
+} // namespace
+
+AsyncFileIO::Buffer::~Buffer() {
+    if (owner_) {
+        owner_->releaseBuffer(index_);
+    }
+}
+
+AsyncFileIO::Buffer::Buffer(Buffer&& other) noexcept
+    : owner_(other.owner_), data_(other.data_), capacity_(other.capacity_), index_(other.index_) {
+    other.owner_ = nullptr;
+    other.data_ = nullptr;
+    other.capacity_ = 0;
+    other.index_ = -1;
+}
+
+AsyncFileIO::Buffer& AsyncFileIO::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        if (owner_) {
+            owner_->releaseBuffer(index_);
+        }
+        owner_ = other.owner_;
+        data_ = other.data_;
+        capacity_ = other.capacity_;
+        index_ = other.index_;
+        other.owner_ = nullptr;
+        other.data_ = nullptr;
+        other.capacity_ = 0;
+        other.index_ = -1;
+    }
+    return *this;
+}
+
+AsyncFileIO::AsyncFileIO(const AsyncIoOptions& options, ServiceMetrics* metrics)
+    : metrics_(metrics),
+      buffer_size_((std::max<size_t>(options.buffer_size, 1) + kBufferAlignment - 1) & ~(kBufferAlignment - 1)) {
+    buffers_.reserve(options.buffer_count);
+    free_buffers_.reserve(options.buffer_count);
+    for (size_t i = 0; i < options.buffer_count; ++i) {
+        void* memory = std::aligned_alloc(kBufferAlignment, buffer_size_);
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        buffers_.emplace_back(static_cast<uint8_t*>(memory));
+        free_buffers_.push_back(static_cast<int>(i));
+    }
+}
+
+AsyncFileIO::Buffer AsyncFileIO::acquireBuffer() {
+    Buffer buffer;
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    if (!free_buffers_.empty()) {
+        buffer.owner_ = this;
+        buffer.index_ = free_buffers_.back();
+        buffer.data_ = buffers_[static_cast<size_t>(buffer.index_)].get();
+        buffer.capacity_ = buffer_size_;
+        free_buffers_.pop_back();
+    }
+    return buffer;
+}
+
+void AsyncFileIO::releaseBuffer(int index) {
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    free_buffers_.push_back(index);
+}
+
+namespace {
+
+/**
+ * io_uring through the raw system calls: one submission/completion ring
+ * pair, a fixed table of request slots (so at most sq_entries requests are
+ * ever in flight and neither ring can overflow) and one completion thread.
+ */
+class UringFileIO : public AsyncFileIO {
+public:
+    UringFileIO(const AsyncIoOptions& options, ServiceMetrics* metrics);
+    ~UringFileIO() override;
+
+    const char* backend() const override { return "io_uring"; }
+    void submit() override;
+    void shutdown() override;
+
+protected:
+    void queue(bool write, int fd, void* data, size_t length, uint64_t offset, int buffer_index,
+               Completion done) override;
+
+private:
+    static constexpr uint64_t kWakeup = ~0ULL;  ///< user_data of the NOP that stops the completion thread
+
+    /// Fill the next submission entry (caller holds mutex_)
+    void prepareLocked(uint8_t opcode, int fd, void* data, size_t length, uint64_t offset, int buffer_index,
+                       uint64_t user_data);
+    /// Submit the entries queued so far; entries the kernel refuses are taken back and failed
+    /// @return false if any were refused
+    bool flushLocked();
+    /// Run the completions of refused entries (caller must not hold mutex_)
+    void completeFailed();
+    void reap();
+
+    int ring_fd_ = -1;
+    void* sq_ring_ = MAP_FAILED;
+    void* cq_ring_ = MAP_FAILED;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    bool registered_ = false;   ///< Buffers registered: pooled-buffer requests use the _FIXED opcodes
+
+    std::mutex mutex_;
+    std::condition_variable slot_free_;
+    std::vector<Completion> requests_;      ///< Indexed by user_data
+    std::vector<uint32_t> free_requests_;
+    std::vector<std::pair<Completion, int>> failed_;  ///< Refused by io_uring_enter, with the errno
+    unsigned unsubmitted_ = 0;
+    bool stopping_ = false;
+    std::thread reaper_;
+};
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+UringFileIO::UringFileIO(const AsyncIoOptions& options, ServiceMetrics* metrics)
+    : AsyncFileIO(options, metrics) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd_ = ioUringSetup(std::max(options.queue_depth, 1u), &params);
+    if (ring_fd_ < 0) {
+        throw std::runtime_error("io_uring_setup failed: " + std::string(std::strerror(errno)));
+    }
+    // IORING_OP_READ/WRITE arrived in the same kernel (5.6) as this feature bit
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        ::close(ring_fd_);
+        throw std::runtime_error("kernel io_uring lacks IORING_OP_READ/WRITE");
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_
+                           : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                    ring_fd_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_SQES);
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+        int err = errno;
+        shutdown();
+        throw std::runtime_error("io_uring mmap failed: " + std::string(std::strerror(err)));
+    }
+
+    auto* sq = static_cast<uint8_t*>(sq_ring_);
+    auto* cq = static_cast<uint8_t*>(cq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Registration pins the buffers once instead of per request. It counts
+    // against RLIMIT_MEMLOCK, so a refusal only costs the pinning.
+    if (!buffers().empty()) {
+        std::vector<iovec> iovecs(buffers().size());
+        for (size_t i = 0; i < iovecs.size(); ++i) {
+            iovecs[i].iov_base = buffers()[i].get();
+            iovecs[i].iov_len = bufferSize();
+        }
+        registered_ = ioUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                      static_cast<unsigned>(iovecs.size())) == 0;
+        if (!registered_) {
+            Logger::warning("io_uring buffer registration failed (" + std::string(std::strerror(errno)) +
+                            "); using unregistered buffers");
+        }
+    }
+
+    // One slot per submission entry; the completion ring is twice as large
+    requests_.resize(params.sq_entries);
+    free_requests_.reserve(params.sq_entries);
+    for (uint32_t i = params.sq_entries; i > 0; --i) {
+        free_requests_.push_back(i - 1);
+    }
+
+    reaper_ = std::thread([this]() {
+        reap();
+    });
+    Logger::debug("io_uring ready: " + std::to_string(params.sq_entries) + " entries, " +
+                  std::to_string(buffers().size()) + (registered_ ? " registered" : "") + " buffer(s)");
+}
+
+UringFileIO::~UringFileIO() {
+    shutdown();
+}
+
+void UringFileIO::prepareLocked(uint8_t opcode, int fd, void* data, size_t length, uint64_t offset,
+                                int buffer_index, uint64_t user_data) {
+    // Only this class writes the tail, always under mutex_; the kernel reads it
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe& sqe = sqes_[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = opcode;
+    sqe.fd = fd;
+    sqe.off = offset;
+    sqe.addr = reinterpret_cast<uint64_t>(data);
+    sqe.len = static_cast<uint32_t>(std::min<size_t>(length, UINT32_MAX)); // longer requests complete short
+    sqe.user_data = user_data;
+    if (buffer_index >= 0) {
+        sqe.buf_index = static_cast<uint16_t>(buffer_index);
+    }
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    unsubmitted_++;
+}
+
+void UringFileIO::queue(bool write, int fd, void* data, size_t length, uint64_t offset, int buffer_index,
+                        Completion done) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (free_requests_.empty() && !stopping_) {
+        // Whatever is still queued here has to go out before a slot can free up
+        flushLocked();
+        slot_free_.wait(lock, [this]() { return stopping_ || !free_requests_.empty(); });
+    }
+    if (stopping_) {
+        lock.unlock();
+        completeFailed();
+        done(-ECANCELED);
+        return;
+    }
+
+    uint32_t id = free_requests_.back();
+    free_requests_.pop_back();
+    requests_[id] = std::move(done);
+
+    const bool fixed = registered_ && buffer_index >= 0;
+    uint8_t opcode = write ? (fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE)
+                           : (fixed ? IORING_OP_READ_FIXED : IORING_OP_READ);
+    prepareLocked(opcode, fd, data, length, offset, fixed ? buffer_index : -1, id);
+    if (metrics_) {
+        metrics_->io_requests.inc();
+        metrics_->io_in_flight.add(1);
+    }
+    const bool failed = !failed_.empty();
+    lock.unlock();
+    if (failed) {
+        completeFailed();
+    }
+}
+
+void UringFileIO::submit() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushLocked();
+    const bool failed = !failed_.empty();
+    lock.unlock();
+    if (failed) {
+        completeFailed();
+    }
+}
+
+bool UringFileIO::flushLocked() {
+    while (unsubmitted_ > 0) {
+        int submitted = ioUringEnter(ring_fd_, unsubmitted_, 0, 0);
+        if (submitted >= 0) {
+            unsubmitted_ -= static_cast<unsigned>(submitted);
+            continue;
+        }
+        const int error = errno;
+        if (error == EINTR) {
+            continue;
+        }
+        Logger::error("io_uring_enter failed: " + std::string(std::strerror(error)));
+
+        // Nothing polls the ring, so the kernel has not looked at the
+        // unsubmitted entries: take them back, free their slots and fail them
+        // rather than leave them for a submit() that may never come
+        unsigned tail = *sq_tail_;
+        for (unsigned i = 0; i < unsubmitted_; ++i) {
+            const uint64_t user_data = sqes_[(tail - 1 - i) & sq_mask_].user_data;
+            if (user_data == kWakeup) {
+                continue;
+            }
+            auto id = static_cast<uint32_t>(user_data);
+            failed_.emplace_back(std::move(requests_[id]), error);
+            requests_[id] = nullptr;
+            free_requests_.push_back(id);
+        }
+        __atomic_store_n(sq_tail_, tail - unsubmitted_, __ATOMIC_RELEASE);
+        unsubmitted_ = 0;
+        slot_free_.notify_all();
+        return false;
+    }
+    return true;
+}
+
+void UringFileIO::completeFailed() {
+    std::vector<std::pair<Completion, int>> failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failed.swap(failed_);
+    }
+    for (auto& [done, error] : failed) {
+        if (metrics_) {
+            metrics_->io_in_flight.add(-1);
+            metrics_->io_errors.inc();
+        }
+        try {
+            done(-error);
+        } catch (const std::exception& e) {
+            Logger::error("File I/O completion failed: " + std::string(e.what()));
+        }
+    }
+}
+
+void UringFileIO::reap() {
+    for (;;) {
+        if (ioUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            Logger::error("io_uring wait failed: " + std::string(std::strerror(errno)));
+            return;
+        }
+
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        bool wakeup = false;
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            const uint64_t user_data = cqe.user_data;
+            const ssize_t result = cqe.res;
+            head++;
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+            if (user_data == kWakeup) {
+                wakeup = true;
+                continue;
+            }
+            Completion done;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto id = static_cast<uint32_t>(user_data);
+                done = std::move(requests_[id]);
+                requests_[id] = nullptr;
+                free_requests_.push_back(id);
+            }
+            slot_free_.notify_all();
+            if (metrics_) {
+                metrics_->io_in_flight.add(-1);
+                if (result < 0) {
+                    metrics_->io_errors.inc();
+                }
+            }
+            try {
+                done(result);
+            } catch (const std::exception& e) {
+                Logger::error("File I/O completion failed: " + std::string(e.what()));
+            }
+        }
+        if (wakeup) {
+            return;
+        }
+    }
+}
+
+void UringFileIO::shutdown() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!stopping_ && reaper_.joinable()) {
+            stopping_ = true;
+            flushLocked();
+            slot_free_.wait(lock, [this]() { return free_requests_.size() == requests_.size(); });
+            prepareLocked(IORING_OP_NOP, -1, nullptr, 0, 0, -1, kWakeup);
+            while (!flushLocked()) {
+                // The reaper only stops on the wakeup, so keep offering it while it drains
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                lock.lock();
+                prepareLocked(IORING_OP_NOP, -1, nullptr, 0, 0, -1, kWakeup);
+            }
+        }
+        stopping_ = true;
+    }
+    slot_free_.notify_all();
+    completeFailed();
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+
+    if (sqes_ != MAP_FAILED) {
+        ::munmap(sqes_, sqes_size_);
+        sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        ::munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = MAP_FAILED;
+    if (sq_ring_ != MAP_FAILED) {
+        ::munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = MAP_FAILED;
+    }
+    if (ring_fd_ >= 0) {
+        ::close(ring_fd_); // also drops the buffer registration
+        ring_fd_ = -1;
+    }
+}
+
+/**
+ * Blocking pread()/pwrite() on a small pool, for kernels (or seccomp
+ * profiles) without io_uring. The pool's bounded queue limits requests in
+ * flight the way the ring does.
+ */
+class ThreadFileIO : public AsyncFileIO {
+public:
+    ThreadFileIO(const AsyncIoOptions& options, ServiceMetrics* metrics)
+        : AsyncFileIO(options, metrics),
+          pool_("file I/O", std::max(options.fallback_threads, 1), std::max(options.queue_depth, 1u)) {}
+    ~ThreadFileIO() override { shutdown(); }
+
+    const char* backend() const override { return "threads"; }
+    void submit() override {}
+    void shutdown() override { pool_.shutdown(); }
+
+protected:
+    void queue(bool write, int fd, void* data, size_t length, uint64_t offset, int /*buffer_index*/,
+               Completion done) override;
+
+private:
+    ThreadPool pool_;
+};
+
+void ThreadFileIO::queue(bool write, int fd, void* data, size_t length, uint64_t offset, int /*buffer_index*/,
+                         Completion done) {
+    if (metrics_) {
+        metrics_->io_requests.inc();
+        metrics_->io_in_flight.add(1);
+    }
+    auto transfer = [this, write, fd, data, length, offset, done]() {
+        // Loop over short transfers the way one io_uring request would not,
+        // stopping at end of file
+        size_t moved = 0;
+        ssize_t result = 0;
+        while (moved < length) {
+            ssize_t n = write ? ::pwrite(fd, static_cast<const uint8_t*>(data) + moved, length - moved,
+                                         static_cast<off_t>(offset + moved))
+                              : ::pread(fd, static_cast<uint8_t*>(data) + moved, length - moved,
+                                        static_cast<off_t>(offset + moved));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                result = n < 0 ? -errno : 0;
+                break;
+            }
+            moved += static_cast<size_t>(n);
+        }
+        if (result == 0 || moved > 0) {
+            result = static_cast<ssize_t>(moved);
+        }
+        if (metrics_) {
+            metrics_->io_in_flight.add(-1);
+            if (result < 0) {
+                metrics_->io_errors.inc();
+            }
+        }
+        done(result);
+    };
+    try {
+        pool_.submit(std::move(transfer));
+    } catch (const std::runtime_error&) {
+        if (metrics_) {
+            metrics_->io_in_flight.add(-1);
+        }
+        done(-ECANCELED); // shut down
+    }
+}
+
+} // namespace
+
+std::unique_ptr<AsyncFileIO> AsyncFileIO::create(const AsyncIoOptions& options, ServiceMetrics* metrics) {
+    if (options.use_io_uring) {
+        try {
+            return std::make_unique<UringFileIO>(options, metrics);
+        } catch (const std::exception& e) {
+            Logger::warning("io_uring unavailable (" + std::string(e.what()) + "); using file I/O threads");
+        }
+    }
+    return std::make_unique<ThreadFileIO>(options, metrics);
+}
+
+} // namespace sar_atr
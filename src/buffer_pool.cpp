@@ -0,0 +1,79 @@
+#include "buffer_pool.h"
+#include <cstdlib>
+#include <new>
+
+namespace sar_atr {
+
+void BufferPool::AlignedFree::operator()(uint8_t* p) const {
+    std::free(p);
+}
+
+BufferPool::Lease::~Lease() {
+    if (pool_ && storage_) {
+        pool_->release(std::move(storage_), capacity_);
+    }
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        if (pool_ && storage_) {
+            pool_->release(std::move(storage_), capacity_);
+        }
+        pool_ = other.pool_;
+        storage_ = std::move(other.storage_);
+        capacity_ = other.capacity_;
+        other.pool_ = nullptr;
+        other.capacity_ = 0;
+    }
+    return *this;
+}
+
+BufferPool::BufferPool(size_t alignment, size_t max_cached)
+    : alignment_(alignment), max_cached_(max_cached) {}
+
+BufferPool::Lease BufferPool::acquire(size_t min_bytes) {
+    size_t wanted = alignUp(min_bytes == 0 ? 1 : min_bytes);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Prefer the smallest cached buffer that fits
+        size_t best = free_.size();
+        for (size_t i = 0; i < free_.size(); ++i) {
+            if (free_[i].capacity >= wanted && (best == free_.size() || free_[i].capacity < free_[best].capacity)) {
+                best = i;
+            }
+        }
+        if (best != free_.size()) {
+            Cached cached = std::move(free_[best]);
+            free_[best] = std::move(free_.back());
+            free_.pop_back();
+            return Lease(this, std::move(cached.storage), cached.capacity);
+        }
+    }
+
+    void* memory = std::aligned_alloc(alignment_, wanted);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return Lease(this, Storage(static_cast<uint8_t*>(memory)), wanted);
+}
+
+void BufferPool::release(Storage storage, size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < max_cached_) {
+        free_.push_back({std::move(storage), capacity});
+        return;
+    }
+    // Pool is full: replace the smallest cached buffer if this one is larger
+    size_t smallest = 0;
+    for (size_t i = 1; i < free_.size(); ++i) {
+        if (free_[i].capacity < free_[smallest].capacity) {
+            smallest = i;
+        }
+    }
+    if (!free_.empty() && free_[smallest].capacity < capacity) {
+        free_[smallest] = {std::move(storage), capacity};
+    }
+}
+
+} // namespace sar_atr
@@ -0,0 +1,534 @@
+#include "chip_extractor.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <future>
+#include <stdexcept>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace sar_atr {
+
+namespace {
+
+// Fixed part of a single-image NITF 2.1 file header (all lengths in bytes)
+constexpr size_t kChipFileHeaderLength = 404;
+
+void appendText(std::string& out, std::string_view value, size_t width) {
+    value = value.substr(0, width);
+    out.append(value.data(), value.size());
+    out.append(width - value.size(), ' ');
+}
+
+void appendNumber(std::string& out, unsigned long long value, size_t width) {
+    std::string digits = std::to_string(value);
+    if (digits.size() > width) {
+        throw std::runtime_error("NITF field value " + digits + " does not fit in " + std::to_string(width) +
+                                 " characters");
+    }
+    out.append(width - digits.size(), '0');
+    out += digits;
+}
+
+std::string nitfDateTime() {
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    char buffer[16];
+    std::strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S", &utc);
+    return buffer;
+}
+
+std::string imageSubheader(const NitfImageInfo& source, const ChipRegion& region,
+                           const DetectionResult& detection, const std::string& date_time) {
+    std::string sub;
+    sub.reserve(512);
+    sub += "IM";
+    appendText(sub, "CHIP", 10);                          // IID1
+    sub += date_time;                                     // IDATIM
+    appendText(sub, "", 17);                              // TGTID
+    appendText(sub, detection.classification(), 80);      // IID2
+    sub += 'U';                                           // ISCLAS
+    appendText(sub, "", 166);                             // ISCLSY..ISCTLN
+    sub += '0';                                           // ENCRYP
+    appendText(sub, "Chip of " + source.image_id, 42);    // ISORCE
+    appendNumber(sub, static_cast<unsigned>(region.rows), 8);
+    appendNumber(sub, static_cast<unsigned>(region.cols), 8);
+    appendText(sub, source.pixel_type, 3);
+    appendText(sub, source.representation, 8);
+    appendText(sub, source.category, 8);
+    appendNumber(sub, static_cast<unsigned>(source.actual_bits_per_pixel), 2);
+    sub += 'R';                                           // PJUST
+    sub += ' ';                                           // ICORDS: no geolocation
+    sub += '0';                                           // NICOM
+    sub += "NC";                                          // IC
+    if (source.bands <= 9) {
+        appendNumber(sub, static_cast<unsigned>(source.bands), 1);
+    } else {
+        sub += '0';
+        appendNumber(sub, static_cast<unsigned>(source.bands), 5);
+    }
+    for (int band = 0; band < source.bands; ++band) {
+        appendText(sub, source.bands == 1 && source.representation == "MONO" ? "M" : "", 2); // IREPBANDn
+        appendText(sub, "", 6);                           // ISUBCATn
+        sub += 'N';                                       // IFCn
+        appendText(sub, "", 3);                           // IMFLTn
+        sub += '0';                                       // NLUTSn
+    }
+    sub += '0';                                           // ISYNC
+    sub += 'B';                                           // IMODE
+    sub += "00010001";                                    // NBPR, NBPC: one block
+    appendNumber(sub, static_cast<unsigned>(region.cols), 4);
+    appendNumber(sub, static_cast<unsigned>(region.rows), 4);
+    appendNumber(sub, static_cast<unsigned>(source.bits_per_pixel), 2);
+    sub += "001";                                         // IDLVL
+    sub += "000";                                         // IALVL
+    sub += "0000000000";                                  // ILOC
+    sub += "1.0 ";                                        // IMAG
+    sub += "00000";                                       // UDIDL
+    sub += "00000";                                       // IXSHDL
+    return sub;
+}
+
+std::string chipHeaders(const NitfImageInfo& source, const ChipRegion& region,
+                        const DetectionResult& detection, size_t pixel_bytes) {
+    std::string date_time = nitfDateTime();
+    std::string sub = imageSubheader(source, region, detection, date_time);
+
+    std::string header;
+    header.reserve(kChipFileHeaderLength + sub.size());
+    header += "NITF02.10";
+    header += "03";                                       // CLEVEL
+    header += "BF01";                                     // STYPE
+    appendText(header, "SAR_ATR", 10);                    // OSTAID
+    header += date_time;                                  // FDT
+    appendText(header, std::string("Detection chip: ").append(detection.classification()), 80);
+    header += 'U';                                        // FSCLAS
+    appendText(header, "", 166);                          // FSCLSY..FSCTLN
+    header += "00000";                                    // FSCOP
+    header += "00000";                                    // FSCPYS
+    header += '0';                                        // ENCRYP
+    header.append(3, '\0');                               // FBKGC
+    appendText(header, "", 24);                           // ONAME
+    appendText(header, "", 18);                           // OPHONE
+    appendNumber(header, kChipFileHeaderLength + sub.size() + pixel_bytes, 12);
+    appendNumber(header, kChipFileHeaderLength, 6);
+    header += "001";                                      // NUMI
+    appendNumber(header, sub.size(), 6);
+    appendNumber(header, pixel_bytes, 10);
+    header += "000000000000000";                          // NUMS, NUMX, NUMT, NUMDES, NUMRES
+    header += "00000";                                    // UDHDL
+    header += "00000";                                    // XHDL
+    header += sub;
+    return header;
+}
+
+// Copy one band of a region row by row, crossing block boundaries as needed
+void copyRegion(const NitfReader& reader, const NitfImageInfo& info, const ChipRegion& region,
+                uint8_t* out) {
+    const size_t bytes_per_pixel = static_cast<size_t>(info.bytesPerPixel());
+    const int region_end = region.col + region.cols;
+
+    for (int band = 0; band < info.bands; ++band) {
+        for (int r = 0; r < region.rows; ++r) {
+            const int image_row = region.row + r;
+            const int block_row = image_row / info.block_rows;
+            const int y = image_row % info.block_rows;
+
+            int col = region.col;
+            while (col < region_end) {
+                const int block_col = col / info.block_cols;
+                const int x = col % info.block_cols;
+                const int count = std::min(region_end - col, info.block_cols - x);
+                const size_t span = static_cast<size_t>(count) * bytes_per_pixel;
+
+                NitfBlockView view = reader.block(0, block_row, block_col, band);
+                if (view.empty()) {
+                    std::memset(out, 0, span);
+                } else if (view.contiguous()) {
+                    std::memcpy(out, view.pixel(y, x), span);
+                } else {
+                    for (int i = 0; i < count; ++i) {
+                        std::memcpy(out + i * bytes_per_pixel, view.pixel(y, x + i), bytes_per_pixel);
+                    }
+                }
+                out += span;
+                col += count;
+            }
+        }
+    }
+}
+
+std::string fileStem(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+void writeAll(int fd, const uint8_t* data, size_t length, size_t offset) {
+    while (offset < length) {
+        ssize_t n = ::pwrite(fd, data + offset, length - offset, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("write failed: " + std::string(std::strerror(errno)));
+        }
+        offset += static_cast<size_t>(n);
+    }
+}
+
+// Cut the O_DIRECT padding off and close; the descriptor is closed even on failure
+void closeChip(int fd, bool direct, size_t length, size_t aligned_length) {
+    if (direct && aligned_length != length && ::ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("truncate failed: " + std::string(std::strerror(err)));
+    }
+    if (::close(fd) != 0) {
+        throw std::runtime_error("close failed: " + std::string(std::strerror(errno)));
+    }
+}
+
+} // namespace
+
+/// A chip whose write is in flight: owns its buffer and descriptor until finishChip()
+struct ChipExtractor::PendingChip {
+    int fd = -1;
+    bool direct = false;
+    size_t length = 0;
+    size_t to_write = 0;
+    size_t aligned_length = 0;
+    const uint8_t* data = nullptr;
+    AsyncFileIO::Buffer io_buffer;
+    BufferPool::Lease lease;
+    std::promise<ssize_t> written; ///< Result of the queued write, set on the I/O layer's thread
+    std::future<ssize_t> result;
+};
+
+ChipRegion computeChipRegion(const BoundingBox& box, int image_cols, int image_rows, const ChipOptions& options) {
+    const double scale = 1.0 + options.padding;
+    int cols = static_cast<int>((box.x2 - box.x1) * image_cols * scale);
+    int rows = static_cast<int>((box.y2 - box.y1) * image_rows * scale);
+    cols = std::min(std::max(options.min_size, std::min(options.max_size, cols)), image_cols);
+    rows = std::min(std::max(options.min_size, std::min(options.max_size, rows)), image_rows);
+
+    ChipRegion region;
+    region.cols = std::max(0, cols);
+    region.rows = std::max(0, rows);
+    int col = static_cast<int>(std::lround(box.centerX() * image_cols - region.cols / 2.0));
+    int row = static_cast<int>(std::lround(box.centerY() * image_rows - region.rows / 2.0));
+    region.col = std::max(0, std::min(image_cols - region.cols, col));
+    region.row = std::max(0, std::min(image_rows - region.rows, row));
+    return region;
+}
+
+long long totalChipPixels(const DetectionBatch& candidates, float min_confidence, int image_cols, int image_rows,
+                          const ChipOptions& options) {
+    const float* confidence = candidates.confidence();
+    const float* x1 = candidates.x1();
+    const float* y1 = candidates.y1();
+    const float* x2 = candidates.x2();
+    const float* y2 = candidates.y2();
+    const size_t count = candidates.size();
+    long long total = 0;
+    size_t i = 0;
+
+    // Same arithmetic as computeChipRegion(): float box extent times the image
+    // size, then double padding and truncation. Chip edges are clamped while
+    // still doubles (clamping to integer bounds commutes with truncation) and
+    // summed in doubles, which stay exact far beyond any realistic total.
+#if defined(__AVX2__) || defined(__SSE2__)
+    const double scale = 1.0 + options.padding;
+    const __m128 limit = _mm_set1_ps(min_confidence);
+    const __m128 cols_f = _mm_set1_ps(static_cast<float>(image_cols));
+    const __m128 rows_f = _mm_set1_ps(static_cast<float>(image_rows));
+#endif
+#if defined(__AVX2__)
+    const __m256d scale4 = _mm256_set1_pd(scale);
+    const __m256d min_edge4 = _mm256_set1_pd(options.min_size);
+    const __m256d max_edge4 = _mm256_set1_pd(options.max_size);
+    const __m256d cols4 = _mm256_set1_pd(image_cols);
+    const __m256d rows4 = _mm256_set1_pd(image_rows);
+    const __m256d zero4 = _mm256_setzero_pd();
+    auto edge4 = [&](__m128 extent, __m256d bound) {
+        __m256d edge = _mm256_mul_pd(_mm256_cvtps_pd(extent), scale4);
+        edge = _mm256_min_pd(_mm256_max_pd(min_edge4, _mm256_min_pd(max_edge4, edge)), bound);
+        return _mm256_round_pd(_mm256_max_pd(zero4, edge), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    };
+    __m256d sum4 = zero4;
+    for (; i + 4 <= count; i += 4) {
+        __m128 passed = _mm_cmpge_ps(_mm_loadu_ps(confidence + i), limit);
+        if (_mm_movemask_ps(passed) == 0) {
+            continue; // the usual case for raw candidates
+        }
+        __m128i keep = _mm_castps_si128(passed);
+        __m128 width = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x2 + i), _mm_loadu_ps(x1 + i)), cols_f);
+        __m128 height = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y2 + i), _mm_loadu_ps(y1 + i)), rows_f);
+        __m256d pixels = _mm256_mul_pd(edge4(width, cols4), edge4(height, rows4));
+        sum4 = _mm256_add_pd(sum4, _mm256_and_pd(pixels, _mm256_castsi256_pd(_mm256_cvtepi32_epi64(keep))));
+    }
+    alignas(32) double lanes4[4];
+    _mm256_store_pd(lanes4, sum4);
+    total += static_cast<long long>((lanes4[0] + lanes4[1]) + (lanes4[2] + lanes4[3]));
+#elif defined(__SSE2__)
+    const __m128d scale2 = _mm_set1_pd(scale);
+    const __m128d min_edge2 = _mm_set1_pd(options.min_size);
+    const __m128d max_edge2 = _mm_set1_pd(options.max_size);
+    const __m128d cols2 = _mm_set1_pd(image_cols);
+    const __m128d rows2 = _mm_set1_pd(image_rows);
+    const __m128d zero2 = _mm_setzero_pd();
+    // Two lanes of doubles: the low two floats of extent
+    auto edge2 = [&](__m128 extent, __m128d bound) {
+        __m128d edge = _mm_mul_pd(_mm_cvtps_pd(extent), scale2);
+        edge = _mm_min_pd(_mm_max_pd(min_edge2, _mm_min_pd(max_edge2, edge)), bound);
+        return _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_max_pd(zero2, edge)));
+    };
+    __m128d sum2 = zero2;
+    for (; i + 4 <= count; i += 4) {
+        __m128 passed = _mm_cmpge_ps(_mm_loadu_ps(confidence + i), limit);
+        if (_mm_movemask_ps(passed) == 0) {
+            continue; // the usual case for raw candidates
+        }
+        __m128i keep = _mm_castps_si128(passed);
+        __m128 width = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x2 + i), _mm_loadu_ps(x1 + i)), cols_f);
+        __m128 height = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y2 + i), _mm_loadu_ps(y1 + i)), rows_f);
+        __m128d low = _mm_mul_pd(edge2(width, cols2), edge2(height, rows2));
+        __m128d high = _mm_mul_pd(edge2(_mm_movehl_ps(width, width), cols2),
+                                  edge2(_mm_movehl_ps(height, height), rows2));
+        sum2 = _mm_add_pd(sum2, _mm_and_pd(low, _mm_castsi128_pd(_mm_unpacklo_epi32(keep, keep))));
+        sum2 = _mm_add_pd(sum2, _mm_and_pd(high, _mm_castsi128_pd(_mm_unpackhi_epi32(keep, keep))));
+    }
+    alignas(16) double lanes2[2];
+    _mm_store_pd(lanes2, sum2);
+    total += static_cast<long long>(lanes2[0] + lanes2[1]);
+#endif
+
+    for (; i < count; ++i) {
+        if (confidence[i] >= min_confidence) {
+            ChipRegion chip = computeChipRegion(candidates.box(i), image_cols, image_rows, options);
+            total += static_cast<long long>(chip.cols) * chip.rows;
+        }
+    }
+    return total;
+}
+
+ChipExtractor::ChipExtractor(const ChipOptions& options, AsyncFileIO* io)
+    : options_(options), buffers_(4096, 32), io_(io), sequence_(0) {
+    std::error_code ec;
+    std::filesystem::create_directories(options_.output_dir, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot create chip output directory " + options_.output_dir + ": " +
+                                 ec.message());
+    }
+
+    int threads = options_.threads;
+    if (threads <= 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threads = cores > 0 ? static_cast<int>(cores) : 1;
+    }
+    pool_ = std::make_unique<ThreadPool>("chip", threads, static_cast<size_t>(threads) * 4);
+}
+
+int ChipExtractor::extract(const std::string& nitf_path, DetectionList& detections, float min_confidence) {
+    std::vector<size_t> selected;
+    for (size_t i = 0; i < detections.size(); ++i) {
+        if (detections[i].confidence >= min_confidence) {
+            selected.push_back(i);
+        }
+    }
+    if (selected.empty()) {
+        return 0;
+    }
+
+    std::unique_ptr<NitfReader> reader;
+    try {
+        reader = std::make_unique<NitfReader>(nitf_path);
+        if (reader->imageCount() == 0) {
+            throw std::runtime_error("no image segments");
+        }
+        const NitfImageInfo& info = reader->image(0);
+        if (!info.isUncompressed() || info.bits_per_pixel % 8 != 0) {
+            throw std::runtime_error("chips need uncompressed, byte-aligned pixels (IC=" + info.compression +
+                                     ", NBPP=" + std::to_string(info.bits_per_pixel) + ")");
+        }
+    } catch (const std::exception& e) {
+        Logger::warning("Cannot cut chips from " + nitf_path + ": " + std::string(e.what()));
+        return 0;
+    }
+
+    const std::string prefix = options_.output_dir + "/" + fileStem(nitf_path) + "_";
+    const char* extension = options_.write_nitf ? ".ntf" : ".raw";
+
+    std::vector<std::string> paths(selected.size());
+    std::vector<std::shared_ptr<PendingChip>> pending(selected.size());
+    std::vector<std::future<void>> cut;
+    cut.reserve(selected.size());
+    for (size_t k = 0; k < selected.size(); ++k) {
+        paths[k] = prefix + std::to_string(sequence_.fetch_add(1)) + extension;
+        const DetectionResult& detection = detections[selected[k]];
+        const std::string& chip_path = paths[k];
+        const NitfReader& source = *reader;
+        std::shared_ptr<PendingChip>& chip = pending[k];
+        cut.push_back(pool_->submit([this, &source, &detection, &chip_path, &chip]() {
+            writeChip(source, detection, chip_path, chip);
+        }));
+    }
+
+    // Wait for every chip to be cut (the tasks reference the reader and the
+    // detections), start all of their writes with one submission, then
+    // finish each write here as it completes
+    std::vector<bool> ok(selected.size(), true);
+    for (size_t k = 0; k < cut.size(); ++k) {
+        try {
+            cut[k].get();
+        } catch (const std::exception& e) {
+            Logger::error("Failed to write chip " + paths[k] + ": " + std::string(e.what()));
+            ok[k] = false;
+        }
+    }
+    if (io_) {
+        io_->submit();
+    }
+    int chips = 0;
+    for (size_t k = 0; k < pending.size(); ++k) {
+        if (!ok[k]) {
+            continue;
+        }
+        try {
+            if (pending[k]) {
+                finishChip(*pending[k]);
+            }
+            detections[selected[k]].output_file_path.assign(paths[k]);
+            chips++;
+        } catch (const std::exception& e) {
+            Logger::error("Failed to write chip " + paths[k] + ": " + std::string(e.what()));
+        }
+    }
+
+    SAR_LOG_DEBUG("Wrote " + std::to_string(chips) + " chip(s) from " + nitf_path);
+    return chips;
+}
+
+void ChipExtractor::writeChip(const NitfReader& reader, const DetectionResult& detection,
+                              const std::string& chip_path, std::shared_ptr<PendingChip>& pending) {
+    const NitfImageInfo& info = reader.image(0);
+    ChipRegion region = computeChipRegion(detection.bounding_box, info.cols, info.rows, options_);
+    if (region.cols <= 0 || region.rows <= 0) {
+        throw std::runtime_error("empty chip region");
+    }
+
+    const size_t pixel_bytes = static_cast<size_t>(region.cols) * region.rows * info.bytesPerPixel() *
+                               info.bands;
+    std::string header;
+    if (options_.write_nitf) {
+        header = chipHeaders(info, region, detection, pixel_bytes);
+    }
+
+    const size_t length = header.size() + pixel_bytes;
+    const size_t aligned_length = buffers_.alignUp(length);
+
+    // A chip that fits one of the I/O layer's buffers is cut straight into it
+    // (registered with io_uring, so the write skips page pinning)
+    auto chip = std::make_shared<PendingChip>();
+    uint8_t* data = nullptr;
+    if (io_) {
+        chip->io_buffer = io_->acquireBuffer();
+        if (chip->io_buffer && chip->io_buffer.capacity() >= aligned_length) {
+            data = chip->io_buffer.data();
+        } else {
+            chip->io_buffer = AsyncFileIO::Buffer();
+        }
+    }
+    if (!data) {
+        chip->lease = buffers_.acquire(aligned_length);
+        data = chip->lease.data();
+    }
+
+    std::memcpy(data, header.data(), header.size());
+    copyRegion(reader, info, region, data + header.size());
+    std::memset(data + length, 0, aligned_length - length);
+
+    chip->fd = openChip(chip_path, chip->direct);
+    chip->length = length;
+    chip->aligned_length = aligned_length;
+    // O_DIRECT needs whole aligned blocks; the padding is cut off afterwards
+    chip->to_write = chip->direct ? aligned_length : length;
+    chip->data = data;
+
+    if (!io_) {
+        try {
+            writeAll(chip->fd, data, chip->to_write, 0);
+        } catch (...) {
+            ::close(chip->fd);
+            throw;
+        }
+        closeChip(chip->fd, chip->direct, length, aligned_length);
+        return;
+    }
+
+    // Queued only: extract() submits every chip of the image at once. The
+    // completion runs on the I/O layer's thread, so it only hands the result
+    // back; extract() finishes the chip.
+    chip->result = chip->written.get_future();
+    pending = chip;
+    auto done = [chip](ssize_t result) { chip->written.set_value(result); };
+    if (chip->io_buffer) {
+        io_->write(chip->fd, chip->io_buffer, chip->to_write, 0, std::move(done));
+    } else {
+        io_->write(chip->fd, data, chip->to_write, 0, std::move(done));
+    }
+}
+
+void ChipExtractor::finishChip(PendingChip& chip) {
+    ssize_t result = chip.result.get();
+    if (result < 0) {
+        ::close(chip.fd);
+        throw std::runtime_error("write failed: " + std::string(std::strerror(static_cast<int>(-result))));
+    }
+    try {
+        // One request rarely comes back short; finish the tail in place
+        writeAll(chip.fd, chip.data, chip.to_write, static_cast<size_t>(result));
+    } catch (...) {
+        ::close(chip.fd);
+        throw;
+    }
+    closeChip(chip.fd, chip.direct, chip.length, chip.aligned_length);
+}
+
+int ChipExtractor::openChip(const std::string& path, bool& direct) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+    direct = false;
+#ifdef O_DIRECT
+    if (options_.direct_io) {
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        direct = fd >= 0;
+    }
+#endif
+    if (fd < 0) {
+        // tmpfs and some network filesystems reject O_DIRECT; fall back to buffered writes
+        fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0) {
+        throw std::runtime_error("open failed: " + std::string(std::strerror(errno)));
+    }
+    return fd;
+}
+
+void ChipExtractor::shutdown() {
+    if (pool_) {
+        pool_->shutdown();
+    }
+}
+
+} // namespace sar_atr
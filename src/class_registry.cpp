@@ -0,0 +1,70 @@
+#include "class_registry.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace sar_atr {
+
+namespace {
+
+/**
+ * Names are only ever appended. A slot is written before count is
+ * published, so readers that see an ID below count see its name without
+ * taking the lock.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::deque<std::string> names;                  ///< Stable storage behind the views
+    std::unordered_map<std::string, ClassId> ids;
+    std::array<std::string_view, kMaxClasses> views{};
+    std::atomic<size_t> count{1};                   ///< Slot 0 is kUnclassified ("")
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace
+
+ClassId internClass(std::string_view name) {
+    if (name.empty()) {
+        return kUnclassified;
+    }
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::string key(name);
+    auto it = r.ids.find(key);
+    if (it != r.ids.end()) {
+        return it->second;
+    }
+
+    size_t id = r.count.load(std::memory_order_relaxed);
+    if (id >= kMaxClasses) {
+        throw std::runtime_error("Too many classifications (limit " + std::to_string(kMaxClasses) + ")");
+    }
+    r.names.push_back(key);
+    r.views[id] = r.names.back();
+    r.ids.emplace(std::move(key), static_cast<ClassId>(id));
+    r.count.store(id + 1, std::memory_order_release);
+    return static_cast<ClassId>(id);
+}
+
+std::string_view className(ClassId id) {
+    Registry& r = registry();
+    if (id >= r.count.load(std::memory_order_acquire)) {
+        return std::string_view();
+    }
+    return r.views[id];
+}
+
+size_t classCount() {
+    return registry().count.load(std::memory_order_acquire);
+}
+
+} // namespace sar_atr
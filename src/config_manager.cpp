@@ -1,7 +1,10 @@
 #include "config_manager.h"
+#include "amq_connection_pool.h"
 #include "logger.h"
+#include "non_max_suppression.h"
 #include <fstream>
 #include <stdexcept>
+#include <thread>
 
 namespace sar_atr {
 
@@ -12,12 +15,20 @@ ServiceConfig ConfigManager::loadConfig(const std::string& config_path) {
         YAML::Node config = YAML::LoadFile(config_path);
         
         ServiceConfig service_config;
+        service_config.config_path = config_path;
         
-        // Required fields
-        if (!config["broker_address"]) {
+        // Required fields: broker_address, or a broker_addresses list instead
+        if (config["broker_addresses"]) {
+            service_config.broker_addresses = config["broker_addresses"].as<std::vector<std::string>>();
+            if (service_config.broker_addresses.empty()) {
+                throw std::runtime_error("broker_addresses must not be empty");
+            }
+        } else if (config["broker_address"]) {
+            service_config.broker_addresses.push_back(config["broker_address"].as<std::string>());
+        } else {
             throw std::runtime_error("Missing required field: broker_address");
         }
-        service_config.broker_address = config["broker_address"].as<std::string>();
+        service_config.broker_address = service_config.broker_addresses.front();
         
         if (!config["confidence_threshold"]) {
             throw std::runtime_error("Missing required field: confidence_threshold");
@@ -29,6 +40,62 @@ ServiceConfig ConfigManager::loadConfig(const std::string& config_path) {
             throw std::runtime_error("confidence_threshold must be between 0.0 and 1.0");
         }
         
+        // Non-maximum suppression
+        service_config.nms_method = config["nms_method"]
+            ? config["nms_method"].as<std::string>()
+            : "greedy";
+        parseNmsMethod(service_config.nms_method); // throws on unknown names
+        service_config.nms_iou_threshold = config["nms_iou_threshold"]
+            ? config["nms_iou_threshold"].as<float>()
+            : 0.5f;
+        if (service_config.nms_iou_threshold < 0.0f || service_config.nms_iou_threshold > 1.0f) {
+            throw std::runtime_error("nms_iou_threshold must be between 0.0 and 1.0");
+        }
+        service_config.nms_sigma = config["nms_sigma"]
+            ? config["nms_sigma"].as<float>()
+            : 0.5f;
+        if (!(service_config.nms_sigma > 0.0f)) {
+            throw std::runtime_error("nms_sigma must be greater than 0");
+        }
+        
+        // Inference engines (the registry checks names, types and routes)
+        if (config["engines"]) {
+            for (const auto& node : config["engines"]) {
+                EngineConfig engine;
+                if (!node["name"] || !node["type"]) {
+                    throw std::runtime_error("Every entry in engines needs a name and a type");
+                }
+                engine.name = node["name"].as<std::string>();
+                engine.type = node["type"].as<std::string>();
+                engine.model_path = node["model_path"] ? node["model_path"].as<std::string>() : "";
+                if (node["options"]) {
+                    for (const auto& option : node["options"]) {
+                        engine.options[option.first.as<std::string>()] = option.second.as<std::string>();
+                    }
+                }
+                service_config.engines.push_back(std::move(engine));
+            }
+        }
+        if (config["engine_routes"]) {
+            for (const auto& node : config["engine_routes"]) {
+                EngineRoute route;
+                if (!node["engine"]) {
+                    throw std::runtime_error("Every entry in engine_routes needs an engine");
+                }
+                route.engine = node["engine"].as<std::string>();
+                route.path_prefix = node["path_prefix"] ? node["path_prefix"].as<std::string>() : "";
+                route.category = node["category"] ? node["category"].as<std::string>() : "";
+                route.min_pixels = node["min_pixels"] ? node["min_pixels"].as<long long>() : 0;
+                service_config.engine_routes.push_back(std::move(route));
+            }
+        }
+        service_config.default_engine = config["default_engine"]
+            ? config["default_engine"].as<std::string>()
+            : "";
+        service_config.engine_warmup = config["engine_warmup"]
+            ? config["engine_warmup"].as<bool>()
+            : true;
+        
         // Optional fields with defaults
         service_config.system_uuid = config["system_uuid"] 
             ? config["system_uuid"].as<std::string>() 
@@ -42,10 +109,428 @@ ServiceConfig ConfigManager::loadConfig(const std::string& config_path) {
             ? config["service_version"].as<std::string>()
             : "1.0.0";
         
+        // Logging
+        service_config.log_level = config["log_level"]
+            ? config["log_level"].as<std::string>()
+            : "info";
+        parseLogLevel(service_config.log_level); // throws on unknown names
+        
+        // Worker pool
+        service_config.worker_threads = config["worker_threads"]
+            ? config["worker_threads"].as<int>()
+            : 0;
+        if (service_config.worker_threads <= 0) {
+            unsigned int cores = std::thread::hardware_concurrency();
+            service_config.worker_threads = cores > 0 ? static_cast<int>(cores) : 1;
+        }
+        
+        service_config.job_queue_capacity = config["job_queue_capacity"]
+            ? config["job_queue_capacity"].as<int>()
+            : 64;
+        if (service_config.job_queue_capacity <= 0) {
+            throw std::runtime_error("job_queue_capacity must be greater than 0");
+        }
+        
+        service_config.enqueue_timeout_ms = config["enqueue_timeout_ms"]
+            ? config["enqueue_timeout_ms"].as<int>()
+            : 1000;
+        if (service_config.enqueue_timeout_ms < 0) {
+            throw std::runtime_error("enqueue_timeout_ms must not be negative");
+        }
+        
+        // Request scheduling and load shedding
+        if (config["request_topics"]) {
+            for (const auto& node : config["request_topics"]) {
+                RequestTopic request_topic;
+                if (!node["topic"]) {
+                    throw std::runtime_error("Every entry in request_topics needs a topic");
+                }
+                request_topic.topic = node["topic"].as<std::string>();
+                request_topic.priority = node["priority"] ? node["priority"].as<int>() : 0;
+                request_topic.deadline_ms = node["deadline_ms"] ? node["deadline_ms"].as<int>() : 0;
+                if (request_topic.deadline_ms < 0) {
+                    throw std::runtime_error("deadline_ms of request topic " + request_topic.topic +
+                                             " must not be negative");
+                }
+                for (const auto& existing : service_config.request_topics) {
+                    if (existing.topic == request_topic.topic) {
+                        throw std::runtime_error("Request topic " + request_topic.topic + " is configured twice");
+                    }
+                }
+                service_config.request_topics.push_back(std::move(request_topic));
+            }
+        }
+        if (service_config.request_topics.empty()) {
+            RequestTopic file_location;
+            file_location.topic = "FileLocation_uci";
+            service_config.request_topics.push_back(file_location);
+        }
+        
+        service_config.queue_slo_ms = config["queue_slo_ms"]
+            ? config["queue_slo_ms"].as<int>()
+            : 0;
+        if (service_config.queue_slo_ms < 0) {
+            throw std::runtime_error("queue_slo_ms must not be negative");
+        }
+        
+        service_config.overload_action = config["overload_action"]
+            ? config["overload_action"].as<std::string>()
+            : "shed";
+        if (service_config.overload_action != "shed" && service_config.overload_action != "degrade") {
+            throw std::runtime_error("overload_action must be shed or degrade");
+        }
+        
+        service_config.degraded_engine = config["degraded_engine"]
+            ? config["degraded_engine"].as<std::string>()
+            : "";
+        
+        // Pipeline stages
+        service_config.parse_threads = config["parse_threads"]
+            ? config["parse_threads"].as<int>()
+            : 0;
+        service_config.serialize_threads = config["serialize_threads"]
+            ? config["serialize_threads"].as<int>()
+            : 1;
+        service_config.publish_threads = config["publish_threads"]
+            ? config["publish_threads"].as<int>()
+            : 1;
+        if (service_config.parse_threads < 0 || service_config.serialize_threads < 0 ||
+            service_config.publish_threads < 0) {
+            throw std::runtime_error("parse_threads, serialize_threads and publish_threads must not be negative");
+        }
+        
+        service_config.stage_queue_capacity = config["stage_queue_capacity"]
+            ? config["stage_queue_capacity"].as<int>()
+            : 64;
+        if (service_config.stage_queue_capacity <= 0) {
+            throw std::runtime_error("stage_queue_capacity must be greater than 0");
+        }
+        
+        service_config.ordered_output = config["ordered_output"]
+            ? config["ordered_output"].as<bool>()
+            : false;
+        if (service_config.ordered_output) {
+            // Scheduling out of arrival order would hold every later image
+            // behind whichever one the scheduler keeps putting off
+            for (const auto& request_topic : service_config.request_topics) {
+                if (request_topic.priority != service_config.request_topics.front().priority ||
+                    request_topic.deadline_ms > 0) {
+                    throw std::runtime_error("ordered_output cannot be combined with request topic priorities or "
+                                             "deadlines (request topic " + request_topic.topic + ")");
+                }
+            }
+        }
+        
+        // Dynamic batching
+        service_config.inference_batch_size = config["inference_batch_size"]
+            ? config["inference_batch_size"].as<int>()
+            : 1;
+        if (service_config.inference_batch_size <= 0) {
+            throw std::runtime_error("inference_batch_size must be greater than 0");
+        }
+        
+        service_config.inference_batch_wait_ms = config["inference_batch_wait_ms"]
+            ? config["inference_batch_wait_ms"].as<int>()
+            : 20;
+        if (service_config.inference_batch_wait_ms < 0) {
+            throw std::runtime_error("inference_batch_wait_ms must not be negative");
+        }
+        
+        // Result cache
+        service_config.result_cache_enabled = config["result_cache_enabled"]
+            ? config["result_cache_enabled"].as<bool>()
+            : false;
+        service_config.result_cache_entries = config["result_cache_entries"]
+            ? config["result_cache_entries"].as<int>()
+            : 256;
+        if (service_config.result_cache_entries < 1) {
+            throw std::runtime_error("result_cache_entries must be at least 1");
+        }
+        service_config.result_cache_ttl_s = config["result_cache_ttl_s"]
+            ? config["result_cache_ttl_s"].as<int>()
+            : 600;
+        if (service_config.result_cache_ttl_s < 0) {
+            throw std::runtime_error("result_cache_ttl_s must not be negative");
+        }
+        
+        // Read-ahead of queued images
+        service_config.prefetch_enabled = config["prefetch_enabled"]
+            ? config["prefetch_enabled"].as<bool>()
+            : false;
+        service_config.prefetch_image_mb = config["prefetch_image_mb"]
+            ? config["prefetch_image_mb"].as<int>()
+            : 32;
+        if (service_config.prefetch_image_mb < 1) {
+            throw std::runtime_error("prefetch_image_mb must be at least 1");
+        }
+        service_config.prefetch_budget_mb = config["prefetch_budget_mb"]
+            ? config["prefetch_budget_mb"].as<int>()
+            : 512;
+        if (service_config.prefetch_budget_mb < service_config.prefetch_image_mb) {
+            throw std::runtime_error("prefetch_budget_mb must be at least prefetch_image_mb");
+        }
+        service_config.prefetch_threads = config["prefetch_threads"]
+            ? config["prefetch_threads"].as<int>()
+            : 1;
+        if (service_config.prefetch_threads < 1) {
+            throw std::runtime_error("prefetch_threads must be at least 1");
+        }
+        
+        // Tiled inference
+        service_config.tiling_enabled = config["tiling_enabled"]
+            ? config["tiling_enabled"].as<bool>()
+            : false;
+        
+        service_config.tile_size = config["tile_size"]
+            ? config["tile_size"].as<int>()
+            : 1024;
+        if (service_config.tile_size < 64) {
+            throw std::runtime_error("tile_size must be at least 64 pixels");
+        }
+        
+        service_config.tile_overlap = config["tile_overlap"]
+            ? config["tile_overlap"].as<int>()
+            : 128;
+        if (service_config.tile_overlap < 0 || service_config.tile_overlap >= service_config.tile_size) {
+            throw std::runtime_error("tile_overlap must be between 0 and tile_size - 1");
+        }
+        service_config.degraded_tile_overlap = config["degraded_tile_overlap"]
+            ? config["degraded_tile_overlap"].as<int>()
+            : service_config.tile_overlap;
+        if (service_config.degraded_tile_overlap < 0 ||
+            service_config.degraded_tile_overlap >= service_config.tile_size) {
+            throw std::runtime_error("degraded_tile_overlap must be between 0 and tile_size - 1");
+        }
+        
+        service_config.tile_threads = config["tile_threads"]
+            ? config["tile_threads"].as<int>()
+            : 0;
+        
+        service_config.tile_merge_threshold = config["tile_merge_threshold"]
+            ? config["tile_merge_threshold"].as<float>()
+            : 0.5f;
+        if (service_config.tile_merge_threshold <= 0.0f || service_config.tile_merge_threshold > 1.0f) {
+            throw std::runtime_error("tile_merge_threshold must be in (0.0, 1.0]");
+        }
+        
+        // Chip extraction
+        service_config.chip_extraction_enabled = config["chip_extraction_enabled"]
+            ? config["chip_extraction_enabled"].as<bool>()
+            : false;
+        
+        service_config.chip_output_dir = config["chip_output_dir"]
+            ? config["chip_output_dir"].as<std::string>()
+            : "/tmp/sar_atr_chips";
+        
+        service_config.chip_format = config["chip_format"]
+            ? config["chip_format"].as<std::string>()
+            : "nitf";
+        if (service_config.chip_format != "nitf" && service_config.chip_format != "raw") {
+            throw std::runtime_error("chip_format must be 'nitf' or 'raw'");
+        }
+        
+        service_config.chip_padding = config["chip_padding"]
+            ? config["chip_padding"].as<double>()
+            : 0.4;
+        if (service_config.chip_padding < 0.0) {
+            throw std::runtime_error("chip_padding must be non-negative");
+        }
+        
+        service_config.chip_min_size = config["chip_min_size"]
+            ? config["chip_min_size"].as<int>()
+            : 64;
+        service_config.chip_max_size = config["chip_max_size"]
+            ? config["chip_max_size"].as<int>()
+            : 512;
+        if (service_config.chip_min_size < 1 || service_config.chip_max_size < service_config.chip_min_size) {
+            throw std::runtime_error("chip sizes must satisfy 1 <= chip_min_size <= chip_max_size");
+        }
+        
+        service_config.chip_threads = config["chip_threads"]
+            ? config["chip_threads"].as<int>()
+            : 0;
+        
+        service_config.chip_direct_io = config["chip_direct_io"]
+            ? config["chip_direct_io"].as<bool>()
+            : true;
+        
+        // Async file I/O (chip writes, prefetch reads)
+        service_config.io_uring_enabled = config["io_uring_enabled"]
+            ? config["io_uring_enabled"].as<bool>()
+            : true;
+        service_config.io_queue_depth = config["io_queue_depth"]
+            ? config["io_queue_depth"].as<int>()
+            : 64;
+        if (service_config.io_queue_depth < 1 || service_config.io_queue_depth > 4096) {
+            throw std::runtime_error("io_queue_depth must be between 1 and 4096");
+        }
+        service_config.io_buffer_count = config["io_buffer_count"]
+            ? config["io_buffer_count"].as<int>()
+            : 16;
+        if (service_config.io_buffer_count < 0) {
+            throw std::runtime_error("io_buffer_count must not be negative");
+        }
+        service_config.io_buffer_kb = config["io_buffer_kb"]
+            ? config["io_buffer_kb"].as<int>()
+            : 1024;
+        if (service_config.io_buffer_kb < 4) {
+            throw std::runtime_error("io_buffer_kb must be at least 4");
+        }
+        service_config.io_threads = config["io_threads"]
+            ? config["io_threads"].as<int>()
+            : 2;
+        if (service_config.io_threads < 1) {
+            throw std::runtime_error("io_threads must be at least 1");
+        }
+        
+        // Broker connection
+        service_config.connect_timeout_ms = config["connect_timeout_ms"]
+            ? config["connect_timeout_ms"].as<int>()
+            : 10000;
+        if (service_config.connect_timeout_ms <= 0) {
+            throw std::runtime_error("connect_timeout_ms must be greater than 0");
+        }
+        
+        service_config.heartbeat_interval_ms = config["heartbeat_interval_ms"]
+            ? config["heartbeat_interval_ms"].as<int>()
+            : 10000;
+        if (service_config.heartbeat_interval_ms < 0) {
+            throw std::runtime_error("heartbeat_interval_ms must not be negative");
+        }
+        
+        service_config.reconnect_enabled = config["reconnect_enabled"]
+            ? config["reconnect_enabled"].as<bool>()
+            : true;
+        service_config.reconnect_initial_ms = config["reconnect_initial_ms"]
+            ? config["reconnect_initial_ms"].as<int>()
+            : 250;
+        service_config.reconnect_max_ms = config["reconnect_max_ms"]
+            ? config["reconnect_max_ms"].as<int>()
+            : 30000;
+        if (service_config.reconnect_initial_ms <= 0 ||
+            service_config.reconnect_max_ms < service_config.reconnect_initial_ms) {
+            throw std::runtime_error("reconnect_initial_ms must be greater than 0 and at most reconnect_max_ms");
+        }
+        
+        // Publishing
+        service_config.publish_connections = config["publish_connections"]
+            ? config["publish_connections"].as<int>()
+            : 1;
+        if (service_config.publish_connections < 1) {
+            throw std::runtime_error("publish_connections must be at least 1");
+        }
+        if (service_config.ordered_output && service_config.publish_connections > 1) {
+            // Images sharded (or failed over) across connections reach the broker in any order
+            throw std::runtime_error("ordered_output needs publish_connections: 1");
+        }
+        
+        service_config.publish_shard_by = config["publish_shard_by"]
+            ? config["publish_shard_by"].as<std::string>()
+            : "image";
+        parseShardPolicy(service_config.publish_shard_by);
+        
+        service_config.publish_linger_us = config["publish_linger_us"]
+            ? config["publish_linger_us"].as<int>()
+            : 0;
+        if (service_config.publish_linger_us < 0) {
+            throw std::runtime_error("publish_linger_us must not be negative");
+        }
+        
+        service_config.send_high_water_bytes = config["send_high_water_bytes"]
+            ? config["send_high_water_bytes"].as<int>()
+            : 8 * 1024 * 1024;
+        if (service_config.send_high_water_bytes <= 0) {
+            throw std::runtime_error("send_high_water_bytes must be greater than 0");
+        }
+        
+        service_config.send_block_timeout_ms = config["send_block_timeout_ms"]
+            ? config["send_block_timeout_ms"].as<int>()
+            : 5000;
+        
+        service_config.send_flush_timeout_ms = config["send_flush_timeout_ms"]
+            ? config["send_flush_timeout_ms"].as<int>()
+            : 5000;
+        
+        if (service_config.send_block_timeout_ms < 0 || service_config.send_flush_timeout_ms < 0) {
+            throw std::runtime_error("send timeouts must not be negative");
+        }
+        
+        service_config.publish_receipts = config["publish_receipts"]
+            ? config["publish_receipts"].as<bool>()
+            : true;
+        
+        // Metrics
+        service_config.metrics_enabled = config["metrics_enabled"]
+            ? config["metrics_enabled"].as<bool>()
+            : false;
+        
+        service_config.metrics_bind_address = config["metrics_bind_address"]
+            ? config["metrics_bind_address"].as<std::string>()
+            : "0.0.0.0";
+        
+        service_config.metrics_port = config["metrics_port"]
+            ? config["metrics_port"].as<int>()
+            : 9464;
+        if (service_config.metrics_port <= 0 || service_config.metrics_port > 65535) {
+            throw std::runtime_error("metrics_port must be between 1 and 65535");
+        }
+        
         Logger::info("Configuration loaded successfully");
-        Logger::info("  Broker: " + service_config.broker_address);
+        for (const auto& address : service_config.broker_addresses) {
+            Logger::info("  Broker: " + address);
+        }
+        Logger::info("  Publish Connections: " + std::to_string(service_config.publish_connections) +
+                     " (sharded by " + service_config.publish_shard_by + ")");
+        Logger::info("  Reconnect: " +
+                     (service_config.reconnect_enabled
+                          ? std::to_string(service_config.reconnect_initial_ms) + "-" +
+                                std::to_string(service_config.reconnect_max_ms) + " ms backoff"
+                          : std::string("off")) +
+                     (service_config.publish_receipts ? ", publish receipts" : ""));
         Logger::info("  Confidence Threshold: " + std::to_string(service_config.confidence_threshold));
+        Logger::info("  NMS: " + service_config.nms_method +
+                     " (IoU " + std::to_string(service_config.nms_iou_threshold) +
+                     (service_config.nms_method == "soft_gaussian"
+                          ? ", sigma " + std::to_string(service_config.nms_sigma) : std::string()) + ")");
+        for (const auto& engine : service_config.engines) {
+            Logger::info("  Engine: " + engine.name + " (" + engine.type +
+                         (engine.model_path.empty() ? "" : ", " + engine.model_path) + ")" +
+                         (engine.name == service_config.default_engine ? ", default" : ""));
+        }
+        if (!service_config.engine_routes.empty()) {
+            Logger::info("  Engine Routes: " + std::to_string(service_config.engine_routes.size()));
+        }
         Logger::info("  System UUID: " + service_config.system_uuid);
+        Logger::info("  Log Level: " + service_config.log_level);
+        Logger::info("  Worker Threads: " + std::to_string(service_config.worker_threads));
+        Logger::info("  Job Queue Capacity: " + std::to_string(service_config.job_queue_capacity));
+        for (const auto& request_topic : service_config.request_topics) {
+            Logger::info("  Request Topic: " + request_topic.topic + " (priority " +
+                         std::to_string(request_topic.priority) +
+                         (request_topic.deadline_ms > 0
+                              ? ", deadline " + std::to_string(request_topic.deadline_ms) + " ms"
+                              : std::string()) + ")");
+        }
+        if (service_config.queue_slo_ms > 0) {
+            Logger::info("  Queue SLO: " + std::to_string(service_config.queue_slo_ms) + " ms, then " +
+                         service_config.overload_action +
+                         (service_config.overload_action == "degrade" && !service_config.degraded_engine.empty()
+                              ? " to engine " + service_config.degraded_engine : std::string()));
+        }
+        Logger::info("  Stage Threads (parse/serialize/publish): " + std::to_string(service_config.parse_threads) +
+                     "/" + std::to_string(service_config.serialize_threads) + "/" +
+                     std::to_string(service_config.publish_threads) +
+                     (service_config.ordered_output ? ", ordered output" : ""));
+        Logger::info("  Inference Batch Size: " + std::to_string(service_config.inference_batch_size));
+        if (service_config.result_cache_enabled) {
+            Logger::info("  Result Cache: " + std::to_string(service_config.result_cache_entries) + " image(s), TTL " +
+                         std::to_string(service_config.result_cache_ttl_s) + " s");
+        }
+        if (service_config.prefetch_enabled) {
+            Logger::info("  Prefetch: " + std::to_string(service_config.prefetch_image_mb) + " MiB per image, " +
+                         std::to_string(service_config.prefetch_budget_mb) + " MiB budget, " +
+                         std::to_string(service_config.prefetch_threads) + " thread(s)");
+        }
         
         return service_config;
         
@@ -0,0 +1,214 @@
+#include "detection_batch.h"
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sar_atr {
+
+void DetectionBatch::swap(DetectionBatch& other) {
+    confidence_.swap(other.confidence_);
+    x1_.swap(other.x1_);
+    y1_.swap(other.y1_);
+    x2_.swap(other.x2_);
+    y2_.swap(other.y2_);
+    class_ids_.swap(other.class_ids_);
+}
+
+void DetectionBatch::assign(const DetectionBatch& other) {
+    confidence_.assign(other.confidence_.begin(), other.confidence_.end());
+    x1_.assign(other.x1_.begin(), other.x1_.end());
+    y1_.assign(other.y1_.begin(), other.y1_.end());
+    x2_.assign(other.x2_.begin(), other.x2_.end());
+    y2_.assign(other.y2_.begin(), other.y2_.end());
+    class_ids_.assign(other.class_ids_.begin(), other.class_ids_.end());
+}
+
+void DetectionBatch::reserve(size_t count) {
+    confidence_.reserve(count);
+    x1_.reserve(count);
+    y1_.reserve(count);
+    x2_.reserve(count);
+    y2_.reserve(count);
+    class_ids_.reserve(count);
+}
+
+void DetectionBatch::clear() {
+    confidence_.clear();
+    x1_.clear();
+    y1_.clear();
+    x2_.clear();
+    y2_.clear();
+    class_ids_.clear();
+}
+
+void DetectionBatch::resize(size_t count) {
+    confidence_.resize(count);
+    x1_.resize(count);
+    y1_.resize(count);
+    x2_.resize(count);
+    y2_.resize(count);
+    class_ids_.resize(count);
+}
+
+void DetectionBatch::append(const DetectionList& detections) {
+    reserve(size() + detections.size());
+    for (const auto& detection : detections) {
+        push_back(detection.class_id, detection.confidence, detection.bounding_box);
+    }
+}
+
+void DetectionBatch::appendTo(const uint32_t* selected, size_t count, DetectionList& out) const {
+    // Grow once (results are constructed with the list's allocator), then gather
+    size_t base = out.size();
+    out.resize(base + count);
+    DetectionResult* results = out.data() + base;
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t i = selected[k];
+        results[k].class_id = class_ids_[i];
+        results[k].confidence = confidence_[i];
+        results[k].bounding_box = BoundingBox{x1_[i], y1_[i], x2_[i], y2_[i]};
+    }
+}
+
+size_t DetectionBatch::selectAbove(float threshold, uint32_t* selected) const {
+    const float* confidence = confidence_.data();
+    const size_t count = confidence_.size();
+    size_t written = 0;
+    size_t i = 0;
+
+    // Compare a register of confidences, then write every lane's index and
+    // advance past the ones that passed. Rejected lanes are overwritten by the
+    // next store (written never passes the lane index, so this stays inside
+    // selected), and nothing branches on the unpredictable outcome
+#if defined(__AVX2__)
+    const __m256 limit256 = _mm256_set1_ps(threshold);
+    for (; i + 8 <= count; i += 8) {
+        __m256 values = _mm256_loadu_ps(confidence + i);
+        unsigned int bits = static_cast<unsigned int>(
+            _mm256_movemask_ps(_mm256_cmp_ps(values, limit256, _CMP_GE_OQ)));
+        for (unsigned int lane = 0; lane < 8; ++lane) {
+            selected[written] = static_cast<uint32_t>(i + lane);
+            written += (bits >> lane) & 1;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 limit128 = _mm_set1_ps(threshold);
+    for (; i + 4 <= count; i += 4) {
+        __m128 values = _mm_loadu_ps(confidence + i);
+        unsigned int bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmpge_ps(values, limit128)));
+        for (unsigned int lane = 0; lane < 4; ++lane) {
+            selected[written] = static_cast<uint32_t>(i + lane);
+            written += (bits >> lane) & 1;
+        }
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t limit128 = vdupq_n_f32(threshold);
+    const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    const uint32x4_t lane_bits128 = vld1q_u32(lane_bits);
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t set = vandq_u32(vcgeq_f32(vld1q_f32(confidence + i), limit128), lane_bits128);
+        unsigned int bits = vgetq_lane_u32(set, 0) | vgetq_lane_u32(set, 1) |
+                            vgetq_lane_u32(set, 2) | vgetq_lane_u32(set, 3);
+        for (unsigned int lane = 0; lane < 4; ++lane) {
+            selected[written] = static_cast<uint32_t>(i + lane);
+            written += (bits >> lane) & 1;
+        }
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (confidence[i] >= threshold) {
+            selected[written++] = static_cast<uint32_t>(i);
+        }
+    }
+    return written;
+}
+
+void DetectionBatch::boxAreas(float* areas) const {
+    computeBoxAreas(x1_.data(), y1_.data(), x2_.data(), y2_.data(), size(), areas);
+}
+
+void computeBoxAreas(const float* x1, const float* y1, const float* x2, const float* y2, size_t count,
+                     float* areas) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 width = _mm256_sub_ps(_mm256_loadu_ps(x2 + i), _mm256_loadu_ps(x1 + i));
+        __m256 height = _mm256_sub_ps(_mm256_loadu_ps(y2 + i), _mm256_loadu_ps(y1 + i));
+        _mm256_storeu_ps(areas + i, _mm256_mul_ps(width, height));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128 width = _mm_sub_ps(_mm_loadu_ps(x2 + i), _mm_loadu_ps(x1 + i));
+        __m128 height = _mm_sub_ps(_mm_loadu_ps(y2 + i), _mm_loadu_ps(y1 + i));
+        _mm_storeu_ps(areas + i, _mm_mul_ps(width, height));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t width = vsubq_f32(vld1q_f32(x2 + i), vld1q_f32(x1 + i));
+        float32x4_t height = vsubq_f32(vld1q_f32(y2 + i), vld1q_f32(y1 + i));
+        vst1q_f32(areas + i, vmulq_f32(width, height));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        areas[i] = (x2[i] - x1[i]) * (y2[i] - y1[i]);
+    }
+}
+
+namespace {
+
+// column[i] = min(1, column[i] * scale + offset)
+void scaleColumn(float* column, size_t count, float scale, float offset) {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 scale256 = _mm256_set1_ps(scale);
+    const __m256 offset256 = _mm256_set1_ps(offset);
+    const __m256 one256 = _mm256_set1_ps(1.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 values = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(column + i), scale256), offset256);
+        _mm256_storeu_ps(column + i, _mm256_min_ps(values, one256));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 scale128 = _mm_set1_ps(scale);
+    const __m128 offset128 = _mm_set1_ps(offset);
+    const __m128 one128 = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 values = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(column + i), scale128), offset128);
+        _mm_storeu_ps(column + i, _mm_min_ps(values, one128));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t scale128 = vdupq_n_f32(scale);
+    const float32x4_t offset128 = vdupq_n_f32(offset);
+    const float32x4_t one128 = vdupq_n_f32(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t values = vaddq_f32(vmulq_f32(vld1q_f32(column + i), scale128), offset128);
+        vst1q_f32(column + i, vminq_f32(values, one128));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        column[i] = std::min(1.0f, column[i] * scale + offset);
+    }
+}
+
+} // namespace
+
+void DetectionBatch::mapBoxes(float scale_x, float offset_x, float scale_y, float offset_y) {
+    const size_t count = size();
+    scaleColumn(x1_.data(), count, scale_x, offset_x);
+    scaleColumn(x2_.data(), count, scale_x, offset_x);
+    scaleColumn(y1_.data(), count, scale_y, offset_y);
+    scaleColumn(y2_.data(), count, scale_y, offset_y);
+}
+
+} // namespace sar_atr
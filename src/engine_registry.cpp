@@ -0,0 +1,257 @@
+#include "engine_registry.h"
+#include "logger.h"
+#include "mock_inference_engine.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+namespace sar_atr {
+
+namespace {
+
+double numberOption(const EngineConfig& config, const std::string& key, double fallback) {
+    auto found = config.options.find(key);
+    if (found == config.options.end()) {
+        return fallback;
+    }
+    try {
+        size_t used = 0;
+        double value = std::stod(found->second, &used);
+        if (used == found->second.size()) {
+            return value;
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::runtime_error("Engine '" + config.name + "': option " + key + " is not a number: " + found->second);
+}
+
+std::shared_ptr<InferenceEngine> buildMockEngine(const EngineConfig& config) {
+    MockInferenceEngine::LatencyModel latency;
+    latency.min_overhead_ms = numberOption(config, "min_overhead_ms", latency.min_overhead_ms);
+    latency.max_overhead_ms = numberOption(config, "max_overhead_ms", latency.max_overhead_ms);
+    latency.per_image_ms = numberOption(config, "per_image_ms", latency.per_image_ms);
+    auto distribution = config.options.find("distribution");
+    if (distribution != config.options.end()) {
+        if (distribution->second == "uniform") {
+            latency.distribution = MockInferenceEngine::LatencyModel::Distribution::UNIFORM;
+        } else if (distribution->second == "normal") {
+            latency.distribution = MockInferenceEngine::LatencyModel::Distribution::NORMAL;
+        } else if (distribution->second == "exponential") {
+            latency.distribution = MockInferenceEngine::LatencyModel::Distribution::EXPONENTIAL;
+        } else {
+            throw std::runtime_error("Engine '" + config.name + "': distribution must be uniform, normal or "
+                                     "exponential");
+        }
+    }
+
+    MockInferenceEngine::DetectionModel detections;
+    detections.min_detections = static_cast<int>(numberOption(config, "min_detections", detections.min_detections));
+    detections.max_detections = static_cast<int>(numberOption(config, "max_detections", detections.max_detections));
+    return std::make_shared<MockInferenceEngine>(latency, detections);
+}
+
+std::mutex& factoryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, EngineRegistry::Factory>& factories() {
+    static std::map<std::string, EngineRegistry::Factory> registered{{"mock", buildMockEngine}};
+    return registered;
+}
+
+EngineRegistry::Factory findFactory(const std::string& type) {
+    std::lock_guard<std::mutex> lock(factoryMutex());
+    auto found = factories().find(type);
+    return found != factories().end() ? found->second : EngineRegistry::Factory();
+}
+
+} // namespace
+
+void EngineRegistry::registerFactory(const std::string& type, Factory factory) {
+    std::lock_guard<std::mutex> lock(factoryMutex());
+    factories()[type] = std::move(factory);
+}
+
+std::shared_ptr<const EngineRegistry::Snapshot> EngineRegistry::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void EngineRegistry::publish(std::shared_ptr<const Snapshot> next) {
+    // Jobs holding engines of the old snapshot keep them alive until they finish
+    std::atomic_store(&snapshot_, std::move(next));
+}
+
+void EngineRegistry::adopt(const std::string& name, std::shared_ptr<InferenceEngine> engine) {
+    if (!engine) {
+        throw std::invalid_argument("EngineRegistry::adopt() needs an engine");
+    }
+    auto entry = std::make_shared<Engine>();
+    entry->config.name = name;
+    entry->config.type = "external";
+    entry->engine = std::move(engine);
+
+    auto next = std::make_shared<Snapshot>();
+    next->engines.push_back(entry);
+    next->fallback = entry;
+
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    publish(std::move(next));
+}
+
+size_t EngineRegistry::load(const ServiceConfig& config) {
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    std::shared_ptr<const Snapshot> current = snapshot();
+
+    std::vector<EngineConfig> configs = config.engines;
+    if (configs.empty()) {
+        EngineConfig mock;
+        mock.name = "default";
+        mock.type = "mock";
+        configs.push_back(mock);
+    }
+
+    auto next = std::make_shared<Snapshot>();
+    size_t built = 0;
+    for (const auto& engine_config : configs) {
+        for (const auto& existing : next->engines) {
+            if (existing->config.name == engine_config.name) {
+                throw std::runtime_error("Engine '" + engine_config.name + "' is configured twice");
+            }
+        }
+
+        // An engine whose configuration did not change keeps running as it is
+        std::shared_ptr<const Engine> kept;
+        if (current) {
+            for (const auto& existing : current->engines) {
+                if (existing->config == engine_config) {
+                    kept = existing;
+                    break;
+                }
+            }
+        }
+        if (kept) {
+            next->engines.push_back(kept);
+            continue;
+        }
+
+        Factory factory = findFactory(engine_config.type);
+        if (!factory) {
+            throw std::runtime_error("Engine '" + engine_config.name + "': unknown type '" + engine_config.type +
+                                     "'");
+        }
+        auto entry = std::make_shared<Engine>();
+        entry->config = engine_config;
+        entry->engine = factory(engine_config);
+        if (!entry->engine) {
+            throw std::runtime_error("Engine '" + engine_config.name + "': factory returned no engine");
+        }
+        if (config.engine_warmup) {
+            auto start = std::chrono::steady_clock::now();
+            entry->engine->warmUp();
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                  start);
+            Logger::info("Engine '" + engine_config.name + "' (" + engine_config.type + ") warmed up in " +
+                         std::to_string(elapsed.count()) + " ms");
+        } else {
+            Logger::info("Engine '" + engine_config.name + "' (" + engine_config.type + ") loaded");
+        }
+        next->engines.push_back(entry);
+        built++;
+    }
+
+    auto byName = [&next](const std::string& name) -> std::shared_ptr<const Engine> {
+        for (const auto& entry : next->engines) {
+            if (entry->config.name == name) {
+                return entry;
+            }
+        }
+        return nullptr;
+    };
+
+    next->fallback = config.default_engine.empty() ? next->engines.front() : byName(config.default_engine);
+    if (!next->fallback) {
+        throw std::runtime_error("default_engine '" + config.default_engine + "' is not configured");
+    }
+    if (!config.degraded_engine.empty() && !byName(config.degraded_engine)) {
+        throw std::runtime_error("degraded_engine '" + config.degraded_engine + "' is not configured");
+    }
+    for (const auto& route : config.engine_routes) {
+        auto target = byName(route.engine);
+        if (!target) {
+            throw std::runtime_error("Engine route names unknown engine '" + route.engine + "'");
+        }
+        next->routes.push_back({route, target});
+        next->reads_headers = next->reads_headers || !route.category.empty() || route.min_pixels > 0;
+    }
+
+    publish(std::move(next));
+    return built;
+}
+
+std::shared_ptr<const EngineRegistry::Engine> EngineRegistry::route(const std::string& nitf_path,
+                                                                    ImageDescription& geometry) const {
+    std::shared_ptr<const Snapshot> current = snapshot();
+    if (!current) {
+        throw std::runtime_error("No inference engine loaded");
+    }
+    if (current->routes.empty()) {
+        return current->fallback;
+    }
+
+    // Header fields are read only if some route looks at them
+    const ImageGeometry* header = nullptr;
+    if (current->reads_headers) {
+        const ImageGeometry& described = geometry.get(nitf_path);
+        if (described.fromHeader()) {
+            header = &described;
+        }
+    }
+
+    for (const auto& route : current->routes) {
+        const EngineRoute& match = route.match;
+        if (!match.path_prefix.empty() && nitf_path.compare(0, match.path_prefix.size(), match.path_prefix) != 0) {
+            continue;
+        }
+        if (!match.category.empty() && (!header || header->category != match.category)) {
+            continue;
+        }
+        if (match.min_pixels > 0 &&
+            (!header || static_cast<long long>(header->rows) * header->cols < match.min_pixels)) {
+            continue;
+        }
+        return route.engine;
+    }
+    return current->fallback;
+}
+
+std::shared_ptr<const EngineRegistry::Engine> EngineRegistry::defaultEngine() const {
+    std::shared_ptr<const Snapshot> current = snapshot();
+    if (!current) {
+        throw std::runtime_error("No inference engine loaded");
+    }
+    return current->fallback;
+}
+
+std::shared_ptr<const EngineRegistry::Engine> EngineRegistry::find(const std::string& name) const {
+    if (std::shared_ptr<const Snapshot> current = snapshot()) {
+        for (const auto& entry : current->engines) {
+            if (entry->config.name == name) {
+                return entry;
+            }
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string> EngineRegistry::names() const {
+    std::vector<std::string> result;
+    if (std::shared_ptr<const Snapshot> current = snapshot()) {
+        for (const auto& entry : current->engines) {
+            result.push_back(entry->config.name);
+        }
+    }
+    return result;
+}
+
+} // namespace sar_atr
@@ -0,0 +1,266 @@
+#include "event_loop.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace sar_atr {
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+constexpr uint64_t kWakeToken = 0;
+
+thread_local const EventLoop* current_loop = nullptr;
+
+} // namespace
+
+EventLoop::EventLoop()
+    : epoll_fd_(-1), wake_fd_(-1), running_(false), wake_pending_(false), next_token_(kWakeToken + 1),
+      next_timer_id_(1) {
+}
+
+EventLoop::~EventLoop() {
+    stop();
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+void EventLoop::start() {
+    if (running_) {
+        return;
+    }
+
+    if (epoll_fd_ < 0) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            throw std::runtime_error("Failed to create epoll instance: " + std::string(std::strerror(errno)));
+        }
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd_ < 0) {
+            throw std::runtime_error("Failed to create eventfd: " + std::string(std::strerror(errno)));
+        }
+        struct epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = kWakeToken;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) < 0) {
+            throw std::runtime_error("Failed to watch eventfd: " + std::string(std::strerror(errno)));
+        }
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() {
+        loop();
+    });
+}
+
+void EventLoop::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        wake_pending_ = true;
+    }
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd_, &one, sizeof(one));
+    (void)written;
+
+    // From a handler, the loop exits once the handler returns; the destructor joins
+    if (!inLoopThread() && thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool EventLoop::inLoopThread() const {
+    return current_loop == this;
+}
+
+void EventLoop::add(int fd, uint32_t events, IoHandler handler) {
+    uint64_t token = next_token_++;
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = token;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        throw std::runtime_error("Failed to watch descriptor: " + std::string(std::strerror(errno)));
+    }
+    watches_[token] = Watch{fd, std::move(handler)};
+    fd_tokens_[fd] = token;
+}
+
+void EventLoop::modify(int fd, uint32_t events) {
+    auto it = fd_tokens_.find(fd);
+    if (it == fd_tokens_.end()) {
+        return;
+    }
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = it->second;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) < 0) {
+        Logger::warning("Failed to update epoll interest: " + std::string(std::strerror(errno)));
+    }
+}
+
+void EventLoop::remove(int fd) {
+    auto it = fd_tokens_.find(fd);
+    if (it == fd_tokens_.end()) {
+        return;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    watches_.erase(it->second);
+    fd_tokens_.erase(it);
+}
+
+void EventLoop::post(Task task) {
+    bool need_wake;
+    {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        tasks_.push_back(std::move(task));
+        need_wake = !wake_pending_;
+        wake_pending_ = true;
+    }
+    if (need_wake) {
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd_, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void EventLoop::runSync(const Task& task) {
+    if (inLoopThread() || !running_) {
+        task();
+        return;
+    }
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    post([&task, &done]() {
+        try {
+            task();
+            done.set_value();
+        } catch (...) {
+            done.set_exception(std::current_exception());
+        }
+    });
+    finished.get();
+}
+
+EventLoop::TimerId EventLoop::runAfter(std::chrono::steady_clock::duration delay, Task task) {
+    TimerId id = next_timer_id_++;
+    timers_[id] = std::move(task);
+    timer_heap_.push(Timer{std::chrono::steady_clock::now() + delay, id});
+    return id;
+}
+
+void EventLoop::cancel(TimerId id) {
+    // The heap entry stays until its deadline and is skipped then
+    timers_.erase(id);
+}
+
+void EventLoop::loop() {
+    current_loop = this;
+    struct epoll_event events[kMaxEvents];
+
+    while (running_) {
+        int ready = epoll_wait(epoll_fd_, events, kMaxEvents, nextTimeoutMs());
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::error("epoll_wait failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            uint64_t token = events[i].data.u64;
+            if (token == kWakeToken) {
+                uint64_t count;
+                ssize_t drained = read(wake_fd_, &count, sizeof(count));
+                (void)drained;
+                continue;
+            }
+            // An earlier handler in this batch may have removed the watch
+            auto it = watches_.find(token);
+            if (it == watches_.end()) {
+                continue;
+            }
+            // The handler may remove its own watch, so call a copy
+            IoHandler handler = it->second.handler;
+            handler(events[i].events);
+        }
+
+        runTimers();
+        runTasks();
+    }
+
+    runTasks();
+    current_loop = nullptr;
+}
+
+void EventLoop::runTasks() {
+    // Swapping with a member keeps both vectors' capacity, so posting
+    // allocates nothing once the loop has warmed up
+    {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        running_tasks_.swap(tasks_);
+        wake_pending_ = false;
+    }
+    for (auto& task : running_tasks_) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            Logger::error("Event loop task failed: " + std::string(e.what()));
+        }
+    }
+    running_tasks_.clear();
+}
+
+void EventLoop::runTimers() {
+    auto now = std::chrono::steady_clock::now();
+    while (!timer_heap_.empty() && timer_heap_.top().deadline <= now) {
+        TimerId id = timer_heap_.top().id;
+        timer_heap_.pop();
+        auto it = timers_.find(id);
+        if (it == timers_.end()) {
+            continue;
+        }
+        Task task = std::move(it->second);
+        timers_.erase(it);
+        try {
+            task();
+        } catch (const std::exception& e) {
+            Logger::error("Event loop timer failed: " + std::string(e.what()));
+        }
+    }
+}
+
+int EventLoop::nextTimeoutMs() {
+    // Cancelled timers at the top would only cause early wakeups; drop them here
+    while (!timer_heap_.empty() && timers_.find(timer_heap_.top().id) == timers_.end()) {
+        timer_heap_.pop();
+    }
+    if (timer_heap_.empty()) {
+        return -1;
+    }
+    auto remaining = timer_heap_.top().deadline - std::chrono::steady_clock::now();
+    if (remaining <= std::chrono::steady_clock::duration::zero()) {
+        return 0;
+    }
+    // Round up so a timer is never run a fraction of a millisecond early
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+    return static_cast<int>(std::min<long long>(ms, 60 * 1000));
+}
+
+} // namespace sar_atr
@@ -0,0 +1,75 @@
+#include "image_arena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace sar_atr {
+
+ImageArena::ImageArena(size_t initial_bytes, size_t retain_limit)
+    : initial_bytes_(std::max<size_t>(initial_bytes, 256)),
+      retain_limit_(std::max(retain_limit, initial_bytes_)),
+      current_(0), offset_(0), used_(0) {
+    addBlock(initial_bytes_);
+}
+
+size_t ImageArena::capacity() const {
+    size_t total = 0;
+    for (const auto& block : blocks_) {
+        total += block.size;
+    }
+    return total;
+}
+
+void ImageArena::reset() {
+    if (blocks_.size() > 1 || blocks_.front().size > retain_limit_) {
+        // Next time, fit the whole image in one block (within the retain limit)
+        size_t wanted = initial_bytes_;
+        while (wanted < used_ && wanted * 2 <= retain_limit_) {
+            wanted *= 2;
+        }
+        blocks_.clear();
+        addBlock(wanted);
+    }
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+void ImageArena::addBlock(size_t min_bytes) {
+    Block block;
+    block.size = min_bytes;
+    block.data.reset(new std::byte[min_bytes]);
+    blocks_.push_back(std::move(block));
+}
+
+void* ImageArena::do_allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        Block& block = blocks_[current_];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t aligned = (base + offset_ + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        size_t end = static_cast<size_t>(aligned - base) + bytes;
+        if (end <= block.size) {
+            used_ += end - offset_;
+            offset_ = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+        if (current_ + 1 == blocks_.size()) {
+            // Geometric growth, and always room for this request
+            addBlock(std::max(block.size * 2, bytes + alignment));
+        }
+        ++current_;
+        offset_ = 0;
+    }
+}
+
+void ImageArena::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    // Monotonic: memory comes back all at once in reset()
+    (void)p;
+    (void)bytes;
+    (void)alignment;
+}
+
+bool ImageArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+} // namespace sar_atr
@@ -0,0 +1,70 @@
+#include "image_geometry.h"
+#include "logger.h"
+#include "nitf_reader.h"
+#include <algorithm>
+#include <cctype>
+#include <exception>
+
+namespace sar_atr {
+
+ImageGeometry describeImage(const std::string& nitf_path) {
+    ImageGeometry geometry;
+    
+    // Header fields are the authority; only the header pages are touched
+    try {
+        NitfReader reader(nitf_path);
+        if (reader.imageCount() > 0) {
+            const NitfImageInfo& image = reader.image(0);
+            geometry.cols = image.cols;
+            geometry.rows = image.rows;
+            geometry.bytes_per_pixel = image.bytesPerPixel() * image.bands;
+            geometry.file_bytes = static_cast<long long>(reader.fileSize());
+            geometry.category = image.category;
+            geometry.source = ImageGeometry::Source::NITF_HEADER;
+            return geometry;
+        }
+    } catch (const std::exception& e) {
+        SAR_LOG_DEBUG("NITF header unavailable, using filename: " + std::string(e.what()));
+    }
+    
+    // Fallback heuristic: try to extract dimensions from filename patterns
+    size_t last_slash = nitf_path.find_last_of("/\\");
+    std::string filename = (last_slash != std::string::npos) ? nitf_path.substr(last_slash + 1) : nitf_path;
+    
+    // Look for dimension patterns in filename like "2048x2048" or "_4096_4096"
+    std::string fname_lower = filename;
+    std::transform(fname_lower.begin(), fname_lower.end(), fname_lower.begin(), ::tolower);
+    
+    // Try pattern: NNNNxNNNN
+    size_t x_pos = fname_lower.find('x');
+    if (x_pos != std::string::npos && x_pos > 0) {
+        // Look backwards for digits
+        size_t start = x_pos;
+        while (start > 0 && std::isdigit(fname_lower[start - 1])) {
+            start--;
+        }
+        // Look forwards for digits
+        size_t end = x_pos + 1;
+        while (end < fname_lower.length() && std::isdigit(fname_lower[end])) {
+            end++;
+        }
+        
+        if (start < x_pos && end > x_pos + 1) {
+            try {
+                int w = std::stoi(fname_lower.substr(start, x_pos - start));
+                int h = std::stoi(fname_lower.substr(x_pos + 1, end - x_pos - 1));
+                if (w > 0 && h > 0 && w < 100000 && h < 100000) {
+                    geometry.cols = w;
+                    geometry.rows = h;
+                    geometry.source = ImageGeometry::Source::FILENAME;
+                }
+            } catch (...) {
+                // Parsing failed, use defaults
+            }
+        }
+    }
+    
+    return geometry;
+}
+
+} // namespace sar_atr
@@ -0,0 +1,355 @@
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace sar_atr {
+
+std::atomic<int> Logger::min_level_{static_cast<int>(LogLevel::INFO)};
+
+namespace {
+
+constexpr size_t kRingCapacity = 4096; // entries per thread, power of two
+constexpr auto kFlushInterval = std::chrono::milliseconds(5);
+
+struct LogEntry {
+    std::chrono::system_clock::time_point time;
+    LogLevel level = LogLevel::INFO;
+    std::string message;
+};
+
+/**
+ * Single-producer/single-consumer ring: the owning thread pushes, the
+ * writer thread pops. Entries own their message, so nothing is copied twice.
+ */
+class LogRing {
+public:
+    LogRing() : slots_(kRingCapacity), head_(0), tail_(0), retired_(false) {}
+
+    bool push(LogEntry& entry) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == kRingCapacity) {
+            return false;
+        }
+        slots_[head & (kRingCapacity - 1)] = std::move(entry);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drain(std::vector<LogEntry>& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        while (tail != head) {
+            out.push_back(std::move(slots_[tail & (kRingCapacity - 1)]));
+            ++tail;
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    void retire() { retired_.store(true, std::memory_order_release); }
+    bool retired() const { return retired_.load(std::memory_order_acquire); }
+
+private:
+    std::vector<LogEntry> slots_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    std::atomic<bool> retired_;
+};
+
+const char* levelTag(LogLevel level) {
+    switch (level) {
+        case LogLevel::INFO:
+            return "[INFO]    ";
+        case LogLevel::WARNING:
+            return "[WARNING] ";
+        case LogLevel::ERROR:
+            return "[ERROR]   ";
+        case LogLevel::DEBUG:
+            return "[DEBUG]   ";
+    }
+    return "";
+}
+
+/**
+ * Formats "[YYYY-MM-DD HH:MM:SS.mmm] [LEVEL]   message\n", caching the
+ * local-time prefix for the current second
+ */
+class LineFormatter {
+public:
+    void append(std::string& out, const LogEntry& entry) {
+        auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+            entry.time.time_since_epoch()).count();
+        std::time_t second = static_cast<std::time_t>(ms_since_epoch / 1000);
+        int ms = static_cast<int>(ms_since_epoch % 1000);
+
+        if (second != cached_second_) {
+            std::tm local_tm;
+            localtime_r(&second, &local_tm);
+            std::strftime(prefix_, sizeof(prefix_), "[%Y-%m-%d %H:%M:%S.", &local_tm);
+            prefix_length_ = std::strlen(prefix_);
+            cached_second_ = second;
+        }
+
+        out.append(prefix_, prefix_length_);
+        out += static_cast<char>('0' + ms / 100);
+        out += static_cast<char>('0' + (ms / 10) % 10);
+        out += static_cast<char>('0' + ms % 10);
+        out += "] ";
+        out += levelTag(entry.level);
+        out += entry.message;
+        out += '\n';
+    }
+
+private:
+    std::time_t cached_second_ = -1;
+    char prefix_[32] = {};
+    size_t prefix_length_ = 0;
+};
+
+class AsyncBackend {
+public:
+    static AsyncBackend& instance() {
+        // Leaked on purpose: threads may log during static destruction
+        static AsyncBackend* backend = new AsyncBackend();
+        return *backend;
+    }
+
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        if (running_.load()) {
+            return;
+        }
+        stop_requested_ = false;
+        running_.store(true, std::memory_order_release);
+        writer_ = std::thread([this]() { run(); });
+    }
+
+    void shutdown() {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        if (!running_.load()) {
+            return;
+        }
+        // New lines go out synchronously from here; the writer drains what is queued
+        running_.store(false, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> wake_lock(wake_mutex_);
+            stop_requested_ = true;
+        }
+        wake_cv_.notify_one();
+        writer_.join();
+        // Lines queued by threads that saw running() just before the store
+        flushQueued();
+    }
+
+    /// Write whatever is still queued, synchronously (after shutdown)
+    void flushQueued() {
+        // Pairs with the fence in Logger::log(): either the producer sees
+        // running() false, or this sees its entry
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<LogEntry> batch;
+        collect(batch);
+        if (batch.empty()) {
+            return;
+        }
+        std::stable_sort(batch.begin(), batch.end(), [](const LogEntry& a, const LogEntry& b) {
+            return a.time < b.time;
+        });
+        std::string output;
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        for (const auto& entry : batch) {
+            sync_formatter_.append(output, entry);
+        }
+        std::fwrite(output.data(), 1, output.size(), stdout);
+        std::fflush(stdout);
+    }
+
+    /// Returns false if the entry could not be queued (ring full)
+    bool enqueue(LogEntry& entry) {
+        return localRing().push(entry);
+    }
+
+    void countDropped() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// Synchronous path, used before start() and for ERRORs that find the ring full
+    void writeNow(const LogEntry& entry) {
+        std::string line;
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        sync_formatter_.append(line, entry);
+        std::fwrite(line.data(), 1, line.size(), stdout);
+        std::fflush(stdout);
+    }
+
+private:
+    struct RingHandle {
+        std::shared_ptr<LogRing> ring;
+        ~RingHandle() {
+            if (ring) {
+                ring->retire();
+            }
+        }
+    };
+
+    std::mutex control_mutex_;
+    std::atomic<bool> running_{false};
+    std::thread writer_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool stop_requested_ = false;
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+
+    std::mutex output_mutex_;
+    LineFormatter sync_formatter_;
+    std::atomic<unsigned long long> dropped_{0};
+
+    LogRing& localRing() {
+        thread_local RingHandle handle;
+        if (!handle.ring) {
+            handle.ring = std::make_shared<LogRing>();
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(handle.ring);
+        }
+        return *handle.ring;
+    }
+
+    void run() {
+        LineFormatter formatter;
+        std::vector<LogEntry> batch;
+        std::string output;
+
+        while (true) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                wake_cv_.wait_for(lock, kFlushInterval, [this]() { return stop_requested_; });
+                stopping = stop_requested_;
+            }
+
+            collect(batch);
+            if (!batch.empty()) {
+                // Rings are per thread; restore global order before writing
+                std::stable_sort(batch.begin(), batch.end(), [](const LogEntry& a, const LogEntry& b) {
+                    return a.time < b.time;
+                });
+                output.clear();
+                for (const auto& entry : batch) {
+                    formatter.append(output, entry);
+                }
+                batch.clear();
+            }
+
+            unsigned long long dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                LogEntry notice;
+                notice.time = std::chrono::system_clock::now();
+                notice.level = LogLevel::WARNING;
+                notice.message = "Logger dropped " + std::to_string(dropped) + " message(s): ring buffer full";
+                formatter.append(output, notice);
+            }
+
+            if (!output.empty()) {
+                std::lock_guard<std::mutex> lock(output_mutex_);
+                std::fwrite(output.data(), 1, output.size(), stdout);
+                std::fflush(stdout);
+                output.clear();
+            }
+
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    void collect(std::vector<LogEntry>& batch) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto& ring : rings_) {
+            ring->drain(batch);
+        }
+        // Forget rings of threads that have exited once they are empty
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<LogRing>& ring) {
+                                        return ring->retired() && ring->empty();
+                                    }),
+                     rings_.end());
+    }
+};
+
+} // namespace
+
+LogLevel parseLogLevel(const std::string& name) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (lower == "debug") {
+        return LogLevel::DEBUG;
+    }
+    if (lower == "info") {
+        return LogLevel::INFO;
+    }
+    if (lower == "warning" || lower == "warn") {
+        return LogLevel::WARNING;
+    }
+    if (lower == "error") {
+        return LogLevel::ERROR;
+    }
+    throw std::runtime_error("Unknown log level '" + name + "' (expected debug, info, warning or error)");
+}
+
+void Logger::log(LogLevel level, std::string message) {
+    if (!enabled(level)) {
+        return;
+    }
+
+    LogEntry entry;
+    entry.time = std::chrono::system_clock::now();
+    entry.level = level;
+    entry.message = std::move(message);
+
+    AsyncBackend& backend = AsyncBackend::instance();
+    if (!backend.running()) {
+        backend.writeNow(entry);
+        return;
+    }
+    if (backend.enqueue(entry)) {
+        // shutdown() may have drained for the last time since the check
+        // above; then nobody but this thread will write the entry
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!backend.running()) {
+            backend.flushQueued();
+        }
+        return;
+    }
+    if (level == LogLevel::ERROR) {
+        backend.writeNow(entry);
+    } else {
+        backend.countDropped();
+    }
+}
+
+void Logger::start() {
+    AsyncBackend::instance().start();
+}
+
+void Logger::shutdown() {
+    AsyncBackend::instance().shutdown();
+}
+
+} // namespace sar_atr
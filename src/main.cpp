@@ -1,5 +1,4 @@
 #include "sar_atr_service.h"
-#include "mock_inference_engine.h"
 #include "config_manager.h"
 #include "logger.h"
 #include <csignal>
@@ -8,10 +7,16 @@
 namespace {
     sar_atr::SarAtrService* g_service = nullptr;
     
-    void signalHandler(int signal) {
+    // Handlers only set flags; the thread in start() does the work
+    void signalHandler(int) {
         if (g_service) {
-            sar_atr::Logger::info("Received interrupt signal, shutting down...");
-            g_service->stop();
+            g_service->requestStop();
+        }
+    }
+    
+    void reloadHandler(int) {
+        if (g_service) {
+            g_service->requestEngineReload();
         }
     }
 }
@@ -27,24 +32,30 @@ int main(int argc, char* argv[]) {
         // Load configuration
         sar_atr::ServiceConfig config = sar_atr::ConfigManager::loadConfig(config_path);
         
-        // Create inference engine (mock for now)
-        auto inference_engine = std::make_shared<sar_atr::MockInferenceEngine>();
+        // From here on lines are written by the background logger thread
+        sar_atr::Logger::setLevel(sar_atr::parseLogLevel(config.log_level));
+        sar_atr::Logger::start();
         
-        // Create service
-        sar_atr::SarAtrService service(config, inference_engine);
+        // Create service (builds and warms the configured inference engines)
+        sar_atr::SarAtrService service(config);
         g_service = &service;
         
         // Set up signal handlers for graceful shutdown
         std::signal(SIGINT, signalHandler);
         std::signal(SIGTERM, signalHandler);
         
+        // SIGHUP re-reads the configuration and swaps in changed engines
+        std::signal(SIGHUP, reloadHandler);
+        
         // Start service
         service.start();
         
+        sar_atr::Logger::shutdown();
         return 0;
         
     } catch (const std::exception& e) {
         sar_atr::Logger::error("Fatal error: " + std::string(e.what()));
+        sar_atr::Logger::shutdown();
         return 1;
     }
 }
@@ -0,0 +1,307 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace sar_atr {
+
+namespace {
+
+// Bucket boundaries exported to Prometheus, in seconds
+constexpr double kExportBounds[] = {
+    0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005,
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+    0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0,
+};
+
+constexpr double kExportQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+int highestBit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+void appendNumber(std::string& out, uint64_t value) {
+    out += std::to_string(value);
+}
+
+void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void appendCounter(std::string& out, const char* name, const char* help, const Counter& counter) {
+    appendHeader(out, name, "counter", help);
+    out += name;
+    out += ' ';
+    appendNumber(out, counter.value());
+    out += '\n';
+}
+
+void appendGauge(std::string& out, const char* name, const char* help, const Gauge& gauge) {
+    appendHeader(out, name, "gauge", help);
+    out += name;
+    out += ' ';
+    out += std::to_string(gauge.value());
+    out += '\n';
+}
+
+} // namespace
+
+size_t LatencyHistogram::bucketIndex(uint64_t nanos) {
+    // Values below 2 * kSubBuckets get one bucket each; above that every
+    // power of two is split into kSubBuckets equal steps
+    if (nanos < static_cast<uint64_t>(2 * kSubBuckets)) {
+        return static_cast<size_t>(nanos);
+    }
+    int msb = highestBit(nanos);
+    if (msb >= kMaxValueBits) {
+        return kBucketCount - 1;
+    }
+    int shift = msb - kSubBucketBits;
+    size_t sub = static_cast<size_t>(nanos >> shift) - kSubBuckets;
+    return 2 * kSubBuckets + static_cast<size_t>(msb - kSubBucketBits - 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < static_cast<size_t>(2 * kSubBuckets)) {
+        return index;
+    }
+    size_t offset = index - 2 * kSubBuckets;
+    int shift = static_cast<int>(offset / kSubBuckets) + 1;
+    uint64_t low = static_cast<uint64_t>(offset % kSubBuckets + kSubBuckets) << shift;
+    return low + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    buckets_[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+    sum_nanos_.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.resize(kBucketCount);
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += snapshot.buckets[i];
+    }
+    // Count comes from the buckets so quantiles and buckets always agree
+    snapshot.count = total;
+    snapshot.sum_nanos = sum_nanos_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::valueAtQuantile(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    quantile = std::min(1.0, std::max(0.0, quantile));
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count)));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(buckets.size() - 1);
+}
+
+uint64_t LatencyHistogram::Snapshot::countAtOrBelow(uint64_t limit_nanos) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (bucketUpperBound(i) > limit_nanos) {
+            break;
+        }
+        total += buckets[i];
+    }
+    return total;
+}
+
+const char* pipelineStageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::RECEIVE:
+            return "receive";
+        case PipelineStage::PARSE_WAIT:
+            return "parse_wait";
+        case PipelineStage::PARSE:
+            return "parse";
+        case PipelineStage::QUEUE_WAIT:
+            return "queue_wait";
+        case PipelineStage::INFERENCE:
+            return "inference";
+        case PipelineStage::SERIALIZE:
+            return "serialize";
+        case PipelineStage::PUBLISH:
+            return "publish";
+        case PipelineStage::SOCKET_WRITE:
+            return "socket_write";
+        case PipelineStage::COUNT:
+            break;
+    }
+    return "unknown";
+}
+
+std::string ServiceMetrics::renderPrometheus() const {
+    std::string out;
+    out.reserve(16 * 1024);
+
+    appendCounter(out, "sar_atr_messages_received_total",
+                  "FileLocation messages delivered by the broker", messages_received);
+    appendCounter(out, "sar_atr_parse_failures_total",
+                  "FileLocation messages without a usable NITF path", parse_failures);
+    appendCounter(out, "sar_atr_jobs_dropped_total",
+                  "Jobs dropped because the job queue stayed full", jobs_dropped);
+    appendCounter(out, "sar_atr_receive_pauses_total",
+                  "Times the service stopped reading from the broker until a full queue drained", receive_pauses);
+    appendCounter(out, "sar_atr_jobs_shed_total",
+                  "Jobs shed as stale or displaced by more urgent requests", jobs_shed);
+    appendCounter(out, "sar_atr_jobs_degraded_total",
+                  "Jobs run degraded because they queued past the SLO", jobs_degraded);
+    appendCounter(out, "sar_atr_jobs_processed_total",
+                  "Images whose results reached the publish step", jobs_processed);
+    appendCounter(out, "sar_atr_jobs_failed_total",
+                  "Images whose inference or publishing failed", jobs_failed);
+    appendCounter(out, "sar_atr_detections_total",
+                  "Detections returned by the inference engine", detections_total);
+    appendCounter(out, "sar_atr_detections_filtered_total",
+                  "Detections below the confidence threshold", detections_filtered);
+    appendCounter(out, "sar_atr_detections_suppressed_total",
+                  "Detections removed as duplicates by non-maximum suppression", detections_suppressed);
+    appendCounter(out, "sar_atr_detections_published_total",
+                  "Detections published as Entity messages", detections_published);
+    appendCounter(out, "sar_atr_messages_published_total",
+                  "UCI messages accepted by the send queue", messages_published);
+    appendCounter(out, "sar_atr_publish_failures_total",
+                  "UCI messages rejected by the send queue", publish_failures);
+    appendCounter(out, "sar_atr_frames_dropped_total",
+                  "Queued frames discarded when the broker connection failed", frames_dropped);
+    appendCounter(out, "sar_atr_frames_replayed_total",
+                  "Publish frames resent on a new broker connection after one was lost", frames_replayed);
+    appendCounter(out, "sar_atr_broker_reconnects_total",
+                  "Lost broker connections re-established in the background", broker_reconnects);
+    appendCounter(out, "sar_atr_socket_bytes_written_total",
+                  "Bytes written to the broker socket", bytes_written);
+    appendCounter(out, "sar_atr_result_cache_hits_total",
+                  "Images answered from the result cache", result_cache_hits);
+    appendCounter(out, "sar_atr_result_cache_misses_total",
+                  "Images the result cache sent to the inference engine", result_cache_misses);
+    appendCounter(out, "sar_atr_result_cache_coalesced_total",
+                  "Images that shared another request's inference", result_cache_coalesced);
+    appendCounter(out, "sar_atr_result_cache_evictions_total",
+                  "Cached results evicted to stay within capacity", result_cache_evictions);
+    appendCounter(out, "sar_atr_prefetch_images_total",
+                  "Queued images whose read-ahead was issued", prefetch_images);
+    appendCounter(out, "sar_atr_prefetch_bytes_total",
+                  "Bytes read ahead for queued images", prefetch_bytes);
+    appendCounter(out, "sar_atr_prefetch_skipped_total",
+                  "Images queued without read-ahead because the budget or slots were used up", prefetch_skipped);
+    appendCounter(out, "sar_atr_prefetch_late_total",
+                  "Images a worker reached before their read-ahead started", prefetch_late);
+    appendCounter(out, "sar_atr_io_requests_total",
+                  "Reads and writes queued on the async file I/O layer", io_requests);
+    appendCounter(out, "sar_atr_io_errors_total",
+                  "Async file I/O requests that completed with an error", io_errors);
+    appendCounter(out, "sar_atr_engine_reloads_total",
+                  "Engine reloads that swapped in the new configuration", engine_reloads);
+    appendCounter(out, "sar_atr_engine_reload_failures_total",
+                  "Engine reloads that failed and kept the running engines", engine_reload_failures);
+    appendGauge(out, "sar_atr_send_queue_bytes",
+                "Outbound bytes waiting to be written to the broker", send_queue_bytes);
+    appendGauge(out, "sar_atr_parse_queue_depth",
+                "FileLocation messages waiting for a parse thread", parse_queue_depth);
+    appendGauge(out, "sar_atr_job_queue_depth",
+                "Jobs waiting for an inference worker", job_queue_depth);
+    appendGauge(out, "sar_atr_serialize_queue_depth",
+                "Images waiting for a serialize thread", serialize_queue_depth);
+    appendGauge(out, "sar_atr_publish_queue_depth",
+                "Message batches waiting for a publish thread", publish_queue_depth);
+    appendGauge(out, "sar_atr_reorder_held",
+                "Finished images held back for ordered output", reorder_held);
+    appendGauge(out, "sar_atr_result_cache_entries",
+                "Images in the result cache, including ones being inferred", result_cache_entries);
+    appendGauge(out, "sar_atr_prefetch_outstanding_bytes",
+                "Read-ahead bytes held for images no worker has reached yet", prefetch_outstanding_bytes);
+    appendGauge(out, "sar_atr_io_in_flight",
+                "Async file I/O requests queued or in flight", io_in_flight);
+
+    std::vector<LatencyHistogram::Snapshot> snapshots;
+    snapshots.reserve(stages.size());
+    for (const auto& histogram : stages) {
+        snapshots.push_back(histogram.snapshot());
+    }
+
+    const char* histogram_name = "sar_atr_stage_duration_seconds";
+    appendHeader(out, histogram_name, "histogram", "Time spent in each pipeline stage");
+    for (size_t s = 0; s < snapshots.size(); ++s) {
+        const auto& snapshot = snapshots[s];
+        const char* stage = pipelineStageName(static_cast<PipelineStage>(s));
+        for (double bound : kExportBounds) {
+            out += histogram_name;
+            out += "_bucket{stage=\"";
+            out += stage;
+            out += "\",le=\"";
+            appendNumber(out, bound);
+            out += "\"} ";
+            appendNumber(out, snapshot.countAtOrBelow(static_cast<uint64_t>(bound * 1e9)));
+            out += '\n';
+        }
+        out += histogram_name;
+        out += "_bucket{stage=\"";
+        out += stage;
+        out += "\",le=\"+Inf\"} ";
+        appendNumber(out, snapshot.count);
+        out += '\n';
+
+        out += histogram_name;
+        out += "_sum{stage=\"";
+        out += stage;
+        out += "\"} ";
+        appendNumber(out, static_cast<double>(snapshot.sum_nanos) / 1e9);
+        out += '\n';
+
+        out += histogram_name;
+        out += "_count{stage=\"";
+        out += stage;
+        out += "\"} ";
+        appendNumber(out, snapshot.count);
+        out += '\n';
+    }
+
+    // Quantiles from the full-resolution buckets (within ~3%), so p99/p999
+    // do not depend on where the exported bucket boundaries fall
+    const char* quantile_name = "sar_atr_stage_duration_quantile_seconds";
+    appendHeader(out, quantile_name, "gauge", "Stage latency quantiles since start");
+    for (size_t s = 0; s < snapshots.size(); ++s) {
+        const char* stage = pipelineStageName(static_cast<PipelineStage>(s));
+        for (double quantile : kExportQuantiles) {
+            out += quantile_name;
+            out += "{stage=\"";
+            out += stage;
+            out += "\",quantile=\"";
+            appendNumber(out, quantile);
+            out += "\"} ";
+            appendNumber(out, static_cast<double>(snapshots[s].valueAtQuantile(quantile)) / 1e9);
+            out += '\n';
+        }
+    }
+
+    return out;
+}
+
+} // namespace sar_atr
@@ -0,0 +1,223 @@
+#include "metrics_server.h"
+#include "logger.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace sar_atr {
+
+namespace {
+
+constexpr int kAcceptPollMs = 200;          // how often the loop checks for stop()
+constexpr int kRequestTimeoutMs = 2000;     // whole request, read to last byte sent
+constexpr size_t kMaxRequestBytes = 8192;
+
+using Clock = std::chrono::steady_clock;
+
+int remainingMs(Clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+void setSocketTimeout(int fd, int option, int timeout_ms) {
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, option, &timeout, sizeof(timeout));
+}
+
+bool sendAll(int fd, const char* data, size_t length, Clock::time_point deadline) {
+    while (length > 0) {
+        // However the client trickles its reads, no send() outlasts the request
+        int left = remainingMs(deadline);
+        if (left == 0) {
+            return false;
+        }
+        setSocketTimeout(fd, SO_SNDTIMEO, left);
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false; // EAGAIN: the timeout ran out
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+void sendResponse(int fd, const char* status, const char* content_type, const std::string& body,
+                  Clock::time_point deadline) {
+    std::string response = "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += content_type;
+    response += "\r\nContent-Length: ";
+    response += std::to_string(body.size());
+    response += "\r\nConnection: close\r\n\r\n";
+    response += body;
+    sendAll(fd, response.data(), response.size(), deadline);
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(const std::string& bind_address, int port, RenderFunction render)
+    : bind_address_(bind_address), port_(port), render_(std::move(render)), listen_fd_(-1), running_(false) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start() {
+    if (running_) {
+        return;
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port_));
+    if (inet_pton(AF_INET, bind_address_.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid metrics bind address: " + bind_address_);
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error("Failed to create metrics socket: " + std::string(std::strerror(errno)));
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listen_fd_, 16) < 0) {
+        std::string reason = std::strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        throw std::runtime_error("Failed to listen on " + bind_address_ + ":" + std::to_string(port_) +
+                                 " for metrics: " + reason);
+    }
+
+    socklen_t length = sizeof(addr);
+    if (getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), &length) == 0) {
+        port_ = ntohs(addr.sin_port);
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() {
+        serveLoop();
+    });
+    Logger::info("Metrics available at http://" + bind_address_ + ":" + std::to_string(port_) + "/metrics");
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void MetricsServer::serveLoop() {
+    while (running_) {
+        struct pollfd pfd;
+        pfd.fd = listen_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ready = poll(&pfd, 1, kAcceptPollMs);
+        if (ready <= 0) {
+            if (ready < 0 && errno != EINTR) {
+                Logger::error("Metrics server poll failed: " + std::string(std::strerror(errno)));
+                return;
+            }
+            continue;
+        }
+
+        int client_fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            continue;
+        }
+        try {
+            serveConnection(client_fd);
+        } catch (const std::exception& e) {
+            Logger::warning("Metrics request failed: " + std::string(e.what()));
+        }
+        close(client_fd);
+    }
+}
+
+void MetricsServer::serveConnection(int client_fd) {
+    // The server is single-threaded: one deadline covers the whole request,
+    // and the socket timeouts back it up should a call block regardless
+    const auto deadline = Clock::now() + std::chrono::milliseconds(kRequestTimeoutMs);
+    setSocketTimeout(client_fd, SO_RCVTIMEO, kRequestTimeoutMs);
+    setSocketTimeout(client_fd, SO_SNDTIMEO, kRequestTimeoutMs);
+
+    // Read until the end of the request headers
+    std::string request;
+    char buffer[2048];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+        int left = remainingMs(deadline);
+        if (left == 0) {
+            return;
+        }
+        struct pollfd pfd;
+        pfd.fd = client_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, left) <= 0) {
+            return;
+        }
+        ssize_t received = recv(client_fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+        if (request.size() > kMaxRequestBytes) {
+            sendResponse(client_fd, "431 Request Header Fields Too Large", "text/plain", "", deadline);
+            return;
+        }
+    }
+
+    size_t line_end = request.find("\r\n");
+    std::string request_line = request.substr(0, line_end);
+    size_t method_end = request_line.find(' ');
+    size_t target_end = request_line.find(' ', method_end + 1);
+    if (method_end == std::string::npos || target_end == std::string::npos) {
+        sendResponse(client_fd, "400 Bad Request", "text/plain", "", deadline);
+        return;
+    }
+
+    std::string method = request_line.substr(0, method_end);
+    std::string target = request_line.substr(method_end + 1, target_end - method_end - 1);
+    size_t query = target.find('?');
+    if (query != std::string::npos) {
+        target.resize(query);
+    }
+
+    if (target != "/metrics") {
+        sendResponse(client_fd, "404 Not Found", "text/plain", "Not found\n", deadline);
+        return;
+    }
+    if (method != "GET") {
+        sendResponse(client_fd, "405 Method Not Allowed", "text/plain", "", deadline);
+        return;
+    }
+
+    sendResponse(client_fd, "200 OK", "text/plain; version=0.0.4; charset=utf-8", render_(), deadline);
+}
+
+} // namespace sar_atr
@@ -3,34 +3,107 @@
 #include <random>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <charconv>
 
 namespace sar_atr {
 
-const std::vector<std::string> MockInferenceEngine::classifications_ = {
-    "class1", "class2", "class3"
-};
-
 MockInferenceEngine::MockInferenceEngine() 
-    : rng_(std::random_device{}()),
+    : MockInferenceEngine(LatencyModel()) {
+}
+
+MockInferenceEngine::MockInferenceEngine(const LatencyModel& latency)
+    : MockInferenceEngine(latency, DetectionModel()) {
+}
+
+MockInferenceEngine::MockInferenceEngine(const LatencyModel& latency, const DetectionModel& detections)
+    : latency_(latency),
+      rng_(std::random_device{}()),
       confidence_dist_(0.3f, 0.99f),
       coord_dist_(0.05f, 0.95f),
-      count_dist_(0, 5) {
+      count_dist_(std::max(0, detections.min_detections),
+                  std::max(std::max(0, detections.min_detections), detections.max_detections)),
+      class_ids_{internClass("class1"), internClass("class2"), internClass("class3")} {
+}
+
+void MockInferenceEngine::process(const std::string& nitf_file_path, DetectionList& detections) {
+    SAR_LOG_INFO("Mock inference engine processing: " + nitf_file_path);
+    
+    simulateLatency(1);
+    
+    generateDetections(detections);
+}
+
+void MockInferenceEngine::processBatch(const std::vector<BatchItem>& items) {
+    SAR_LOG_INFO("Mock inference engine processing batch of " + std::to_string(items.size()) + " images");
+    
+    simulateLatency(items.size());
+    
+    for (const auto& item : items) {
+        generateDetections(*item.detections);
+    }
 }
 
-std::vector<DetectionResult> MockInferenceEngine::process(const std::string& nitf_file_path) {
-    Logger::info("Mock inference engine processing: " + nitf_file_path);
+void MockInferenceEngine::processTile(const std::string& nitf_file_path, const ImageTile& tile,
+                                      DetectionList& detections) {
+    SAR_LOG_DEBUG("Mock inference engine processing tile " + std::to_string(tile.index) + " of " +
+                  nitf_file_path);
     
-    // Simulate processing time
-    std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rng_() % 400)));
+    // Compute cost scales with pixels relative to a 2048x2048 reference scene
+    double area_scale = (static_cast<double>(tile.cols) * tile.rows) / (2048.0 * 2048.0);
+    simulateLatency(1, area_scale);
+    
+    generateDetections(detections, 2);
+}
+
+void MockInferenceEngine::warmUp() {
+    // A synthetic image through the whole simulated model, its results discarded
+    std::pmr::monotonic_buffer_resource scratch;
+    DetectionList detections(&scratch);
+    simulateLatency(1);
+    generateDetections(detections);
+}
+
+void MockInferenceEngine::simulateLatency(size_t batch_size, double overhead_scale) {
+    // Simulate processing time (outside the lock so workers overlap)
+    double overhead_ms = latency_.min_overhead_ms;
+    double spread = std::max(0.0, latency_.max_overhead_ms - latency_.min_overhead_ms);
+    if (spread > 0) {
+        std::lock_guard<std::mutex> lock(rng_mutex_);
+        switch (latency_.distribution) {
+            case LatencyModel::Distribution::UNIFORM:
+                overhead_ms += std::uniform_real_distribution<double>(0.0, spread)(rng_);
+                break;
+            case LatencyModel::Distribution::NORMAL:
+                overhead_ms += std::normal_distribution<double>(spread / 2, spread / 6)(rng_);
+                break;
+            case LatencyModel::Distribution::EXPONENTIAL:
+                overhead_ms += std::exponential_distribution<double>(4.0 / spread)(rng_);
+                break;
+        }
+        overhead_ms = std::min(latency_.max_overhead_ms, std::max(latency_.min_overhead_ms, overhead_ms));
+    }
+    double processing_ms = overhead_ms * overhead_scale + latency_.per_image_ms * static_cast<double>(batch_size);
+    if (processing_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>(processing_ms * 1000)));
+    }
+}
+
+void MockInferenceEngine::generateDetections(DetectionList& detections, int max_detections) {
+    std::lock_guard<std::mutex> lock(rng_mutex_);
     
-    std::vector<DetectionResult> results;
     int num_detections = count_dist_(rng_);
+    if (max_detections >= 0) {
+        num_detections = std::min(num_detections, max_detections);
+    }
     
+    detections.reserve(detections.size() + static_cast<size_t>(num_detections));
     for (int i = 0; i < num_detections; ++i) {
-        DetectionResult detection;
+        // Constructed in place so the output path uses the list's memory
+        DetectionResult& detection = detections.emplace_back();
         
         // Random classification
-        detection.classification = classifications_[rng_() % classifications_.size()];
+        detection.class_id = class_ids_[rng_() % class_ids_.size()];
         
         // Random confidence
         detection.confidence = confidence_dist_(rng_);
@@ -47,18 +120,17 @@ std::vector<DetectionResult> MockInferenceEngine::process(const std::string& nit
         detection.bounding_box.y2 = std::min(1.0f, y1 + height);
         
         // 50% chance of generating an output file path
+        // (left empty otherwise)
         if (rng_() % 2 == 0) {
-            detection.output_file_path = "/output/chips/chip_" + std::to_string(rng_() % 10000) + ".nitf";
-        } else {
-            detection.output_file_path = "";  // No output file for this detection
+            char number[16];
+            auto end = std::to_chars(number, number + sizeof(number), rng_() % 10000).ptr;
+            detection.output_file_path.append("/output/chips/chip_");
+            detection.output_file_path.append(number, end);
+            detection.output_file_path.append(".nitf");
         }
-        
-        results.push_back(detection);
     }
     
-    Logger::info("Mock inference generated " + std::to_string(num_detections) + " detections");
-    
-    return results;
+    SAR_LOG_INFO("Mock inference generated " + std::to_string(num_detections) + " detections");
 }
 
 } // namespace sar_atr
@@ -0,0 +1,334 @@
+#include "nitf_reader.h"
+#include <charconv>
+#include <stdexcept>
+
+namespace sar_atr {
+
+namespace {
+
+// NITF 2.1 file header: the fixed-length fields in front of FL add up to 342
+// bytes; FL and HL are followed by NUMI at 360
+constexpr size_t kFileLengthOffset = 342;
+constexpr size_t kImageCountOffset = 360;
+
+// Image subheader: IM through ISORCE is fixed at 333 bytes, ahead of NROWS
+constexpr size_t kImageIdOffset = 2;
+constexpr size_t kImageSizeOffset = 333;
+
+constexpr uint32_t kBlockNotRecorded = 0xFFFFFFFFu;
+
+/**
+ * Cursor over fixed-width ASCII header fields, bounded by the header length
+ */
+class FieldCursor {
+public:
+    FieldCursor(const uint8_t* data, size_t size, size_t pos)
+        : data_(data), size_(size), pos_(pos) {}
+
+    std::string_view take(size_t length) {
+        if (pos_ + length > size_) {
+            throw std::runtime_error("NITF header truncated at offset " + std::to_string(pos_));
+        }
+        std::string_view field(reinterpret_cast<const char*>(data_ + pos_), length);
+        pos_ += length;
+        return field;
+    }
+
+    long long takeInt(size_t length) {
+        std::string_view field = trim(take(length));
+        long long value = 0;
+        auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        if (field.empty() || result.ec != std::errc() || result.ptr != field.data() + field.size()) {
+            throw std::runtime_error("Invalid numeric NITF field '" + std::string(field) + "' at offset " +
+                                     std::to_string(pos_ - length));
+        }
+        return value;
+    }
+
+    std::string takeString(size_t length) {
+        return std::string(trim(take(length)));
+    }
+
+    void skip(size_t length) { take(length); }
+
+    static std::string_view trim(std::string_view field) {
+        while (!field.empty() && field.front() == ' ') {
+            field.remove_prefix(1);
+        }
+        while (!field.empty() && field.back() == ' ') {
+            field.remove_suffix(1);
+        }
+        return field;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+uint32_t readBigEndian32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint16_t readBigEndian16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+} // namespace
+
+NitfReader::NitfReader(const std::string& path)
+    : file_(path) {
+    parseFileHeader();
+}
+
+void NitfReader::parseFileHeader() {
+    FieldCursor header(file_.data(), file_.size(), 0);
+
+    std::string_view signature = header.take(4);
+    version_ = std::string(header.take(5));
+    bool nitf21 = signature == "NITF" && version_ == "02.10";
+    bool nsif10 = signature == "NSIF" && version_ == "01.00";
+    if (!nitf21 && !nsif10) {
+        throw std::runtime_error(path() + " is not a NITF 2.1/NSIF 1.0 file (found '" +
+                                 std::string(signature) + version_ + "')");
+    }
+
+    FieldCursor lengths(file_.data(), file_.size(), kFileLengthOffset);
+    lengths.takeInt(12); // FL; may be all 9s for streamed files, so trust the file size instead
+    size_t header_length = static_cast<size_t>(lengths.takeInt(6));
+
+    FieldCursor segments(file_.data(), header_length, kImageCountOffset);
+    int image_count = static_cast<int>(segments.takeInt(3));
+
+    size_t segment_offset = header_length;
+    images_.resize(image_count);
+    block_offsets_.resize(image_count);
+    for (int i = 0; i < image_count; ++i) {
+        NitfImageInfo& info = images_[i];
+        info.header_offset = segment_offset;
+        info.header_length = static_cast<size_t>(segments.takeInt(6));
+        info.data_offset = segment_offset + info.header_length;
+        info.data_length = static_cast<size_t>(segments.takeInt(10));
+        segment_offset = info.data_offset + info.data_length;
+
+        if (segment_offset > file_.size()) {
+            throw std::runtime_error(path() + ": image segment " + std::to_string(i) +
+                                     " runs past end of file");
+        }
+
+        parseImageSubheader(info);
+        if (info.hasMaskTable()) {
+            parseMaskTable(static_cast<size_t>(i));
+        }
+    }
+}
+
+void NitfReader::parseImageSubheader(NitfImageInfo& info) {
+    FieldCursor sub(file_.data(), info.header_offset + info.header_length, info.header_offset);
+    if (sub.take(2) != "IM") {
+        throw std::runtime_error(path() + ": image subheader at offset " +
+                                 std::to_string(info.header_offset) + " does not start with IM");
+    }
+
+    FieldCursor id(file_.data(), info.header_offset + info.header_length, info.header_offset + kImageIdOffset);
+    info.image_id = id.takeString(10);
+
+    sub = FieldCursor(file_.data(), info.header_offset + info.header_length,
+                      info.header_offset + kImageSizeOffset);
+    info.rows = static_cast<int>(sub.takeInt(8));
+    info.cols = static_cast<int>(sub.takeInt(8));
+    info.pixel_type = sub.takeString(3);
+    info.representation = sub.takeString(8);
+    info.category = sub.takeString(8);
+    info.actual_bits_per_pixel = static_cast<int>(sub.takeInt(2));
+    sub.skip(1); // PJUST
+
+    std::string_view icords = sub.take(1);
+    if (icords != " ") {
+        sub.skip(60); // IGEOLO
+    }
+
+    int comment_count = static_cast<int>(sub.takeInt(1));
+    sub.skip(static_cast<size_t>(comment_count) * 80);
+
+    info.compression = sub.takeString(2);
+    if (!info.isUncompressed()) {
+        sub.skip(4); // COMRAT
+    }
+
+    info.bands = static_cast<int>(sub.takeInt(1));
+    if (info.bands == 0) {
+        info.bands = static_cast<int>(sub.takeInt(5));
+    }
+    if (info.bands <= 0) {
+        throw std::runtime_error(path() + ": image has no bands");
+    }
+
+    for (int band = 0; band < info.bands; ++band) {
+        sub.skip(2 + 6 + 1 + 3); // IREPBANDn, ISUBCATn, IFCn, IMFLTn
+        int lut_count = static_cast<int>(sub.takeInt(1));
+        if (lut_count > 0) {
+            size_t lut_entries = static_cast<size_t>(sub.takeInt(5));
+            sub.skip(lut_entries * static_cast<size_t>(lut_count));
+        }
+    }
+
+    sub.skip(1); // ISYNC
+    info.image_mode = sub.take(1).front();
+    info.blocks_per_row = static_cast<int>(sub.takeInt(4));
+    info.blocks_per_column = static_cast<int>(sub.takeInt(4));
+    info.block_cols = static_cast<int>(sub.takeInt(4));
+    info.block_rows = static_cast<int>(sub.takeInt(4));
+    info.bits_per_pixel = static_cast<int>(sub.takeInt(2));
+
+    // NPPBH/NPPBV of 0 mean "one block spans the whole (> 8192 pixel) dimension"
+    if (info.block_cols == 0 && info.blocks_per_row == 1) {
+        info.block_cols = info.cols;
+    }
+    if (info.block_rows == 0 && info.blocks_per_column == 1) {
+        info.block_rows = info.rows;
+    }
+
+    if (info.rows <= 0 || info.cols <= 0 || info.block_cols <= 0 || info.block_rows <= 0 ||
+        info.blocks_per_row <= 0 || info.blocks_per_column <= 0 ||
+        static_cast<long long>(info.blocks_per_row) * info.block_cols < info.cols ||
+        static_cast<long long>(info.blocks_per_column) * info.block_rows < info.rows) {
+        throw std::runtime_error(path() + ": inconsistent image blocking (" +
+                                 std::to_string(info.blocks_per_row) + "x" +
+                                 std::to_string(info.blocks_per_column) + " blocks of " +
+                                 std::to_string(info.block_cols) + "x" + std::to_string(info.block_rows) +
+                                 " for " + std::to_string(info.cols) + "x" + std::to_string(info.rows) + ")");
+    }
+    if (info.image_mode != 'B' && info.image_mode != 'P' && info.image_mode != 'R' && info.image_mode != 'S') {
+        throw std::runtime_error(path() + ": unknown IMODE '" + std::string(1, info.image_mode) + "'");
+    }
+}
+
+void NitfReader::parseMaskTable(size_t image_index) {
+    NitfImageInfo& info = images_[image_index];
+    const uint8_t* table = file_.data() + info.data_offset;
+    if (info.data_length < 10) {
+        throw std::runtime_error(path() + ": image mask table truncated");
+    }
+
+    uint32_t data_offset = readBigEndian32(table);
+    uint16_t block_record_length = readBigEndian16(table + 4);
+    uint16_t pad_pixel_bits = readBigEndian16(table + 8);
+    size_t pos = 10 + (pad_pixel_bits + 7) / 8;
+
+    if (data_offset > info.data_length) {
+        throw std::runtime_error(path() + ": image mask table points past image data");
+    }
+
+    if (block_record_length == 0) {
+        // No block mask: every block is recorded, back to back after the table
+        info.data_offset += data_offset;
+        info.data_length -= data_offset;
+        return;
+    }
+    if (block_record_length != 4) {
+        throw std::runtime_error(path() + ": unsupported block mask record length " +
+                                 std::to_string(block_record_length));
+    }
+
+    size_t records = static_cast<size_t>(info.blockCount()) *
+                     (info.image_mode == 'S' ? static_cast<size_t>(info.bands) : 1);
+    if (pos + records * 4 > data_offset) {
+        throw std::runtime_error(path() + ": image block mask truncated");
+    }
+
+    std::vector<uint32_t>& offsets = block_offsets_[image_index];
+    offsets.resize(records);
+    for (size_t r = 0; r < records; ++r) {
+        uint32_t offset = readBigEndian32(table + pos + r * 4);
+        offsets[r] = offset == kBlockNotRecorded ? kBlockNotRecorded : data_offset + offset;
+    }
+}
+
+const NitfImageInfo& NitfReader::image(size_t index) const {
+    if (index >= images_.size()) {
+        throw std::out_of_range(path() + ": no image segment " + std::to_string(index));
+    }
+    return images_[index];
+}
+
+NitfBlockView NitfReader::block(size_t image_index, int block_row, int block_col, int band) const {
+    const NitfImageInfo& info = image(image_index);
+    if (!info.isUncompressed()) {
+        throw std::runtime_error(path() + ": block views need uncompressed data (IC=" + info.compression + ")");
+    }
+    if (info.bits_per_pixel % 8 != 0) {
+        throw std::runtime_error(path() + ": block views need byte-aligned pixels (NBPP=" +
+                                 std::to_string(info.bits_per_pixel) + ")");
+    }
+    if (block_row < 0 || block_row >= info.blocks_per_column || block_col < 0 ||
+        block_col >= info.blocks_per_row || band < 0 || band >= info.bands) {
+        throw std::out_of_range(path() + ": block (" + std::to_string(block_row) + ", " +
+                                std::to_string(block_col) + ") band " + std::to_string(band) +
+                                " out of range");
+    }
+
+    const size_t bytes_per_pixel = static_cast<size_t>(info.bytesPerPixel());
+    const size_t bands = static_cast<size_t>(info.bands);
+    const size_t cols = static_cast<size_t>(info.block_cols);
+    const size_t band_bytes = info.blockBytes();
+    const size_t block_index = static_cast<size_t>(block_row) * info.blocks_per_row + block_col;
+
+    NitfBlockView view;
+    view.rows = info.block_rows;
+    view.cols = info.block_cols;
+    view.bytes_per_pixel = static_cast<int>(bytes_per_pixel);
+
+    size_t record = block_index;
+    size_t record_bytes = band_bytes * bands;
+    size_t within = 0;
+    switch (info.image_mode) {
+        case 'S':
+            record = static_cast<size_t>(band) * info.blockCount() + block_index;
+            record_bytes = band_bytes;
+            view.pixel_stride = bytes_per_pixel;
+            view.row_stride = cols * bytes_per_pixel;
+            break;
+        case 'P':
+            within = static_cast<size_t>(band) * bytes_per_pixel;
+            view.pixel_stride = bands * bytes_per_pixel;
+            view.row_stride = cols * bands * bytes_per_pixel;
+            break;
+        case 'R':
+            within = static_cast<size_t>(band) * cols * bytes_per_pixel;
+            view.pixel_stride = bytes_per_pixel;
+            view.row_stride = cols * bands * bytes_per_pixel;
+            break;
+        default: // 'B'
+            within = static_cast<size_t>(band) * band_bytes;
+            view.pixel_stride = bytes_per_pixel;
+            view.row_stride = cols * bytes_per_pixel;
+            break;
+    }
+
+    size_t record_offset = record * record_bytes;
+    const std::vector<uint32_t>& offsets = block_offsets_[image_index];
+    if (!offsets.empty()) {
+        if (offsets[record] == kBlockNotRecorded) {
+            return NitfBlockView();
+        }
+        record_offset = offsets[record];
+    }
+
+    if (record_offset + record_bytes > info.data_length) {
+        throw std::runtime_error(path() + ": block (" + std::to_string(block_row) + ", " +
+                                 std::to_string(block_col) + ") runs past end of image data");
+    }
+
+    view.data = file_.data() + info.data_offset + record_offset + within;
+    return view;
+}
+
+std::string_view NitfReader::imageData(size_t image_index) const {
+    const NitfImageInfo& info = image(image_index);
+    return std::string_view(reinterpret_cast<const char*>(file_.data() + info.data_offset), info.data_length);
+}
+
+} // namespace sar_atr
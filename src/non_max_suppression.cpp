@@ -0,0 +1,429 @@
+#include "non_max_suppression.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace sar_atr {
+
+NmsOptions::Method parseNmsMethod(const std::string& name) {
+    if (name == "none") {
+        return NmsOptions::Method::NONE;
+    }
+    if (name == "greedy") {
+        return NmsOptions::Method::GREEDY;
+    }
+    if (name == "soft_linear") {
+        return NmsOptions::Method::SOFT_LINEAR;
+    }
+    if (name == "soft_gaussian") {
+        return NmsOptions::Method::SOFT_GAUSSIAN;
+    }
+    throw std::runtime_error("Unknown NMS method '" + name + "' (expected none, greedy, soft_linear or soft_gaussian)");
+}
+
+namespace {
+
+/// Score of a box greedy NMS has suppressed (or soft NMS has already kept)
+constexpr float kSuppressed = -INFINITY;
+
+/// Boxes of one class, gathered into contiguous columns in x1 order
+struct WorkingSet {
+    float* x1;
+    float* y1;
+    float* x2;
+    float* y2;
+    float* area;
+    float* score;
+    uint32_t* index;
+};
+
+/// The box every other box is compared against
+struct Probe {
+    float x1, y1, x2, y2, area;
+
+    Probe(const WorkingSet& w, size_t i) : x1(w.x1[i]), y1(w.y1[i]), x2(w.x2[i]), y2(w.y2[i]), area(w.area[i]) {}
+
+    // Intersection and union areas with box j (the SIMD blocks below do the same per lane)
+    void overlap(const WorkingSet& w, size_t j, float& inter, float& uni) const {
+        float iw = std::max(0.0f, std::min(x2, w.x2[j]) - std::max(x1, w.x1[j]));
+        float ih = std::max(0.0f, std::min(y2, w.y2[j]) - std::max(y1, w.y1[j]));
+        inter = iw * ih;
+        uni = area + w.area[j] - inter;
+    }
+};
+
+#if defined(__AVX2__)
+struct Probe8 {
+    __m256 x1, y1, x2, y2, area;
+
+    explicit Probe8(const Probe& p)
+        : x1(_mm256_set1_ps(p.x1)), y1(_mm256_set1_ps(p.y1)), x2(_mm256_set1_ps(p.x2)),
+          y2(_mm256_set1_ps(p.y2)), area(_mm256_set1_ps(p.area)) {}
+
+    void overlap(const WorkingSet& w, size_t j, __m256& inter, __m256& uni) const {
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 iw = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(x2, _mm256_loadu_ps(w.x2 + j)),
+                                                      _mm256_max_ps(x1, _mm256_loadu_ps(w.x1 + j))));
+        __m256 ih = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(y2, _mm256_loadu_ps(w.y2 + j)),
+                                                      _mm256_max_ps(y1, _mm256_loadu_ps(w.y1 + j))));
+        inter = _mm256_mul_ps(iw, ih);
+        uni = _mm256_sub_ps(_mm256_add_ps(area, _mm256_loadu_ps(w.area + j)), inter);
+    }
+};
+#endif
+
+#if defined(__SSE2__)
+struct Probe4 {
+    __m128 x1, y1, x2, y2, area;
+
+    explicit Probe4(const Probe& p)
+        : x1(_mm_set1_ps(p.x1)), y1(_mm_set1_ps(p.y1)), x2(_mm_set1_ps(p.x2)),
+          y2(_mm_set1_ps(p.y2)), area(_mm_set1_ps(p.area)) {}
+
+    void overlap(const WorkingSet& w, size_t j, __m128& inter, __m128& uni) const {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 iw = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(x2, _mm_loadu_ps(w.x2 + j)),
+                                                _mm_max_ps(x1, _mm_loadu_ps(w.x1 + j))));
+        __m128 ih = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(y2, _mm_loadu_ps(w.y2 + j)),
+                                                _mm_max_ps(y1, _mm_loadu_ps(w.y1 + j))));
+        inter = _mm_mul_ps(iw, ih);
+        uni = _mm_sub_ps(_mm_add_ps(area, _mm_loadu_ps(w.area + j)), inter);
+    }
+};
+#endif
+
+/*
+ * Greedy: box j is a duplicate of the probe when IoU > threshold, tested
+ * as inter > threshold * union so no lane divides.
+ */
+void suppressOverlaps(WorkingSet& w, size_t from, size_t end, const Probe& probe, float threshold) {
+    size_t j = from;
+
+#if defined(__AVX2__)
+    const Probe8 probe8(probe);
+    const __m256 threshold8 = _mm256_set1_ps(threshold);
+    const __m256 dead8 = _mm256_set1_ps(kSuppressed);
+    for (; j + 8 <= end; j += 8) {
+        __m256 inter, uni;
+        probe8.overlap(w, j, inter, uni);
+        __m256 duplicate = _mm256_cmp_ps(inter, _mm256_mul_ps(threshold8, uni), _CMP_GT_OQ);
+        __m256 score = _mm256_loadu_ps(w.score + j);
+        _mm256_storeu_ps(w.score + j, _mm256_blendv_ps(score, dead8, duplicate));
+    }
+#endif
+#if defined(__SSE2__)
+    const Probe4 probe4(probe);
+    const __m128 threshold4 = _mm_set1_ps(threshold);
+    const __m128 dead4 = _mm_set1_ps(kSuppressed);
+    for (; j + 4 <= end; j += 4) {
+        __m128 inter, uni;
+        probe4.overlap(w, j, inter, uni);
+        __m128 duplicate = _mm_cmpgt_ps(inter, _mm_mul_ps(threshold4, uni));
+        __m128 score = _mm_loadu_ps(w.score + j);
+        _mm_storeu_ps(w.score + j, _mm_or_ps(_mm_andnot_ps(duplicate, score), _mm_and_ps(duplicate, dead4)));
+    }
+#endif
+
+    for (; j < end; ++j) {
+        float inter, uni;
+        probe.overlap(w, j, inter, uni);
+        if (inter > threshold * uni) {
+            w.score[j] = kSuppressed;
+        }
+    }
+}
+
+/*
+ * Soft: scale each remaining score in [from, end) by the decay of its IoU
+ * with the probe (kept boxes, scored kSuppressed, are left alone).
+ */
+void decayOverlaps(WorkingSet& w, size_t from, size_t end, const Probe& probe, const NmsOptions& options) {
+    const bool linear = options.method == NmsOptions::Method::SOFT_LINEAR;
+    const float threshold = options.iou_threshold;
+    const float inv_sigma = 1.0f / options.sigma;
+    size_t j = from;
+
+    // Gaussian decay needs exp(), which is left to the scalar loop: only
+    // lanes that actually intersect the probe (usually few) pay for it
+    auto gaussian = [&](size_t k, float iou) {
+        if (w.score[k] > kSuppressed) {
+            w.score[k] *= std::exp(-(iou * iou) * inv_sigma);
+        }
+    };
+
+#if defined(__SSE2__)
+    const Probe4 probe4(probe);
+    const __m128 threshold4 = _mm_set1_ps(threshold);
+    const __m128 one4 = _mm_set1_ps(1.0f);
+    const __m128 tiny4 = _mm_set1_ps(FLT_MIN);
+    const __m128 zero4 = _mm_setzero_ps();
+    const __m128 dead4 = _mm_set1_ps(kSuppressed);
+    for (; j + 4 <= end; j += 4) {
+        __m128 inter, uni;
+        probe4.overlap(w, j, inter, uni);
+        __m128 iou = _mm_div_ps(inter, _mm_max_ps(uni, tiny4));
+        if (linear) {
+            __m128 before = _mm_loadu_ps(w.score + j);
+            __m128 decays = _mm_and_ps(_mm_cmpgt_ps(iou, threshold4), _mm_cmpgt_ps(before, dead4));
+            if (_mm_movemask_ps(decays) == 0) {
+                continue;
+            }
+            __m128 factor = _mm_or_ps(_mm_and_ps(decays, _mm_sub_ps(one4, iou)), _mm_andnot_ps(decays, one4));
+            _mm_storeu_ps(w.score + j, _mm_mul_ps(before, factor));
+        } else {
+            int touching = _mm_movemask_ps(_mm_cmpgt_ps(iou, zero4));
+            if (touching == 0) {
+                continue;
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, iou);
+            for (int lane = 0; lane < 4; ++lane) {
+                if (touching & (1 << lane)) {
+                    gaussian(j + static_cast<size_t>(lane), lanes[lane]);
+                }
+            }
+        }
+    }
+#endif
+
+    for (; j < end; ++j) {
+        float inter, uni;
+        probe.overlap(w, j, inter, uni);
+        float iou = inter / std::max(uni, FLT_MIN);
+        if (linear) {
+            if (iou > threshold && w.score[j] > kSuppressed) {
+                w.score[j] *= 1.0f - iou;
+            }
+        } else if (iou > 0.0f) {
+            gaussian(j, iou);
+        }
+    }
+}
+
+/// Radix sort record: a key and the position or candidate it belongs to
+struct SortKey {
+    uint64_t key;
+    uint32_t index;
+};
+
+/// Float bits reordered so unsigned comparison matches float comparison
+uint32_t orderedBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+/*
+ * Stable LSD radix sort on the low key_bytes bytes of each key, a byte per
+ * pass; passes over a byte every key shares are skipped. A few linear
+ * passes beat a comparison sort at the thousands of boxes seen here.
+ */
+void radixSort(SortKey* keys, SortKey* buffer, size_t n, unsigned key_bytes) {
+    if (n < 2) {
+        return;
+    }
+    SortKey* from = keys;
+    SortKey* to = buffer;
+    for (unsigned byte = 0; byte < key_bytes; ++byte) {
+        const unsigned shift = byte * 8;
+        size_t counts[256] = {};
+        for (size_t k = 0; k < n; ++k) {
+            ++counts[(from[k].key >> shift) & 0xFF];
+        }
+        if (counts[(from[0].key >> shift) & 0xFF] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (size_t& count : counts) {
+            size_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            to[counts[(from[k].key >> shift) & 0xFF]++] = from[k];
+        }
+        std::swap(from, to);
+    }
+    if (from != keys) {
+        std::copy(from, from + n, keys);
+    }
+}
+
+/*
+ * The working set is ordered by x1, so the only boxes that can overlap a
+ * probe are the run whose x1 lies in (probe.x1 - widest, probe.x2): every
+ * box outside it has no intersection and therefore IoU 0. Each probe then
+ * scans a narrow window instead of the whole class.
+ */
+struct Window {
+    size_t begin, end;
+};
+
+Window overlapWindow(const WorkingSet& w, size_t end, const Probe& probe, float widest) {
+    // Widened slightly so rounding in x2 - x1 never excludes a box that touches
+    float reach = probe.x1 - widest * (1.0f + 1e-5f) - 1e-6f;
+    const float* x1 = w.x1;
+    const float* first = std::lower_bound(x1, x1 + end, reach);
+    const float* last = std::lower_bound(first, x1 + end, probe.x2);
+    return Window{static_cast<size_t>(first - x1), static_cast<size_t>(last - x1)};
+}
+
+/*
+ * by_score lists working-set positions best first. A box still live when its
+ * turn comes is kept and suppresses its overlaps; boxes it could overlap that
+ * were already kept are never duplicates of it (they would have suppressed it),
+ * so the window needs no masking.
+ */
+size_t greedyClass(WorkingSet& w, size_t n, const uint32_t* by_score, float widest, float threshold,
+                   uint32_t* kept) {
+    size_t written = 0;
+    for (size_t k = 0; k < n; ++k) {
+        size_t pos = by_score[k];
+        if (!(w.score[pos] > kSuppressed)) {
+            continue;
+        }
+        kept[written++] = w.index[pos];
+        Probe probe(w, pos);
+        Window window = overlapWindow(w, n, probe, widest);
+        suppressOverlaps(w, window.begin, window.end, probe, threshold);
+    }
+    return written;
+}
+
+/// Soft NMS heap entry: the score a box had when it was pushed
+struct Contender {
+    float score;
+    uint32_t pos;
+    uint32_t index;
+
+    /// Max-heap order: highest score first, then the lowest candidate index
+    bool operator<(const Contender& other) const {
+        return score < other.score || (score == other.score && index > other.index);
+    }
+};
+
+/*
+ * Scores only ever decrease, so a heap entry is an upper bound on its box's
+ * current score. When the top entry is still current it is the true maximum;
+ * a stale one goes back in at its decayed score. Kept boxes stay in place
+ * scored kSuppressed, so the working set keeps its x1 order for the windows.
+ */
+size_t softClass(WorkingSet& w, size_t n, float widest, const NmsOptions& options, float floor, float* confidence,
+                 Contender* heap, uint32_t* kept) {
+    size_t size = 0;
+    for (size_t pos = 0; pos < n; ++pos) {
+        if (w.score[pos] >= floor) {
+            heap[size++] = Contender{w.score[pos], static_cast<uint32_t>(pos), w.index[pos]};
+        }
+    }
+    std::make_heap(heap, heap + size);
+
+    size_t written = 0;
+    while (size > 0) {
+        std::pop_heap(heap, heap + size);
+        Contender top = heap[--size];
+        float current = w.score[top.pos];
+        if (!(current >= floor)) {
+            continue;
+        }
+        if (current != top.score) {
+            heap[size++] = Contender{current, top.pos, top.index};
+            std::push_heap(heap, heap + size);
+            continue;
+        }
+        confidence[top.index] = current;
+        kept[written++] = top.index;
+        w.score[top.pos] = kSuppressed;
+        Probe probe(w, top.pos);
+        Window window = overlapWindow(w, n, probe, widest);
+        decayOverlaps(w, window.begin, window.end, probe, options);
+    }
+    return written;
+}
+
+} // namespace
+
+size_t suppressNonMaxima(DetectionBatch& candidates, uint32_t* selected, size_t count, const NmsOptions& options,
+                         float min_confidence, std::pmr::memory_resource* scratch) {
+    if (options.method == NmsOptions::Method::NONE || count < 2) {
+        return count;
+    }
+
+    const ClassId* class_ids = candidates.classIds();
+    float* confidence = candidates.confidence();
+
+    // Class by class, best first (ties keep their order in selected, so the result is deterministic)
+    std::pmr::vector<SortKey> order(count, scratch);
+    std::pmr::vector<SortKey> sort_buffer(count, scratch);
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t i = selected[k];
+        order[k].key = static_cast<uint64_t>(class_ids[i]) << 32 | static_cast<uint32_t>(~orderedBits(confidence[i]));
+        order[k].index = i;
+    }
+    radixSort(order.data(), sort_buffer.data(), count, 4 + sizeof(ClassId));
+
+    std::pmr::vector<float> columns(count * 6, scratch);
+    std::pmr::vector<uint32_t> indices(count, scratch);
+    std::pmr::vector<SortKey> by_x(count, scratch);
+    std::pmr::vector<uint32_t> by_score(count, scratch);
+    std::pmr::vector<Contender> heap(options.method == NmsOptions::Method::GREEDY ? 0 : count, scratch);
+    WorkingSet w{columns.data(), columns.data() + count, columns.data() + count * 2, columns.data() + count * 3,
+                 columns.data() + count * 4, columns.data() + count * 5, indices.data()};
+
+    const float floor = std::max(min_confidence, kSoftNmsScoreFloor);
+    const float* x1 = candidates.x1();
+    const float* y1 = candidates.y1();
+    const float* x2 = candidates.x2();
+    const float* y2 = candidates.y2();
+    size_t kept = 0;
+
+    for (size_t group = 0; group < count;) {
+        size_t group_end = group + 1;
+        while (group_end < count && order[group_end].key >> 32 == order[group].key >> 32) {
+            ++group_end;
+        }
+        const size_t n = group_end - group;
+        const SortKey* ranked = order.data() + group;
+
+        // Gather the class in x1 order, remembering where each score rank went
+        for (size_t k = 0; k < n; ++k) {
+            by_x[k].key = orderedBits(x1[ranked[k].index]);
+            by_x[k].index = static_cast<uint32_t>(k);
+        }
+        radixSort(by_x.data(), sort_buffer.data(), n, 4);
+        float widest = 0.0f;
+        for (size_t pos = 0; pos < n; ++pos) {
+            uint32_t rank = by_x[pos].index;
+            uint32_t i = ranked[rank].index;
+            w.x1[pos] = x1[i];
+            w.y1[pos] = y1[i];
+            w.x2[pos] = x2[i];
+            w.y2[pos] = y2[i];
+            w.score[pos] = confidence[i];
+            w.index[pos] = i;
+            by_score[rank] = static_cast<uint32_t>(pos);
+            widest = std::max(widest, x2[i] - x1[i]);
+        }
+        computeBoxAreas(w.x1, w.y1, w.x2, w.y2, n, w.area);
+
+        // selected was copied into order, so results can go straight into it
+        if (options.method == NmsOptions::Method::GREEDY) {
+            kept += greedyClass(w, n, by_score.data(), widest, options.iou_threshold, selected + kept);
+        } else {
+            kept += softClass(w, n, widest, options, floor, confidence, heap.data(), selected + kept);
+        }
+        group = group_end;
+    }
+
+    std::sort(selected, selected + kept);
+    return kept;
+}
+
+} // namespace sar_atr
@@ -0,0 +1,235 @@
+#include "prefetcher.h"
+#include "logger.h"
+#include "nitf_reader.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sar_atr {
+
+namespace {
+
+// Advised before parsing, so the file header and the first image subheaders
+// are already on their way when NitfReader touches them
+constexpr size_t kHeaderReadahead = 64 * 1024;
+
+} // namespace
+
+Prefetcher::Prefetcher(size_t slots, size_t bytes_per_image, size_t budget_bytes, int threads,
+                       ServiceMetrics* metrics, AsyncFileIO* io)
+    : bytes_per_image_(bytes_per_image), budget_bytes_(budget_bytes), metrics_(metrics), io_(io),
+      slots_(slots > 0 ? slots : 1) {
+    if (bytes_per_image_ == 0 || budget_bytes_ < bytes_per_image_) {
+        throw std::invalid_argument("Prefetch budget must hold at least one image's read-ahead");
+    }
+    free_slots_.reserve(slots_.size());
+    queued_.reserve(slots_.size());
+    for (size_t i = slots_.size(); i > 0; --i) {
+        slots_[i - 1].path.reserve(256);
+        free_slots_.push_back(static_cast<uint32_t>(i - 1));
+    }
+    for (int i = 0; i < std::max(threads, 1); ++i) {
+        threads_.emplace_back([this]() {
+            run();
+        });
+    }
+    Logger::debug("Started " + std::to_string(threads_.size()) + " prefetch thread(s), " +
+                  std::to_string(slots_.size()) + " slot(s)");
+}
+
+Prefetcher::~Prefetcher() {
+    shutdown();
+}
+
+uint64_t Prefetcher::hint(const std::string& nitf_path) {
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || free_slots_.empty() || outstanding_ + bytes_per_image_ > budget_bytes_) {
+            if (metrics_) {
+                metrics_->prefetch_skipped.inc();
+            }
+            return 0;
+        }
+        // Reserve the most this image can take; warming gives back what it did not use
+        uint32_t index = free_slots_.back();
+        free_slots_.pop_back();
+        queued_.push_back(index);
+        ticket = (next_serial_++ << 32) | index;
+        Slot& slot = slots_[index];
+        slot.ticket = ticket;
+        slot.state = State::QUEUED;
+        slot.released = false;
+        slot.bytes = bytes_per_image_;
+        slot.path.assign(nitf_path);
+        outstanding_ += bytes_per_image_;
+    }
+    ready_.notify_one();
+    return ticket;
+}
+
+void Prefetcher::release(uint64_t ticket) {
+    if (ticket == 0) {
+        return;
+    }
+    const auto index = static_cast<uint32_t>(ticket);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= slots_.size() || slots_[index].ticket != ticket) {
+        return;
+    }
+    Slot& slot = slots_[index];
+    switch (slot.state) {
+        case State::QUEUED:
+            // The worker got there first; reading it now would only compete with the worker
+            if (metrics_) {
+                metrics_->prefetch_late.inc();
+            }
+            queued_.erase(std::find(queued_.begin(), queued_.end(), index));
+            outstanding_ -= slot.bytes;
+            slot.state = State::FREE;
+            free_slots_.push_back(index);
+            break;
+        case State::RUNNING:
+            slot.released = true;
+            break;
+        case State::WARM:
+            outstanding_ -= slot.bytes;
+            slot.state = State::FREE;
+            free_slots_.push_back(index);
+            break;
+        case State::FREE:
+            break;
+    }
+}
+
+size_t Prefetcher::outstandingBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return outstanding_;
+}
+
+void Prefetcher::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+void Prefetcher::run() {
+    std::string path;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        ready_.wait(lock, [this]() { return stopping_ || !queued_.empty(); });
+        if (stopping_) {
+            return;
+        }
+
+        // Oldest queued hint first; released hints have already left the queue
+        uint32_t index = queued_.front();
+        queued_.erase(queued_.begin());
+        Slot& slot = slots_[index];
+        slot.state = State::RUNNING;
+        path.assign(slot.path);
+        size_t reserved = slot.bytes;
+
+        lock.unlock();
+        size_t bytes = warm(path, reserved);
+        lock.lock();
+
+        outstanding_ -= reserved - bytes;
+        if (slot.released) {
+            outstanding_ -= bytes;
+            slot.state = State::FREE;
+            free_slots_.push_back(index);
+        } else {
+            slot.bytes = bytes;
+            slot.state = State::WARM;
+        }
+        if (metrics_ && bytes > 0) {
+            metrics_->prefetch_images.inc();
+            metrics_->prefetch_bytes.inc(bytes);
+        }
+    }
+}
+
+Prefetcher::OpenFile::~OpenFile() {
+    ::close(fd);
+}
+
+size_t Prefetcher::warm(const std::string& path, size_t limit) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0; // the worker reports the missing file
+    }
+    auto file = std::make_shared<OpenFile>(fd);
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+        return 0;
+    }
+    const size_t file_size = static_cast<size_t>(info.st_size);
+
+    size_t header = std::min({kHeaderReadahead, file_size, limit});
+    ::posix_fadvise(fd, 0, static_cast<off_t>(header), POSIX_FADV_WILLNEED);
+    size_t bytes = header;
+
+    try {
+        // Parsing faults the header pages in; then read ahead the first
+        // blocks of each image segment in file order (for blocked images, the
+        // top row of tiles) until the image's share of the budget is used
+        NitfReader reader(path);
+        for (size_t i = 0; i < reader.imageCount() && bytes < limit; ++i) {
+            const NitfImageInfo& image = reader.image(i);
+            size_t start = std::max(image.data_offset, header);
+            size_t end = std::min(image.data_offset + image.data_length, file_size);
+            if (start >= end) {
+                continue;
+            }
+            size_t length = std::min(end - start, limit - bytes);
+            readAhead(file, start, length);
+            bytes += length;
+        }
+    } catch (const std::exception& e) {
+        // Not something NitfReader understands: read ahead from the start
+        SAR_LOG_DEBUG("Prefetching " + path + " without headers: " + std::string(e.what()));
+        if (header < file_size && bytes < limit) {
+            size_t length = std::min(file_size - header, limit - bytes);
+            readAhead(file, header, length);
+            bytes += length;
+        }
+    }
+
+    if (io_) {
+        io_->submit();
+    }
+    return bytes;
+}
+
+void Prefetcher::readAhead(const std::shared_ptr<OpenFile>& file, size_t offset, size_t length) {
+    if (io_) {
+        // Only the page cache keeps what is read; each buffer goes back
+        // when its read completes
+        while (length > 0) {
+            auto buffer = std::make_shared<AsyncFileIO::Buffer>(io_->acquireBuffer());
+            if (!*buffer) {
+                break;
+            }
+            size_t chunk = std::min(length, buffer->capacity());
+            io_->read(file->fd, *buffer, chunk, offset, [file, buffer](ssize_t) {});
+            offset += chunk;
+            length -= chunk;
+        }
+    }
+    if (length > 0) {
+        ::posix_fadvise(file->fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+    }
+}
+
+} // namespace sar_atr
@@ -0,0 +1,210 @@
+#include "result_cache.h"
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace sar_atr {
+
+bool readFileIdentity(const std::string& path, FileIdentity& identity) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    identity.device = static_cast<uint64_t>(info.st_dev);
+    identity.inode = static_cast<uint64_t>(info.st_ino);
+    identity.size = static_cast<int64_t>(info.st_size);
+    identity.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+    return true;
+}
+
+ResultCache::Claim::Claim(Claim&& other) noexcept
+    : cache_(other.cache_), kind_(other.kind_), path_(std::move(other.path_)),
+      result_(std::move(other.result_)), flight_(std::move(other.flight_)) {
+    other.kind_ = Kind::BYPASS;
+}
+
+ResultCache::Claim& ResultCache::Claim::operator=(Claim&& other) noexcept {
+    if (this != &other) {
+        cancel();
+        cache_ = other.cache_;
+        kind_ = other.kind_;
+        path_ = std::move(other.path_);
+        result_ = std::move(other.result_);
+        flight_ = std::move(other.flight_);
+        other.kind_ = Kind::BYPASS;
+    }
+    return *this;
+}
+
+void ResultCache::Claim::cancel() {
+    if (kind_ == Kind::LEAD) {
+        cache_->abandon(*this);
+    }
+}
+
+ResultCache::ResultCache(size_t capacity, std::chrono::seconds ttl, ServiceMetrics* metrics)
+    : capacity_(capacity > 0 ? capacity : 1), ttl_(ttl), metrics_(metrics) {
+    index_.reserve(capacity_ + 1);
+}
+
+ResultCache::Claim ResultCache::claim(const std::string& nitf_path) {
+    Claim claim;
+    FileIdentity identity;
+    if (!readFileIdentity(nitf_path, identity)) {
+        return claim; // let the engine report the missing file
+    }
+    claim.cache_ = this;
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = index_.find(std::string_view(nitf_path));
+    if (found != index_.end()) {
+        auto node = found->second;
+        Entry& entry = node->second;
+        lru_.splice(lru_.begin(), lru_, node);
+        if (entry.identity == identity) {
+            bool fresh = ttl_ == std::chrono::steady_clock::duration::zero() || now - entry.stored_at < ttl_;
+            if (entry.result && fresh) {
+                claim.kind_ = Claim::Kind::HIT;
+                claim.result_ = entry.result;
+                if (metrics_) {
+                    metrics_->result_cache_hits.inc();
+                }
+                return claim;
+            }
+            if (entry.flight) {
+                claim.kind_ = Claim::Kind::FOLLOW;
+                claim.flight_ = entry.flight;
+                if (metrics_) {
+                    metrics_->result_cache_coalesced.inc();
+                }
+                return claim;
+            }
+        }
+        // Expired, or the file changed since: start over. A leader still
+        // running for the old file keeps serving its own followers but no
+        // longer fills this entry.
+        entry.identity = identity;
+        entry.result.reset();
+        entry.flight = std::make_shared<Flight>();
+        claim.flight_ = entry.flight;
+    } else {
+        lru_.emplace_front(nitf_path, Entry{});
+        Entry& entry = lru_.front().second;
+        entry.identity = identity;
+        entry.flight = std::make_shared<Flight>();
+        claim.flight_ = entry.flight;
+        index_.emplace(std::string_view(lru_.front().first), lru_.begin());
+        evictLocked();
+    }
+    claim.kind_ = Claim::Kind::LEAD;
+    claim.path_ = nitf_path;
+    if (metrics_) {
+        metrics_->result_cache_misses.inc();
+    }
+    return claim;
+}
+
+void ResultCache::restore(Claim& claim, DetectionList& detections, DetectionBatch& candidates) {
+    std::shared_ptr<const Result> result = claim.result_;
+    if (!result) {
+        if (!claim.flight_) {
+            throw std::logic_error("ResultCache::restore() needs a HIT or FOLLOW claim");
+        }
+        result = claim.flight_->result.get(); // rethrows if the leader gave up
+    }
+    // Copies land in the destination's memory resource (the image's arena)
+    detections.assign(result->detections.begin(), result->detections.end());
+    candidates.assign(result->candidates);
+}
+
+void ResultCache::fill(Claim& claim, const DetectionList& detections, const DetectionBatch& candidates) {
+    if (!claim.leads()) {
+        return;
+    }
+    auto result = std::make_shared<Result>();
+    result->detections.assign(detections.begin(), detections.end());
+    result->candidates.assign(candidates);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(std::string_view(claim.path_));
+        if (found != index_.end() && found->second->second.flight == claim.flight_) {
+            Entry& entry = found->second->second;
+            entry.result = result;
+            entry.flight.reset();
+            entry.stored_at = std::chrono::steady_clock::now();
+            evictLocked();
+        }
+    }
+    claim.flight_->promise.set_value(result);
+    claim.kind_ = Claim::Kind::HIT;
+    claim.result_ = std::move(result);
+    claim.flight_.reset();
+}
+
+void ResultCache::share(Claim& claim, const DetectionList& detections, const DetectionBatch& candidates) {
+    if (!claim.leads()) {
+        return;
+    }
+    auto result = std::make_shared<Result>();
+    result->detections.assign(detections.begin(), detections.end());
+    result->candidates.assign(candidates);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(std::string_view(claim.path_));
+        if (found != index_.end() && found->second->second.flight == claim.flight_) {
+            auto node = found->second;
+            index_.erase(found);
+            lru_.erase(node);
+        }
+    }
+    claim.flight_->promise.set_value(std::move(result));
+    claim.kind_ = Claim::Kind::BYPASS;
+    claim.flight_.reset();
+}
+
+void ResultCache::abandon(Claim& claim) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(std::string_view(claim.path_));
+        if (found != index_.end() && found->second->second.flight == claim.flight_) {
+            auto node = found->second;
+            index_.erase(found);
+            lru_.erase(node);
+        }
+    }
+    claim.flight_->promise.set_exception(
+        std::make_exception_ptr(std::runtime_error("Shared inference for " + claim.path_ + " failed")));
+    claim.kind_ = Claim::Kind::BYPASS;
+    claim.flight_.reset();
+}
+
+void ResultCache::evictLocked() {
+    // Entries still in flight have followers waiting on them and stay
+    auto node = lru_.end();
+    while (index_.size() > capacity_ && node != lru_.begin()) {
+        --node;
+        if (node->second.flight) {
+            continue;
+        }
+        index_.erase(std::string_view(node->first));
+        node = lru_.erase(node);
+        if (metrics_) {
+            metrics_->result_cache_evictions.inc();
+        }
+    }
+}
+
+size_t ResultCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    lru_.clear();
+}
+
+} // namespace sar_atr
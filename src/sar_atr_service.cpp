@@ -1,25 +1,127 @@
 #include "sar_atr_service.h"
 #include "logger.h"
 #include <chrono>
+#include <iomanip>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
 
 namespace sar_atr {
 
+namespace {
+
+// Outbound topics; OutboundMessage only keeps a view of the name
+constexpr std::string_view kEntityTopic = "Entity_uci";
+constexpr std::string_view kProductMetadataTopic = "ProductMetadata_uci";
+constexpr std::string_view kProductLocationTopic = "ProductLocation_uci";
+constexpr std::string_view kAtrProcessingResultTopic = "AtrProcessingResult_uci";
+
+} // namespace
+
 SarAtrService::SarAtrService(const ServiceConfig& config,
                              std::shared_ptr<InferenceEngine> inference_engine)
     : config_(config),
-      inference_engine_(inference_engine),
-      running_(false) {
+      running_(false),
+      reload_requested_(false),
+      stop_requested_(false),
+      system_info_{config.system_uuid, config.system_description, config.service_version},
+      uci_serializer_(system_info_),
+      image_pool_(static_cast<size_t>(config.job_queue_capacity) + 3 * static_cast<size_t>(config.stage_queue_capacity)),
+      next_sequence_(0),
+      parse_queue_(static_cast<size_t>(config.stage_queue_capacity)),
+      job_queue_(static_cast<size_t>(config.job_queue_capacity)),
+      serialize_queue_(static_cast<size_t>(config.stage_queue_capacity)),
+      publish_queue_(static_cast<size_t>(config.stage_queue_capacity)),
+      release_requested_(false),
+      receive_paused_(false) {
     
-    // Set up system info from config
-    system_info_.system_uuid = config.system_uuid;
-    system_info_.system_description = config.system_description;
-    system_info_.service_version = config.service_version;
+    // Engines are warm before the service subscribes
+    if (inference_engine) {
+        engines_.adopt("default", std::move(inference_engine));
+    } else {
+        engines_.load(config);
+    }
     
     // Create AMQ client
-    amq_client_ = std::make_unique<AMQClient>();
+    amq_pool_ = std::make_unique<AMQConnectionPool>(static_cast<size_t>(config.publish_connections),
+                                                    parseShardPolicy(config.publish_shard_by));
+    
+    SendOptions send_options;
+    send_options.high_water_bytes = static_cast<size_t>(config.send_high_water_bytes);
+    send_options.block_timeout = std::chrono::milliseconds(config.send_block_timeout_ms);
+    send_options.flush_timeout = std::chrono::milliseconds(config.send_flush_timeout_ms);
+    send_options.linger = std::chrono::microseconds(config.publish_linger_us);
+    send_options.receipts = config.publish_receipts;
+    amq_pool_->setSendOptions(send_options);
+    
+    connection_options_.connect_timeout = std::chrono::milliseconds(config.connect_timeout_ms);
+    connection_options_.heartbeat_interval = std::chrono::milliseconds(config.heartbeat_interval_ms);
+    connection_options_.reconnect = config.reconnect_enabled;
+    connection_options_.reconnect_initial_delay = std::chrono::milliseconds(config.reconnect_initial_ms);
+    connection_options_.reconnect_max_delay = std::chrono::milliseconds(config.reconnect_max_ms);
+    amq_pool_->setConnectionOptions(connection_options_);
+    amq_pool_->setMetrics(&metrics_);
+    
+    if (config.tiling_enabled) {
+        // Engines without tile support get whole images (a reload may add some that have it)
+        TilingOptions tiling;
+        tiling.tile_size = config.tile_size;
+        tiling.overlap = config.tile_overlap;
+        tiling.threads = config.tile_threads;
+        tiling.merge_overlap_threshold = config.tile_merge_threshold;
+        tiler_ = std::make_unique<TiledInferenceRunner>(tiling);
+        if (!engines_.defaultEngine()->engine->supportsTiling()) {
+            Logger::warning("tiling_enabled is set but the default inference engine does not support tiles; "
+                            "processing whole images");
+        }
+    }
+    
+    nms_options_.method = parseNmsMethod(config.nms_method);
+    nms_options_.iou_threshold = config.nms_iou_threshold;
+    nms_options_.sigma = config.nms_sigma;
+    
+    chip_options_.output_dir = config.chip_output_dir;
+    chip_options_.write_nitf = config.chip_format == "nitf";
+    chip_options_.padding = config.chip_padding;
+    chip_options_.min_size = config.chip_min_size;
+    chip_options_.max_size = config.chip_max_size;
+    chip_options_.threads = config.chip_threads;
+    chip_options_.direct_io = config.chip_direct_io;
+    
+    if (config.chip_extraction_enabled || config.prefetch_enabled) {
+        AsyncIoOptions io;
+        io.use_io_uring = config.io_uring_enabled;
+        io.queue_depth = static_cast<unsigned>(config.io_queue_depth);
+        io.buffer_count = static_cast<size_t>(config.io_buffer_count);
+        io.buffer_size = static_cast<size_t>(config.io_buffer_kb) * 1024;
+        io.fallback_threads = config.io_threads;
+        file_io_ = AsyncFileIO::create(io, &metrics_);
+        Logger::info(std::string("File I/O backend: ") + file_io_->backend());
+    }
+    
+    if (config.chip_extraction_enabled) {
+        chip_extractor_ = std::make_unique<ChipExtractor>(chip_options_, file_io_.get());
+    }
+    
+    if (config.result_cache_enabled) {
+        result_cache_ = std::make_unique<ResultCache>(static_cast<size_t>(config.result_cache_entries),
+                                                      std::chrono::seconds(config.result_cache_ttl_s), &metrics_);
+    }
+    
+    if (config.prefetch_enabled) {
+        // One slot per job the queue can hold, plus the ones parse threads are pushing
+        constexpr size_t kMiB = 1024 * 1024;
+        prefetcher_ = std::make_unique<Prefetcher>(
+            job_queue_.capacity() + static_cast<size_t>(config.parse_threads) + 1,
+            static_cast<size_t>(config.prefetch_image_mb) * kMiB,
+            static_cast<size_t>(config.prefetch_budget_mb) * kMiB, config.prefetch_threads, &metrics_,
+            file_io_.get());
+    }
+    
+    if (config.metrics_enabled) {
+        metrics_server_ = std::make_unique<MetricsServer>(config.metrics_bind_address, config.metrics_port,
+                                                          [this]() { return renderMetrics(); });
+    }
 }
 
 void SarAtrService::start() {
@@ -30,24 +132,39 @@ void SarAtrService::start() {
     Logger::info("System UUID: " + config_.system_uuid);
     Logger::info("Confidence Threshold: " + std::to_string(config_.confidence_threshold));
     
-    // Retry connection logic
+    // Scrapes work while we are still connecting
+    if (metrics_server_) {
+        metrics_server_->start();
+    }
+    
+    // Workers must be ready before the subscription starts delivering messages
+    startWorkers();
+    
+    // Startup gives up after a few attempts (backing off like reconnects do);
+    // once connected, the connections re-establish themselves
     const int max_retries = 5;
-    const int retry_delay_ms = 2000; // 2 seconds
     
     for (int attempt = 1; attempt <= max_retries; ++attempt) {
+        if (stop_requested_) {
+            Logger::info("Received interrupt signal while connecting, shutting down...");
+            stop();
+            return;
+        }
         try {
             Logger::info("Connection attempt " + std::to_string(attempt) + " of " + std::to_string(max_retries));
             
             // Connect to broker
-            amq_client_->connect(config_.broker_address);
+            amq_pool_->connect(config_.broker_addresses);
             Logger::info("Connected to message broker");
             
-            // Subscribe to FileLocation_uci
-            Logger::info("Subscribing to FileLocation_uci topic");
-            amq_client_->subscribe("FileLocation_uci", 
-                [this](const std::string& message) {
-                    this->handleFileLocationMessage(message);
-                });
+            // Subscribe to every topic FileLocation requests come in on
+            for (const RequestTopic& request_topic : config_.request_topics) {
+                Logger::info("Subscribing to " + request_topic.topic + " topic");
+                amq_pool_->subscribe(request_topic.topic,
+                    [this, &request_topic](std::string_view message) {
+                        this->handleFileLocationMessage(message, request_topic);
+                    });
+            }
             
             running_ = true;
             
@@ -57,6 +174,14 @@ void SarAtrService::start() {
             
             // Keep service running
             while (running_) {
+                if (stop_requested_) {
+                    Logger::info("Received interrupt signal, shutting down...");
+                    stop();
+                    break;
+                }
+                if (reload_requested_.exchange(false)) {
+                    reloadEngines();
+                }
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
             
@@ -66,11 +191,29 @@ void SarAtrService::start() {
         } catch (const std::exception& e) {
             Logger::error("Connection attempt " + std::to_string(attempt) + " failed: " + std::string(e.what()));
             
+            // Start the next attempt from scratch (e.g. connected but the subscription failed)
+            amq_pool_->disconnect();
+            
+            if (stop_requested_) {
+                Logger::info("Received interrupt signal while connecting, shutting down...");
+                stop();
+                return;
+            }
             if (attempt < max_retries) {
-                Logger::info("Retrying in " + std::to_string(retry_delay_ms / 1000) + " seconds...");
-                std::this_thread::sleep_for(std::chrono::milliseconds(retry_delay_ms));
+                auto delay = reconnectDelay(connection_options_, static_cast<unsigned>(attempt - 1));
+                Logger::info("Retrying in " + std::to_string(delay.count()) + " ms...");
+                // In slices, so a stop request does not wait out the backoff
+                auto retry_at = std::chrono::steady_clock::now() + delay;
+                while (!stop_requested_ && std::chrono::steady_clock::now() < retry_at) {
+                    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        retry_at - std::chrono::steady_clock::now(), std::chrono::milliseconds(100)));
+                }
             } else {
                 Logger::error("Failed to connect after " + std::to_string(max_retries) + " attempts");
+                stopWorkers();
+                if (metrics_server_) {
+                    metrics_server_->stop();
+                }
                 throw std::runtime_error("Failed to start service after multiple connection attempts");
             }
         }
@@ -81,8 +224,15 @@ void SarAtrService::stop() {
     Logger::info("Stopping SAR ATR service");
     running_ = false;
     
-    if (amq_client_) {
-        amq_client_->disconnect();
+    // Finish queued work while the broker connection is still up
+    stopWorkers();
+    
+    if (amq_pool_) {
+        amq_pool_->disconnect();
+    }
+    
+    if (metrics_server_) {
+        metrics_server_->stop();
     }
     
     Logger::info("Service stopped");
@@ -92,221 +242,883 @@ bool SarAtrService::isRunning() const {
     return running_;
 }
 
-void SarAtrService::handleFileLocationMessage(const std::string& message) {
-    Logger::info("========================================");
-    Logger::info("Received FileLocation_uci message");
-    
+void SarAtrService::requestEngineReload() {
+    reload_requested_ = true;
+}
+
+void SarAtrService::requestStop() {
+    stop_requested_ = true;
+}
+
+void SarAtrService::reloadEngines() {
+    Logger::info("Reloading inference engines from " + config_.config_path);
     try {
-        // Parse the message to extract file path
-        std::string nitf_path = parseFileLocationMessage(message);
-        Logger::info("Extracted NITF file path: " + nitf_path);
+        if (config_.config_path.empty()) {
+            throw std::runtime_error("the service was not configured from a file");
+        }
+        // Only the engine settings take effect; everything else needs a restart
+        ServiceConfig reloaded = ConfigManager::loadConfig(config_.config_path);
+        size_t built = engines_.load(reloaded);
+        
+        // Cached results may come from an engine that was just replaced or rerouted
+        if (result_cache_) {
+            result_cache_->clear();
+        }
+        metrics_.engine_reloads.inc();
         
+        std::string names;
+        for (const auto& name : engines_.names()) {
+            names += (names.empty() ? "" : ", ") + name;
+        }
+        Logger::info("Inference engines reloaded (" + std::to_string(built) + " rebuilt): " + names);
+    } catch (const std::exception& e) {
+        metrics_.engine_reload_failures.inc();
+        Logger::error("Engine reload failed, keeping the running engines: " + std::string(e.what()));
+    }
+}
+
+void SarAtrService::startWorkers() {
+    if (!workers_.empty()) {
+        return;
+    }
+    
+    Logger::info("Starting " + std::to_string(config_.worker_threads) + " inference worker(s), queue capacity " +
+                 std::to_string(job_queue_.capacity()) + "; " + std::to_string(config_.parse_threads) + " parse, " +
+                 std::to_string(config_.serialize_threads) + " serialize, " +
+                 std::to_string(config_.publish_threads) + " publish thread(s)");
+    
+    for (int i = 0; i < config_.parse_threads; ++i) {
+        parse_workers_.emplace_back([this, i]() {
+            parseLoop(i);
+        });
+    }
+    for (int i = 0; i < config_.worker_threads; ++i) {
+        workers_.emplace_back([this, i]() {
+            workerLoop(i);
+        });
+    }
+    for (int i = 0; i < config_.serialize_threads; ++i) {
+        serialize_workers_.emplace_back([this, i]() {
+            serializeLoop(i);
+        });
+    }
+    for (int i = 0; i < config_.publish_threads; ++i) {
+        publish_workers_.emplace_back([this, i]() {
+            publishLoop(i);
+        });
+    }
+}
+
+namespace {
+
+/// Close a stage's queue, let its threads drain it, and join them
+template <typename Queue>
+void drainStage(Queue& queue, std::vector<std::thread>& threads) {
+    queue.close();
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads.clear();
+}
+
+} // namespace
+
+void SarAtrService::stopWorkers() {
+    if (workers_.empty()) {
+        return;
+    }
+    
+    size_t pending = parse_queue_.size() + job_queue_.size() + serialize_queue_.size() + publish_queue_.size();
+    if (pending > 0) {
+        Logger::info("Waiting for " + std::to_string(pending) + " queued job(s) to finish");
+    }
+    
+    // Front to back, so each stage only stops once nothing more can reach it
+    drainStage(parse_queue_, parse_workers_);
+    drainStage(job_queue_, workers_);
+    if (prefetcher_) {
+        prefetcher_->shutdown();
+    }
+    if (tiler_) {
+        tiler_->shutdown();
+    }
+    drainStage(serialize_queue_, serialize_workers_);
+    if (chip_extractor_) {
+        chip_extractor_->shutdown();
+    }
+    if (file_io_) {
+        file_io_->shutdown();
+    }
+    drainStage(publish_queue_, publish_workers_);
+    
+    // Every sequence is put or skipped, so this only catches accounting slips
+    PublishJob held;
+    while (reorder_.popAny(held)) {
+        Logger::warning("Publishing " + held.image->nitf_path + " out of order at shutdown");
+        publishResults(held);
+    }
+}
+
+void SarAtrService::parseLoop(int worker_id) {
+    SAR_LOG_DEBUG("Parse thread " + std::to_string(worker_id) + " started");
+    
+    ReceivedMessage message;
+    while (parse_queue_.pop(message)) {
+        if (receive_paused_.load()) {
+            resumeReceive();
+        }
+        metrics_.stage(PipelineStage::PARSE_WAIT).record(std::chrono::steady_clock::now() - message.received_at);
+        std::string_view body = message.image->request;
+        parseMessage(message.sequence, body, std::move(message.image), *message.topic);
+    }
+    
+    SAR_LOG_DEBUG("Parse thread " + std::to_string(worker_id) + " stopped");
+}
+
+void SarAtrService::workerLoop(int worker_id) {
+    SAR_LOG_DEBUG("Inference worker " + std::to_string(worker_id) + " started");
+    
+    const size_t batch_size = static_cast<size_t>(config_.inference_batch_size);
+    const auto batch_wait = std::chrono::milliseconds(config_.inference_batch_wait_ms);
+    
+    std::vector<InferenceJob> jobs;
+    while (job_queue_.popBatch(jobs, batch_size, batch_wait)) {
+        if (receive_paused_.load()) {
+            resumeReceive();
+        }
+        processJobs(jobs);
+    }
+    
+    SAR_LOG_DEBUG("Inference worker " + std::to_string(worker_id) + " stopped");
+}
+
+void SarAtrService::serializeLoop(int worker_id) {
+    SAR_LOG_DEBUG("Serialize thread " + std::to_string(worker_id) + " started");
+    
+    SerializeJob job;
+    while (serialize_queue_.pop(job)) {
+        serializeResults(job);
+    }
+    
+    SAR_LOG_DEBUG("Serialize thread " + std::to_string(worker_id) + " stopped");
+}
+
+void SarAtrService::publishLoop(int worker_id) {
+    SAR_LOG_DEBUG("Publish thread " + std::to_string(worker_id) + " started");
+    
+    PublishJob job;
+    while (publish_queue_.pop(job)) {
+        publishInOrder(std::move(job));
+    }
+    
+    SAR_LOG_DEBUG("Publish thread " + std::to_string(worker_id) + " stopped");
+}
+
+void SarAtrService::handleFileLocationMessage(std::string_view message, const RequestTopic& topic) {
+    SAR_LOG_INFO("Received FileLocation message on " + topic.topic);
+    metrics_.messages_received.inc();
+    
+    // Numbered on arrival: this is the order ordered_output publishes in
+    uint64_t sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed) + 1;
+    
+    if (config_.parse_threads == 0) {
+        parseMessage(sequence, message, image_pool_.acquire(), topic);
+        return;
+    }
+    
+    // The body lives in the socket buffer, so the parse thread gets its own copy
+    ReceivedMessage received;
+    received.sequence = sequence;
+    received.image = image_pool_.acquire();
+    received.image->request.assign(message.data(), message.size());
+    received.topic = &topic;
+    received.received_at = std::chrono::steady_clock::now();
+    
+    // Never waits: the event loop also flushes every connection's sends,
+    // which the stages behind this queue may be blocked on
+    if (!parse_queue_.tryPush(std::move(received))) {
+        holdReceived(received);
+    }
+}
+
+void SarAtrService::holdReceived(InferenceJob& job) {
+    std::lock_guard<std::mutex> lock(held_mutex_);
+    // Paused before the retry: a consumer that takes a job after the retry
+    // sees the pause, one that took it before left room for the retry
+    receive_paused_.store(true);
+    if (job_queue_.tryPush(std::move(job))) {
+        receive_paused_.store(false);
+        return;
+    }
+    held_job_ = std::move(job);
+    metrics_.receive_pauses.inc();
+    SAR_LOG_DEBUG("Job queue full (" + std::to_string(job_queue_.capacity()) +
+                  " jobs), pausing FileLocation deliveries");
+    amq_pool_->pauseReading(true);
+}
+
+void SarAtrService::holdReceived(ReceivedMessage& message) {
+    std::lock_guard<std::mutex> lock(held_mutex_);
+    receive_paused_.store(true);
+    if (parse_queue_.tryPush(std::move(message))) {
+        receive_paused_.store(false);
+        return;
+    }
+    held_message_ = std::move(message);
+    metrics_.receive_pauses.inc();
+    SAR_LOG_DEBUG("Parse queue full (" + std::to_string(parse_queue_.capacity()) +
+                  " messages), pausing FileLocation deliveries");
+    amq_pool_->pauseReading(true);
+}
+
+void SarAtrService::resumeReceive() {
+    std::lock_guard<std::mutex> lock(held_mutex_);
+    if (!receive_paused_.load()) {
+        return;
+    }
+    bool queued = config_.parse_threads == 0 ? job_queue_.tryPush(std::move(held_job_))
+                                             : parse_queue_.tryPush(std::move(held_message_));
+    if (!queued) {
+        return;
+    }
+    receive_paused_.store(false);
+    SAR_LOG_DEBUG("Queue drained, resuming FileLocation deliveries");
+    amq_pool_->pauseReading(false);
+}
+
+void SarAtrService::parseMessage(uint64_t sequence, std::string_view message, ImageLease image,
+                                 const RequestTopic& topic) {
+    try {
+        // Parse the message to extract file path; the fast path copies it
+        // straight into the pooled image's buffer
+        StageTimer timer(&metrics_, PipelineStage::PARSE);
+        std::string_view address;
+        if (findFileLocationAddress(message, address)) {
+            image->nitf_path.assign(address.data(), address.size());
+        } else {
+            image->nitf_path = parseFileLocationJson(message); // the scan already failed
+        }
+    } catch (const std::exception& e) {
+        metrics_.parse_failures.inc();
+        Logger::error("Error processing FileLocation message: " + std::string(e.what()));
+        skipSequence(sequence);
+        return;
+    }
+    SAR_LOG_INFO("Extracted NITF file path: " + image->nitf_path);
+    
+    InferenceJob job;
+    job.sequence = sequence;
+    job.image = std::move(image);
+    job.enqueued_at = std::chrono::steady_clock::now();
+    job.priority = topic.priority;
+    job.due = job.enqueued_at;
+    if (topic.deadline_ms > 0) {
+        // Counted from when the request was issued, as far as the clocks agree
+        const auto allowed = std::chrono::milliseconds(topic.deadline_ms);
+        std::chrono::steady_clock::duration age{0};
+        std::chrono::system_clock::time_point issued;
+        if (findFileLocationTimestamp(message, issued)) {
+            auto since = std::chrono::system_clock::now() - issued;
+            age = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::clamp<std::chrono::system_clock::duration>(since, std::chrono::system_clock::duration::zero(),
+                                                                allowed));
+        }
+        job.deadline = job.enqueued_at + allowed - age;
+        job.due = job.deadline;
+        if (age >= allowed) {
+            shedJob(job, "past its deadline on arrival");
+            return;
+        }
+    }
+    if (prefetcher_) {
+        job.prefetch_ticket = prefetcher_->hint(job.image->nitf_path);
+    }
+    
+    // A full queue makes room by shedding the job that would run last, if
+    // this one is more urgent; otherwise a parse thread waits for space for
+    // at most enqueue_timeout_ms. The event loop thread (no parse threads)
+    // never waits, as it also flushes the sends the workers may be blocked
+    // on: it holds the job and stops reading until a worker makes room.
+    InferenceJob displaced;
+    bool displacing = false;
+    bool queued = job_queue_.tryPushDisplacing(std::move(job), displaced, displacing);
+    if (!queued && config_.parse_threads > 0 && config_.enqueue_timeout_ms > 0) {
+        queued = job_queue_.pushFor(std::move(job), std::chrono::milliseconds(config_.enqueue_timeout_ms));
+    }
+    if (displacing) {
+        if (prefetcher_) {
+            prefetcher_->release(displaced.prefetch_ticket);
+        }
+        shedJob(displaced, "displaced by a more urgent request");
+    }
+    if (!queued && config_.parse_threads == 0) {
+        holdReceived(job);
+        return;
+    }
+    
+    if (!queued) {
+        if (prefetcher_) {
+            prefetcher_->release(job.prefetch_ticket);
+        }
+        metrics_.jobs_dropped.inc();
+        Logger::error("Job queue full (" + std::to_string(job_queue_.capacity()) +
+                      " jobs), dropping FileLocation for: " + job.image->nitf_path);
+        skipSequence(sequence);
+        return;
+    }
+    
+    SAR_LOG_DEBUG("Queued FileLocation " + std::to_string(sequence) + " (queue depth: " +
+                  std::to_string(job_queue_.size()) + ")");
+}
+
+void SarAtrService::processJobs(std::vector<InferenceJob>& jobs) {
+    // Jobs waiting on another request's inference, finished after this batch
+    thread_local std::vector<InferenceJob> following;
+    
+    // Large images are tiled on their own; only whole-image jobs are batched.
+    // Compacted in place so the worker's vector is the only one.
+    const auto now = std::chrono::steady_clock::now();
+    size_t batched = 0;
+    for (auto& job : jobs) {
+        // From here the worker is reading the file itself
+        if (prefetcher_) {
+            prefetcher_->release(job.prefetch_ticket);
+        }
+        // Before the cache: a shed job must never lead other requests
+        if (!admit(job, now)) {
+            continue;
+        }
+        if (result_cache_) {
+            job.cached = result_cache_->claim(job.image->nitf_path);
+            if (job.cached.hit()) {
+                finishCached(std::move(job));
+                continue;
+            }
+            if (job.cached.follows()) {
+                following.push_back(std::move(job));
+                continue;
+            }
+        }
+        job.engine = engines_.route(job.image->nitf_path, job.image->geometry);
+        if (job.degraded) {
+            degrade(job);
+        }
+        if (wouldTile(*job.engine->engine, *job.image)) {
+            processJob(job);
+        } else {
+            if (&jobs[batched] != &job) {
+                jobs[batched] = std::move(job);
+            }
+            batched++;
+        }
+    }
+    jobs.resize(batched);
+    
+    // One engine call per engine: gather each engine's jobs, in arrival order
+    size_t begin = 0;
+    while (begin < batched) {
+        const EngineRegistry::Engine* engine = jobs[begin].engine.get();
+        size_t end = begin + 1;
+        for (size_t i = end; i < batched; ++i) {
+            if (jobs[i].engine.get() == engine) {
+                if (i != end) {
+                    std::swap(jobs[i], jobs[end]);
+                }
+                end++;
+            }
+        }
+        runBatch(&jobs[begin], end - begin);
+        begin = end;
+    }
+    
+    // This worker's own leads are done by now, so waiting cannot deadlock
+    // (e.g. on a second copy of an image in the same batch)
+    for (auto& job : following) {
+        finishCached(std::move(job));
+    }
+    following.clear();
+}
+
+bool SarAtrService::admit(InferenceJob& job, std::chrono::steady_clock::time_point now) {
+    if (now > job.deadline) {
+        shedJob(job, "past its deadline");
+        return false;
+    }
+    if (config_.queue_slo_ms > 0 && now - job.enqueued_at > std::chrono::milliseconds(config_.queue_slo_ms)) {
+        if (config_.overload_action == "shed") {
+            shedJob(job, "queued past the SLO");
+            return false;
+        }
+        job.degraded = true;
+    }
+    return true;
+}
+
+void SarAtrService::degrade(InferenceJob& job) {
+    const EngineRegistry::Engine* routed = job.engine.get();
+    if (!config_.degraded_engine.empty()) {
+        // Missing only when a reload dropped it; the routed engine then stays
+        if (auto faster = engines_.find(config_.degraded_engine)) {
+            job.engine = std::move(faster);
+        }
+    }
+    bool coarser = config_.degraded_tile_overlap != config_.tile_overlap && wouldTile(*job.engine->engine, *job.image);
+    if (job.engine.get() == routed && !coarser) {
+        // Nothing cheaper to run it on: it runs as it is
+        job.degraded = false;
+        return;
+    }
+    
+    metrics_.jobs_degraded.inc();
+    SAR_LOG_INFO("Degrading " + job.image->nitf_path + " (queued past the SLO) to engine '" +
+                 job.engine->config.name + "'" +
+                 (coarser ? ", tile overlap " + std::to_string(config_.degraded_tile_overlap) : std::string()));
+}
+
+void SarAtrService::shedJob(InferenceJob& job, const char* reason) {
+    auto queued = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                        job.enqueued_at);
+    metrics_.jobs_shed.inc();
+    Logger::warning("Shedding FileLocation for " + job.image->nitf_path + " (" + reason + ", queued " +
+                    std::to_string(queued.count()) + " ms)");
+    skipSequence(job.sequence);
+}
+
+void SarAtrService::runBatch(InferenceJob* jobs, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1) {
+        processJob(jobs[0]);
+        return;
+    }
+    
+    // Each worker keeps its item vector between batches
+    thread_local std::vector<BatchItem> items;
+    items.clear();
+    for (size_t i = 0; i < count; ++i) {
+        items.push_back({&jobs[i].image->nitf_path, &jobs[i].image->detections, &jobs[i].image->candidates});
+    }
+    
+    const EngineRegistry::Engine& engine = *jobs[0].engine;
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Passing batch of " + std::to_string(count) + " files to SAR ATR inference engine '" +
+                 engine.config.name + "'");
+    
+    auto start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        metrics_.stage(PipelineStage::QUEUE_WAIT).record(start_time - jobs[i].enqueued_at);
+    }
+    
+    try {
+        engine.engine->processBatch(items);
+    } catch (const std::exception& e) {
+        // One bad image should not cost the rest of the batch
+        Logger::error("Batch inference failed (" + std::string(e.what()) + "), retrying images individually");
+        for (size_t i = 0; i < count; ++i) {
+            jobs[i].image->detections.clear();
+            jobs[i].image->candidates.clear();
+            processJob(jobs[i]);
+        }
+        return;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+    
+    for (size_t i = 0; i < count; ++i) {
+        // Every image in the batch waited for the whole engine call
+        metrics_.stage(PipelineStage::INFERENCE).record(elapsed);
+        finishInference(std::move(jobs[i]), duration);
+    }
+    
+    SAR_LOG_INFO("========================================");
+}
+
+void SarAtrService::processJob(InferenceJob& job) {
+    SAR_LOG_INFO("========================================");
+    
+    const std::string& nitf_path = job.image->nitf_path;
+    std::chrono::steady_clock::duration elapsed;
+    try {
         // Process with inference engine
-        Logger::info("Passing file to SAR ATR inference engine");
-        auto start_time = std::chrono::high_resolution_clock::now();
+        auto start_time = std::chrono::steady_clock::now();
+        auto queue_wait = start_time - job.enqueued_at;
+        metrics_.stage(PipelineStage::QUEUE_WAIT).record(queue_wait);
+        SAR_LOG_INFO("Passing file to SAR ATR inference engine '" + job.engine->config.name + "': " + nitf_path +
+                     " (queued " +
+                     std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(queue_wait).count()) +
+                     " ms)");
         
-        std::vector<DetectionResult> detections = inference_engine_->process(nitf_path);
+        runInference(*job.engine->engine, *job.image, job.degraded);
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end_time - start_time);
+        elapsed = std::chrono::steady_clock::now() - start_time;
+        metrics_.stage(PipelineStage::INFERENCE).record(elapsed);
+        
+    } catch (const std::exception& e) {
+        metrics_.jobs_failed.inc();
+        Logger::error("Error processing " + nitf_path + ": " + std::string(e.what()));
+        job.cached.cancel();
+        skipSequence(job.sequence);
+        SAR_LOG_INFO("========================================");
+        return;
+    }
+    
+    finishInference(std::move(job), std::chrono::duration_cast<std::chrono::milliseconds>(elapsed));
+    
+    SAR_LOG_INFO("========================================");
+}
+
+void SarAtrService::runInference(InferenceEngine& engine, ImageWork& image, bool degraded) {
+    const std::string& nitf_path = image.nitf_path;
+    if (tiler_ && engine.supportsTiling()) {
+        const ImageGeometry& geometry = image.geometry.get(nitf_path);
+        if (geometry.known() && tiler_->shouldTile(geometry.cols, geometry.rows)) {
+            int overlap = degraded ? config_.degraded_tile_overlap : config_.tile_overlap;
+            tiler_->run(engine, nitf_path, geometry.cols, geometry.rows, overlap, image.detections);
+            return;
+        }
+    }
+    if (engine.emitsCandidates()) {
+        engine.processCandidates(nitf_path, image.candidates);
+    } else {
+        engine.process(nitf_path, image.detections);
+    }
+}
+
+bool SarAtrService::wouldTile(const InferenceEngine& engine, ImageWork& image) const {
+    if (!tiler_ || !engine.supportsTiling()) {
+        return false;
+    }
+    const ImageGeometry& geometry = image.geometry.get(image.nitf_path);
+    return geometry.known() && tiler_->shouldTile(geometry.cols, geometry.rows);
+}
+
+void SarAtrService::finishCached(InferenceJob job) {
+    ImageWork& image = *job.image;
+    auto start_time = std::chrono::steady_clock::now();
+    metrics_.stage(PipelineStage::QUEUE_WAIT).record(start_time - job.enqueued_at);
+    try {
+        result_cache_->restore(job.cached, image.detections, image.candidates);
+    } catch (const std::exception& e) {
+        metrics_.jobs_failed.inc();
+        Logger::error("Error processing " + image.nitf_path + ": " + std::string(e.what()));
+        skipSequence(job.sequence);
+        return;
+    }
+    SAR_LOG_INFO("Reusing inference results for unchanged image: " + image.nitf_path);
+    
+    auto waited = std::chrono::steady_clock::now() - start_time;
+    finishInference(std::move(job), std::chrono::duration_cast<std::chrono::milliseconds>(waited));
+}
+
+void SarAtrService::finishInference(InferenceJob job, std::chrono::milliseconds inference_time) {
+    // Raw engine output, before the serialize stage filters it
+    // A degraded result still serves the requests coalesced onto it, but not later ones
+    if (job.cached.leads()) {
+        if (job.degraded) {
+            result_cache_->share(job.cached, job.image->detections, job.image->candidates);
+        } else {
+            result_cache_->fill(job.cached, job.image->detections, job.image->candidates);
+        }
+    }
+    
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Inference Results: " + job.image->nitf_path);
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Total inference time: " + std::to_string(inference_time.count()) + " ms");
+    SAR_LOG_INFO("Total detections found: " +
+                 std::to_string(job.image->detections.size() + job.image->candidates.size()));
+    
+    SerializeJob next;
+    next.sequence = job.sequence;
+    next.image = std::move(job.image);
+    next.inference_time = inference_time;
+    handOffToSerialize(std::move(next));
+}
+
+void SarAtrService::handOffToSerialize(SerializeJob job) {
+    if (config_.serialize_threads == 0) {
+        serializeResults(job);
+        return;
+    }
+    uint64_t sequence = job.sequence;
+    if (!serialize_queue_.push(std::move(job))) {
+        metrics_.jobs_failed.inc();
+        Logger::error("Serialize stage stopped, dropping results");
+        skipSequence(sequence);
+    }
+}
+
+void SarAtrService::serializeResults(SerializeJob& job) {
+    ImageWork& image = *job.image;
+    try {
+        metrics_.jobs_processed.inc();
+        filterDetections(image);
+        metrics_.detections_total.inc(image.detections.size() + image.below_threshold + image.suppressed);
         
-        Logger::info("========================================");
-        Logger::info("Inference Results");
-        Logger::info("========================================");
-        Logger::info("Total inference time: " + std::to_string(duration.count()) + " ms");
-        Logger::info("Total detections found: " + std::to_string(detections.size()));
+        // Chips must be on disk before ProductLocation points at them
+        if (chip_extractor_) {
+            int chips = chip_extractor_->extract(image.nitf_path, image.detections, config_.confidence_threshold);
+            if (chips > 0) {
+                SAR_LOG_INFO("Wrote " + std::to_string(chips) + " chip(s) to " + chip_options_.output_dir);
+            }
+        }
         
-        // Process and publish results
-        processAndPublishResults(nitf_path, detections);
+        buildResultMessages(image);
         
     } catch (const std::exception& e) {
-        Logger::error("Error processing FileLocation message: " + std::string(e.what()));
+        metrics_.jobs_failed.inc();
+        Logger::error("Error processing " + image.nitf_path + ": " + std::string(e.what()));
+        skipSequence(job.sequence);
+        return;
     }
     
-    Logger::info("========================================");
+    PublishJob next;
+    next.sequence = job.sequence;
+    next.image = std::move(job.image);
+    handOffToPublish(std::move(next));
+}
+
+void SarAtrService::filterDetections(ImageWork& image) {
+    DetectionBatch& candidates = image.candidates;
+    DetectionList& detections = image.detections;
+    const bool from_list = candidates.empty();
+    if (from_list) {
+        candidates.append(detections);
+    }
+    
+    std::pmr::vector<uint32_t> selected(candidates.size(), &image.arena);
+    size_t passed = candidates.selectAbove(config_.confidence_threshold, selected.data());
+    size_t kept = suppressNonMaxima(candidates, selected.data(), passed, nms_options_,
+                                    config_.confidence_threshold, &image.arena);
+    image.below_threshold = candidates.size() - passed;
+    image.suppressed = passed - kept;
+    
+    if (!from_list) {
+        candidates.appendTo(selected.data(), kept, detections);
+        return;
+    }
+    // Compact the engine's list in place (kept indices ascend, so nothing is
+    // overwritten before it moves), keeping output paths and picking up any
+    // soft-NMS score decay
+    const float* confidence = candidates.confidence();
+    for (size_t k = 0; k < kept; ++k) {
+        uint32_t i = selected[k];
+        detections[i].confidence = confidence[i];
+        if (i != k) {
+            detections[k] = std::move(detections[i]);
+        }
+    }
+    detections.erase(detections.begin() + static_cast<std::ptrdiff_t>(kept), detections.end());
+}
+
+void SarAtrService::handOffToPublish(PublishJob job) {
+    if (config_.publish_threads == 0) {
+        publishInOrder(std::move(job));
+        return;
+    }
+    uint64_t sequence = job.sequence;
+    if (!publish_queue_.push(std::move(job))) {
+        metrics_.jobs_failed.inc();
+        Logger::error("Publish stage stopped, dropping results");
+        skipSequence(sequence);
+    }
 }
 
-void SarAtrService::processAndPublishResults(const std::string& nitf_path,
-                                              const std::vector<DetectionResult>& detections) {
-    std::vector<std::string> entity_uuids;
+void SarAtrService::publishInOrder(PublishJob job) {
+    if (!config_.ordered_output) {
+        publishResults(job);
+        return;
+    }
+    uint64_t sequence = job.sequence;
+    reorder_.put(sequence, std::move(job));
+    releaseInOrder();
+}
+
+void SarAtrService::skipSequence(uint64_t sequence) {
+    if (!config_.ordered_output) {
+        return;
+    }
+    reorder_.skip(sequence);
+    releaseInOrder();
+}
+
+void SarAtrService::releaseInOrder() {
+    release_requested_.store(true);
+    while (release_requested_.load()) {
+        std::unique_lock<std::mutex> lock(release_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return; // the releasing thread sees the request once it lets go
+        }
+        release_requested_.store(false);
+        PublishJob job;
+        while (reorder_.popReady(job)) {
+            publishResults(job);
+        }
+    }
+}
+
+void SarAtrService::buildResultMessages(ImageWork& image) {
+    const DetectionList& detections = image.detections;
+    OutboundBatch& batch = image.messages;
     int published_count = 0;
-    int filtered_count = 0;
+    int filtered_count = static_cast<int>(image.below_threshold);
     
-    Logger::info("========================================");
-    Logger::info("Detection Results");
-    Logger::info("========================================");
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Detection Results");
+    SAR_LOG_INFO("========================================");
     
-    // Process each detection
-    for (const auto& detection : detections) {
+    auto serialize_start = std::chrono::steady_clock::now();
+    
+    // One context per image: a shared timestamp and UUIDs minted together
+    size_t to_publish = detections.size();
+    // Context, UUID list and message bodies all live in the image's arena
+    ImageMessageContext context(to_publish * 2, &image.arena);
+    std::pmr::vector<std::string_view> entity_uuids(&image.arena);
+    entity_uuids.reserve(to_publish);
+    batch.reserve(to_publish * 3 + 1);
+    
+    if (image.below_threshold > 0) {
+        SAR_LOG_INFO(std::to_string(image.below_threshold) + " detection(s) below threshold, not publishing");
+    }
+    if (image.suppressed > 0) {
+        SAR_LOG_INFO(std::to_string(image.suppressed) + " duplicate detection(s) suppressed");
+    }
+    
+    // Only formatted when INFO is enabled (the SAR_LOG_* macros skip the call)
+    auto describe = [](const DetectionResult& detection) {
         std::stringstream ss;
-        ss << "Detection: " << detection.classification 
+        ss << "Detection: " << detection.classification()
            << " (confidence: " << std::fixed << std::setprecision(3) << detection.confidence << ")";
+        return ss.str();
+    };
+    
+    // Build every message for this image first, then send them in one batch
+    for (const auto& detection : detections) {
+        SAR_LOG_INFO(describe(detection) + " - Publishing");
         
-        // Check confidence threshold
-        if (detection.confidence >= config_.confidence_threshold) {
-            Logger::info(ss.str() + " - Publishing");
+        try {
+            // The serializer hands back the EntityID it generated alongside the bytes
+            UciMessage entity = uci_serializer_.entity(detection, context);
+            entity_uuids.push_back(entity.uuid);
             
-            try {
-                // Create and send Entity message
-                std::string entity_msg = createEntityMessage(detection, system_info_);
-                
-                // Extract the entity UUID from the message (we need it for AtrProcessingResult and ProductMetadata)
-                Json::Value root;
-                Json::CharReaderBuilder builder;
-                std::string errs;
-                std::istringstream iss(entity_msg);
-                std::string entity_uuid;
-                
-                if (Json::parseFromStream(builder, iss, &root, &errs)) {
-                    entity_uuid = root["Entity"]["MessageData"]["EntityID"]["UUID"].asString();
-                    entity_uuids.push_back(entity_uuid);
-                }
-                
-                amq_client_->publish("Entity_uci", entity_msg);
-                Logger::info("  └─ Published Entity_uci message for " + detection.classification + 
-                            " (Entity UUID: " + entity_uuid + ")");
-                published_count++;
-                
-                // If detection has an output file path, publish ProductMetadata and ProductLocation
-                if (!detection.output_file_path.empty()) {
-                    try {
-                        // Generate UUID for ProductMetadata
-                        std::string product_metadata_uuid = generateUUID();
-                        
-                        // Create and publish ProductMetadata message
-                        std::string product_metadata_msg = createProductMetadataMessage(
-                            product_metadata_uuid, entity_uuid, system_info_);
-                        amq_client_->publish("ProductMetadata_uci", product_metadata_msg);
-                        Logger::info("  └─ Published ProductMetadata_uci message (UUID: " + 
-                                    product_metadata_uuid + ")");
-                        
-                        // Create and publish ProductLocation message
-                        std::string product_location_msg = createProductLocationMessage(
-                            product_metadata_uuid, detection.output_file_path, system_info_);
-                        amq_client_->publish("ProductLocation_uci", product_location_msg);
-                        Logger::info("  └─ Published ProductLocation_uci message (path: " + 
-                                    detection.output_file_path + ")");
-                        
-                    } catch (const std::exception& e) {
-                        Logger::error("Failed to publish Product messages: " + std::string(e.what()));
-                    }
+            batch.emplace_back(kEntityTopic, std::move(entity.body));
+            SAR_LOG_INFO("  └─ Entity_uci message for " + std::string(detection.classification()) +
+                        " (Entity UUID: " + std::string(entity.uuid) + ")");
+            published_count++;
+            
+            // If detection has an output file path, add ProductMetadata and ProductLocation
+            if (!detection.output_file_path.empty()) {
+                try {
+                    UciMessage product_metadata = uci_serializer_.productMetadata(entity.uuid, context);
+                    std::pmr::string product_location_msg = uci_serializer_.productLocation(
+                        product_metadata.uuid, detection.output_file_path, context);
+                    
+                    batch.emplace_back(kProductMetadataTopic, std::move(product_metadata.body));
+                    SAR_LOG_INFO("  └─ ProductMetadata_uci message (UUID: " +
+                                std::string(product_metadata.uuid) + ")");
+                    
+                    batch.emplace_back(kProductLocationTopic, std::move(product_location_msg));
+                    SAR_LOG_INFO("  └─ ProductLocation_uci message (path: " +
+                                std::string(detection.output_file_path) + ")");
+                    
+                } catch (const std::exception& e) {
+                    Logger::error("Failed to create Product messages: " + std::string(e.what()));
                 }
-                
-            } catch (const std::exception& e) {
-                Logger::error("Failed to publish Entity message: " + std::string(e.what()));
             }
-        } else {
-            Logger::info(ss.str() + " - Below threshold, not publishing");
-            filtered_count++;
+            
+        } catch (const std::exception& e) {
+            Logger::error("Failed to create Entity message: " + std::string(e.what()));
         }
     }
     
-    // Publish AtrProcessingResult if we have any entities
+    // AtrProcessingResult closes the batch if we have any entities
     if (!entity_uuids.empty()) {
         try {
-            std::string atr_result_msg = createAtrProcessingResultMessage(entity_uuids);
-            amq_client_->publish("AtrProcessingResult_uci", atr_result_msg);
-            Logger::info("Published AtrProcessingResult_uci message with " + 
+            batch.emplace_back(kAtrProcessingResultTopic, UciSerializer::atrProcessingResult(entity_uuids));
+            SAR_LOG_INFO("AtrProcessingResult_uci message with " + 
                         std::to_string(entity_uuids.size()) + " entity references");
         } catch (const std::exception& e) {
-            Logger::error("Failed to publish AtrProcessingResult message: " + 
+            Logger::error("Failed to create AtrProcessingResult message: " + 
                          std::string(e.what()));
         }
     }
+    metrics_.stage(PipelineStage::SERIALIZE).recordSince(serialize_start);
+    metrics_.detections_published.inc(static_cast<uint64_t>(published_count));
+    metrics_.detections_filtered.inc(static_cast<uint64_t>(filtered_count));
+    metrics_.detections_suppressed.inc(image.suppressed);
     
-    // Calculate bandwidth savings
-    calculateBandwidthSavings(nitf_path, detections, published_count);
+    // Calculate bandwidth savings over what is published (report only; skipped when nobody would see it)
+    if (Logger::enabled(LogLevel::INFO)) {
+        DetectionBatch boxes(&image.arena);
+        boxes.append(detections);
+        calculateBandwidthSavings(image.geometry.get(image.nitf_path), boxes, published_count);
+    }
     
     // Summary
-    Logger::info("========================================");
-    Logger::info("Processing Summary");
-    Logger::info("========================================");
-    Logger::info("Total detections: " + std::to_string(detections.size()));
-    Logger::info("Published: " + std::to_string(published_count));
-    Logger::info("Filtered (below threshold): " + std::to_string(filtered_count));
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Processing Summary");
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Total detections: " + std::to_string(detections.size() + image.below_threshold +
+                                                       image.suppressed));
+    SAR_LOG_INFO("Published: " + std::to_string(published_count));
+    SAR_LOG_INFO("Filtered (below threshold): " + std::to_string(filtered_count));
+    SAR_LOG_INFO("Suppressed (duplicates): " + std::to_string(image.suppressed));
 }
 
-void SarAtrService::calculateBandwidthSavings(const std::string& nitf_path,
-                                               const std::vector<DetectionResult>& detections, 
-                                               int published_count) {
-    // Default SAR image dimensions (used as fallback)
-    int image_width = 4096;
-    int image_height = 4096;
-    const int bytes_per_pixel = 2; // 16-bit SAR data
-    
-    // Try to extract actual dimensions from NITF file path
-    // For mock files or if file doesn't exist, we'll use defaults
-    bool using_actual_dimensions = false;
-    
-    // Simple heuristic: try to extract dimensions from filename patterns
-    // Real implementation would parse NITF headers, but for demo we'll use heuristics
-    size_t last_slash = nitf_path.find_last_of("/\\");
-    std::string filename = (last_slash != std::string::npos) ? nitf_path.substr(last_slash + 1) : nitf_path;
-    
-    // Look for dimension patterns in filename like "2048x2048" or "_4096_4096"
-    std::string fname_lower = filename;
-    std::transform(fname_lower.begin(), fname_lower.end(), fname_lower.begin(), ::tolower);
-    
-    // Try pattern: NNNNxNNNN
-    size_t x_pos = fname_lower.find('x');
-    if (x_pos != std::string::npos && x_pos > 0) {
-        // Look backwards for digits
-        size_t start = x_pos;
-        while (start > 0 && std::isdigit(fname_lower[start - 1])) {
-            start--;
-        }
-        // Look forwards for digits
-        size_t end = x_pos + 1;
-        while (end < fname_lower.length() && std::isdigit(fname_lower[end])) {
-            end++;
-        }
-        
-        if (start < x_pos && end > x_pos + 1) {
-            try {
-                int w = std::stoi(fname_lower.substr(start, x_pos - start));
-                int h = std::stoi(fname_lower.substr(x_pos + 1, end - x_pos - 1));
-                if (w > 0 && h > 0 && w < 100000 && h < 100000) {
-                    image_width = w;
-                    image_height = h;
-                    using_actual_dimensions = true;
-                }
-            } catch (...) {
-                // Parsing failed, use defaults
-            }
+void SarAtrService::publishResults(const PublishJob& job) {
+    const ImageWork& image = *job.image;
+    if (image.messages.empty()) {
+        return;
+    }
+    try {
+        {
+            StageTimer timer(&metrics_, PipelineStage::PUBLISH);
+            amq_pool_->publishBatch(image.nitf_path, image.messages);
         }
+        metrics_.messages_published.inc(image.messages.size());
+        SAR_LOG_INFO("Published " + std::to_string(image.messages.size()) + " UCI messages for " + image.nitf_path);
+    } catch (const std::exception& e) {
+        metrics_.publish_failures.inc(image.messages.size());
+        Logger::error("Failed to publish UCI messages for " + image.nitf_path + ": " + std::string(e.what()));
     }
+}
+
+std::string SarAtrService::renderMetrics() {
+    metrics_.send_queue_bytes.set(static_cast<int64_t>(amq_pool_->queuedBytes()));
+    metrics_.parse_queue_depth.set(static_cast<int64_t>(parse_queue_.size()));
+    metrics_.job_queue_depth.set(static_cast<int64_t>(job_queue_.size()));
+    metrics_.serialize_queue_depth.set(static_cast<int64_t>(serialize_queue_.size()));
+    metrics_.publish_queue_depth.set(static_cast<int64_t>(publish_queue_.size()));
+    metrics_.reorder_held.set(static_cast<int64_t>(reorder_.size()));
+    if (result_cache_) {
+        metrics_.result_cache_entries.set(static_cast<int64_t>(result_cache_->size()));
+    }
+    if (prefetcher_) {
+        metrics_.prefetch_outstanding_bytes.set(static_cast<int64_t>(prefetcher_->outstandingBytes()));
+    }
+    return metrics_.renderPrometheus();
+}
+
+void SarAtrService::calculateBandwidthSavings(const ImageGeometry& geometry,
+                                               const DetectionBatch& boxes,
+                                               int published_count) {
+    // Falls back to 4096x4096 16-bit SAR data when nothing better is known
+    const int image_width = geometry.cols;
+    const int image_height = geometry.rows;
+    const int bytes_per_pixel = geometry.bytes_per_pixel;
     
     // Calculate original file size
     long long original_pixels = static_cast<long long>(image_width) * image_height;
-    long long original_bytes = original_pixels * bytes_per_pixel;
+    long long original_bytes = geometry.file_bytes > 0 ? geometry.file_bytes : original_pixels * bytes_per_pixel;
     double original_mb = original_bytes / (1024.0 * 1024.0);
     
-    // Calculate actual chip sizes from detections
-    long long total_chip_pixels = 0;
-    
-    for (const auto& detection : detections) {
-        // Calculate chip dimensions in pixels from normalized bounding box
-        int chip_width = static_cast<int>((detection.bounding_box.x2 - detection.bounding_box.x1) * image_width);
-        int chip_height = static_cast<int>((detection.bounding_box.y2 - detection.bounding_box.y1) * image_height);
-        
-        // Add some padding around detection (typical 20% on each side)
-        chip_width = static_cast<int>(chip_width * 1.4);
-        chip_height = static_cast<int>(chip_height * 1.4);
-        
-        // Ensure minimum chip size of 64x64 and maximum of 512x512
-        chip_width = std::max(64, std::min(512, chip_width));
-        chip_height = std::max(64, std::min(512, chip_height));
-        
-        long long chip_pixels = static_cast<long long>(chip_width) * chip_height;
-        total_chip_pixels += chip_pixels;
-    }
-    
-    // Only count published detections for bandwidth calculation
-    // Scale by the ratio of published to total
-    if (detections.size() > 0) {
-        total_chip_pixels = total_chip_pixels * published_count / detections.size();
-    }
+    // Actual chip sizes of the published detections: the same padded, clamped
+    // regions the chip extractor cuts out
+    long long total_chip_pixels = totalChipPixels(boxes, config_.confidence_threshold,
+                                                  image_width, image_height, chip_options_);
     
     long long total_chip_bytes = total_chip_pixels * bytes_per_pixel;
     double chip_mb = total_chip_bytes / (1024.0 * 1024.0);
@@ -315,46 +1127,51 @@ void SarAtrService::calculateBandwidthSavings(const std::string& nitf_path,
     double saved_mb = original_mb - chip_mb;
     double saved_percent = (saved_mb / original_mb) * 100.0;
     
-    Logger::info("========================================");
-    Logger::info("Bandwidth Savings Estimate");
-    Logger::info("========================================");
+    SAR_LOG_INFO("========================================");
+    SAR_LOG_INFO("Bandwidth Savings Estimate");
+    SAR_LOG_INFO("========================================");
     
     std::stringstream ss;
     ss << std::fixed << std::setprecision(2);
     
     // Show if using actual or estimated dimensions
-    std::string dim_source = using_actual_dimensions ? " (from filename)" : " (estimated)";
-    Logger::info("Original full image: ~" + std::to_string(static_cast<int>(original_mb)) + " MB " +
+    std::string dim_source = " (estimated)";
+    if (geometry.source == ImageGeometry::Source::NITF_HEADER) {
+        dim_source = " (from NITF header)";
+    } else if (geometry.source == ImageGeometry::Source::FILENAME) {
+        dim_source = " (from filename)";
+    }
+    SAR_LOG_INFO("Original full image: ~" + std::to_string(static_cast<int>(original_mb)) + " MB " +
                  "(" + std::to_string(image_width) + "x" + std::to_string(image_height) + " pixels" + dim_source + ")");
     
     if (published_count > 0) {
-        Logger::info("Detections to transmit: " + std::to_string(published_count) + " chips " +
+        SAR_LOG_INFO("Detections to transmit: " + std::to_string(published_count) + " chips " +
                      "(variable sizes based on actual detections)");
         
         ss.str("");
         ss << "Total chip data: ~" << chip_mb << " MB";
-        Logger::info(ss.str());
+        SAR_LOG_INFO(ss.str());
         
         ss.str("");
         ss << "Data NOT transmitted: ~" << saved_mb << " MB";
-        Logger::info(ss.str());
+        SAR_LOG_INFO(ss.str());
         
         ss.str("");
         ss << "Bandwidth savings: " << saved_percent << "%";
-        Logger::info(ss.str());
+        SAR_LOG_INFO(ss.str());
         
         if (saved_percent > 95.0) {
-            Logger::info("  └─ Excellent bandwidth optimization!");
+            SAR_LOG_INFO("  └─ Excellent bandwidth optimization!");
         } else if (saved_percent > 80.0) {
-            Logger::info("  └─ Good bandwidth savings");
+            SAR_LOG_INFO("  └─ Good bandwidth savings");
         } else if (saved_percent > 50.0) {
-            Logger::info("  └─ Moderate bandwidth savings");
+            SAR_LOG_INFO("  └─ Moderate bandwidth savings");
         } else {
-            Logger::info("  └─ Limited bandwidth savings (large detections)");
+            SAR_LOG_INFO("  └─ Limited bandwidth savings (large detections)");
         }
     } else {
-        Logger::info("No detections published - no chip data transmitted");
-        Logger::info("Bandwidth savings: 100% (no data sent)");
+        SAR_LOG_INFO("No detections published - no chip data transmitted");
+        SAR_LOG_INFO("Bandwidth savings: 100% (no data sent)");
     }
 }
 
@@ -0,0 +1,131 @@
+#include "stomp_frame.h"
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+namespace sar_atr {
+
+namespace {
+
+constexpr std::string_view kSendPrefix = "SEND\ndestination:/topic/";
+constexpr std::string_view kReceiptHeader = "\nreceipt:";
+constexpr std::string_view kContentHeaders = "\ncontent-type:application/json\ncontent-length:";
+
+/// Line starting at pos without its line ending; pos moves past the ending
+std::string_view nextLine(std::string_view data, size_t& pos) {
+    size_t end = data.find('\n', pos);
+    if (end == std::string_view::npos) {
+        throw std::runtime_error("Truncated STOMP frame");
+    }
+    std::string_view line = data.substr(pos, end - pos);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    pos = end + 1;
+    return line;
+}
+
+size_t decimalDigits(size_t value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+} // namespace
+
+size_t stompSendFrameSize(std::string_view topic, std::string_view body, std::string_view receipt) {
+    // headers, length digits, blank line, body, NUL
+    return kSendPrefix.size() + topic.size() + (receipt.empty() ? 0 : kReceiptHeader.size() + receipt.size()) +
+           kContentHeaders.size() + decimalDigits(body.size()) + 2 + body.size() + 1;
+}
+
+void appendStompSendFrame(std::string_view topic, std::string_view body, std::string& out,
+                          std::string_view receipt) {
+    out.reserve(out.size() + stompSendFrameSize(topic, body, receipt));
+
+    out.append(kSendPrefix.data(), kSendPrefix.size());
+    out.append(topic.data(), topic.size());
+    if (!receipt.empty()) {
+        out.append(kReceiptHeader.data(), kReceiptHeader.size());
+        out.append(receipt.data(), receipt.size());
+    }
+    out.append(kContentHeaders.data(), kContentHeaders.size());
+
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), body.size());
+    out.append(digits, static_cast<size_t>(result.ptr - digits));
+
+    out += "\n\n";
+    out.append(body.data(), body.size());
+    out += '\0';
+}
+
+std::string_view StompFrame::header(std::string_view name) const {
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t end = headers.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = headers.size();
+        }
+        std::string_view line = headers.substr(pos, end - pos);
+        if (line.size() > name.size() && line[name.size()] == ':' && line.compare(0, name.size(), name) == 0) {
+            std::string_view value = line.substr(name.size() + 1);
+            if (!value.empty() && value.back() == '\r') {
+                value.remove_suffix(1);
+            }
+            return value;
+        }
+        pos = end + 1;
+    }
+    return std::string_view();
+}
+
+bool StompFrame::hasHeader(std::string_view name) const {
+    return header(name).data() != nullptr;
+}
+
+bool parseStompFrame(std::string_view data, StompFrame& frame) {
+    // Heart-beats are bare EOLs and may also precede a frame
+    size_t pos = 0;
+    while (pos < data.size() && (data[pos] == '\n' || data[pos] == '\r')) {
+        pos++;
+    }
+    if (pos == data.size() || (pos + 1 == data.size() && data[pos] == '\0')) {
+        return false;
+    }
+
+    frame.command = nextLine(data, pos);
+
+    size_t headers_start = pos;
+    size_t headers_end = pos;
+    while (true) {
+        size_t line_start = pos;
+        if (nextLine(data, pos).empty()) {
+            headers_end = line_start;
+            break;
+        }
+    }
+    frame.headers = data.substr(headers_start, headers_end - headers_start);
+
+    std::string_view content_length = frame.header("content-length");
+    if (!content_length.empty()) {
+        size_t length = 0;
+        auto result = std::from_chars(content_length.data(), content_length.data() + content_length.size(), length);
+        if (result.ec != std::errc() || result.ptr != content_length.data() + content_length.size()) {
+            throw std::runtime_error("Invalid STOMP content-length: " + std::string(content_length));
+        }
+        if (length > data.size() - pos) {
+            throw std::runtime_error("STOMP body shorter than content-length");
+        }
+        frame.body = data.substr(pos, length);
+    } else {
+        size_t nul = data.find('\0', pos);
+        frame.body = data.substr(pos, nul == std::string_view::npos ? std::string_view::npos : nul - pos);
+    }
+    return true;
+}
+
+} // namespace sar_atr
@@ -0,0 +1,56 @@
+#include "thread_pool.h"
+#include "logger.h"
+#include <stdexcept>
+
+namespace sar_atr {
+
+ThreadPool::ThreadPool(const std::string& name, int thread_count, size_t queue_capacity)
+    : name_(name), tasks_(queue_capacity) {
+    if (thread_count <= 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        thread_count = cores > 0 ? static_cast<int>(cores) : 1;
+    }
+
+    for (int i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this]() {
+            run();
+        });
+    }
+
+    Logger::debug("Started " + name_ + " pool with " + std::to_string(thread_count) + " thread(s)");
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    if (!tasks_.push(std::move(task))) {
+        throw std::runtime_error(name_ + " pool is shut down");
+    }
+}
+
+void ThreadPool::shutdown() {
+    tasks_.close();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+void ThreadPool::run() {
+    std::function<void()> task;
+    while (tasks_.pop(task)) {
+        // packaged_task captures exceptions into the future; anything else is a bug we log
+        try {
+            task();
+        } catch (const std::exception& e) {
+            Logger::error(name_ + " pool task failed: " + std::string(e.what()));
+        }
+        task = nullptr;
+    }
+}
+
+} // namespace sar_atr
@@ -0,0 +1,302 @@
+#include "tiled_inference.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <future>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace sar_atr {
+
+namespace {
+
+// Tile origins along one axis: regular steps, with the last tile pulled
+// back so it ends on the image edge
+std::vector<int> tileOrigins(int length, int tile_size, int step) {
+    std::vector<int> origins;
+    if (length <= tile_size) {
+        origins.push_back(0);
+        return origins;
+    }
+    for (int pos = 0; pos + tile_size < length; pos += step) {
+        origins.push_back(pos);
+    }
+    origins.push_back(length - tile_size);
+    return origins;
+}
+
+float intersectionOverSmaller(const BoundingBox& a, const BoundingBox& b) {
+    float ix = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    float iy = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if (ix <= 0.0f || iy <= 0.0f) {
+        return 0.0f;
+    }
+    float smaller = std::min(a.width() * a.height(), b.width() * b.height());
+    return smaller > 0.0f ? (ix * iy) / smaller : 0.0f;
+}
+
+/**
+ * Boxes kept by the seam merge, one column per field, so a candidate is
+ * tested against a register of them at a time. Only boxes that pass the
+ * overlap test reach the (scalar) tile check.
+ */
+class SeamColumns {
+public:
+    size_t size() const { return x1_.size(); }
+
+    void reserve(size_t count) {
+        x1_.reserve(count);
+        y1_.reserve(count);
+        x2_.reserve(count);
+        y2_.reserve(count);
+        area_.reserve(count);
+        class_ids_.reserve(count);
+    }
+
+    void push_back(const BoundingBox& box, ClassId class_id) {
+        x1_.push_back(box.x1);
+        y1_.push_back(box.y1);
+        x2_.push_back(box.x2);
+        y2_.push_back(box.y2);
+        area_.push_back(box.width() * box.height());
+        class_ids_.push_back(class_id);
+    }
+
+    void set(size_t k, const BoundingBox& box) {
+        x1_[k] = box.x1;
+        y1_[k] = box.y1;
+        x2_[k] = box.x2;
+        y2_[k] = box.y2;
+        area_[k] = box.width() * box.height();
+    }
+
+    /**
+     * First kept box of the same class whose intersectionOverSmaller() with
+     * box is at least min_overlap and that accept(k) allows; size() if none
+     */
+    template <typename Accept>
+    size_t findDuplicate(const BoundingBox& box, ClassId class_id, float min_overlap, Accept accept) const {
+        const size_t count = size();
+        const float area = box.width() * box.height();
+        size_t k = 0;
+
+#if defined(__SSE2__)
+        const __m128 bx1 = _mm_set1_ps(box.x1);
+        const __m128 by1 = _mm_set1_ps(box.y1);
+        const __m128 bx2 = _mm_set1_ps(box.x2);
+        const __m128 by2 = _mm_set1_ps(box.y2);
+        const __m128 barea = _mm_set1_ps(area);
+        const __m128 limit = _mm_set1_ps(min_overlap);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i klass = _mm_set1_epi32(class_id);
+        for (; k + 4 <= count; k += 4) {
+            __m128 ix = _mm_sub_ps(_mm_min_ps(bx2, _mm_loadu_ps(&x2_[k])), _mm_max_ps(bx1, _mm_loadu_ps(&x1_[k])));
+            __m128 iy = _mm_sub_ps(_mm_min_ps(by2, _mm_loadu_ps(&y2_[k])), _mm_max_ps(by1, _mm_loadu_ps(&y1_[k])));
+            __m128 smaller = _mm_min_ps(_mm_loadu_ps(&area_[k]), barea);
+            // Lanes without a real intersection score 0, as in intersectionOverSmaller()
+            __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(ix, zero), _mm_cmpgt_ps(iy, zero)),
+                                      _mm_cmpgt_ps(smaller, zero));
+            __m128 overlap = _mm_and_ps(valid, _mm_div_ps(_mm_mul_ps(ix, iy), smaller));
+            __m128 same_class = _mm_castsi128_ps(
+                _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&class_ids_[k])), klass));
+            int bits = _mm_movemask_ps(_mm_and_ps(same_class, _mm_cmpge_ps(overlap, limit)));
+            while (bits != 0) {
+                size_t lane = k + static_cast<size_t>(__builtin_ctz(static_cast<unsigned int>(bits)));
+                if (accept(lane)) {
+                    return lane;
+                }
+                bits &= bits - 1;
+            }
+        }
+#endif
+
+        for (; k < count; ++k) {
+            if (class_ids_[k] != class_id) {
+                continue;
+            }
+            BoundingBox kept{x1_[k], y1_[k], x2_[k], y2_[k]};
+            if (intersectionOverSmaller(kept, box) >= min_overlap && accept(k)) {
+                return k;
+            }
+        }
+        return count;
+    }
+
+private:
+    std::vector<float> x1_;
+    std::vector<float> y1_;
+    std::vector<float> x2_;
+    std::vector<float> y2_;
+    std::vector<float> area_;
+    std::vector<int32_t> class_ids_;    ///< Widened so a register of IDs compares in one instruction
+};
+
+} // namespace
+
+std::vector<ImageTile> planTiles(int image_cols, int image_rows, int tile_size, int overlap) {
+    std::vector<ImageTile> tiles;
+    if (image_cols <= 0 || image_rows <= 0 || tile_size <= 0) {
+        return tiles;
+    }
+
+    int step = std::max(1, tile_size - std::max(0, overlap));
+    std::vector<int> col_origins = tileOrigins(image_cols, tile_size, step);
+    std::vector<int> row_origins = tileOrigins(image_rows, tile_size, step);
+
+    tiles.reserve(col_origins.size() * row_origins.size());
+    for (int row : row_origins) {
+        for (int col : col_origins) {
+            ImageTile tile;
+            tile.col_offset = col;
+            tile.row_offset = row;
+            tile.cols = std::min(tile_size, image_cols - col);
+            tile.rows = std::min(tile_size, image_rows - row);
+            tile.image_cols = image_cols;
+            tile.image_rows = image_rows;
+            tile.index = static_cast<int>(tiles.size());
+            tiles.push_back(tile);
+        }
+    }
+    return tiles;
+}
+
+void mapTileDetections(const ImageTile& tile, DetectionList& detections) {
+    const float sx = static_cast<float>(tile.cols) / tile.image_cols;
+    const float sy = static_cast<float>(tile.rows) / tile.image_rows;
+    const float ox = static_cast<float>(tile.col_offset) / tile.image_cols;
+    const float oy = static_cast<float>(tile.row_offset) / tile.image_rows;
+
+    for (auto& detection : detections) {
+        BoundingBox& box = detection.bounding_box;
+        box.x1 = std::min(1.0f, ox + box.x1 * sx);
+        box.x2 = std::min(1.0f, ox + box.x2 * sx);
+        box.y1 = std::min(1.0f, oy + box.y1 * sy);
+        box.y2 = std::min(1.0f, oy + box.y2 * sy);
+    }
+}
+
+void mergeTileDetections(const DetectionList& detections, const std::vector<int>& tile_indices,
+                         float min_overlap, DetectionList& merged) {
+    std::vector<size_t> order(detections.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&detections](size_t a, size_t b) {
+        if (detections[a].confidence != detections[b].confidence) {
+            return detections[a].confidence > detections[b].confidence;
+        }
+        return a < b;
+    });
+
+    const size_t first = merged.size();
+    std::vector<std::vector<int>> merged_tiles;
+    SeamColumns kept;
+    kept.reserve(detections.size());
+
+    for (size_t idx : order) {
+        const DetectionResult& candidate = detections[idx];
+        int tile = tile_indices[idx];
+
+        // Only boxes from different tiles are seam duplicates; overlaps
+        // within one tile are the engine's business
+        auto accept = [&merged_tiles, tile](size_t k) {
+            const std::vector<int>& tiles = merged_tiles[k];
+            return std::find(tiles.begin(), tiles.end(), tile) == tiles.end();
+        };
+        size_t k = kept.findDuplicate(candidate.bounding_box, candidate.class_id, min_overlap, accept);
+
+        if (k < kept.size()) {
+            BoundingBox& box = merged[first + k].bounding_box;
+            box.x1 = std::min(box.x1, candidate.bounding_box.x1);
+            box.y1 = std::min(box.y1, candidate.bounding_box.y1);
+            box.x2 = std::max(box.x2, candidate.bounding_box.x2);
+            box.y2 = std::max(box.y2, candidate.bounding_box.y2);
+            kept.set(k, box);
+            merged_tiles[k].push_back(tile);
+        } else {
+            merged.push_back(candidate);
+            kept.push_back(candidate.bounding_box, candidate.class_id);
+            merged_tiles.push_back({tile});
+        }
+    }
+}
+
+TiledInferenceRunner::TiledInferenceRunner(const TilingOptions& options)
+    : options_(options) {
+    // Queue depth of a few tiles per thread keeps memory bounded per image
+    int threads = options_.threads;
+    if (threads <= 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threads = cores > 0 ? static_cast<int>(cores) : 1;
+    }
+    pool_ = std::make_unique<ThreadPool>("tile", threads, static_cast<size_t>(threads) * 2);
+}
+
+bool TiledInferenceRunner::shouldTile(int image_cols, int image_rows) const {
+    return image_cols > options_.tile_size || image_rows > options_.tile_size;
+}
+
+void TiledInferenceRunner::run(InferenceEngine& engine, const std::string& nitf_path,
+                               int image_cols, int image_rows, DetectionList& detections) {
+    run(engine, nitf_path, image_cols, image_rows, options_.overlap, detections);
+}
+
+void TiledInferenceRunner::run(InferenceEngine& engine, const std::string& nitf_path,
+                               int image_cols, int image_rows, int overlap, DetectionList& detections) {
+    std::vector<ImageTile> tiles = planTiles(image_cols, image_rows, options_.tile_size, overlap);
+
+    SAR_LOG_INFO("Tiled inference: " + std::to_string(tiles.size()) + " tiles of " +
+                 std::to_string(options_.tile_size) + " px (overlap " + std::to_string(overlap) +
+                 ") for " + std::to_string(image_cols) + "x" + std::to_string(image_rows) + " image");
+
+    std::vector<std::future<DetectionList>> pending;
+    pending.reserve(tiles.size());
+    for (const ImageTile& tile : tiles) {
+        pending.push_back(pool_->submit([&engine, nitf_path, tile]() {
+            DetectionList tile_detections;
+            engine.processTile(nitf_path, tile, tile_detections);
+            mapTileDetections(tile, tile_detections);
+            return tile_detections;
+        }));
+    }
+
+    // Wait for every tile even after a failure; tasks reference the engine
+    DetectionList all;
+    std::vector<int> tile_indices;
+    std::exception_ptr first_error;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        try {
+            DetectionList tile_detections = pending[i].get();
+            for (auto& detection : tile_detections) {
+                all.push_back(std::move(detection));
+                tile_indices.push_back(tiles[i].index);
+            }
+        } catch (...) {
+            if (!first_error) {
+                first_error = std::current_exception();
+            }
+        }
+    }
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+
+    const size_t before = detections.size();
+    mergeTileDetections(all, tile_indices, options_.merge_overlap_threshold, detections);
+    size_t kept = detections.size() - before;
+    if (kept != all.size()) {
+        SAR_LOG_INFO("Merged " + std::to_string(all.size() - kept) +
+                     " duplicate detection(s) across tile seams");
+    }
+}
+
+void TiledInferenceRunner::shutdown() {
+    if (pool_) {
+        pool_->shutdown();
+    }
+}
+
+} // namespace sar_atr
@@ -1,64 +1,441 @@
 #include "uci_messages.h"
 #include "logger.h"
+#include "uci_serializer.h"
 #include <random>
-#include <sstream>
-#include <iomanip>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
 
 namespace sar_atr {
 
-std::string generateUUID() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
-    static std::uniform_int_distribution<> dis2(8, 11);
-    
-    std::stringstream ss;
-    int i;
-    ss << std::hex;
-    for (i = 0; i < 8; i++) {
-        ss << dis(gen);
+namespace {
+
+// xoshiro256**: fast, 256-bit state, good enough statistically for IDs
+class Xoshiro256 {
+public:
+    Xoshiro256() {
+        std::random_device device;
+        uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+        for (auto& word : state_) {
+            word = splitMix64(seed);
+        }
     }
-    ss << "-";
-    for (i = 0; i < 4; i++) {
-        ss << dis(gen);
+
+    uint64_t next() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
     }
-    ss << "-4";
-    for (i = 0; i < 3; i++) {
-        ss << dis(gen);
+
+private:
+    uint64_t state_[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    static uint64_t splitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
     }
-    ss << "-";
-    ss << dis2(gen);
-    for (i = 0; i < 3; i++) {
-        ss << dis(gen);
+};
+
+void writeHexBytes(char* out, uint64_t value, int bytes) {
+    static const char kHex[] = "0123456789abcdef";
+    for (int i = bytes - 1; i >= 0; --i) {
+        unsigned byte = static_cast<unsigned>(value >> (i * 8)) & 0xFF;
+        *out++ = kHex[byte >> 4];
+        *out++ = kHex[byte & 0xF];
+    }
+}
+
+void writeDigits(char* out, unsigned value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+} // namespace
+
+void generateUUID(char* out) {
+    // Per-thread generator: UUIDs are created concurrently by the inference workers
+    thread_local Xoshiro256 generator;
+    uint64_t high = generator.next();
+    uint64_t low = generator.next();
+
+    high = (high & 0xFFFFFFFFFFFF0FFFull) | 0x0000000000004000ull; // version 4
+    low = (low & 0x3FFFFFFFFFFFFFFFull) | 0x8000000000000000ull;   // RFC 4122 variant
+
+    writeHexBytes(out, high >> 32, 4);
+    out[8] = '-';
+    writeHexBytes(out + 9, high >> 16, 2);
+    out[13] = '-';
+    writeHexBytes(out + 14, high, 2);
+    out[18] = '-';
+    writeHexBytes(out + 19, low >> 48, 2);
+    out[23] = '-';
+    writeHexBytes(out + 24, low, 6);
+}
+
+std::string generateUUID() {
+    std::string uuid(kUuidLength, '\0');
+    generateUUID(&uuid[0]);
+    return uuid;
+}
+
+void formatTimestamp(char* out, std::chrono::system_clock::time_point time) {
+    // Cache of the formatted "YYYY-MM-DDTHH:MM:SS." prefix for the last second seen
+    thread_local std::time_t cached_second = -1;
+    thread_local char cached_prefix[20];
+
+    auto since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch());
+    long long total_ms = since_epoch.count();
+    long long seconds = total_ms / 1000;
+    int ms = static_cast<int>(total_ms % 1000);
+    if (ms < 0) {
+        ms += 1000;
+        seconds -= 1;
     }
-    ss << "-";
-    for (i = 0; i < 12; i++) {
-        ss << dis(gen);
+
+    std::time_t second = static_cast<std::time_t>(seconds);
+    if (second != cached_second) {
+        std::tm utc_tm;
+        gmtime_r(&second, &utc_tm);
+        writeDigits(cached_prefix, static_cast<unsigned>(utc_tm.tm_year + 1900), 4);
+        cached_prefix[4] = '-';
+        writeDigits(cached_prefix + 5, static_cast<unsigned>(utc_tm.tm_mon + 1), 2);
+        cached_prefix[7] = '-';
+        writeDigits(cached_prefix + 8, static_cast<unsigned>(utc_tm.tm_mday), 2);
+        cached_prefix[10] = 'T';
+        writeDigits(cached_prefix + 11, static_cast<unsigned>(utc_tm.tm_hour), 2);
+        cached_prefix[13] = ':';
+        writeDigits(cached_prefix + 14, static_cast<unsigned>(utc_tm.tm_min), 2);
+        cached_prefix[16] = ':';
+        writeDigits(cached_prefix + 17, static_cast<unsigned>(utc_tm.tm_sec), 2);
+        cached_prefix[19] = '.';
+        cached_second = second;
     }
-    return ss.str();
+
+    std::memcpy(out, cached_prefix, sizeof(cached_prefix));
+    writeDigits(out + 20, static_cast<unsigned>(ms), 3);
+    out[23] = 'Z';
 }
 
 std::string getCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms.count() << "Z";
-    return ss.str();
+    std::string timestamp(kTimestampLength, '\0');
+    formatTimestamp(&timestamp[0], std::chrono::system_clock::now());
+    return timestamp;
+}
+
+namespace {
+
+/**
+ * Forward-only cursor over a JSON document that can descend into object
+ * members by key and skip any value without materializing it
+ */
+class JsonScanner {
+public:
+    explicit JsonScanner(std::string_view json)
+        : p_(json.data()), end_(json.data() + json.size()) {}
+
+    /**
+     * Position on the value of member key of the object at the cursor
+     */
+    bool enterMember(std::string_view key) {
+        skipWhitespace();
+        if (!consume('{')) {
+            return false;
+        }
+        skipWhitespace();
+        if (consume('}')) {
+            return false;
+        }
+        while (true) {
+            std::string_view name;
+            bool escaped = false;
+            skipWhitespace();
+            if (!readString(name, escaped)) {
+                return false;
+            }
+            skipWhitespace();
+            if (!consume(':')) {
+                return false;
+            }
+            if (!escaped && name == key) {
+                skipWhitespace();
+                return true;
+            }
+            if (!skipValue()) {
+                return false;
+            }
+            skipWhitespace();
+            if (consume(',')) {
+                continue;
+            }
+            return false; // '}' without a match, or malformed
+        }
+    }
+
+    /**
+     * Skip the members left in the object whose member value was just read,
+     * and its closing brace. Fails on malformed input or, since a full
+     * parser keeps the last of duplicate keys, on another member named key
+     * (or one with escapes, which might decode to it).
+     */
+    bool leaveObject(std::string_view key) {
+        while (true) {
+            skipWhitespace();
+            if (consume('}')) {
+                return true;
+            }
+            if (!consume(',')) {
+                return false;
+            }
+            std::string_view name;
+            bool escaped = false;
+            skipWhitespace();
+            if (!readString(name, escaped) || escaped || name == key) {
+                return false;
+            }
+            skipWhitespace();
+            if (!consume(':') || !skipValue()) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * Whether only whitespace is left
+     */
+    bool atEnd() {
+        skipWhitespace();
+        return p_ == end_;
+    }
+
+    /**
+     * Read the raw contents of a string value at the cursor
+     */
+    bool readString(std::string_view& value, bool& escaped) {
+        if (!consume('"')) {
+            return false;
+        }
+        const char* start = p_;
+        escaped = false;
+        while (p_ < end_) {
+            char c = *p_;
+            if (c == '"') {
+                value = std::string_view(start, static_cast<size_t>(p_ - start));
+                ++p_;
+                return true;
+            }
+            if (c == '\\') {
+                if (end_ - p_ < 2) {
+                    return false;
+                }
+                escaped = true;
+                p_ += 2;
+                continue;
+            }
+            ++p_;
+        }
+        return false;
+    }
+
+private:
+    const char* p_;
+    const char* end_;
+
+    void skipWhitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    bool consume(char c) {
+        if (p_ < end_ && *p_ == c) {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+
+    // Skip one value; containers are skipped by bracket depth, iteratively
+    bool skipValue() {
+        skipWhitespace();
+        if (p_ >= end_) {
+            return false;
+        }
+        std::string_view ignored;
+        bool escaped = false;
+        if (*p_ == '"') {
+            return readString(ignored, escaped);
+        }
+        if (*p_ == '{' || *p_ == '[') {
+            int depth = 0;
+            while (p_ < end_) {
+                char c = *p_;
+                if (c == '"') {
+                    if (!readString(ignored, escaped)) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (c == '{' || c == '[') {
+                    depth++;
+                } else if (c == '}' || c == ']') {
+                    if (--depth == 0) {
+                        ++p_;
+                        return true;
+                    }
+                }
+                ++p_;
+            }
+            return false;
+        }
+        // Number, true, false or null
+        const char* start = p_;
+        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' &&
+               *p_ != ' ' && *p_ != '\n' && *p_ != '\r' && *p_ != '\t') {
+            ++p_;
+        }
+        return p_ > start;
+    }
+};
+
+// Parse count decimal digits at text; false on anything else
+bool readDigits(const char* text, int count, int& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date (avoids timegm() and the TZ machinery)
+long long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2 ? 1 : 0;
+    const long long era = (year >= 0 ? year : year - 399) / 400;
+    const long long year_of_era = year - era * 400;
+    const long long day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const long long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+} // namespace
+
+bool findFileLocationAddress(std::string_view json_message, std::string_view& address) {
+    static constexpr std::string_view kPath[] = {"FileLocation", "MessageData", "LocationAndStatus",
+                                                 "Location", "Network", "Address"};
+    JsonScanner scanner(json_message);
+    for (std::string_view key : kPath) {
+        if (!scanner.enterMember(key)) {
+            return false;
+        }
+    }
+
+    std::string_view value;
+    bool escaped = false;
+    if (!scanner.readString(value, escaped) || escaped || value.empty()) {
+        return false;
+    }
+
+    // The rest of the document must close properly and not repeat a key on
+    // the path, or the DOM parse could disagree (it rejects truncated input
+    // and keeps the last duplicate)
+    for (size_t depth = std::size(kPath); depth > 0; --depth) {
+        if (!scanner.leaveObject(kPath[depth - 1])) {
+            return false;
+        }
+    }
+    if (!scanner.atEnd()) {
+        return false;
+    }
+    address = value;
+    return true;
+}
+
+bool findFileLocationTimestamp(std::string_view json_message, std::chrono::system_clock::time_point& timestamp) {
+    JsonScanner scanner(json_message);
+    if (!scanner.enterMember("FileLocation") || !scanner.enterMember("MessageHeader") ||
+        !scanner.enterMember("Timestamp")) {
+        return false;
+    }
+
+    std::string_view value;
+    bool escaped = false;
+    if (!scanner.readString(value, escaped) || escaped || value.size() < 20 || value.back() != 'Z') {
+        return false;
+    }
+
+    // YYYY-MM-DDTHH:MM:SS[.fff...]Z
+    const char* text = value.data();
+    int year, month, day, hour, minute, second;
+    if (!readDigits(text, 4, year) || text[4] != '-' || !readDigits(text + 5, 2, month) || text[7] != '-' ||
+        !readDigits(text + 8, 2, day) || text[10] != 'T' || !readDigits(text + 11, 2, hour) ||
+        text[13] != ':' || !readDigits(text + 14, 2, minute) || text[16] != ':' ||
+        !readDigits(text + 17, 2, second)) {
+        return false;
+    }
+    // Years outside what system_clock holds in nanoseconds are not plausible request times either
+    if (year < 1970 || year > 2200 || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 ||
+        minute > 59 || second > 60) {
+        return false;
+    }
+
+    // Fractional seconds are kept to the millisecond
+    int ms = 0;
+    size_t rest = 19;
+    if (value[rest] == '.') {
+        int scale = 100;
+        for (++rest; rest + 1 < value.size(); ++rest) {
+            char c = value[rest];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            ms += (c - '0') * scale;
+            scale /= 10;
+        }
+    }
+    if (rest + 1 != value.size()) {
+        return false;
+    }
+
+    long long seconds = daysFromCivil(year, month, day) * 86400LL + hour * 3600LL + minute * 60LL + second;
+    timestamp = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::milliseconds(seconds * 1000 + ms)));
+    return true;
+}
+
+std::string parseFileLocationMessage(std::string_view json_message) {
+    std::string_view fast_address;
+    if (findFileLocationAddress(json_message, fast_address)) {
+        return std::string(fast_address);
+    }
+    return parseFileLocationJson(json_message);
 }
 
-std::string parseFileLocationMessage(const std::string& json_message) {
+std::string parseFileLocationJson(std::string_view json_message) {
+    // Slow path: full parse for escapes, unusual layouts and precise error messages
     Json::Value root;
     Json::CharReaderBuilder builder;
     std::string errs;
-    std::istringstream iss(json_message);
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
     
-    if (!Json::parseFromStream(builder, iss, &root, &errs)) {
+    if (!reader->parse(json_message.data(), json_message.data() + json_message.size(), &root, &errs)) {
         throw std::runtime_error("Failed to parse FileLocation message: " + errs);
     }
     
@@ -81,141 +458,39 @@ std::string parseFileLocationMessage(const std::string& json_message) {
     }
 }
 
-std::string createEntityMessage(const DetectionResult& detection, const SystemInfo& system_info) {
-    Json::Value root;
-    Json::Value& entity = root["Entity"];
-    
-    // Namespace
-    entity["@xmlns"] = "namespace";
-    
-    // Security Information
-    Json::Value& security = entity["SecurityInformation"];
+// The free functions keep their original signatures; the service holds a
+// UciSerializer and a per-image context so IDs come back without re-parsing
 
-    
-    // Message Header
-    Json::Value& header = entity["MessageHeader"];
-    header["SystemID"]["UUID"] = system_info.system_uuid;
-    header["SystemID"]["DescriptiveLabel"] = system_info.system_description;
-    header["Timestamp"] = getCurrentTimestamp();
-    header["SchemaVersion"] = "002.3";
-    header["Mode"] = "SIMULATION";
-    header["ServiceID"]["UUID"] = system_info.system_uuid;
-    header["ServiceID"]["DescriptiveLabel"] = system_info.system_description;
-    header["ServiceID"]["ServiceVersion"] = system_info.service_version;
-    
-    // Message Data
-    Json::Value& data = entity["MessageData"];
-    std::string entity_uuid = generateUUID();
-    data["EntityID"]["UUID"] = entity_uuid;
-    data["CreationTimestamp"] = getCurrentTimestamp();
-    
-    // Identity
-    data["Identity"]["Platform"]["ThreatType"] = detection.classification;
-    
-    // Kinematics - Position with bounding box
-    Json::Value& rectangle = data["Kinematics"]["Position"]["Zone"]["Shape"]["Rectangle"];
-    rectangle["Width"] = detection.bounding_box.width();
-    rectangle["Height"] = detection.bounding_box.height();
-    
-    Json::Value& relative_offset = rectangle["CenterPositionChoice"]["RelativePoint"]["RelativeOffset"];
-    relative_offset["X"] = detection.bounding_box.centerX();
-    relative_offset["Y"] = detection.bounding_box.centerY();
-    
-    // Convert to string
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";
-    return Json::writeString(writer, root);
+std::string createEntityMessage(const DetectionResult& detection, const SystemInfo& system_info) {
+    ImageMessageContext context(1);
+    std::string out;
+    UciSerializer(system_info).appendEntity(out, detection, context.nextUuid(), context.timestamp());
+    return out;
 }
 
 std::string createAtrProcessingResultMessage(const std::vector<std::string>& entity_uuids) {
-    Json::Value root;
-    Json::Value& atr_result = root["ATR_ProcessingResultsType"];
-    
-    atr_result["@xmlns"] = "";
-    
-    Json::Value entity_ids(Json::arrayValue);
-    for (const auto& uuid : entity_uuids) {
-        Json::Value entity_id;
-        entity_id["@xmlns"] = "namespace";
-        entity_id["ns1:UUID"] = uuid;
-        entity_ids.append(entity_id);
-    }
-    
-    atr_result["ns1:EntityId"] = entity_ids;
-    
-    // Convert to string
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";
-    return Json::writeString(writer, root);
+    std::pmr::vector<std::string_view> views(entity_uuids.begin(), entity_uuids.end());
+    std::string out;
+    UciSerializer::appendAtrProcessingResult(out, views);
+    return out;
 }
 
 std::string createProductMetadataMessage(const std::string& product_metadata_uuid,
                                          const std::string& entity_uuid,
                                          const SystemInfo& system_info) {
-    Json::Value root;
-    Json::Value& file_location = root["FileLocation"];
-    
-    // Namespace
-    file_location["@xmlns"] = "namespace";
-    
-    // Security Information
-    Json::Value& security = file_location["SecurityInformation"];
-    
-    // Message Header
-    Json::Value& header = file_location["MessageHeader"];
-    header["SystemID"]["UUID"] = system_info.system_uuid;
-    header["SystemID"]["DescriptiveLabel"] = system_info.system_description;
-    header["Timestamp"] = getCurrentTimestamp();
-    header["SchemaVersion"] = "002.3";
-    header["Mode"] = "SIMULATION";
-    header["ServiceID"]["UUID"] = system_info.system_uuid;
-    header["ServiceID"]["DescriptiveLabel"] = system_info.system_description;
-    header["ServiceID"]["ServiceVersion"] = system_info.service_version;
-    
-    // Message Data
-    Json::Value& data = file_location["MessageData"];
-    data["ProductMetadataID"] = product_metadata_uuid;
-    data["ProductDescription"]["ProcessingType"] = "AUTOMATIC_TARGET_RECOGNITION";
-    data["EntityMetadata"]["EntityID"]["UUID"] = entity_uuid;
-    
-    // Convert to string
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";
-    return Json::writeString(writer, root);
+    std::string out;
+    UciSerializer(system_info).appendProductMetadata(out, product_metadata_uuid, entity_uuid,
+                                                     getCurrentTimestamp());
+    return out;
 }
 
 std::string createProductLocationMessage(const std::string& product_metadata_uuid,
                                          const std::string& output_file_path,
                                          const SystemInfo& system_info) {
-    Json::Value root;
-    Json::Value& file_location = root["FileLocation"];
-    
-    // Namespace
-    file_location["@xmlns"] = "namespace";
-    
-    // Security Information
-    Json::Value& security = file_location["SecurityInformation"];
-    
-    // Message Header
-    Json::Value& header = file_location["MessageHeader"];
-    header["SystemID"]["UUID"] = system_info.system_uuid;
-    header["SystemID"]["DescriptiveLabel"] = system_info.system_description;
-    header["Timestamp"] = getCurrentTimestamp();
-    header["SchemaVersion"] = "002.3";
-    header["Mode"] = "SIMULATION";
-    header["ServiceID"]["UUID"] = system_info.system_uuid;
-    header["ServiceID"]["DescriptiveLabel"] = system_info.system_description;
-    header["ServiceID"]["ServiceVersion"] = system_info.service_version;
-    
-    // Message Data
-    Json::Value& data = file_location["MessageData"];
-    data["ProductMetadataID"]["UUID"] = product_metadata_uuid;
-    data["LocationAndStatus"]["Location"]["Network"]["Address"] = output_file_path;
-    
-    // Convert to string
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";
-    return Json::writeString(writer, root);
+    std::string out;
+    UciSerializer(system_info).appendProductLocation(out, product_metadata_uuid, output_file_path,
+                                                     getCurrentTimestamp());
+    return out;
 }
 
 } // namespace sar_atr
@@ -0,0 +1,245 @@
+#include "uci_serializer.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+
+namespace sar_atr {
+
+namespace {
+
+// Static segments, split where a dynamic field is written. Keys are in the
+// order jsoncpp emits them (sorted), so output is unchanged for consumers.
+constexpr std::string_view kEntityOpen =
+    R"({"Entity":{"@xmlns":"namespace","MessageData":{"CreationTimestamp":)";
+constexpr std::string_view kEntityId = R"(,"EntityID":{"UUID":)";
+constexpr std::string_view kEntityThreat = R"(},"Identity":{"Platform":{"ThreatType":)";
+constexpr std::string_view kEntityX =
+    R"(}},"Kinematics":{"Position":{"Zone":{"Shape":{"Rectangle":{"CenterPositionChoice":)"
+    R"({"RelativePoint":{"RelativeOffset":{"X":)";
+constexpr std::string_view kEntityY = R"(,"Y":)";
+constexpr std::string_view kEntityHeight = R"(}}},"Height":)";
+constexpr std::string_view kEntityWidth = R"(,"Width":)";
+constexpr std::string_view kEntityClose = R"(}}}}}},)";
+
+constexpr std::string_view kMetadataOpen =
+    R"({"FileLocation":{"@xmlns":"namespace","MessageData":{"EntityMetadata":{"EntityID":{"UUID":)";
+constexpr std::string_view kMetadataId =
+    R"(}},"ProductDescription":{"ProcessingType":"AUTOMATIC_TARGET_RECOGNITION"},"ProductMetadataID":)";
+constexpr std::string_view kMetadataClose = R"(},)";
+
+constexpr std::string_view kLocationOpen =
+    R"({"FileLocation":{"@xmlns":"namespace","MessageData":{"LocationAndStatus":{"Location":{"Network":{"Address":)";
+constexpr std::string_view kLocationId = R"(}}},"ProductMetadataID":{"UUID":)";
+constexpr std::string_view kLocationClose = R"(}},)";
+
+constexpr std::string_view kHeaderClose = R"(},"SecurityInformation":null}})";
+
+constexpr std::string_view kAtrOpen = R"({"ATR_ProcessingResultsType":{"@xmlns":"","ns1:EntityId":[)";
+constexpr std::string_view kAtrEntity = R"({"@xmlns":"namespace","ns1:UUID":)";
+constexpr std::string_view kAtrClose = R"(]}})";
+
+// Room for a quoted UUID/timestamp, or a float
+constexpr size_t kFieldReserve = 40;
+
+template <typename String>
+void append(String& out, std::string_view segment) {
+    out.append(segment.data(), segment.size());
+}
+
+} // namespace
+
+template <typename String>
+void appendJsonString(String& out, std::string_view value) {
+    static const char kHex[] = "0123456789abcdef";
+
+    out += '"';
+    size_t run_start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(value.data() + run_start, i - run_start);
+        run_start = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                out += "\\u00";
+                out += kHex[c >> 4];
+                out += kHex[c & 0xF];
+                break;
+        }
+    }
+    out.append(value.data() + run_start, value.size() - run_start);
+    out += '"';
+}
+
+template <typename String>
+void appendJsonNumber(String& out, float value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, static_cast<size_t>(result.ptr - buffer));
+}
+
+UciSerializer::UciSerializer(const SystemInfo& system_info) {
+    header_ = R"("MessageHeader":{"Mode":"SIMULATION","SchemaVersion":"002.3","ServiceID":{"DescriptiveLabel":)";
+    appendJsonString(header_, system_info.system_description);
+    header_ += R"(,"ServiceVersion":)";
+    appendJsonString(header_, system_info.service_version);
+    header_ += R"(,"UUID":)";
+    appendJsonString(header_, system_info.system_uuid);
+    header_ += R"(},"SystemID":{"DescriptiveLabel":)";
+    appendJsonString(header_, system_info.system_description);
+    header_ += R"(,"UUID":)";
+    appendJsonString(header_, system_info.system_uuid);
+    header_ += R"(},"Timestamp":)";
+}
+
+template <typename String>
+void UciSerializer::appendEntity(String& out, const DetectionResult& detection, std::string_view entity_uuid,
+                                 std::string_view timestamp) const {
+    out.reserve(out.size() + kEntityOpen.size() + kEntityId.size() + kEntityThreat.size() + kEntityX.size() +
+                kEntityY.size() + kEntityHeight.size() + kEntityWidth.size() + kEntityClose.size() +
+                header_.size() + kHeaderClose.size() + detection.classification().size() + 7 * kFieldReserve);
+
+    const BoundingBox& box = detection.bounding_box;
+    append(out, kEntityOpen);
+    appendJsonString(out, timestamp);
+    append(out, kEntityId);
+    appendJsonString(out, entity_uuid);
+    append(out, kEntityThreat);
+    appendJsonString(out, detection.classification());
+    append(out, kEntityX);
+    appendJsonNumber(out, box.centerX());
+    append(out, kEntityY);
+    appendJsonNumber(out, box.centerY());
+    append(out, kEntityHeight);
+    appendJsonNumber(out, box.height());
+    append(out, kEntityWidth);
+    appendJsonNumber(out, box.width());
+    append(out, kEntityClose);
+    append(out, header_);
+    appendJsonString(out, timestamp);
+    append(out, kHeaderClose);
+}
+
+template <typename String>
+void UciSerializer::appendProductMetadata(String& out, std::string_view product_metadata_uuid,
+                                          std::string_view entity_uuid, std::string_view timestamp) const {
+    out.reserve(out.size() + kMetadataOpen.size() + kMetadataId.size() + kMetadataClose.size() +
+                header_.size() + kHeaderClose.size() + 3 * kFieldReserve);
+
+    append(out, kMetadataOpen);
+    appendJsonString(out, entity_uuid);
+    append(out, kMetadataId);
+    appendJsonString(out, product_metadata_uuid);
+    append(out, kMetadataClose);
+    append(out, header_);
+    appendJsonString(out, timestamp);
+    append(out, kHeaderClose);
+}
+
+template <typename String>
+void UciSerializer::appendProductLocation(String& out, std::string_view product_metadata_uuid,
+                                          std::string_view output_file_path, std::string_view timestamp) const {
+    out.reserve(out.size() + kLocationOpen.size() + kLocationId.size() + kLocationClose.size() +
+                header_.size() + kHeaderClose.size() + output_file_path.size() + 3 * kFieldReserve);
+
+    append(out, kLocationOpen);
+    appendJsonString(out, output_file_path);
+    append(out, kLocationId);
+    appendJsonString(out, product_metadata_uuid);
+    append(out, kLocationClose);
+    append(out, header_);
+    appendJsonString(out, timestamp);
+    append(out, kHeaderClose);
+}
+
+template <typename String>
+void UciSerializer::appendAtrProcessingResult(String& out, const std::pmr::vector<std::string_view>& entity_uuids) {
+    out.reserve(out.size() + kAtrOpen.size() + kAtrClose.size() +
+                entity_uuids.size() * (kAtrEntity.size() + kFieldReserve + 2));
+
+    append(out, kAtrOpen);
+    for (size_t i = 0; i < entity_uuids.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        append(out, kAtrEntity);
+        appendJsonString(out, entity_uuids[i]);
+        out += '}';
+    }
+    append(out, kAtrClose);
+}
+
+ImageMessageContext::ImageMessageContext(size_t expected_uuids, std::pmr::memory_resource* memory)
+    : memory_(memory), uuids_(memory), next_(0) {
+    formatTimestamp(timestamp_.data(), std::chrono::system_clock::now());
+    for (size_t i = 0; i < expected_uuids; ++i) {
+        generateUUID(uuids_.emplace_back().data());
+    }
+}
+
+std::string_view ImageMessageContext::nextUuid() {
+    if (next_ == uuids_.size()) {
+        generateUUID(uuids_.emplace_back().data());
+    }
+    const Uuid& uuid = uuids_[next_++];
+    return std::string_view(uuid.data(), uuid.size());
+}
+
+UciMessage UciSerializer::entity(const DetectionResult& detection, ImageMessageContext& context) const {
+    UciMessage message{std::pmr::string(context.memory()), context.nextUuid()};
+    appendEntity(message.body, detection, message.uuid, context.timestamp());
+    return message;
+}
+
+UciMessage UciSerializer::productMetadata(std::string_view entity_uuid, ImageMessageContext& context) const {
+    UciMessage message{std::pmr::string(context.memory()), context.nextUuid()};
+    appendProductMetadata(message.body, message.uuid, entity_uuid, context.timestamp());
+    return message;
+}
+
+std::pmr::string UciSerializer::productLocation(std::string_view product_metadata_uuid,
+                                                std::string_view output_file_path,
+                                                const ImageMessageContext& context) const {
+    std::pmr::string out(context.memory());
+    appendProductLocation(out, product_metadata_uuid, output_file_path, context.timestamp());
+    return out;
+}
+
+std::pmr::string UciSerializer::atrProcessingResult(const std::pmr::vector<std::string_view>& entity_uuids) {
+    std::pmr::string out(entity_uuids.get_allocator());
+    appendAtrProcessingResult(out, entity_uuids);
+    return out;
+}
+
+// The append family is used with both heap and arena-backed strings
+#define SAR_ATR_INSTANTIATE_APPENDERS(String)                                                                  \
+    template void appendJsonString<String>(String&, std::string_view);                                        \
+    template void appendJsonNumber<String>(String&, float);                                                   \
+    template void UciSerializer::appendEntity<String>(String&, const DetectionResult&, std::string_view,      \
+                                                      std::string_view) const;                                \
+    template void UciSerializer::appendProductMetadata<String>(String&, std::string_view, std::string_view,   \
+                                                               std::string_view) const;                       \
+    template void UciSerializer::appendProductLocation<String>(String&, std::string_view, std::string_view,   \
+                                                               std::string_view) const;                       \
+    template void UciSerializer::appendAtrProcessingResult<String>(String&,                                   \
+                                                                   const std::pmr::vector<std::string_view>&);
+
+SAR_ATR_INSTANTIATE_APPENDERS(std::string)
+SAR_ATR_INSTANTIATE_APPENDERS(std::pmr::string)
+
+#undef SAR_ATR_INSTANTIATE_APPENDERS
+
+} // namespace sar_atr
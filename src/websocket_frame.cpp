@@ -0,0 +1,213 @@
+#include "websocket_frame.h"
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace sar_atr {
+
+void maskWebSocketPayload(const char* src, char* dst, size_t length, const unsigned char mask[4]) {
+    size_t i = 0;
+
+    // Replicate the 4-byte key across a 64-bit word; every 4-aligned offset
+    // into the payload lines up with the start of the key again
+    uint32_t key32;
+    std::memcpy(&key32, mask, 4);
+    uint64_t key64 = (static_cast<uint64_t>(key32) << 32) | key32;
+
+#if defined(__AVX2__)
+    const __m256i key256 = _mm256_set1_epi32(static_cast<int>(key32));
+    for (; i + 32 <= length; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(chunk, key256));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i key128 = _mm_set1_epi32(static_cast<int>(key32));
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(chunk, key128));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t key128 = vreinterpretq_u8_u32(vdupq_n_u32(key32));
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), veorq_u8(chunk, key128));
+    }
+#endif
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, src + i, 8);
+        word ^= key64;
+        std::memcpy(dst + i, &word, 8);
+    }
+
+    for (; i < length; i++) {
+        dst[i] = static_cast<char>(src[i] ^ mask[i % 4]);
+    }
+}
+
+void generateWebSocketMask(unsigned char mask[4]) {
+    thread_local std::mt19937 gen(std::random_device{}());
+    uint32_t key = static_cast<uint32_t>(gen());
+    std::memcpy(mask, &key, 4);
+}
+
+size_t webSocketHeaderSize(size_t payload_length) {
+    // 2 base bytes + extended length + 4-byte masking key
+    if (payload_length <= 125) {
+        return 2 + 4;
+    }
+    if (payload_length <= 65535) {
+        return 2 + 2 + 4;
+    }
+    return 2 + 8 + 4;
+}
+
+void appendWebSocketHeader(size_t payload_length, WebSocketOpcode opcode, std::string& out, unsigned char mask[4]) {
+    size_t len = payload_length;
+    size_t header_size = webSocketHeaderSize(len);
+    size_t offset = out.size();
+    out.resize(offset + header_size);
+
+    unsigned char* p = reinterpret_cast<unsigned char*>(&out[offset]);
+
+    // FIN=1, opcode (text for STOMP, control opcodes for ping/pong/close)
+    *p++ = static_cast<unsigned char>(0x80 | static_cast<unsigned char>(opcode));
+
+    // Mask bit set, payload length
+    if (len <= 125) {
+        *p++ = static_cast<unsigned char>(0x80 | len);
+    } else if (len <= 65535) {
+        *p++ = 0x80 | 126;
+        *p++ = static_cast<unsigned char>((len >> 8) & 0xFF);
+        *p++ = static_cast<unsigned char>(len & 0xFF);
+    } else {
+        *p++ = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) {
+            *p++ = static_cast<unsigned char>((static_cast<uint64_t>(len) >> (i * 8)) & 0xFF);
+        }
+    }
+
+    // Fresh masking key per frame (RFC 6455 section 5.3)
+    generateWebSocketMask(mask);
+    std::memcpy(p, mask, 4);
+}
+
+void appendWebSocketFrame(std::string_view payload, WebSocketOpcode opcode, std::string& out) {
+    size_t len = payload.size();
+    out.reserve(out.size() + webSocketHeaderSize(len) + len);
+
+    unsigned char mask[4];
+    appendWebSocketHeader(len, opcode, out, mask);
+    size_t offset = out.size();
+    out.resize(offset + len);
+    maskWebSocketPayload(payload.data(), &out[offset], len, mask);
+}
+
+size_t parseWebSocketFrame(char* data, size_t length, WebSocketFrame& frame) {
+    if (length < 2) {
+        return 0;
+    }
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t pos = 0;
+
+    // Parse header
+    unsigned char byte1 = bytes[pos++];
+    unsigned char byte2 = bytes[pos++];
+
+    if ((byte1 & 0x70) != 0) {
+        throw std::runtime_error("WebSocket frame uses reserved bits without a negotiated extension");
+    }
+
+    bool fin = (byte1 & 0x80) != 0;
+    unsigned char opcode = byte1 & 0x0F;
+    bool masked = (byte2 & 0x80) != 0;
+    unsigned long long payload_len = byte2 & 0x7F;
+
+    // Handle extended payload length
+    if (payload_len == 126) {
+        if (length < pos + 2) return 0;
+        payload_len = (static_cast<unsigned long long>(bytes[pos]) << 8) | bytes[pos + 1];
+        pos += 2;
+    } else if (payload_len == 127) {
+        if (length < pos + 8) return 0;
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | bytes[pos++];
+        }
+    }
+
+    if (payload_len > kMaxWebSocketPayload) {
+        throw std::runtime_error("WebSocket frame too large: " + std::to_string(payload_len) + " bytes");
+    }
+
+    if ((opcode & 0x8) != 0 && (!fin || payload_len > 125)) {
+        throw std::runtime_error("Invalid WebSocket control frame");
+    }
+
+    // Servers should not mask, but unmask in place if one does
+    unsigned char mask[4] = {0, 0, 0, 0};
+    if (masked) {
+        if (length < pos + 4) return 0;
+        std::memcpy(mask, bytes + pos, 4);
+        pos += 4;
+    }
+
+    if (length < pos + payload_len) {
+        return 0;
+    }
+
+    char* payload = data + pos;
+    if (masked) {
+        maskWebSocketPayload(payload, payload, static_cast<size_t>(payload_len), mask);
+    }
+
+    frame.fin = fin;
+    frame.opcode = static_cast<WebSocketOpcode>(opcode);
+    frame.payload = std::string_view(payload, static_cast<size_t>(payload_len));
+
+    return pos + static_cast<size_t>(payload_len);
+}
+
+ReceiveBuffer::ReceiveBuffer(size_t initial_capacity)
+    : buffer_(initial_capacity > 0 ? initial_capacity : 4096), read_pos_(0), write_pos_(0) {
+}
+
+char* ReceiveBuffer::prepareWrite(size_t min_space) {
+    if (writableSize() < min_space) {
+        // Reclaim consumed space first, grow only if that is not enough
+        size_t unread = readableSize();
+        if (read_pos_ > 0) {
+            std::memmove(buffer_.data(), buffer_.data() + read_pos_, unread);
+            read_pos_ = 0;
+            write_pos_ = unread;
+        }
+        if (writableSize() < min_space) {
+            size_t new_size = buffer_.size();
+            while (new_size - write_pos_ < min_space) {
+                new_size *= 2;
+            }
+            buffer_.resize(new_size);
+        }
+    }
+    return buffer_.data() + write_pos_;
+}
+
+void ReceiveBuffer::consume(size_t n) {
+    read_pos_ += n;
+    if (read_pos_ >= write_pos_) {
+        // Fully drained: rewind for free instead of compacting later
+        read_pos_ = write_pos_ = 0;
+    }
+}
+
+} // namespace sar_atr